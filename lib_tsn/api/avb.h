@@ -51,6 +51,23 @@ enum device_media_clock_type_t
   DEVICE_MEDIA_CLOCK_LOCAL_CLOCK           /*!< The clock is sourced from within the entity from the local crystal oscillator */
 };
 
+/** The external PLL the recovered media clock drives. Selects the clock
+ *  recovery loop gains. */
+enum media_clock_pll_profile_t
+{
+  MEDIA_CLOCK_PLL_PROFILE_CS2100, /*!< Cirrus Logic CS2100-CP */
+  MEDIA_CLOCK_PLL_PROFILE_CS2300, /*!< Cirrus Logic CS2300-CP */
+  MEDIA_CLOCK_PLL_PROFILE_DIRECT  /*!< Rate applied directly by a media clock output driver */
+};
+
+/** How the recovered rate of a media clock reaches the audio clock */
+enum media_clock_output_type_t
+{
+  MEDIA_CLOCK_OUTPUT_PLL_REFERENCE, /*!< A reference clock is driven on the media clock port to an external PLL */
+  MEDIA_CLOCK_OUTPUT_PLL_RATIO,     /*!< The ratio register of a fractional-N PLL is written */
+  MEDIA_CLOCK_OUTPUT_MCLK_TRIM      /*!< An internal PLL or master clock divider is trimmed */
+};
+
 /** A set of media related commands generated by the AVB manager */
 enum device_media_clock_commands_t
 {
@@ -66,8 +83,24 @@ typedef struct media_clock_info_t {
   int rate;                 ///<  The rate of the media clock in Hz
   int lock_counter;         ///< A count of the number of lock events on this media clock
   int unlock_counter;       ///< A count of the number of unlock events on this media clock
+  enum media_clock_pll_profile_t pll_profile; ///< The PLL the clock recovery is tuned for
+  int pll_multiplier;       ///< The PLL reference runs at the base rate of the
+                            ///  clock's family divided by half this value
+  int recovery_locked;      ///< Set once a stream derived clock has settled (read only)
+  int lock_time_ms;         ///< Time the last lock took from the start of recovery in ms (read only)
+  int rate_error_ppb;       ///< Recovered rate relative to nominal in parts per billion (read only)
 } media_clock_info_t;
 
+/** Fill statistics of a media output FIFO, gathered while it is locked */
+typedef struct media_output_fifo_stats_t {
+  int locked;               ///< Set if the FIFO is aligned to the presentation times
+  int fill;                 ///< The fill level in samples at the last report
+  int min_fill;             ///< The lowest fill level since the FIFO locked
+  int max_fill;             ///< The highest fill level since the FIFO locked
+  unsigned underflows;      ///< Samples played from an empty FIFO since the stream started
+  int presentation_offset_ns; ///< The offset added to the stream's presentation times in ns
+} media_output_fifo_stats_t;
+
 /** Struct containing fields required for SRP reservations */
 typedef struct avb_srp_info_t {
   unsigned stream_id[2];          /**< 64-bit Stream ID of the stream */
@@ -101,6 +134,7 @@ typedef struct avb_source_info_t
     chanend *unsafe talker_ctl;
     int presentation;
     int map[AVB_MAX_CHANNELS_PER_TALKER_STREAM];
+    int monitor_map[AVB_MAX_CHANNELS_PER_TALKER_STREAM]; /*!< Media outputs that play the stream locally */
 } avb_source_info_t;
 
 
@@ -135,6 +169,8 @@ interface avb_interface {
   void _set_media_clock_info(unsigned clock_num, media_clock_info_t info);
   /** Intended for internal use within client interface extension only */
   struct avb_debug_counters _get_debug_counters(void);
+  /** Intended for internal use within client interface extension only */
+  media_output_fifo_stats_t _get_media_output_fifo_stats(unsigned output_num);
 };
 
 interface media_clock_if {
@@ -142,6 +178,26 @@ interface media_clock_if {
   media_clock_info_t get_clock_info(unsigned clock_num);
   void set_clock_info(unsigned clock_num, media_clock_info_t info);
   void set_buf_fifo(unsigned i, int fifo);
+  media_output_fifo_stats_t get_buf_fifo_stats(unsigned i);
+  void set_buf_accumulated_latency(unsigned i, unsigned latency);
+};
+
+/** Interface to a driver that applies the recovered rate of media clocks
+ *  directly, rather than through a PLL reference clock */
+interface media_clock_output_if {
+  /** Get how the rate of a media clock is applied. Called once at start up. */
+  enum media_clock_output_type_t get_type(unsigned clock_num);
+
+  /** Set the rate of a media clock. Called every clock recovery period for
+   *  active clocks whose type is not ``MEDIA_CLOCK_OUTPUT_PLL_REFERENCE``.
+   *  The driver must return at once and apply the rate afterwards.
+   *
+   *  \param clock_num  the media clock
+   *  \param rate       the nominal sample rate in Hz
+   *  \param wordlen    the recovered sample period in 10ns units with 16
+   *                    fractional bits
+   */
+  void set_rate(unsigned clock_num, unsigned rate, unsigned wordlen);
 };
 
 
@@ -450,6 +506,64 @@ extends client interface avb_interface : {
     return 1;
   }
 
+  /** Get the local monitor map of an avb source.
+   *  \param i          interface to AVB manager
+   *  \param source_num the local source number
+   *  \param map        the map, an array of integers giving the media output
+   *                    that plays each channel of the stream, or -1
+   *  \param len        the length of the map; equal to the number of channels
+   *                    in the stream
+   */
+  static inline int get_source_monitor_map(client interface avb_interface i, unsigned source_num,
+                     int map[], int &len)
+  {
+    if (source_num >= AVB_NUM_SOURCES)
+      return 0;
+    avb_source_info_t source;
+    source = i._get_source_info(source_num);
+    len = source.stream.num_channels;
+    memcpy(map, source.monitor_map, len<<2);
+    return 1;
+  }
+
+  /** Set the local monitor map of an avb source.
+   *
+   *  Channels of the source with a media output in the map are played on
+   *  that output at the stream's presentation time, in step with remote
+   *  listeners. The talker pushes its packets straight into the output
+   *  FIFOs, so it must be on the same tile as the output buffer and have
+   *  buffer control and output buffer links (see avb_1722_talker()).
+   *  The source's presentation time must be no longer than
+   *  ``AVB_TALKER_LOCAL_MONITOR_MAX_DELAY_NS``, which sizes the output FIFOs.
+   *  Requires ``AVB_TALKER_LOCAL_MONITOR``.
+   *
+   *  This setting will not take effect until the next time the source
+   *  state moves from disabled to potential.
+   *
+   *  \param i          interface to AVB manager
+   *  \param source_num the local source number to set
+   *  \param map        the map, an array of integers giving the media output
+   *                    that plays each channel of the stream, or -1 to not
+   *                    monitor the channel
+   *  \param len        the length of the map; should be equal to the number
+   *                    of channels in the stream
+   */
+  static inline int set_source_monitor_map(client interface avb_interface i, unsigned source_num,
+                     int map[len], unsigned len)
+  {
+    if (source_num >= AVB_NUM_SOURCES)
+      return 0;
+    avb_source_info_t source;
+    source = i._get_source_info(source_num);
+    if (source.stream.state != AVB_SOURCE_STATE_DISABLED)
+      return 0;
+    if (len > AVB_MAX_CHANNELS_PER_TALKER_STREAM)
+      return 0;
+    memcpy(source.monitor_map, map, len<<2);
+    i._set_source_info(source_num, source);
+    return 1;
+  }
+
   /** Get the destination address of an avb source.
    *  \param i            interface to AVB manager
    *  \param source_num   the local source number
@@ -1010,6 +1124,142 @@ extends client interface avb_interface : {
     return 1;
   }
 
+  /** Get the PLL gain profile used by the recovery of a media clock.
+   *
+   *  \param i          interface to AVB manager
+   *  \param clock_num  the number of the media clock
+   *  \param profile    the PLL profile
+   */
+  static inline int get_device_media_clock_pll_profile(client interface avb_interface i,
+                                  int clock_num,
+                                  enum media_clock_pll_profile_t &profile)
+  {
+    if (clock_num >= AVB_NUM_MEDIA_CLOCKS)
+      return 0;
+    media_clock_info_t info;
+    info = i._get_media_clock_info(clock_num);
+    profile = info.pll_profile;
+    return 1;
+  }
+
+  /** Set the PLL gain profile used by the recovery of a media clock.
+   *
+   *  The loop gains of stream derived clock recovery depend on the
+   *  response of the external PLL that multiplies the reference clock.
+   *
+   *  \param i          interface to AVB manager
+   *  \param clock_num  the number of the media clock
+   *  \param profile    the PLL profile
+   *
+   *  \returns 0 if the profile is not supported, in which case the clock
+   *           keeps its current profile
+   **/
+  static inline int set_device_media_clock_pll_profile(client interface avb_interface i,
+                                  int clock_num,
+                                  enum media_clock_pll_profile_t profile)
+  {
+    if (clock_num >= AVB_NUM_MEDIA_CLOCKS)
+      return 0;
+    media_clock_info_t info;
+    info = i._get_media_clock_info(clock_num);
+    info.pll_profile = profile;
+    i._set_media_clock_info(clock_num, info);
+    info = i._get_media_clock_info(clock_num);
+    return info.pll_profile == profile;
+  }
+
+  /** Get the PLL multiplier of a media clock.
+   *
+   *  \param i          interface to AVB manager
+   *  \param clock_num  the number of the media clock
+   *  \param multiplier the PLL multiplier
+   */
+  static inline int get_device_media_clock_pll_multiplier(client interface avb_interface i,
+                                  int clock_num,
+                                  int &multiplier)
+  {
+    if (clock_num >= AVB_NUM_MEDIA_CLOCKS)
+      return 0;
+    media_clock_info_t info;
+    info = i._get_media_clock_info(clock_num);
+    multiplier = info.pll_multiplier;
+    return 1;
+  }
+
+  /** Set the PLL multiplier of a media clock.
+   *
+   *  The reference clock output for a media clock runs at the base rate
+   *  of the clock's family (48kHz, 44.1kHz or 32kHz) divided by half the
+   *  multiplier, so the external PLL must multiply it by the master clocks
+   *  per word times the multiplier over two. Clocks of different families
+   *  can then share a PLL configuration. The default is
+   *  ``PLL_TO_WORD_MULTIPLIER``.
+   *
+   *  \param i          interface to AVB manager
+   *  \param clock_num  the number of the media clock
+   *  \param multiplier the PLL multiplier
+   *
+   **/
+  static inline int set_device_media_clock_pll_multiplier(client interface avb_interface i,
+                                  int clock_num,
+                                  int multiplier)
+  {
+    if (clock_num >= AVB_NUM_MEDIA_CLOCKS || multiplier <= 0)
+      return 0;
+    media_clock_info_t info;
+    info = i._get_media_clock_info(clock_num);
+    info.pll_multiplier = multiplier;
+    i._set_media_clock_info(clock_num, info);
+    return 1;
+  }
+
+  /** Get the clock recovery status of a media clock.
+   *
+   *  \param i              interface to AVB manager
+   *  \param clock_num      the number of the media clock
+   *  \param locked         set if the recovered clock has settled
+   *  \param lock_time_ms   the time the last lock took in ms
+   *  \param rate_error_ppb the recovered rate relative to nominal in
+   *                        parts per billion
+   */
+  static inline int get_device_media_clock_recovery_status(client interface avb_interface i,
+                                  int clock_num,
+                                  int &locked,
+                                  int &lock_time_ms,
+                                  int &rate_error_ppb)
+  {
+    if (clock_num >= AVB_NUM_MEDIA_CLOCKS)
+      return 0;
+    media_clock_info_t info;
+    info = i._get_media_clock_info(clock_num);
+    locked = info.recovery_locked;
+    lock_time_ms = info.lock_time_ms;
+    rate_error_ppb = info.rate_error_ppb;
+    return 1;
+  }
+
+  /** Get the fill statistics of a media output FIFO.
+   *
+   *  When adaptive presentation time is enabled
+   *  (``AVB_ADAPTIVE_PRESENTATION_TIME``) the reported offset is the
+   *  amount the output currently plays behind the stream's presentation
+   *  times. It may be negative if the stream's SRP accumulated latency
+   *  allows samples to be played early.
+   *
+   *  \param i          interface to AVB manager
+   *  \param output_num the local media output number
+   *  \param stats      the FIFO statistics
+   */
+  static inline int get_media_output_fifo_stats(client interface avb_interface i,
+                                  unsigned output_num,
+                                  media_output_fifo_stats_t &stats)
+  {
+    if (output_num >= AVB_NUM_MEDIA_OUTPUTS)
+      return 0;
+    stats = i._get_media_output_fifo_stats(output_num);
+    return 1;
+  }
+
   /** Read back debug counters
     *
     * \param i          interface to AVB manager
@@ -1148,12 +1398,18 @@ void avb_srp_task(client interface avb_interface i_avb,
  *  \param c_talker_ctl     channel to configure the talker
  *  \param num_streams      the number of streams the unit controls
  *  \param audio_input_buf  a client interface to get a handle to pull from the audio input buffer
+ *  \param c_buf_ctl        optional buffer control link to the media clock
+ *                          server, for local monitoring
+ *  \param audio_output_buf optional client interface to get a handle to push
+ *                          to the audio output buffer, for local monitoring
  **/
 void avb_1722_talker(chanend c_ptp,
                      streaming chanend c_eth_tx_hp,
                      chanend c_talker_ctl,
                      int num_streams,
-                     client pull_if audio_input_buf);
+                     client pull_if audio_input_buf,
+                     chanend ?c_buf_ctl,
+                     client push_if ?audio_output_buf);
 
 /** An AVB IEEE 1722 audio listener thread.
  *
@@ -1186,6 +1442,8 @@ void avb_1722_listener(streaming chanend c_eth_rx_hp,
  *                          requiring buffer management
  *  \param num_buf_ctl      size of the buf_ctl array
  *  \param p_fs             output port to drive PLL reference clock
+ *  \param i_clk_out        optional client interface to a media clock output
+ *                          driver that applies the recovered rates directly
  *  \param i_eth_rx         a client receive interface into the Ethernet MAC
  *  \param i_eth_tx         a client transmit interface into the Ethernet MAC
  *  \param i_eth_cfg        a client interface for Ethernet MAC configuration
@@ -1198,6 +1456,7 @@ void gptp_media_clock_server(server interface media_clock_if media_clock_ctl,
                             chanend ?ptp_svr,
                             chanend buf_ctl[num_buf_ctl], unsigned num_buf_ctl,
                             out buffered port:32 p_fs[],
+                            client interface media_clock_output_if ?i_clk_out,
                             client interface ethernet_rx_if i_eth_rx,
                             client interface ethernet_tx_if i_eth_tx,
                             client interface ethernet_cfg_if i_eth_cfg,
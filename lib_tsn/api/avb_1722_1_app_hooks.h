@@ -62,6 +62,22 @@ void avb_talker_on_listener_connect_failed(client interface avb_interface i_avb,
 void avb_talker_on_listener_connect_failed_default(client interface avb_interface i_avb, const_guid_ref_t my_guid, int source_num,
         const_guid_ref_t listener_guid, avb_1722_1_acmp_status_t status, client interface ethernet_tx_if i_eth);
 
+/** A batch of connections started by this Controller has completed: every command has had a response
+ *  or timed out after its retry.
+ *
+ * \param i_avb             client interface of type ``avb_interface`` into avb_manager()
+ * \param my_guid           The GUID of this entity
+ * \param num_connections   The number of connections in the batch
+ * \param num_failed        The number of connections that did not succeed; the status of each is
+ *                          given by avb_1722_1_controller_batch_status()
+ * \param i_eth             a client transmit interface into the Ethernet MAC
+ **/
+void avb_controller_on_batch_complete(client interface avb_interface i_avb, const_guid_ref_t my_guid,
+        unsigned num_connections, unsigned num_failed, client interface ethernet_tx_if i_eth);
+
+void avb_controller_on_batch_complete_default(client interface avb_interface i_avb, const_guid_ref_t my_guid,
+        unsigned num_connections, unsigned num_failed, client interface ethernet_tx_if i_eth);
+
 /** A Controller has indicated to connect this Listener sink to a Talker stream
  *
  * \param i_avb             client interface of type ``avb_interface`` into avb_manager()
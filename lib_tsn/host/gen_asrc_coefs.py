@@ -0,0 +1,85 @@
+#!/usr/bin/env python
+# Copyright (c) 2017, XMOS Ltd, All rights reserved
+"""Generate the polyphase filter table of the media output ASRC.
+
+Writes lib_tsn/src/audio_buffering/audio_output_asrc_coefs.h. The prototype
+is a Kaiser windowed sinc spanning ASRC_TAPS input samples, sampled at
+ASRC_PHASES points per input sample. One extra phase is stored so that the
+ASRC can interpolate between phase p and p+1 without wrapping. Each phase is
+normalised to unity gain at DC so that the gain does not depend on the
+fractional position. With the cutoff at half the input rate phase 0 is a
+unit impulse, so a ratio of exactly 1 passes samples through unchanged.
+
+Usage: gen_asrc_coefs.py [out.h]
+"""
+import math
+import os
+import sys
+
+ASRC_TAPS = 24
+ASRC_PHASES = 64
+CUTOFF = 0.5         # Of the input sample rate
+KAISER_BETA = 9.0
+COEF_BITS = 30
+
+
+def bessel_i0(x):
+    total = 1.0
+    term = 1.0
+    k = 1
+    while term > 1e-12 * total:
+        term *= (x / (2.0 * k)) ** 2
+        total += term
+        k += 1
+    return total
+
+
+def prototype(t):
+    """Impulse response at t input samples from the output time"""
+    half = ASRC_TAPS / 2.0
+    if abs(t) >= half:
+        return 0.0
+    if t == 0:
+        sinc = 1.0
+    else:
+        x = 2.0 * CUTOFF * t
+        sinc = math.sin(math.pi * x) / (math.pi * x)
+    window = bessel_i0(KAISER_BETA * math.sqrt(1.0 - (t / half) ** 2)) / bessel_i0(KAISER_BETA)
+    return 2.0 * CUTOFF * sinc * window
+
+
+def phase_row(p):
+    # Tap k is the input sample k - (ASRC_TAPS/2 - 1) samples from the
+    # start of the interval the output falls in
+    frac = float(p) / ASRC_PHASES
+    row = [prototype(k - (ASRC_TAPS // 2 - 1) - frac) for k in range(ASRC_TAPS)]
+    gain = sum(row)
+    return [int(round(c / gain * (1 << COEF_BITS))) for c in row]
+
+
+def main():
+    default = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                           '..', 'src', 'audio_buffering', 'audio_output_asrc_coefs.h')
+    out = sys.argv[1] if len(sys.argv) > 1 else default
+    with open(out, 'w') as f:
+        f.write('// Copyright (c) 2017, XMOS Ltd, All rights reserved\n')
+        f.write('// Generated by lib_tsn/host/gen_asrc_coefs.py, do not edit\n')
+        f.write('// Kaiser windowed sinc, cutoff %.2f fs, beta %.1f\n' % (CUTOFF, KAISER_BETA))
+        f.write('#ifndef __audio_output_asrc_coefs_h__\n')
+        f.write('#define __audio_output_asrc_coefs_h__\n\n')
+        f.write('#if (AUDIO_OUTPUT_ASRC_TAPS != %d) || (AUDIO_OUTPUT_ASRC_PHASES != %d)\n'
+                % (ASRC_TAPS, ASRC_PHASES))
+        f.write('#error "audio_output_asrc_coefs.h does not match the ASRC size"\n')
+        f.write('#endif\n\n')
+        f.write('static const int asrc_coefs[AUDIO_OUTPUT_ASRC_PHASES+1][AUDIO_OUTPUT_ASRC_TAPS] = {\n')
+        for p in range(ASRC_PHASES + 1):
+            row = phase_row(p)
+            lines = [', '.join('%d' % c for c in row[i:i+8])
+                     for i in range(0, ASRC_TAPS, 8)]
+            f.write('  {' + ',\n   '.join(lines) + '},\n')
+        f.write('};\n\n')
+        f.write('#endif // __audio_output_asrc_coefs_h__\n')
+
+
+if __name__ == '__main__':
+    main()
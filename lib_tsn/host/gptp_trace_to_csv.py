@@ -0,0 +1,91 @@
+#!/usr/bin/env python
+# Copyright (c) 2017, XMOS Ltd, All rights reserved
+"""Convert a gPTP binary trace (see lib_tsn/src/ptp/gptp_trace.h) to CSV.
+
+The input is the raw ptp_trace_t structure, either dumped from the debugger:
+
+    (gdb) dump binary value trace.bin ptp_trace
+
+or the bytes received on the 'gPTP Trace' xSCOPE probe after calling
+ptp_dump_trace(), concatenated in order.
+
+Usage: gptp_trace_to_csv.py trace.bin [out.csv]
+"""
+import struct
+import sys
+
+PTP_TRACE_MAGIC = 0x54505447
+PTP_TRACE_VERSION = 1
+
+HEADER = struct.Struct('<IIII')
+ENTRY = struct.Struct('<BBHIii')
+
+TIMER_HZ = 100000000
+
+# Event id -> (name, meaning of a, meaning of b)
+EVENTS = {
+    1: ('sync_rx', '', ''),
+    2: ('follow_up_rx', 'origin_seconds', 'origin_ns'),
+    3: ('sync_tx', 'egress_seconds', 'egress_ns'),
+    4: ('pdelay_resp', 't1_local_ts', 'turnaround_ns'),
+    5: ('pdelay', 'raw_ns', 'filtered_ns'),
+    6: ('pdelay_outlier', 'raw_ns', 'filtered_ns'),
+    7: ('adjust', 'ptp_adjust', 'measured_adjust'),
+    8: ('role', 'role', ''),
+    9: ('lock', 'locked', ''),
+    10: ('holdover', 'active', 'time_error_ns'),
+}
+
+ROLES = {0: 'master', 1: 'uncertain', 2: 'slave', 3: 'disabled'}
+
+
+def decode(data):
+    magic, version, log2_entries, index = HEADER.unpack_from(data, 0)
+    if magic != PTP_TRACE_MAGIC:
+        raise ValueError('not a gPTP trace (magic 0x%08x)' % magic)
+    if version != PTP_TRACE_VERSION:
+        raise ValueError('unsupported trace version %d' % version)
+
+    num_entries = 1 << log2_entries
+    if len(data) < HEADER.size + num_entries * ENTRY.size:
+        raise ValueError('trace is truncated')
+
+    # index counts every entry ever written so the oldest surviving entry
+    # is index - num_entries once the ring has wrapped
+    first = max(0, index - num_entries)
+    for n in range(first, index):
+        offset = HEADER.size + (n % num_entries) * ENTRY.size
+        yield (n,) + ENTRY.unpack_from(data, offset)
+
+
+def to_csv(entries, out):
+    out.write('entry,time_us,event,port,seq_id,local_ts,a,b,a_name,b_name,info\n')
+    prev = None
+    elapsed = 0
+    for n, event, port, seq_id, local_ts, a, b in entries:
+        # Reconstruct a monotonic time from the 32-bit reference timer
+        if prev is not None:
+            elapsed += (local_ts - prev) & 0xffffffff
+        prev = local_ts
+        name, a_name, b_name = EVENTS.get(event, ('unknown_%d' % event, '', ''))
+        info = ''
+        if name == 'role':
+            info = ROLES.get(a, '')
+        elif name == 'adjust':
+            info = '%.3f ppm' % (a * 1e6 / (1 << 30))
+        out.write('%d,%.2f,%s,%d,%d,%u,%d,%d,%s,%s,%s\n' %
+                  (n, elapsed * 1e6 / TIMER_HZ, name, port, seq_id, local_ts,
+                   a, b, a_name, b_name, info))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        sys.stderr.write(__doc__)
+        sys.exit(1)
+    with open(sys.argv[1], 'rb') as f:
+        data = f.read()
+    if len(sys.argv) > 2:
+        with open(sys.argv[2], 'w') as out:
+            to_csv(decode(data), out)
+    else:
+        to_csv(decode(data), sys.stdout)
@@ -0,0 +1,405 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+/* Closed-loop simulation of listener media clock recovery.
+
+   The simulation runs the endpoint's own clock recovery engine
+   (media_clock_recovery.c) and output FIFO lock decisions
+   (media_output_lock.c) against a model of the rest of the system:
+
+     - a talker whose media clock is offset (and optionally steps) from the
+       gPTP grandmaster, sending a packet every 125us with a timestamp on
+       every 8th sample
+     - network latency with uniform jitter
+     - the listener output FIFO (audio_output_fifo.c) including its
+       zeroing, notification and fill adjustment behaviour
+     - the media clock output (pll_model.c): an external PLL as a first
+       order lag on the reference clock, a fractional-N PLL whose ratio is
+       written over I2C, an internal clock trimmed in fixed steps, or a
+       sample rate converter whose ratio applies at once
+
+   gPTP is assumed to be locked so the listener's timer is grandmaster
+   time. Every combination of the parameter grids below is run for each
+   scenario and one CSV line is printed per run.
+
+   Usage: media_clock_sim [-t seconds] [-s seed] */
+#include <stdio.h>
+#include <stdlib.h>
+#include "media_clock_recovery.h"
+#include "media_output_lock.h"
+#include "pll_model.h"
+
+#define SAMPLE_RATE             48000
+#define TICKS_PER_SEC           100000000.0
+#define FIFO_SIZE               (SAMPLE_RATE / 450)   // AUDIO_OUTPUT_FIFO_WORD_SIZE
+#define SAMPLES_PER_PACKET_MAX  (SAMPLE_RATE / 8000)
+#define PACKET_PERIOD           12500                 // 125us
+#define SYT_INTERVAL            8
+#define PRESENTATION_DELAY      200000                // 2ms
+#define BASE_TRANSIT            50000                 // 500us
+#define NOTIFICATION_PERIOD     250
+#define CLOCK_RECOVERY_PERIOD   (1 << 21)
+#define WC_FRACTIONAL_BITS      16
+#define PLL_SETTLE              0.8                   // Fraction of a wordlen change applied per update
+
+/* ------------------------------------------------------------------------
+   Parameter grids. Every combination is run against every scenario.
+   ------------------------------------------------------------------------ */
+
+typedef struct gains_t {
+  const char *name;
+  media_clock_pll_gains_t gains;
+} gains_t;
+
+static const gains_t gain_grid[] = {
+  {"cs2100", MEDIA_CLOCK_PLL_GAINS_CS2100},
+  {"cs2300", MEDIA_CLOCK_PLL_GAINS_CS2300},
+  {"direct", MEDIA_CLOCK_PLL_GAINS_DIRECT},
+  {"asrc",   MEDIA_CLOCK_ASRC_GAINS},
+};
+
+static const pll_model_params_t output_grid[] = {
+  {"pll_reference", PLL_MODEL_REFERENCE, PLL_SETTLE, 0, 0, 0, 0, 0},
+  // CS2300-CP style 12.20 ratio from a 12.288MHz crystal, written in a
+  // six byte I2C transaction at 100kHz
+  {"pll_ratio",     PLL_MODEL_RATIO,     0, 100000, 12288000, 20, 512, 0},
+  {"mclk_trim",     PLL_MODEL_TRIM,      0, 1000, 0, 0, 0, 1000},
+  // Sample rate converter: the ratio applies in full from the next packet
+  {"asrc",          PLL_MODEL_REFERENCE, 1.0, 0, 0, 0, 0, 0},
+};
+
+static const int stable_threshold_grid[] = {8, 32};
+static const int lost_lock_threshold_grid[] = {8, 24};
+static const int lock_count_threshold_grid[] = {400};
+
+typedef struct scenario_t {
+  const char *name;
+  int drift_ppb;              //!< Talker media clock offset from the grandmaster
+  int jitter_ticks;           //!< Peak network jitter
+  double step_time;           //!< Time of a talker rate step in seconds (0 for none)
+  int step_ppb;               //!< Size of the step
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+  {"offset_+50ppm",         50000,     0,  0,      0},
+  {"offset_-100ppm_jitter", -100000, 25000, 0,     0},
+  {"gm_change_+30ppm",      20000,  5000,  30,   30000},
+};
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+/* ------------------------------------------------------------------------
+   Output FIFO model, following audio_output_fifo.c
+   ------------------------------------------------------------------------ */
+
+enum { ZEROING, LOCKING, LOCKED };
+
+typedef struct fifo_t {
+  int state;
+  int slot[FIFO_SIZE];        //!< Only used to detect the end of zeroing
+  int rd;
+  int wr;
+  int marker;                 //!< -1 when no sample is marked
+  unsigned ptp_ts;
+  unsigned local_ts;
+  int zero_marker;
+  unsigned sample_count;
+  unsigned last_notification_time;
+} fifo_t;
+
+static void fifo_reset(fifo_t *f)
+{
+  f->state = ZEROING;
+  f->zero_marker = f->wr == 0 ? FIFO_SIZE - 1 : f->wr - 1;
+  f->slot[f->zero_marker] = 1;
+}
+
+static int fifo_fill(fifo_t *f)
+{
+  int fill = f->wr - f->rd;
+  if (fill < 0)
+    fill += FIFO_SIZE;
+  return fill;
+}
+
+/* ------------------------------------------------------------------------
+   Simulation
+   ------------------------------------------------------------------------ */
+
+typedef struct result_t {
+  double fifo_lock_ms;
+  double clock_lock_ms;
+  double ppb_mean;
+  double ppb_max;
+  int underruns;
+  int overruns;
+  int relocks;
+} result_t;
+
+static unsigned rand_state;
+
+static unsigned rand_next(void)
+{
+  rand_state = rand_state * 1664525 + 1013904223;
+  return rand_state >> 8;
+}
+
+/* The talker captures samples on its own media clock and sends the ones
+   captured since the last packet every PACKET_PERIOD */
+typedef struct talker_t {
+  double period;              //!< Sample period in ticks
+  double base;                //!< Capture time of base_sample
+  long long base_sample;
+  long long next_sample;
+  double sent;
+  double arrival;
+  int stepped;
+  long long first;            //!< First sample in the pending packet
+  int samples;                //!< Number of samples in the pending packet
+} talker_t;
+
+/* Build the next packet and return its arrival time */
+static double next_packet(const scenario_t *sc, talker_t *tk)
+{
+  double arrival;
+
+  tk->sent += PACKET_PERIOD;
+
+  if (sc->step_time != 0 && !tk->stepped && tk->sent >= sc->step_time * TICKS_PER_SEC) {
+    tk->base += (tk->next_sample - tk->base_sample) * tk->period;
+    tk->base_sample = tk->next_sample;
+    tk->period = TICKS_PER_SEC / (SAMPLE_RATE * (1 + (sc->drift_ppb + sc->step_ppb) * 1e-9));
+    tk->stepped = 1;
+  }
+
+  tk->first = tk->next_sample;
+  while (tk->base + (tk->next_sample - tk->base_sample) * tk->period <= tk->sent)
+    tk->next_sample++;
+  tk->samples = (int) (tk->next_sample - tk->first);
+
+  arrival = tk->sent + BASE_TRANSIT;
+  if (sc->jitter_ticks)
+    arrival += rand_next() % sc->jitter_ticks;
+  // The network does not reorder packets
+  if (arrival < tk->arrival)
+    arrival = tk->arrival;
+  tk->arrival = arrival;
+  return arrival;
+}
+
+static unsigned long long nominal_wordlen(void)
+{
+  return (100000000LL << WORDLEN_FRACTIONAL_BITS) / SAMPLE_RATE;
+}
+
+static void run(const scenario_t *sc,
+                const media_clock_pll_gains_t *gains,
+                const pll_model_params_t *output,
+                const media_output_lock_params_t *params,
+                double seconds,
+                unsigned seed,
+                result_t *res)
+{
+  media_clock_recovery_t r;
+  media_output_lock_t lock;
+  fifo_t f = {0};
+  double end = seconds * TICKS_PER_SEC;
+  pll_model_t pll;
+  talker_t talker = {0};
+  double t_packet, t_pull = 0, t_update = CLOCK_RECOVERY_PERIOD;
+  unsigned wordlength;
+  double ppb_sum = 0;
+  int ppb_count = 0;
+  int locked_once = 0;
+
+  rand_state = seed;
+  talker.period = TICKS_PER_SEC / (SAMPLE_RATE * (1 + sc->drift_ppb * 1e-9));
+  t_packet = next_packet(sc, &talker);
+  res->fifo_lock_ms = -1;
+  res->clock_lock_ms = -1;
+  res->ppb_mean = 0;
+  res->ppb_max = 0;
+  res->underruns = 0;
+  res->overruns = 0;
+  res->relocks = 0;
+
+  media_clock_recovery_init(&r, nominal_wordlen(), 0);
+  r.gains = *gains;
+  media_output_lock_init(&lock);
+  wordlength = r.wordlen >> (WORDLEN_FRACTIONAL_BITS - WC_FRACTIONAL_BITS);
+  pll_model_init(&pll, output, SAMPLE_RATE, wordlength);
+
+  f.marker = -1;
+  f.zero_marker = FIFO_SIZE - 1;
+  f.slot[f.zero_marker] = 1;
+  f.state = ZEROING;
+
+  while (1) {
+    double t = t_packet;
+    if (t_pull < t) t = t_pull;
+    if (t_update < t) t = t_update;
+    if (t >= end)
+      break;
+
+    if (t == t_update) {
+      /* update_media_clocks() */
+      media_clock_recovery_update(&r, (unsigned) (long long) t);
+      wordlength = r.wordlen >> (WORDLEN_FRACTIONAL_BITS - WC_FRACTIONAL_BITS);
+      pll_model_set_wordlen(&pll, wordlength, t);
+      if (r.locked && res->clock_lock_ms < 0)
+        res->clock_lock_ms = t * 1000 / TICKS_PER_SEC;
+
+      if (t > end * 3 / 4) {
+        /* Steady state rate error of the listener against the talker */
+        double ppb = (talker.period / pll_model_period(&pll, t) - 1) * 1e9;
+        ppb_sum += ppb;
+        ppb_count++;
+        if (ppb > res->ppb_max || -ppb > res->ppb_max)
+          res->ppb_max = ppb < 0 ? -ppb : ppb;
+      }
+      t_update += CLOCK_RECOVERY_PERIOD;
+    }
+    else if (t == t_pull) {
+      /* audio_output_fifo_pull_sample() */
+      if (f.rd == f.wr) {
+        if (f.state == LOCKED)
+          res->underruns++;
+      } else {
+        if (f.rd == f.marker && f.local_ts == 0) {
+          f.local_ts = (unsigned) (long long) t;
+          if (f.local_ts == 0) f.local_ts = 1;
+        }
+        f.rd = (f.rd + 1) % FIFO_SIZE;
+      }
+      t_pull += pll_model_period(&pll, t);
+    }
+    else {
+      /* The next packet arrives */
+      long long first = talker.first;
+      int n = talker.samples;
+
+      if (n > 0) {
+        long long k = first + (SYT_INTERVAL - first % SYT_INTERVAL) % SYT_INTERVAL;
+
+        /* audio_output_fifo_set_ptp_timestamp() */
+        if (k < first + n && f.marker < 0) {
+          double capture = talker.base + (k - talker.base_sample) * talker.period;
+          unsigned ptp_ts = (unsigned) (long long) ((capture + PRESENTATION_DELAY) * 10);
+          f.marker = (f.wr + (int) (k - first)) % FIFO_SIZE;
+          f.ptp_ts = ptp_ts == 0 ? 1 : ptp_ts;
+          f.local_ts = 0;
+        }
+
+        /* audio_output_fifo_maintain() and the media clock server's
+           manage_buffer() */
+        if (f.state == ZEROING) {
+          if (f.slot[f.zero_marker] == 0) {
+            f.wr = (f.rd + FIFO_SIZE / 2) % FIFO_SIZE;
+            f.state = LOCKING;
+            f.local_ts = 0;
+            f.ptp_ts = 0;
+            f.marker = -1;
+          }
+        }
+        else if (f.ptp_ts != 0 && f.local_ts != 0 &&
+                 (f.last_notification_time == 0 ||
+                  (int) (f.sample_count - f.last_notification_time) > NOTIFICATION_PERIOD)) {
+          unsigned outgoing = f.local_ts * 10;
+          int diff = (int) outgoing - (int) f.ptp_ts;
+          int fill = fifo_fill(&f);
+          int locked = f.state == LOCKED;
+          int sample_diff;
+
+          f.last_notification_time = f.sample_count;
+
+          media_clock_recovery_stream_info(&r, f.local_ts, outgoing, f.ptp_ts,
+                                           locked, fill);
+          f.ptp_ts = 0;
+          f.local_ts = 0;
+          f.marker = -1;
+
+          sample_diff = diff / (int) ((wordlength * 10) >> WC_FRACTIONAL_BITS);
+
+          switch (media_output_lock_update(&lock, params, locked, sample_diff, fill)) {
+          case MEDIA_OUTPUT_LOCK_ADJUST_FILL:
+            media_clock_recovery_fifo_adjusted(&r);
+            f.wr = ((f.wr - sample_diff) % FIFO_SIZE + FIFO_SIZE) % FIFO_SIZE;
+            f.state = LOCKED;
+            if (res->fifo_lock_ms < 0)
+              res->fifo_lock_ms = t * 1000 / TICKS_PER_SEC;
+            locked_once = 1;
+            break;
+          case MEDIA_OUTPUT_LOCK_TOO_LARGE:
+          case MEDIA_OUTPUT_LOCK_LOST:
+            if (locked_once)
+              res->relocks++;
+            fifo_reset(&f);
+            break;
+          default:
+            break;
+          }
+        }
+
+        /* audio_output_fifo_strided_push() */
+        for (int i = 0; i < n; i++) {
+          int new_wr = (f.wr + 1) % FIFO_SIZE;
+          if (new_wr != f.rd) {
+            if (f.state == ZEROING)
+              f.slot[f.wr] = 0;
+            f.wr = new_wr;
+          } else if (f.state == LOCKED) {
+            res->overruns++;
+          }
+        }
+        f.sample_count += n;
+      }
+      t_packet = next_packet(sc, &talker);
+    }
+  }
+
+  if (ppb_count)
+    res->ppb_mean = ppb_sum / ppb_count;
+}
+
+int main(int argc, char *argv[])
+{
+  double seconds = 60;
+  unsigned seed = 1;
+
+  for (int i = 1; i < argc - 1; i++) {
+    if (argv[i][0] == '-' && argv[i][1] == 't')
+      seconds = atof(argv[++i]);
+    else if (argv[i][0] == '-' && argv[i][1] == 's')
+      seed = atoi(argv[++i]);
+  }
+
+  printf("scenario,gains,output,stable_threshold,lost_lock_threshold,lock_count_threshold,"
+         "fifo_lock_ms,clock_lock_ms,ppb_mean,ppb_max,underruns,overruns,relocks\n");
+
+  for (unsigned s = 0; s < ARRAY_SIZE(scenarios); s++)
+  for (unsigned g = 0; g < ARRAY_SIZE(gain_grid); g++)
+  for (unsigned o = 0; o < ARRAY_SIZE(output_grid); o++)
+  for (unsigned st = 0; st < ARRAY_SIZE(stable_threshold_grid); st++)
+  for (unsigned ll = 0; ll < ARRAY_SIZE(lost_lock_threshold_grid); ll++)
+  for (unsigned lc = 0; lc < ARRAY_SIZE(lock_count_threshold_grid); lc++) {
+    media_output_lock_params_t params = {
+      stable_threshold_grid[st],
+      lock_count_threshold_grid[lc],
+      lost_lock_threshold_grid[ll],
+      0,
+      5,                                        // MIN_FILL_LEVEL
+      50000,                                    // ACCEPTABLE_FILL_ADJUST
+      FIFO_SIZE - SAMPLES_PER_PACKET_MAX,
+    };
+    result_t res;
+
+    run(&scenarios[s], &gain_grid[g].gains, &output_grid[o], &params,
+        seconds, seed, &res);
+
+    printf("%s,%s,%s,%d,%d,%d,%.1f,%.1f,%.1f,%.1f,%d,%d,%d\n",
+           scenarios[s].name, gain_grid[g].name, output_grid[o].name,
+           params.stable_threshold, params.lost_lock_threshold,
+           params.lock_count_threshold,
+           res.fifo_lock_ms, res.clock_lock_ms, res.ppb_mean, res.ppb_max,
+           res.underruns, res.overruns, res.relocks);
+  }
+  return 0;
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <math.h>
+#include "pll_model.h"
+#include "media_clock_output.h"
+
+#define WC_FRACTIONAL_BITS 16
+#define TICKS_PER_SEC      100000000.0
+
+static double wordlen_period(unsigned wordlen)
+{
+  return (double) wordlen / (1 << WC_FRACTIONAL_BITS);
+}
+
+void pll_model_init(pll_model_t *m, const pll_model_params_t *params,
+                    unsigned rate, unsigned wordlen)
+{
+  m->params = params;
+  m->rate = rate;
+  m->period = wordlen_period(wordlen);
+  m->apply_time = -1;
+}
+
+void pll_model_set_wordlen(pll_model_t *m, unsigned wordlen, double time)
+{
+  const pll_model_params_t *p = m->params;
+  double target = wordlen_period(wordlen);
+
+  switch (p->type) {
+  case PLL_MODEL_REFERENCE:
+    // The PLL's loop filter follows the reference clock as a first order lag
+    m->period += (target - m->period) * p->settle;
+    return;
+  case PLL_MODEL_RATIO: {
+    // The MCLK is the reference times the ratio actually written
+    unsigned ratio = media_clock_output_pll_ratio(wordlen, p->mclks_per_word,
+                                                  p->ref_hz, p->frac_bits);
+    double mclk_hz = (double) p->ref_hz * ratio / (1 << p->frac_bits);
+    m->next_period = TICKS_PER_SEC * p->mclks_per_word / mclk_hz;
+    break;
+  }
+  case PLL_MODEL_TRIM: {
+    int ppb = media_clock_output_trim_ppb(m->rate, wordlen);
+    double trim = floor(ppb / p->step_ppb + 0.5) * p->step_ppb;
+    m->next_period = TICKS_PER_SEC / (m->rate * (1 + trim * 1e-9));
+    break;
+  }
+  }
+  m->apply_time = time + p->latency;
+}
+
+double pll_model_period(pll_model_t *m, double time)
+{
+  if (m->apply_time >= 0 && time >= m->apply_time) {
+    m->period = m->next_period;
+    m->apply_time = -1;
+  }
+  return m->period;
+}
@@ -0,0 +1,44 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __pll_model_h__
+#define __pll_model_h__
+
+/* Stand-ins for the media clock outputs of avb.h's media_clock_output_if,
+   turning the word length the clock recovery commands into the sample
+   period the listener actually plays out at. */
+
+typedef enum pll_model_type_t {
+  PLL_MODEL_REFERENCE,        //!< External PLL tracking a reference clock
+  PLL_MODEL_RATIO,            //!< Fractional-N PLL ratio written over I2C
+  PLL_MODEL_TRIM,             //!< Internal PLL trimmed in fixed steps
+} pll_model_type_t;
+
+typedef struct pll_model_params_t {
+  const char *name;
+  pll_model_type_t type;
+  double settle;              //!< REFERENCE: fraction of a change applied per update
+  double latency;             //!< RATIO, TRIM: ticks from an update to the new rate
+  unsigned ref_hz;            //!< RATIO: PLL reference frequency
+  unsigned frac_bits;         //!< RATIO: fractional bits of the ratio register
+  unsigned mclks_per_word;    //!< RATIO: master clocks per sample
+  double step_ppb;            //!< TRIM: resolution of the trim
+} pll_model_params_t;
+
+typedef struct pll_model_t {
+  const pll_model_params_t *params;
+  unsigned rate;
+  double period;              //!< Current sample period in ticks
+  double next_period;         //!< Period that takes effect at apply_time
+  double apply_time;          //!< Negative when no change is pending
+} pll_model_t;
+
+void pll_model_init(pll_model_t *m, const pll_model_params_t *params,
+                    unsigned rate, unsigned wordlen);
+
+/** Command a new word length, as media_clock_output_if's set_rate() or the
+ *  PLL reference clock would */
+void pll_model_set_wordlen(pll_model_t *m, unsigned wordlen, double time);
+
+/** The sample period in ticks at a time */
+double pll_model_period(pll_model_t *m, double time);
+
+#endif
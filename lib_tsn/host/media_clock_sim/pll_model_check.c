@@ -0,0 +1,126 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+/* Checks of the media clock output conversions (media_clock_output.c) and
+   of the PLL model the simulator drives with them. The output is compared
+   with pll_model_check.expect by "make check".
+
+   - The MCLK frequency, fractional-N ratio and trim of the nominal 48kHz
+     word length, and of word lengths 100ppm either side, must be within
+     rounding of the exact values. The trim is taken from a whole nominal
+     word length, so may be out by one unit of it.
+   - A reference PLL must move by its settle fraction per update.
+   - A ratio write must not take effect before its latency, and must then
+     give the period of the quantised ratio.
+   - A trim must take effect after its latency in whole steps. */
+#include <stdio.h>
+#include <math.h>
+#include "media_clock_output.h"
+#include "pll_model.h"
+
+#define RATE               48000
+#define MCLKS_PER_WORD     512
+#define REF_HZ             12288000
+#define FRAC_BITS          20
+#define WC_FRACTIONAL_BITS 16
+#define TICKS_PER_SEC      100000000.0
+
+static const pll_model_params_t reference = {"reference", PLL_MODEL_REFERENCE, 0.5, 0, 0, 0, 0, 0};
+static const pll_model_params_t ratio = {"ratio", PLL_MODEL_RATIO, 0, 100000, REF_HZ, FRAC_BITS, MCLKS_PER_WORD, 0};
+static const pll_model_params_t trim = {"trim", PLL_MODEL_TRIM, 0, 1000, 0, 0, 0, 1000};
+
+static int failed = 0;
+
+static void check(const char *name, int ok)
+{
+  printf("%s: %s\n", name, ok ? "ok" : "failed");
+  if (!ok)
+    failed = 1;
+}
+
+// The word length of a clock ppm fast of RATE
+static unsigned wordlen(int ppm)
+{
+  return (unsigned) floor(TICKS_PER_SEC * (1 << WC_FRACTIONAL_BITS) /
+                          (RATE * (1 + ppm * 1e-6)) + 0.5);
+}
+
+static double wordlen_hz(unsigned wl)
+{
+  return TICKS_PER_SEC * (1 << WC_FRACTIONAL_BITS) / wl;
+}
+
+static void check_conversions(int ppm)
+{
+  unsigned wl = wordlen(ppm);
+  double mclk = wordlen_hz(wl) * MCLKS_PER_WORD;
+  double mclk_hz = media_clock_output_mclk_hz(wl, MCLKS_PER_WORD) / 256.0;
+  unsigned r = media_clock_output_pll_ratio(wl, MCLKS_PER_WORD, REF_HZ, FRAC_BITS);
+  double exact_ratio = mclk / REF_HZ * (1 << FRAC_BITS);
+  int ppb = media_clock_output_trim_ppb(RATE, wl);
+  double exact_ppb = (wordlen_hz(wl) / RATE - 1) * 1e9;
+  char name[80];
+
+  snprintf(name, sizeof(name), "%+dppm: mclk %.3fHz ratio 0x%06x trim %dppb",
+           ppm, mclk_hz, r, ppb);
+  check(name, fabs(mclk_hz - mclk) < 1.0 / 256 &&
+              fabs(r - exact_ratio) <= 0.5 &&
+              fabs(ppb - exact_ppb) < 1e9 / wl);
+}
+
+static void check_reference(void)
+{
+  pll_model_t m;
+  double start, target, after;
+
+  pll_model_init(&m, &reference, RATE, wordlen(0));
+  start = pll_model_period(&m, 0);
+  pll_model_set_wordlen(&m, wordlen(100), 0);
+  target = (double) wordlen(100) / (1 << WC_FRACTIONAL_BITS);
+  after = pll_model_period(&m, 0);
+  check("reference: half way after one update",
+        fabs(after - (start + target) / 2) < 1e-9);
+}
+
+static void check_ratio(void)
+{
+  pll_model_t m;
+  unsigned wl = wordlen(100);
+  unsigned r = media_clock_output_pll_ratio(wl, MCLKS_PER_WORD, REF_HZ, FRAC_BITS);
+  double expected = TICKS_PER_SEC * MCLKS_PER_WORD /
+                    ((double) REF_HZ * r / (1 << FRAC_BITS));
+  double start, before, after;
+
+  pll_model_init(&m, &ratio, RATE, wordlen(0));
+  start = pll_model_period(&m, 0);
+  pll_model_set_wordlen(&m, wl, 1000);
+  before = pll_model_period(&m, 1000 + ratio.latency - 1);
+  after = pll_model_period(&m, 1000 + ratio.latency);
+  check("ratio: applied after the write latency, quantised",
+        before == start && fabs(after - expected) < 1e-9);
+}
+
+static void check_trim(void)
+{
+  pll_model_t m;
+  double start, before, after, ppb;
+
+  pll_model_init(&m, &trim, RATE, wordlen(0));
+  start = pll_model_period(&m, 0);
+  pll_model_set_wordlen(&m, wordlen(2), 0);
+  before = pll_model_period(&m, trim.latency - 1);
+  after = pll_model_period(&m, trim.latency);
+  ppb = (TICKS_PER_SEC / (RATE * after) - 1) * 1e9;
+  check("trim: applied after its latency in whole steps",
+        before == start && fabs(ppb - 2000) < 1e-3);
+}
+
+int main(void)
+{
+  check_conversions(0);
+  check_conversions(100);
+  check_conversions(-100);
+  check_reference();
+  check_ratio();
+  check_trim();
+  printf("%s\n", failed ? "FAIL" : "PASS");
+  return 0;
+}
@@ -0,0 +1,10 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+/* Minimal stand-in for the XMOS tools' xccompat.h so that the endpoint's
+   C sources can be built with a host compiler */
+#ifndef __host_xccompat_h__
+#define __host_xccompat_h__
+
+#define REFERENCE_PARAM(type, name) type *name
+#define NULLABLE_REFERENCE_PARAM(type, name) type *name
+
+#endif
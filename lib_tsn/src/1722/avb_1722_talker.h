@@ -13,6 +13,7 @@
 #include "default_avb_conf.h"
 #include "gptp.h"
 #include "audio_buffering.h"
+#include "avb_1722_listener.h"
 
 #if AVB_NUM_SOURCES > 0
 
@@ -123,6 +124,11 @@ typedef struct avb_1722_talker_state_s {
   unsigned char mac_addr[6];
   int vlan;
   struct talker_counters counters;
+#if AVB_TALKER_LOCAL_MONITOR
+  //! Each stream's packets are also played locally as a listener would
+  avb_1722_stream_info_t monitor_streams[AVB_MAX_STREAMS_PER_TALKER_UNIT];
+  int notified_buf_ctl;
+#endif
 } avb_1722_talker_state_t;
 
 #endif // AVB_NUM_SOURCES > 0
@@ -51,6 +51,13 @@ void avb_1722_maap_relinquish_addresses();
  */
 void avb_1722_maap_rerequest_addresses();
 
+/** Note when MAAP next needs its periodic function called
+ *
+ *  Its timer notes when it expires; this adds a probe or announcement
+ *  that is to be sent straight away.
+ */
+void avb_1722_maap_schedule(void);
+
 #ifdef __XC__
 /** Perform MAAP periodic functions
  *
@@ -0,0 +1,126 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stddef.h>
+#include "aem_descriptor_index.h"
+
+static aem_descriptor_entry_t *entries;
+static unsigned max_entries;
+static unsigned num_entries;
+static unsigned short type_first[AEM_DESCRIPTOR_INDEX_NUM_TYPES];
+static unsigned short type_count[AEM_DESCRIPTOR_INDEX_NUM_TYPES];
+
+void aem_descriptor_index_init(aem_descriptor_entry_t entries_storage[], unsigned size)
+{
+  entries = entries_storage;
+  max_entries = size;
+  num_entries = 0;
+  for (int t = 0; t < AEM_DESCRIPTOR_INDEX_NUM_TYPES; t++) {
+    type_first[t] = 0;
+    type_count[t] = 0;
+  }
+}
+
+int aem_descriptor_index_add(unsigned type, unsigned index,
+                             const unsigned char *descriptor, unsigned size)
+{
+  aem_descriptor_entry_t *e;
+
+  if (type >= AEM_DESCRIPTOR_INDEX_NUM_TYPES)
+    return 0;
+
+  // Only done at startup, so scan for an entry to replace
+  for (e = entries; e < &entries[num_entries]; e++) {
+    if (e->type == type && e->index == index)
+      break;
+  }
+  if (e == &entries[num_entries]) {
+    if (num_entries >= max_entries)
+      return 0;
+    num_entries++;
+  }
+  e->descriptor = descriptor;
+  e->type = type;
+  e->index = index;
+  e->size = size;
+  return 1;
+}
+
+int aem_descriptor_index_add_list(const unsigned int list[], unsigned words)
+{
+  unsigned i = 0;
+  int ok = 1;
+
+  while (i + 1 < words) {
+    unsigned type = list[i];
+    unsigned n = list[i+1];
+
+    for (unsigned j = 0, k = i + 2; j < n && k + 1 < words; j++, k += 2) {
+      const unsigned char *d = (const unsigned char *) (size_t) list[k+1];
+      unsigned index = ((unsigned) d[2] << 8) | d[3];
+      ok &= aem_descriptor_index_add(type, index, d, list[k]);
+    }
+    i += 2 + 2 * n;
+  }
+  return ok;
+}
+
+static int entry_before(const aem_descriptor_entry_t *a,
+                        const aem_descriptor_entry_t *b)
+{
+  if (a->type != b->type)
+    return a->type < b->type;
+  return a->index < b->index;
+}
+
+void aem_descriptor_index_finish(void)
+{
+  // Entries mostly arrive in order, so an insertion sort is close to linear
+  for (unsigned i = 1; i < num_entries; i++) {
+    aem_descriptor_entry_t e = entries[i];
+    unsigned j = i;
+    while (j > 0 && entry_before(&e, &entries[j-1])) {
+      entries[j] = entries[j-1];
+      j--;
+    }
+    entries[j] = e;
+  }
+
+  for (unsigned i = num_entries; i > 0; i--) {
+    unsigned t = entries[i-1].type;
+    type_first[t] = i - 1;
+    type_count[t]++;
+  }
+}
+
+const unsigned char *aem_descriptor_index_find(unsigned type, unsigned index,
+                                               unsigned *size)
+{
+  unsigned lo, hi;
+  const aem_descriptor_entry_t *e;
+
+  if (type >= AEM_DESCRIPTOR_INDEX_NUM_TYPES || type_count[type] == 0)
+    return NULL;
+
+  if (index < type_count[type]) {
+    e = &entries[type_first[type] + index];
+    if (e->index == index) {
+      *size = e->size;
+      return e->descriptor;
+    }
+  }
+
+  // The type's indices have gaps
+  lo = type_first[type];
+  hi = lo + type_count[type];
+  while (lo < hi) {
+    unsigned mid = (lo + hi) / 2;
+    if (entries[mid].index < index)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo < type_first[type] + type_count[type] && entries[lo].index == index) {
+    *size = entries[lo].size;
+    return entries[lo].descriptor;
+  }
+  return NULL;
+}
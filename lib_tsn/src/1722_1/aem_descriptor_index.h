@@ -0,0 +1,68 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef AEM_DESCRIPTOR_INDEX_H_
+#define AEM_DESCRIPTOR_INDEX_H_
+
+#include <xccompat.h>
+
+/* Lookup of AEM descriptors by type and index.
+
+   The index is built once at startup from aem_descriptor_list and the
+   descriptors rendered from templates. Entries of each type are kept in
+   index order, so a descriptor is normally found directly at the start
+   of its type's entries plus its index, with a binary search as the
+   fallback when a type's indices are not contiguous. */
+
+/** The number of descriptor types the index can hold, up to
+ *  AEM_CONTROL_BLOCK_TYPE */
+#define AEM_DESCRIPTOR_INDEX_NUM_TYPES 0x26
+
+/** The number of entries needed to index a list in the format of
+ *  aem_descriptor_list of list_words words and n more descriptors. Every
+ *  descriptor in the list takes two words, so this is never too few. */
+#define AEM_DESCRIPTOR_INDEX_ENTRIES(list_words, n) ((list_words) / 2 + (n))
+
+#ifndef __XC__
+typedef struct aem_descriptor_entry_t {
+  const unsigned char *descriptor;
+  unsigned short type;
+  unsigned short index;
+  unsigned short size;
+} aem_descriptor_entry_t;
+
+/** Remove all descriptors from the index and give it storage
+ *
+ *  \param entries  storage for the entries, see AEM_DESCRIPTOR_INDEX_ENTRIES()
+ *  \param size     the number of entries
+ */
+void aem_descriptor_index_init(aem_descriptor_entry_t entries[], unsigned size);
+
+/** Add a descriptor. Descriptors can be added in any order, but must all
+ *  be added before aem_descriptor_index_finish(). A descriptor with the
+ *  type and index of one already added replaces it.
+ *
+ *  \returns  0 if the type is out of range or the index is full
+ */
+int aem_descriptor_index_add(unsigned type, unsigned index,
+                             const unsigned char *descriptor, unsigned size);
+
+/** Add the descriptors of a list in the format of aem_descriptor_list:
+ *  type, count, then size and address of each descriptor of the type.
+ *  The index of each descriptor is read from the descriptor.
+ *
+ *  \returns  0 if a descriptor could not be added
+ */
+int aem_descriptor_index_add_list(const unsigned int list[], unsigned words);
+
+/** Sort the descriptors so that they can be found */
+void aem_descriptor_index_finish(void);
+
+/** Find a descriptor.
+ *
+ *  \param size  set to the size of the descriptor in bytes
+ *  \returns     the descriptor, or NULL if there is none
+ */
+const unsigned char *aem_descriptor_index_find(unsigned type, unsigned index,
+                                               unsigned *size);
+#endif
+
+#endif /* AEM_DESCRIPTOR_INDEX_H_ */
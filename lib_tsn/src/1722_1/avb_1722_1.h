@@ -33,7 +33,8 @@ typedef union {
 void avb_1722_1_init(unsigned char macaddr[6], unsigned int serial_num);
 
 #ifdef __XC__
-/** This function performs periodic processing for 1722.1 state machines. It must be called frequently.
+/** This function performs periodic processing for 1722.1 state machines. It must be called again
+ *  by the time given by avb_1722_1_schedule(), and after each received packet.
  *
  *  \param  c_tx        a transmit chanend to the Ethernet server
  *  \param  c_ptp       a chanend to the PTP server
@@ -41,6 +42,12 @@ void avb_1722_1_init(unsigned char macaddr[6], unsigned int serial_num);
  */
 void avb_1722_1_periodic(client interface ethernet_tx_if i_eth, chanend c_ptp, client interface avb_interface i_avb);
 
+/** Note when the 1722.1 state machines next need avb_1722_1_periodic() called, with
+ *  avb_timer_wake_at(). Call this after avb_1722_1_periodic() and anything else in the same
+ *  pass that can start the state machines, such as MAAP.
+ */
+void avb_1722_1_schedule(void);
+
 /** Process a received 1722.1 packet
  *
  *  \param  buf         an array of received packet data to be processed
@@ -1,7 +1,6 @@
 // Copyright (c) 2011-2017, XMOS Ltd, All rights reserved
 #include <string.h>
 #include <print.h>
-#include "quadflashlib.h"
 #include "avb_1722_common.h"
 #include "avb_1722_1_common.h"
 #include "avb_1722_1_acmp.h"
@@ -14,6 +13,11 @@
 #include "avb_1722_1_app_hooks.h"
 #include "avb_1722_def.h"
 #include "avb_1722_1.h"
+#include "avb_1722_1_acmp_inflight.h"
+#include "avb_1722_1_acmp_batch.h"
+#include "avb_1722_1_journal.h"
+#include "aem_descriptor_types.h"
+#include <xs1.h>
 
 /* Inflight command defines */
 #define CONTROLLER  0
@@ -31,23 +35,29 @@ extern guid_t my_guid;
 
 static const unsigned char avb_1722_1_acmp_dest_addr[6] = AVB_1722_1_ACMP_DEST_MAC;
 
-// ACMP command timeouts (in centiseconds) as defined in Table 7.4 of the specification
+// ACMP command timeouts (in 100ms ticks) as defined in Table 7.4 of the specification
 static const unsigned int avb_1722_1_acmp_inflight_timeouts[] = {20, 2, 2, 45, 5, 2, 2};
 
+#define ACMP_INFLIGHT_TICK (100 * XS1_TIMER_KHZ)
+
 // Stream info lists
 avb_1722_1_acmp_listener_stream_info acmp_listener_streams[AVB_1722_1_MAX_LISTENERS];
 avb_1722_1_acmp_talker_stream_info acmp_talker_streams[AVB_1722_1_MAX_TALKERS];
 
 // Inflight command lists
-avb_1722_1_acmp_inflight_command acmp_controller_inflight_commands[AVB_1722_1_MAX_INFLIGHT_COMMANDS];
-avb_1722_1_acmp_inflight_command acmp_listener_inflight_commands[AVB_1722_1_MAX_INFLIGHT_COMMANDS];
+extern avb_1722_1_acmp_inflight_command acmp_controller_inflight_commands[AVB_1722_1_MAX_INFLIGHT_COMMANDS];
+extern avb_1722_1_acmp_inflight_command acmp_listener_inflight_commands[AVB_1722_1_MAX_INFLIGHT_COMMANDS];
 
-static unsigned acmp_centisecond_counter[2];
-static avb_timer acmp_inflight_timer[2];
+static unsigned acmp_inflight_tick_time[2];
 
 // Controller command
 avb_1722_1_acmp_cmd_resp acmp_controller_cmd_resp;
 
+// Controller responses waiting to be handled
+static avb_1722_1_acmp_cmd_resp acmp_controller_responses[AVB_1722_1_MAX_INFLIGHT_COMMANDS];
+static unsigned acmp_controller_response_head;
+static unsigned acmp_controller_num_responses;
+
 // Talker's rcvdCmdResp
 avb_1722_1_acmp_cmd_resp acmp_talker_rcvd_cmd_resp;
 
@@ -66,13 +76,14 @@ void acmp_zero_listener_stream_info(int unique_id);
 void avb_1722_1_acmp_controller_init()
 {
     acmp_controller_state = ACMP_CONTROLLER_WAITING;
-    memset(acmp_controller_inflight_commands, 0, sizeof(avb_1722_1_acmp_inflight_command) * AVB_1722_1_MAX_INFLIGHT_COMMANDS);
+    acmp_inflight_init(CONTROLLER);
+    acmp_batch_init();
+    acmp_controller_response_head = 0;
+    acmp_controller_num_responses = 0;
 
     sequence_id[CONTROLLER] = 0;
 
-    init_avb_timer(&acmp_inflight_timer[CONTROLLER], 10);
-    acmp_centisecond_counter[CONTROLLER] = 0;
-    start_avb_timer(&acmp_inflight_timer[CONTROLLER], 1);
+    acmp_inflight_tick_time[CONTROLLER] = get_local_time();
 }
 
 void avb_1722_1_acmp_controller_deinit()
@@ -89,15 +100,13 @@ void avb_1722_1_acmp_listener_init()
 {
     int i;
     acmp_listener_state = ACMP_LISTENER_WAITING;
-    memset(acmp_listener_inflight_commands, 0, sizeof(avb_1722_1_acmp_inflight_command) * AVB_1722_1_MAX_INFLIGHT_COMMANDS);
+    acmp_inflight_init(LISTENER);
 
     for (i = 0; i < AVB_1722_1_MAX_LISTENERS; i++) acmp_zero_listener_stream_info(i);
 
     sequence_id[LISTENER] = 0;
 
-    init_avb_timer(&acmp_inflight_timer[LISTENER], 10);
-    acmp_centisecond_counter[LISTENER] = 0;
-    start_avb_timer(&acmp_inflight_timer[LISTENER], 1);
+    acmp_inflight_tick_time[LISTENER] = get_local_time();
 }
 
 /**
@@ -125,113 +134,105 @@ void avb_1722_1_create_acmp_packet(avb_1722_1_acmp_cmd_resp *cr, int message_typ
 
 void acmp_progress_inflight_timer(int entity_type)
 {
-    if (avb_timer_expired(&acmp_inflight_timer[entity_type]))
+    unsigned now = get_local_time();
+
+    // Catch up on every tick that has passed since the last call
+    while ((int)(now - acmp_inflight_tick_time[entity_type]) >= ACMP_INFLIGHT_TICK)
     {
-        acmp_centisecond_counter[entity_type]++;
-        start_avb_timer(&acmp_inflight_timer[entity_type], 1);
+        acmp_inflight_tick_time[entity_type] += ACMP_INFLIGHT_TICK;
+        acmp_inflight_tick(entity_type);
     }
 }
 
-/*
- * Returns a pointer to the correct inflight command list for a talker/listener/controller
- */
-static avb_1722_1_acmp_inflight_command *acmp_get_inflight_list(int entity_type)
+void avb_1722_1_acmp_schedule(void)
 {
-    avb_1722_1_acmp_inflight_command *inflight;
+    // A state other than waiting has work for the next periodic call
+#if (AVB_1722_1_CONTROLLER_ENABLED)
+    if (acmp_controller_state != ACMP_CONTROLLER_IDLE)
+    {
+        int can_send = acmp_inflight_next_free(CONTROLLER, sequence_id[CONTROLLER]) >= 0;
 
-#ifdef AVB_1722_1_ENABLE_ASSERTIONS
-    assert(entity_type == CONTROLLER || entity_type == LISTENER);
+        if (acmp_controller_state != ACMP_CONTROLLER_WAITING ||
+            acmp_controller_num_responses != 0 ||
+            (can_send && (acmp_inflight_queue_count() || acmp_batch_running())))
+        {
+            avb_timer_wake_now();
+        }
+        else if (acmp_inflight_count(CONTROLLER))
+        {
+            avb_timer_wake_at(acmp_inflight_tick_time[CONTROLLER] + ACMP_INFLIGHT_TICK);
+        }
+    }
 #endif
-
-    switch (entity_type)
+#if (AVB_1722_1_TALKER_ENABLED)
+    if (acmp_talker_state != ACMP_TALKER_IDLE && acmp_talker_state != ACMP_TALKER_WAITING)
     {
-        case CONTROLLER: inflight = &acmp_controller_inflight_commands[0]; break;
-        case LISTENER: inflight = &acmp_listener_inflight_commands[0]; break;
+        avb_timer_wake_now();
     }
-
-    return inflight;
-}
-
-/*
- * Returns the index into the inflight list for a specific received command's sequence id
- *
- * Returns -1 if the sequence id is not found in the list
- */
-static int acmp_get_inflight_from_sequence_id(int entity_type, unsigned short id)
-{
-    int i;
-    avb_1722_1_acmp_inflight_command *inflight = acmp_get_inflight_list(entity_type);
-
-    for (i = 0; i < AVB_1722_1_MAX_INFLIGHT_COMMANDS; ++i)
+#endif
+#if (AVB_1722_1_LISTENER_ENABLED)
+    if (acmp_listener_state != ACMP_LISTENER_IDLE)
     {
-        if (inflight[i].in_use && (inflight[i].command.sequence_id == id))
+        if (acmp_listener_state != ACMP_LISTENER_WAITING)
         {
-            return i;
+            avb_timer_wake_now();
+        }
+        else if (acmp_inflight_count(LISTENER))
+        {
+            avb_timer_wake_at(acmp_inflight_tick_time[LISTENER] + ACMP_INFLIGHT_TICK);
         }
     }
-
-    return -1;
+#endif
 }
 
 /**
- * Sets the timeout field of an inflight command to the current time plus offset for
- * the particular message type
+ * Returns the timeout in ticks for a command message type
  */
-static void acmp_update_inflight_timeout(int entity_type, avb_1722_1_acmp_inflight_command *inflight, unsigned int message_type)
+static unsigned acmp_inflight_timeout(unsigned int message_type)
 {
     // Must check the message type is a valid value before doing the timeout array access
     if ((message_type % 2 == 0) && (message_type <= 12))
     {
-        inflight->timeout = acmp_centisecond_counter[entity_type] + avb_1722_1_acmp_inflight_timeouts[message_type/2];
-    }
-    else
-    {
-        inflight->timeout = 0;
+        return avb_1722_1_acmp_inflight_timeouts[message_type/2];
     }
+    return 0;
 }
 
-void acmp_set_inflight_retry(int entity_type, unsigned int message_type, int inflight_idx)
+int acmp_inflight_command_available(int entity_type)
 {
-    avb_1722_1_acmp_inflight_command *inflight = acmp_get_inflight_list(entity_type);
+    int next = acmp_inflight_next_free(entity_type, sequence_id[entity_type]);
 
-    acmp_update_inflight_timeout(entity_type, &inflight[inflight_idx], message_type);
+    if (next < 0) return 0;
+    sequence_id[entity_type] = next;
+    return 1;
+}
 
-    inflight[inflight_idx].retried = 1;
+void acmp_set_inflight_retry(int entity_type, unsigned int message_type, int inflight_idx)
+{
+    acmp_inflight_retry(entity_type, inflight_idx, acmp_inflight_timeout(message_type));
 }
 
 void acmp_add_inflight(int entity_type, unsigned int message_type, unsigned short original_sequence_id)
 {
-    int i;
-    avb_1722_1_acmp_inflight_command *inflight = acmp_get_inflight_list(entity_type);
+    avb_1722_1_acmp_cmd_resp *command;
 
-    for (i = 0; i < AVB_1722_1_MAX_INFLIGHT_COMMANDS; i++)
+    switch (entity_type)
     {
-        if (inflight[i].in_use) continue;
-
-        inflight[i].in_use = 1;
-        inflight[i].retried = 0;
-
-        switch (entity_type)
-        {
-            case CONTROLLER: inflight[i].command = acmp_controller_cmd_resp; break;
-            case LISTENER: inflight[i].command = acmp_listener_rcvd_cmd_resp; break;
-        }
-
-        inflight[i].command.message_type = message_type;
-        inflight[i].original_sequence_id = original_sequence_id;
-
-        acmp_update_inflight_timeout(entity_type, &inflight[i], message_type);
-
-        return;
+        case CONTROLLER: command = &acmp_controller_cmd_resp; break;
+        case LISTENER: command = &acmp_listener_rcvd_cmd_resp; break;
     }
 
-    // TODO: Return error if inflight command list is full
+    // The ticks only advance when the task wakes, so count the ones it
+    // slept through before timing the command from them
+    acmp_progress_inflight_timer(entity_type);
+
+    // acmp_send_command only sends a command when its entry is free
+    acmp_inflight_add(entity_type, command, message_type, original_sequence_id, acmp_inflight_timeout(message_type));
 }
 
 avb_1722_1_acmp_inflight_command *acmp_remove_inflight(int entity_type)
 {
     avb_1722_1_acmp_cmd_resp *acmp_command;
-    avb_1722_1_acmp_inflight_command *inflight = acmp_get_inflight_list(entity_type);
     int index;
     avb_1722_1_acmp_inflight_command *result = 0;
 
@@ -241,12 +242,12 @@ avb_1722_1_acmp_inflight_command *acmp_remove_inflight(int entity_type)
         case LISTENER: acmp_command = &acmp_listener_rcvd_cmd_resp; break;
     }
 
-    index = acmp_get_inflight_from_sequence_id(entity_type, acmp_command->sequence_id);
+    index = acmp_inflight_find(entity_type, acmp_command->sequence_id);
 
     if (index >= 0)
     {
-        inflight[index].in_use = 0;
-        result = &inflight[index];
+        acmp_inflight_free(entity_type, index);
+        result = (entity_type == CONTROLLER) ? &acmp_controller_inflight_commands[index] : &acmp_listener_inflight_commands[index];
     }
     else
     {
@@ -262,18 +263,7 @@ avb_1722_1_acmp_inflight_command *acmp_remove_inflight(int entity_type)
 
 int acmp_check_inflight_command_timeouts(int entity_type)
 {
-    int i;
-    avb_1722_1_acmp_inflight_command *inflight = acmp_get_inflight_list(entity_type);
-
-    for (i = 0; i < AVB_1722_1_MAX_INFLIGHT_COMMANDS; i++)
-    {
-        if (inflight[i].in_use)
-        {
-            if (acmp_centisecond_counter[entity_type] >= inflight[i].timeout) return i;
-        }
-    }
-
-    return -1;
+    return acmp_inflight_next_timeout(entity_type);
 }
 
 void acmp_set_talker_response(void)
@@ -288,18 +278,35 @@ void acmp_set_talker_response(void)
 
 
 
-void avb_1722_1_controller_connect(const_guid_ref_t talker_guid, const_guid_ref_t listener_guid, int talker_id, int listener_id, CLIENT_INTERFACE(ethernet_if, i_eth))
+int avb_1722_1_controller_connect(const_guid_ref_t talker_guid, const_guid_ref_t listener_guid, int talker_id, int listener_id, CLIENT_INTERFACE(ethernet_if, i_eth))
+{
+    return acmp_controller_connect_disconnect(ACMP_CMD_CONNECT_RX_COMMAND, talker_guid, listener_guid, talker_id, listener_id, i_eth);
+}
+
+int avb_1722_1_controller_disconnect(const_guid_ref_t talker_guid, const_guid_ref_t listener_guid, int talker_id, int listener_id, CLIENT_INTERFACE(ethernet_if, i_eth))
+{
+    return acmp_controller_connect_disconnect(ACMP_CMD_DISCONNECT_RX_COMMAND, talker_guid, listener_guid, talker_id, listener_id, i_eth);
+}
+
+int avb_1722_1_controller_connect_batch(const avb_1722_1_acmp_connection_t connections[], unsigned num_connections)
 {
-    acmp_controller_connect_disconnect(ACMP_CMD_CONNECT_RX_COMMAND, talker_guid, listener_guid, talker_id, listener_id, i_eth);
+    return acmp_batch_start(ACMP_CMD_CONNECT_RX_COMMAND, connections, num_connections);
 }
 
-void avb_1722_1_controller_disconnect(const_guid_ref_t talker_guid, const_guid_ref_t listener_guid, int talker_id, int listener_id, CLIENT_INTERFACE(ethernet_if, i_eth))
+int avb_1722_1_controller_disconnect_batch(const avb_1722_1_acmp_connection_t connections[], unsigned num_connections)
 {
-    acmp_controller_connect_disconnect(ACMP_CMD_DISCONNECT_RX_COMMAND, talker_guid, listener_guid, talker_id, listener_id, i_eth);
+    return acmp_batch_start(ACMP_CMD_DISCONNECT_RX_COMMAND, connections, num_connections);
 }
 
-void avb_1722_1_controller_disconnect_all_listeners(int talker_id, CLIENT_INTERFACE(ethernet_if, i_eth))
+unsigned avb_1722_1_controller_batch_status(unsigned index)
 {
+    return acmp_batch_status(index);
+}
+
+int avb_1722_1_controller_disconnect_all_listeners(int talker_id, CLIENT_INTERFACE(ethernet_if, i_eth))
+{
+    int queued = 1;
+
     if (acmp_talker_streams[talker_id].stream_id.l != 0)
     {
         if (acmp_talker_streams[talker_id].connection_count > 0)
@@ -308,26 +315,32 @@ void avb_1722_1_controller_disconnect_all_listeners(int talker_id, CLIENT_INTERF
             {
                 if (acmp_talker_streams[talker_id].connected_listeners[i].guid.l != 0)
                 {
-                    avb_1722_1_controller_disconnect(&my_guid, &acmp_talker_streams[talker_id].connected_listeners[i].guid, talker_id, i, i_eth);
+                    queued &= avb_1722_1_controller_disconnect(&my_guid,
+                                                               &acmp_talker_streams[talker_id].connected_listeners[i].guid,
+                                                               talker_id,
+                                                               acmp_talker_streams[talker_id].connected_listeners[i].unique_id,
+                                                               i_eth);
                 }
             }
         }
     }
+    return queued;
 }
 
-void avb_1722_1_controller_disconnect_talker(int listener_id, CLIENT_INTERFACE(ethernet_if, i_eth))
+int avb_1722_1_controller_disconnect_talker(int listener_id, CLIENT_INTERFACE(ethernet_if, i_eth))
 {
     if (acmp_listener_streams[listener_id].stream_id.l != 0)
     {
         if (acmp_listener_streams[listener_id].connected)
         {
-            avb_1722_1_controller_disconnect(&acmp_listener_streams[listener_id].talker_guid,
-                                             &my_guid,
-                                             acmp_listener_streams[listener_id].talker_unique_id,
-                                             listener_id,
-                                             i_eth);
+            return avb_1722_1_controller_disconnect(&acmp_listener_streams[listener_id].talker_guid,
+                                                    &my_guid,
+                                                    acmp_listener_streams[listener_id].talker_unique_id,
+                                                    listener_id,
+                                                    i_eth);
         }
     }
+    return 1;
 }
 
 static void store_rcvd_cmd_resp(avb_1722_1_acmp_cmd_resp* store, avb_1722_1_acmp_packet_t* pkt)
@@ -348,99 +361,58 @@ static void store_rcvd_cmd_resp(avb_1722_1_acmp_cmd_resp* store, avb_1722_1_acmp
 }
 
 #if AVB_1722_1_FAST_CONNECT_ENABLED
+// The journal data of a sink's fast connect entry
+#define FAST_CONNECT_CONTROLLER_GUID   0
+#define FAST_CONNECT_TALKER_GUID       8
+#define FAST_CONNECT_TALKER_UNIQUE_ID  16
+
 void acmp_listener_store_fast_connect_info(int unique_id, guid_t *controller_guid, guid_t *talker_guid, unsigned short talker_unique_id)
 {
-    if (fl_readDataPage(0, (unsigned char *)avb_1722_1_buf) == 0)
-    {
-        avb_1722_1_acmp_fast_connect_persist_state *info = (avb_1722_1_acmp_fast_connect_persist_state*) &avb_1722_1_buf[0];
-        unsigned int bitfield_temp = info->info_present_bitfield;
+    unsigned char data[AVB_1722_1_JOURNAL_DATA_SIZE];
 
-        if (bitfield_temp == 0xFFFFFFFF)
-        {
-            debug_printf("First word empty\n");
-            bitfield_temp = 0;
-        }
-        else
-        {
-            fl_eraseDataSector(0);
-        }
-
-        bitfield_temp |= 1 << unique_id;
-        info->info_present_bitfield = bitfield_temp;
-        memcpy(&info->talkers[unique_id].controller_guid, controller_guid, sizeof(guid_t));
-        memcpy(&info->talkers[unique_id].talker_guid, talker_guid, sizeof(guid_t));
-        info->talkers[unique_id].talker_unique_id = talker_unique_id;
-
-        fl_writeDataPage(0, (unsigned char *)avb_1722_1_buf);
+    memset(data, 0, sizeof(data));
+    memcpy(&data[FAST_CONNECT_CONTROLLER_GUID], controller_guid, sizeof(guid_t));
+    memcpy(&data[FAST_CONNECT_TALKER_GUID], talker_guid, sizeof(guid_t));
+    memcpy(&data[FAST_CONNECT_TALKER_UNIQUE_ID], &talker_unique_id, sizeof(talker_unique_id));
 
+    if (avb_1722_1_journal_write(AVB_1722_1_JOURNAL_SINK_CONNECTION, 0, AEM_STREAM_INPUT_TYPE, unique_id, data, sizeof(data)))
+    {
         debug_printf("\nWrote fast connect for %d\n", unique_id);
     }
     else {
-        debug_printf("Couldn't read from data partition page 0\n");
+        debug_printf("Couldn't write fast connect for %d\n", unique_id);
     }
 }
 
 void acmp_listener_erase_fast_connect_info(int unique_id)
 {
-    if (fl_readDataPage(0, (unsigned char *)avb_1722_1_buf) == 0)
-    {
-        avb_1722_1_acmp_fast_connect_persist_state *info = (avb_1722_1_acmp_fast_connect_persist_state*) &avb_1722_1_buf[0];
-        unsigned int bitfield_temp = info->info_present_bitfield;
-
-        if (bitfield_temp != 0xFFFFFFFF)
-        {
-            fl_eraseDataSector(0);
-
-            bitfield_temp &= ~(1 << unique_id);
-            info->info_present_bitfield = bitfield_temp;
-            memset(&info->talkers[unique_id], 0xFF, sizeof(avb_1722_1_acmp_fast_connect_talker_info));
-
-            fl_writeDataPage(0, (unsigned char *)avb_1722_1_buf);
-
-            debug_printf("Erased fast connect for %d\n", unique_id);
-        }
-    }
-}
-
-static int acmp_listener_read_fast_connect_info(unsigned char buffer[256])
-{
-    if (fl_readDataPage(0, buffer) == 0)
-    {
-        return 0;
-    }
-    else {
-        return 1;
-    }
+    avb_1722_1_journal_erase(AVB_1722_1_JOURNAL_SINK_CONNECTION, 0, AEM_STREAM_INPUT_TYPE, unique_id);
+    debug_printf("Erased fast connect for %d\n", unique_id);
 }
 
 void acmp_start_fast_connect(CLIENT_INTERFACE(ethernet_tx_if, i_eth))
 {
-    unsigned char flash_buf[256];
+    unsigned char data[AVB_1722_1_JOURNAL_DATA_SIZE];
+    unsigned i = 0, command, descriptor_type, unique_id;
 
-    if (acmp_listener_read_fast_connect_info(flash_buf) == 0)
+    // The journal was read into memory at start up, so every sink is
+    // connected without going back to flash
+    while (avb_1722_1_journal_next(AVB_1722_1_JOURNAL_SINK_CONNECTION, &i, &command, &descriptor_type, &unique_id, data))
     {
-        avb_1722_1_acmp_fast_connect_persist_state *info = (avb_1722_1_acmp_fast_connect_persist_state*) &flash_buf[0];
-
-        if (flash_buf[3] == 0xFF) {
-            debug_printf("no data in flash\n");
-            return;
-        }
-
-        for (int i=0; i < AVB_1722_1_MAX_LISTENERS; i++)
+        if (unique_id >= AVB_1722_1_MAX_LISTENERS)
         {
-            if ((info->info_present_bitfield >> i) & 1)
-            {
-                memcpy(&acmp_listener_rcvd_cmd_resp.controller_guid, &info->talkers[i].controller_guid, sizeof(guid_t));
-                memcpy(&acmp_listener_rcvd_cmd_resp.talker_guid, &info->talkers[i].talker_guid, sizeof(guid_t));
-                memcpy(&acmp_listener_rcvd_cmd_resp.listener_guid, &my_guid, sizeof(guid_t));
-                acmp_listener_rcvd_cmd_resp.talker_unique_id = info->talkers[i].talker_unique_id;
-                acmp_listener_rcvd_cmd_resp.listener_unique_id = i;
-                acmp_listener_rcvd_cmd_resp.flags = AVB_1722_1_ACMP_FLAGS_FAST_CONNECT;
-
-                debug_printf("Issuing fast connect for %d\n", i);
-                acmp_send_command(LISTENER, ACMP_CMD_CONNECT_TX_COMMAND, &acmp_listener_rcvd_cmd_resp, FALSE, -1, i_eth);
-            }
+            continue;
         }
+
+        memcpy(&acmp_listener_rcvd_cmd_resp.controller_guid, &data[FAST_CONNECT_CONTROLLER_GUID], sizeof(guid_t));
+        memcpy(&acmp_listener_rcvd_cmd_resp.talker_guid, &data[FAST_CONNECT_TALKER_GUID], sizeof(guid_t));
+        memcpy(&acmp_listener_rcvd_cmd_resp.listener_guid, &my_guid, sizeof(guid_t));
+        memcpy(&acmp_listener_rcvd_cmd_resp.talker_unique_id, &data[FAST_CONNECT_TALKER_UNIQUE_ID], sizeof(unsigned short));
+        acmp_listener_rcvd_cmd_resp.listener_unique_id = unique_id;
+        acmp_listener_rcvd_cmd_resp.flags = AVB_1722_1_ACMP_FLAGS_FAST_CONNECT;
+
+        debug_printf("Issuing fast connect for %d\n", unique_id);
+        acmp_send_command(LISTENER, ACMP_CMD_CONNECT_TX_COMMAND, &acmp_listener_rcvd_cmd_resp, FALSE, -1, i_eth);
     }
 }
 #endif
@@ -609,18 +581,35 @@ unsigned acmp_talker_valid_talker_unique(void)
 static void process_avb_1722_1_acmp_controller_packet(unsigned char message_type, avb_1722_1_acmp_packet_t* pkt)
 {
     int inflight_index = 0;
+    unsigned i;
 
-    if (acmp_controller_state != ACMP_CONTROLLER_WAITING) return;
+    if (acmp_controller_state == ACMP_CONTROLLER_IDLE) return;
     if (compare_guid(pkt->controller_guid, &my_guid) == 0) return;
 
-    inflight_index = acmp_get_inflight_from_sequence_id(CONTROLLER, ntoh_16(pkt->sequence_id));
+    inflight_index = acmp_inflight_find(CONTROLLER, ntoh_16(pkt->sequence_id));
     if (inflight_index < 0) return; // We don't have an inflight entry for this command
 
     if (message_type != (acmp_controller_inflight_commands[inflight_index].command.message_type + 1)) return;
 
-    store_rcvd_cmd_resp(&acmp_controller_cmd_resp, pkt);
+    // Responses wait here until the controller periodic gets to them, as
+    // several can arrive between ticks with many commands in flight
+    if (acmp_controller_num_responses == AVB_1722_1_MAX_INFLIGHT_COMMANDS) return;
+    i = acmp_controller_response_head + acmp_controller_num_responses;
+    if (i >= AVB_1722_1_MAX_INFLIGHT_COMMANDS) i -= AVB_1722_1_MAX_INFLIGHT_COMMANDS;
+    store_rcvd_cmd_resp(&acmp_controller_responses[i], pkt);
+    acmp_controller_num_responses++;
+}
 
-    switch (message_type)
+int acmp_controller_next_response(void)
+{
+    if (acmp_controller_num_responses == 0) return 0;
+
+    acmp_controller_cmd_resp = acmp_controller_responses[acmp_controller_response_head];
+    acmp_controller_response_head++;
+    if (acmp_controller_response_head == AVB_1722_1_MAX_INFLIGHT_COMMANDS) acmp_controller_response_head = 0;
+    acmp_controller_num_responses--;
+
+    switch (acmp_controller_cmd_resp.message_type)
     {
         case ACMP_CMD_CONNECT_RX_RESPONSE:
             acmp_controller_state = ACMP_CONTROLLER_CONNECT_RX_RESPONSE;
@@ -643,6 +632,7 @@ static void process_avb_1722_1_acmp_controller_packet(unsigned char message_type
             break;
         }
     }
+    return 1;
 }
 
 static void process_avb_1722_1_acmp_talker_packet(unsigned char message_type, avb_1722_1_acmp_packet_t* pkt)
@@ -6,6 +6,7 @@
 #include <xccompat.h>
 #include "xc2compat.h"
 #include "avb_1722_1_acmp_pdu.h"
+#include "avb_1722_1_acmp_batch.h"
 
 #define AVB_1722_1_ACMP_DEST_MAC {0x91, 0xe0, 0xf0, 0x01, 0x00, 0x00};
 
@@ -54,7 +55,8 @@ void avb_1722_1_acmp_listener_periodic(client interface ethernet_tx_if i_eth, cl
 /** Setup a new stream connection between a Talker and Listener entity.
  *
  *  The Controller shall send a CONNECT_RX_COMMAND to the Listener Entity. The Listener Entity shall then send a
- *  CONNECT_TX_COMMAND to the Talker Entity.
+ *  CONNECT_TX_COMMAND to the Talker Entity. The command is queued and sent as soon as the Controller has
+ *  room for another command in flight.
  *
  *  \param talker_guid      the GUID of the Talker being targeted by the command
  *  \param listener_guid    the GUID of the Listener being targeted by the command
@@ -63,18 +65,20 @@ void avb_1722_1_acmp_listener_periodic(client interface ethernet_tx_if i_eth, cl
  *  \param listener_id      the unique id of the Listener stream source to connect.
  *                          For entities using AEM, this corresponds to the id of the STREAM_INPUT descriptor
  *  \param c_tx             a transmit chanend to the Ethernet server
+ *  \returns                0 if the command queue is full and the command was not sent
  *
  **/
-void avb_1722_1_controller_connect(const_guid_ref_t talker_guid,
-                                   const_guid_ref_t listener_guid,
-                                   int talker_id,
-                                   int listener_id,
-                                   CLIENT_INTERFACE(ethernet_tx_if, i_eth));
+int avb_1722_1_controller_connect(const_guid_ref_t talker_guid,
+                                  const_guid_ref_t listener_guid,
+                                  int talker_id,
+                                  int listener_id,
+                                  CLIENT_INTERFACE(ethernet_tx_if, i_eth));
 
 /** Disconnect an existing stream connection between a Talker and Listener entity.
  *
  *  The Controller shall send a DISCONNECT_RX_COMMAND to the Listener Entity. The Listener Entity shall then send a
- *  DISCONNECT_TX_COMMAND to the Talker Entity.
+ *  DISCONNECT_TX_COMMAND to the Talker Entity. The command is queued and sent as soon as the Controller has
+ *  room for another command in flight.
  *
  *  \param talker_guid      the GUID of the Talker being targeted by the command
  *  \param listener_guid    the GUID of the Listener being targeted by the command
@@ -83,13 +87,47 @@ void avb_1722_1_controller_connect(const_guid_ref_t talker_guid,
  *  \param listener_id      the unique id of the Listener stream source to disconnect.
  *                          For entities using AEM, this corresponds to the id of the STREAM_INPUT descriptor
  *  \param c_tx             a transmit chanend to the Ethernet server
+ *  \returns                0 if the command queue is full and the command was not sent
  *
  **/
-void avb_1722_1_controller_disconnect(const_guid_ref_t talker_guid,
-                                      const_guid_ref_t listener_guid,
-                                      int talker_id,
-                                      int listener_id,
-                                      CLIENT_INTERFACE(ethernet_tx_if, i_eth));
+int avb_1722_1_controller_disconnect(const_guid_ref_t talker_guid,
+                                     const_guid_ref_t listener_guid,
+                                     int talker_id,
+                                     int listener_id,
+                                     CLIENT_INTERFACE(ethernet_tx_if, i_eth));
+
+/** Connect a batch of Talker stream sources to Listener stream sinks.
+ *
+ *  A CONNECT_RX_COMMAND is sent for each connection in turn, with up to AVB_1722_1_ACMP_BATCH_WINDOW
+ *  in flight at once. avb_controller_on_batch_complete() is called when every command has had a
+ *  response or timed out. Only one batch can run at a time.
+ *
+ *  \param connections      the connections to make, which are copied
+ *  \param num_connections  the number of connections, up to AVB_1722_1_ACMP_MAX_BATCH
+ *  \returns                0 if a batch is already running or there are too many connections
+ *
+ **/
+int avb_1722_1_controller_connect_batch(const avb_1722_1_acmp_connection_t connections[], unsigned num_connections);
+
+/** Disconnect a batch of Talker stream sources from Listener stream sinks.
+ *
+ *  As avb_1722_1_controller_connect_batch(), sending a DISCONNECT_RX_COMMAND for each connection.
+ *
+ *  \param connections      the connections to remove, which are copied
+ *  \param num_connections  the number of connections, up to AVB_1722_1_ACMP_MAX_BATCH
+ *  \returns                0 if a batch is already running or there are too many connections
+ *
+ **/
+int avb_1722_1_controller_disconnect_batch(const avb_1722_1_acmp_connection_t connections[], unsigned num_connections);
+
+/** The outcome of a connection in the last batch.
+ *
+ *  \param index            the position of the connection in the batch
+ *  \returns                the ACMP status of the response, ACMP_BATCH_STATUS_TIMED_OUT if there was no
+ *                          response or ACMP_BATCH_STATUS_PENDING if the command has not finished
+ *
+ **/
+unsigned avb_1722_1_controller_batch_status(unsigned index);
 
 /** Disconnect all Listener sinks currently connected to the Talker stream source with ``talker_id``
  *
@@ -97,9 +135,10 @@ void avb_1722_1_controller_disconnect(const_guid_ref_t talker_guid,
  *  \param talker_id        the unique id of the Talker stream source to disconnect its listeners.
  *                          For entities using AEM, this corresponds to the id of the STREAM_OUTPUT descriptor
  *  \param c_tx             a transmit chanend to the Ethernet server
+ *  \returns                0 if the command queue filled up and a disconnection was not sent
  *
  **/
-void avb_1722_1_controller_disconnect_all_listeners(int talker_id, CLIENT_INTERFACE(ethernet_tx_if, i_eth));
+int avb_1722_1_controller_disconnect_all_listeners(int talker_id, CLIENT_INTERFACE(ethernet_tx_if, i_eth));
 
 
 /** Disconnect the Talker source currently connected to the Listener stream sink with ``listener_id``
@@ -108,9 +147,10 @@ void avb_1722_1_controller_disconnect_all_listeners(int talker_id, CLIENT_INTERF
  *  \param listener_id      the unique id of the Listener stream source to disconnect its Talker.
  *                          For entities using AEM, this corresponds to the id of the STREAM_INPUT descriptor
  *  \param c_tx             a transmit chanend to the Ethernet server
+ *  \returns                0 if the command queue is full and the disconnection was not sent
  *
  **/
-void avb_1722_1_controller_disconnect_talker(int listener_id, CLIENT_INTERFACE(ethernet_tx_if, i_eth));
+int avb_1722_1_controller_disconnect_talker(int listener_id, CLIENT_INTERFACE(ethernet_tx_if, i_eth));
 
 /**
  *
@@ -142,8 +182,15 @@ void avb_1722_1_talker_set_stream_id(unsigned talker_unique_id, unsigned streamI
 
 void acmp_progress_inflight_timer(int entity_type);
 
+/** Note when the ACMP state machines next need their periodic call */
+void avb_1722_1_acmp_schedule(void);
+
 int acmp_check_inflight_command_timeouts(int entity_type);
 
+int acmp_inflight_command_available(int entity_type);
+
+int acmp_controller_next_response(void);
+
 void acmp_set_talker_response(void);
 
 unsigned acmp_listener_valid_listener_unique(void);
@@ -162,7 +209,7 @@ void acmp_remove_talker_stream_info(void);
 
 unsigned acmp_talker_valid_talker_unique(void);
 
-void acmp_send_command(int entity_type, int message_type, avb_1722_1_acmp_cmd_resp *alias command, int retry, int inflight_idx, CLIENT_INTERFACE(ethernet_tx_if, i_eth));
+int acmp_send_command(int entity_type, int message_type, avb_1722_1_acmp_cmd_resp *alias command, int retry, int inflight_idx, CLIENT_INTERFACE(ethernet_tx_if, i_eth));
 void acmp_send_response(int message_type, avb_1722_1_acmp_cmd_resp *alias response, int status, CLIENT_INTERFACE(ethernet_tx_if, i_eth));
 
 #ifdef __XC__
@@ -178,7 +225,7 @@ void acmp_set_inflight_retry(int entity_type, unsigned int message_type, int inf
 
 void acmp_add_inflight(int entity_type, unsigned int message_type, unsigned short original_sequence_id);
 
-void acmp_controller_connect_disconnect(int message_type, const_guid_ref_t talker_guid, const_guid_ref_t listener_guid, int talker_id, int listener_id, CLIENT_INTERFACE(ethernet_tx_if, i_eth));
+int acmp_controller_connect_disconnect(int message_type, const_guid_ref_t talker_guid, const_guid_ref_t listener_guid, int talker_id, int listener_id, CLIENT_INTERFACE(ethernet_tx_if, i_eth));
 
 void acmp_start_fast_connect(CLIENT_INTERFACE(ethernet_tx_if, i_eth));
 
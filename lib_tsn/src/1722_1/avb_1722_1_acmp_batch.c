@@ -0,0 +1,112 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "avb_1722_1_acmp_batch.h"
+
+#define NONE  (-1)
+
+static avb_1722_1_acmp_connection_t connections[AVB_1722_1_ACMP_MAX_BATCH];
+static unsigned char status[AVB_1722_1_ACMP_MAX_BATCH];
+static unsigned batch_message_type;
+static unsigned batch_len;
+static unsigned num_sent;
+static unsigned num_inflight;
+static unsigned num_done;
+static unsigned num_failed;
+static int running;
+
+// The position in the batch of the command in each controller inflight entry
+static short owner[AVB_1722_1_MAX_INFLIGHT_COMMANDS];
+
+void acmp_batch_init(void)
+{
+  for (int i = 0; i < AVB_1722_1_MAX_INFLIGHT_COMMANDS; i++)
+    owner[i] = NONE;
+  running = 0;
+  batch_len = 0;
+  num_inflight = 0;
+  num_failed = 0;
+}
+
+int acmp_batch_start(unsigned message_type,
+                     const avb_1722_1_acmp_connection_t list[],
+                     unsigned num_connections)
+{
+  if (running || num_connections == 0 || num_connections > AVB_1722_1_ACMP_MAX_BATCH)
+    return 0;
+
+  memcpy(connections, list, num_connections * sizeof(avb_1722_1_acmp_connection_t));
+  memset(status, ACMP_BATCH_STATUS_PENDING, num_connections);
+  batch_message_type = message_type;
+  batch_len = num_connections;
+  num_sent = 0;
+  num_inflight = 0;
+  num_done = 0;
+  num_failed = 0;
+  running = 1;
+  return 1;
+}
+
+int acmp_batch_running(void)
+{
+  return running;
+}
+
+int acmp_batch_next(avb_1722_1_acmp_cmd_resp *command)
+{
+  const avb_1722_1_acmp_connection_t *c;
+
+  if (!running || num_sent == batch_len || num_inflight >= AVB_1722_1_ACMP_BATCH_WINDOW)
+    return NONE;
+
+  c = &connections[num_sent];
+  memset(command, 0, sizeof(avb_1722_1_acmp_cmd_resp));
+  command->message_type = batch_message_type;
+  command->talker_guid.l = c->talker_guid.l;
+  command->listener_guid.l = c->listener_guid.l;
+  command->talker_unique_id = c->talker_unique_id;
+  command->listener_unique_id = c->listener_unique_id;
+  return num_sent++;
+}
+
+void acmp_batch_sent(int position, int inflight_index)
+{
+  if (position < 0 || inflight_index < 0)
+    return;
+  owner[inflight_index] = position;
+  num_inflight++;
+}
+
+int acmp_batch_complete(int inflight_index, unsigned result)
+{
+  int position;
+
+  if (inflight_index < 0 || owner[inflight_index] == NONE)
+    return 0;
+
+  position = owner[inflight_index];
+  owner[inflight_index] = NONE;
+  status[position] = result;
+  num_inflight--;
+  num_done++;
+  if (result != ACMP_STATUS_SUCCESS)
+    num_failed++;
+
+  if (num_done == batch_len) {
+    running = 0;
+    return 1;
+  }
+  return 0;
+}
+
+void acmp_batch_get_result(unsigned *num_connections, unsigned *failed)
+{
+  *num_connections = batch_len;
+  *failed = num_failed;
+}
+
+unsigned acmp_batch_status(unsigned position)
+{
+  if (position >= batch_len)
+    return ACMP_BATCH_STATUS_PENDING;
+  return status[position];
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef AVB_1722_1_ACMP_BATCH_H_
+#define AVB_1722_1_ACMP_BATCH_H_
+
+#include <xccompat.h>
+#include "avb_1722_1_acmp_pdu.h"
+
+/* Batches of controller connect and disconnect commands.
+
+   A batch is a list of connections that the controller connects or
+   disconnects together, such as when a scene is recalled. Its commands
+   are sent in order, keeping up to AVB_1722_1_ACMP_BATCH_WINDOW in flight
+   at once, and each is retried once on a timeout like any other
+   controller command. When every command has had a response or timed out
+   after its retry, the batch is complete and the application is told how
+   many failed. One batch runs at a time. */
+
+/** The status of a command in a batch that has not had a response yet */
+#define ACMP_BATCH_STATUS_PENDING   0xff
+
+/** The status of a command in a batch that had no response to its retry */
+#define ACMP_BATCH_STATUS_TIMED_OUT 0xfe
+
+#if AVB_1722_1_ACMP_BATCH_WINDOW < 1
+#error "AVB_1722_1_ACMP_BATCH_WINDOW must be at least 1"
+#endif
+
+/** A connection between a Talker stream source and a Listener stream sink */
+typedef struct avb_1722_1_acmp_connection_t {
+  guid_t talker_guid;
+  guid_t listener_guid;
+  unsigned short talker_unique_id;
+  unsigned short listener_unique_id;
+} avb_1722_1_acmp_connection_t;
+
+/** Abandon any batch that is running */
+void acmp_batch_init(void);
+
+/** Start a batch. The connections are copied.
+ *
+ *  \param message_type  ACMP_CMD_CONNECT_RX_COMMAND or ACMP_CMD_DISCONNECT_RX_COMMAND
+ *  \returns             0 if a batch is already running, or there are no
+ *                       connections or more than AVB_1722_1_ACMP_MAX_BATCH
+ */
+int acmp_batch_start(unsigned message_type,
+                     const avb_1722_1_acmp_connection_t connections[],
+                     unsigned num_connections);
+
+/** Returns 1 if a batch is running */
+int acmp_batch_running(void);
+
+/** Fill in the next command of the batch to send. The controller GUID and
+ *  sequence ID are left to the sender.
+ *
+ *  \returns  the position of the command in the batch, or -1 if every
+ *            command has been sent or the window is full
+ */
+int acmp_batch_next(REFERENCE_PARAM(avb_1722_1_acmp_cmd_resp, command));
+
+/** Record the controller inflight entry a command from the batch was sent in */
+void acmp_batch_sent(int position, int inflight_index);
+
+/** Record the end of a controller inflight command: a response or a
+ *  timeout after its retry. Does nothing if the command is not part of the
+ *  batch.
+ *
+ *  \returns  1 if this completes the batch
+ */
+int acmp_batch_complete(int inflight_index, unsigned status);
+
+/** Get the outcome of the last batch.
+ *
+ *  \param num_connections  set to the number of connections in the batch
+ *  \param num_failed       set to the number that did not succeed
+ */
+void acmp_batch_get_result(REFERENCE_PARAM(unsigned, num_connections),
+                           REFERENCE_PARAM(unsigned, num_failed));
+
+/** The status of a connection in the last batch: an ACMP status, or
+ *  ACMP_BATCH_STATUS_PENDING or ACMP_BATCH_STATUS_TIMED_OUT */
+unsigned acmp_batch_status(unsigned position);
+
+#endif /* AVB_1722_1_ACMP_BATCH_H_ */
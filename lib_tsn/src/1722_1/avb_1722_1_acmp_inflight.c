@@ -0,0 +1,223 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "avb_1722_1_acmp_inflight.h"
+
+#define NUM_TABLES  2
+#define NONE        (-1)
+
+// Inflight command lists, indexed by sequence ID
+avb_1722_1_acmp_inflight_command acmp_controller_inflight_commands[AVB_1722_1_MAX_INFLIGHT_COMMANDS];
+avb_1722_1_acmp_inflight_command acmp_listener_inflight_commands[AVB_1722_1_MAX_INFLIGHT_COMMANDS];
+
+typedef struct inflight_wheel_t {
+  unsigned now;         // Ticks since the table was initialised
+  unsigned scan;        // The next tick to look for timeouts in
+  int count;
+  short head[ACMP_INFLIGHT_WHEEL_SLOTS];
+  short next[AVB_1722_1_MAX_INFLIGHT_COMMANDS];
+  short prev[AVB_1722_1_MAX_INFLIGHT_COMMANDS];
+} inflight_wheel_t;
+
+static inflight_wheel_t wheels[NUM_TABLES];
+
+static avb_1722_1_acmp_cmd_resp queue[AVB_1722_1_ACMP_CONTROLLER_QUEUE_LEN];
+static unsigned queue_head;
+static unsigned queue_count;
+
+static avb_1722_1_acmp_inflight_command *get_list(int entity_type)
+{
+  return entity_type == 0 ? acmp_controller_inflight_commands : acmp_listener_inflight_commands;
+}
+
+static void wheel_link(inflight_wheel_t *w, int index, unsigned timeout)
+{
+  int slot = timeout % ACMP_INFLIGHT_WHEEL_SLOTS;
+
+  w->prev[index] = NONE;
+  w->next[index] = w->head[slot];
+  if (w->head[slot] != NONE)
+    w->prev[w->head[slot]] = index;
+  w->head[slot] = index;
+}
+
+static void wheel_unlink(inflight_wheel_t *w, int index, unsigned timeout)
+{
+  int slot = timeout % ACMP_INFLIGHT_WHEEL_SLOTS;
+
+  if (w->prev[index] != NONE)
+    w->next[w->prev[index]] = w->next[index];
+  else if (w->head[slot] == index)
+    w->head[slot] = w->next[index];
+  else
+    return;   // Not on the wheel
+  if (w->next[index] != NONE)
+    w->prev[w->next[index]] = w->prev[index];
+  w->next[index] = NONE;
+  w->prev[index] = NONE;
+}
+
+void acmp_inflight_init(int entity_type)
+{
+  inflight_wheel_t *w = &wheels[entity_type];
+
+  memset(get_list(entity_type), 0, sizeof(avb_1722_1_acmp_inflight_command) * AVB_1722_1_MAX_INFLIGHT_COMMANDS);
+  w->now = 0;
+  w->scan = 0;
+  w->count = 0;
+  for (int i = 0; i < ACMP_INFLIGHT_WHEEL_SLOTS; i++)
+    w->head[i] = NONE;
+  for (int i = 0; i < AVB_1722_1_MAX_INFLIGHT_COMMANDS; i++) {
+    w->next[i] = NONE;
+    w->prev[i] = NONE;
+  }
+  if (entity_type == 0) {
+    queue_head = 0;
+    queue_count = 0;
+  }
+}
+
+void acmp_inflight_tick(int entity_type)
+{
+  wheels[entity_type].now++;
+}
+
+int acmp_inflight_available(int entity_type, unsigned short sequence_id)
+{
+  return !get_list(entity_type)[sequence_id % AVB_1722_1_MAX_INFLIGHT_COMMANDS].in_use;
+}
+
+int acmp_inflight_next_free(int entity_type, unsigned short sequence_id)
+{
+  avb_1722_1_acmp_inflight_command *list = get_list(entity_type);
+
+  for (int i = 0; i < AVB_1722_1_MAX_INFLIGHT_COMMANDS; i++) {
+    unsigned short s = sequence_id + i;
+    if (!list[s % AVB_1722_1_MAX_INFLIGHT_COMMANDS].in_use)
+      return s;
+  }
+  return -1;
+}
+
+int acmp_inflight_add(int entity_type,
+                      const avb_1722_1_acmp_cmd_resp *command,
+                      unsigned message_type,
+                      unsigned short original_sequence_id,
+                      unsigned timeout)
+{
+  inflight_wheel_t *w = &wheels[entity_type];
+  int index = command->sequence_id % AVB_1722_1_MAX_INFLIGHT_COMMANDS;
+  avb_1722_1_acmp_inflight_command *inflight = &get_list(entity_type)[index];
+
+  inflight->in_use = 1;
+  inflight->retried = 0;
+  inflight->command = *command;
+  inflight->command.message_type = message_type;
+  inflight->original_sequence_id = original_sequence_id;
+  w->count++;
+
+  // Commands that never time out are kept off the wheel
+  if (timeout) {
+    inflight->timeout = w->now + timeout;
+    wheel_link(w, index, inflight->timeout);
+  }
+  else {
+    inflight->timeout = 0;
+  }
+  return index;
+}
+
+int acmp_inflight_find(int entity_type, unsigned short sequence_id)
+{
+  int index = sequence_id % AVB_1722_1_MAX_INFLIGHT_COMMANDS;
+  avb_1722_1_acmp_inflight_command *inflight = &get_list(entity_type)[index];
+
+  if (inflight->in_use && inflight->command.sequence_id == sequence_id)
+    return index;
+  return -1;
+}
+
+void acmp_inflight_retry(int entity_type, int index, unsigned timeout)
+{
+  inflight_wheel_t *w = &wheels[entity_type];
+  avb_1722_1_acmp_inflight_command *inflight = &get_list(entity_type)[index];
+
+  wheel_unlink(w, index, inflight->timeout);
+  inflight->retried = 1;
+  if (timeout) {
+    inflight->timeout = w->now + timeout;
+    wheel_link(w, index, inflight->timeout);
+  }
+  else {
+    inflight->timeout = 0;
+  }
+}
+
+void acmp_inflight_free(int entity_type, int index)
+{
+  inflight_wheel_t *w = &wheels[entity_type];
+  avb_1722_1_acmp_inflight_command *inflight = &get_list(entity_type)[index];
+
+  if (!inflight->in_use)
+    return;
+  wheel_unlink(w, index, inflight->timeout);
+  inflight->in_use = 0;
+  w->count--;
+}
+
+int acmp_inflight_next_timeout(int entity_type)
+{
+  inflight_wheel_t *w = &wheels[entity_type];
+  avb_1722_1_acmp_inflight_command *list = get_list(entity_type);
+
+  if (w->count == 0) {
+    w->scan = w->now;
+    return -1;
+  }
+
+  // Every command on a slot is due at the same tick, or one whole
+  // turn of the wheel later if the scan has fallen behind
+  for (;;) {
+    for (int i = w->head[w->scan % ACMP_INFLIGHT_WHEEL_SLOTS]; i != NONE; i = w->next[i]) {
+      if ((int) (w->now - list[i].timeout) >= 0)
+        return i;
+    }
+    if (w->scan == w->now)
+      return -1;
+    w->scan++;
+  }
+}
+
+int acmp_inflight_count(int entity_type)
+{
+  return wheels[entity_type].count;
+}
+
+int acmp_inflight_queue_push(const avb_1722_1_acmp_cmd_resp *command)
+{
+  unsigned i = queue_head + queue_count;
+
+  if (queue_count == AVB_1722_1_ACMP_CONTROLLER_QUEUE_LEN)
+    return 0;
+  if (i >= AVB_1722_1_ACMP_CONTROLLER_QUEUE_LEN)
+    i -= AVB_1722_1_ACMP_CONTROLLER_QUEUE_LEN;
+  queue[i] = *command;
+  queue_count++;
+  return 1;
+}
+
+int acmp_inflight_queue_pop(avb_1722_1_acmp_cmd_resp *command)
+{
+  if (queue_count == 0)
+    return 0;
+  *command = queue[queue_head];
+  queue_head++;
+  if (queue_head == AVB_1722_1_ACMP_CONTROLLER_QUEUE_LEN)
+    queue_head = 0;
+  queue_count--;
+  return 1;
+}
+
+int acmp_inflight_queue_count(void)
+{
+  return queue_count;
+}
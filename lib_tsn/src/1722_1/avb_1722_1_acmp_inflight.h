@@ -0,0 +1,109 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef AVB_1722_1_ACMP_INFLIGHT_H_
+#define AVB_1722_1_ACMP_INFLIGHT_H_
+
+#include <xccompat.h>
+#include "avb_1722_1_acmp_pdu.h"
+
+/* ACMP inflight command tables.
+
+   The controller and the listener each keep a table of the commands they
+   have sent and not yet had a response to, as acmp_controller_inflight_commands
+   and acmp_listener_inflight_commands. A command is kept in the entry
+   indexed by its sequence ID modulo AVB_1722_1_MAX_INFLIGHT_COMMANDS, so a
+   response is matched without a search. Sequence IDs are handed out in
+   order and a retry keeps the ID of the command it repeats. IDs whose
+   entries are held by commands still waiting for a response are skipped,
+   so one lost command does not hold up the ones behind it; a command is
+   only held back when the table is full.
+
+   Time is counted in ticks of 100ms, the resolution of the ACMP command
+   timeouts. Commands waiting for a response are kept on a timer wheel
+   with a slot per tick, so the expired commands are found without
+   scanning the table.
+
+   Commands that a controller cannot send straight away wait in a queue of
+   AVB_1722_1_ACMP_CONTROLLER_QUEUE_LEN commands and are sent in order as
+   entries free up. */
+
+/** The number of 100ms slots on the timer wheel. Must be more than the
+ *  longest ACMP command timeout. */
+#define ACMP_INFLIGHT_WHEEL_SLOTS 64
+
+#if AVB_1722_1_MAX_INFLIGHT_COMMANDS < 1
+#error "AVB_1722_1_MAX_INFLIGHT_COMMANDS must be at least 1"
+#endif
+
+#if AVB_1722_1_ACMP_CONTROLLER_QUEUE_LEN < 1
+#error "AVB_1722_1_ACMP_CONTROLLER_QUEUE_LEN must be at least 1"
+#endif
+
+/** Remove all commands from a table and restart its tick count */
+void acmp_inflight_init(int entity_type);
+
+/** Advance the tick count of a table by one */
+void acmp_inflight_tick(int entity_type);
+
+/** Returns 1 if a command with a sequence ID has a free entry */
+int acmp_inflight_available(int entity_type, unsigned short sequence_id);
+
+/** Find the first sequence ID from sequence_id on that has a free entry.
+ *
+ *  \returns  the sequence ID, or -1 if the table is full
+ */
+int acmp_inflight_next_free(int entity_type, unsigned short sequence_id);
+
+#ifndef __XC__
+/** Add a sent command to a table. The entry for its sequence ID must be
+ *  free.
+ *
+ *  \param timeout  ticks until the command times out, or 0 for
+ *                  a command that never times out
+ *  \returns        the index of the command
+ */
+int acmp_inflight_add(int entity_type,
+                      const avb_1722_1_acmp_cmd_resp *command,
+                      unsigned message_type,
+                      unsigned short original_sequence_id,
+                      unsigned timeout);
+#endif
+
+/** Find the command waiting for a response with a sequence ID.
+ *
+ *  \returns  the index of the command, or -1 if there is none
+ */
+int acmp_inflight_find(int entity_type, unsigned short sequence_id);
+
+/** Mark a command as retried and restart its timeout */
+void acmp_inflight_retry(int entity_type, int index, unsigned timeout);
+
+/** Remove a command from a table */
+void acmp_inflight_free(int entity_type, int index);
+
+/** Find a command that has timed out. The command stays in the table
+ *  until it is retried or freed.
+ *
+ *  \returns  the index of the command, or -1 if none have timed out
+ */
+int acmp_inflight_next_timeout(int entity_type);
+
+/** The number of commands in a table */
+int acmp_inflight_count(int entity_type);
+
+/** Queue a controller command to be sent once an entry is free. The
+ *  message type is taken from the command.
+ *
+ *  \returns  0 if the queue is full
+ */
+int acmp_inflight_queue_push(REFERENCE_PARAM(const avb_1722_1_acmp_cmd_resp, command));
+
+/** Take the oldest queued controller command.
+ *
+ *  \returns  0 if the queue is empty
+ */
+int acmp_inflight_queue_pop(REFERENCE_PARAM(avb_1722_1_acmp_cmd_resp, command));
+
+/** The number of queued controller commands */
+int acmp_inflight_queue_count(void);
+
+#endif /* AVB_1722_1_ACMP_INFLIGHT_H_ */
@@ -17,6 +17,9 @@ void avb_1722_1_adp_discovery_periodic(client interface ethernet_tx_if i_eth, cl
 #endif
 int avb_1722_1_get_latest_new_entity_idx();
 
+/** Note when the ADP state machines next need their periodic call */
+void avb_1722_1_adp_schedule(void);
+
 /**
  *
  *  Start advertising information about this entity via ADP
@@ -55,6 +58,18 @@ void avb_1722_1_adp_discover_all(void);
  */
 void avb_1722_1_adp_change_ptp_grandmaster(unsigned char grandmaster[8]);
 
+/** Get the path delay of a PTP port as last polled by ADP
+ *
+ *  \param port      the PTP port number
+ *  \param pdelay    the mean path delay in ns
+ *  \param variance  the variance of the path delay estimate in ns^2
+ *
+ *  \return          1 if the port exists, otherwise 0
+ */
+int avb_1722_1_adp_get_ptp_port_pdelay(int port,
+                                       REFERENCE_PARAM(unsigned, pdelay),
+                                       REFERENCE_PARAM(unsigned, variance));
+
 /** Find a GUID within the entities list.
  *
  *  \param guid  the GUID to be found
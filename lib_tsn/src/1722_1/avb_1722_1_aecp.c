@@ -9,6 +9,7 @@
 #include <string.h>
 #include <print.h>
 #include "debug_print.h"
+#include "xassert.h"
 #include "xccompat.h"
 #include "avb_1722_1.h"
 #include "avb_1722_1_aecp_controls.h"
@@ -16,21 +17,20 @@
 #include <xs1.h>
 #include <platform.h>
 #include "avb_util.h"
-#include "ethernet_wrappers.h"
 #include "aem_descriptor_types.h"
 #if AVB_1722_1_AEM_ENABLED
 #include "aem_descriptors.h"
 #endif
 #include "aem_descriptor_structs.h"
+#include "aem_descriptor_index.h"
+#include "avb_1722_1_aecp_notify.h"
+#include "avb_1722_1_journal.h"
+#include "avb_1722_1_aecp_efu.h"
 
 extern unsigned int avb_1722_1_buf[AVB_1722_1_PACKET_SIZE_WORDS];
 extern guid_t my_guid;
 extern unsigned char my_mac_addr[6];
 
-static unsigned char aecp_flash_page_buf[FLASH_PAGE_SIZE];
-static unsigned int aecp_aa_bytes_copied;
-static unsigned int aecp_aa_flash_write_addr;
-static unsigned int aecp_aa_next_write_address;
 static int operation_id = 1234;
 
 static avb_timer aecp_aem_lock_timer;
@@ -53,6 +53,8 @@ static enum {
 } aecp_aem_controller_available_state = AECP_AEM_CONTROLLER_AVAILABLE_IDLE;
 
 static avb_timer aecp_aem_controller_available_timer;
+static avb_1722_1_aecp_packet_t aecp_notify_pkt;
+static unsigned aecp_notify_poll_time;
 static guid_t pending_controller_guid;
 static guid_t acquired_controller_guid;
 static unsigned char acquired_controller_mac[6];
@@ -69,6 +71,10 @@ static enum {
     AECP_AEM_LOCK_TIMEOUT
 } aecp_aem_state = AECP_AEM_IDLE;
 
+#if AVB_1722_1_AEM_ENABLED
+static void aem_descriptors_build_index(void);
+#endif
+
 // Called on startup to initialise certain static descriptor fields
 void avb_1722_1_aem_descriptors_init(unsigned int serial_num)
 {
@@ -111,6 +117,8 @@ void avb_1722_1_aem_descriptors_init(unsigned int serial_num)
   desc_avb_interface_0[78+7] = my_mac_addr[5];
   desc_avb_interface_0[78+8] = 0;
   desc_avb_interface_0[78+9] = 1;
+
+  aem_descriptors_build_index();
 #endif
 }
 
@@ -120,6 +128,21 @@ void avb_1722_1_aecp_aem_init(unsigned int serial_num)
   init_avb_timer(&aecp_aem_lock_timer, 100);
   init_avb_timer(&aecp_aem_controller_available_timer, 5);
 
+  // Watch the state that changes without a command from a controller
+  avb_1722_1_aecp_notify_init();
+  for (int i = 0; i < AVB_NUM_SINKS; i++)
+  {
+    avb_1722_1_aecp_notify_watch(AECP_AEM_CMD_GET_STREAM_INFO, AEM_STREAM_INPUT_TYPE, i);
+  }
+  for (int i = 0; i < AVB_NUM_SOURCES; i++)
+  {
+    avb_1722_1_aecp_notify_watch(AECP_AEM_CMD_GET_STREAM_INFO, AEM_STREAM_OUTPUT_TYPE, i);
+  }
+  for (int i = 0; i < AVB_NUM_MEDIA_CLOCKS; i++)
+  {
+    avb_1722_1_aecp_notify_watch(AECP_AEM_CMD_GET_COUNTERS, AEM_CLOCK_DOMAIN_TYPE, i);
+  }
+
   aecp_aem_state = AECP_AEM_WAITING;
 }
 
@@ -154,7 +177,7 @@ static void avb_1722_1_create_aecp_aem_response(unsigned char src_addr[6], unsig
   memcpy(aem, cmd_pkt->data.payload, command_data_len + 2);
 }
 
-#if (AVB_1722_1_AEM_ENABLED == 0)
+#if (AVB_1722_1_AEM_ENABLED == 0) || (AEM_GENERATE_DESCRIPTORS_ON_FLY == 0)
 __attribute__((unused))
 #endif
 static void generate_object_name(char *object_name, int base, int n) {
@@ -173,179 +196,223 @@ static void generate_object_name(char *object_name, int base, int n) {
   strcat(object_name, num_string);
 }
 
-static int create_aem_read_descriptor_response(unsigned int read_type,
-                                               unsigned int read_id,
-                                               unsigned char src_addr[6],
-                                               avb_1722_1_aecp_packet_t *pkt,
-                                               CLIENT_INTERFACE(avb_interface, i_avb_api),
-                                               CLIENT_INTERFACE(avb_1722_1_control_callbacks, i_1722_1_entity))
+#if AVB_1722_1_AEM_ENABLED && AEM_GENERATE_DESCRIPTORS_ON_FLY
+#if (AVB_NUM_SINKS > 0)
+#define AEM_STREAM_INPUT_BYTES (AVB_NUM_SINKS * (sizeof(desc_stream_input_0) + sizeof(aem_desc_stream_port_input_output_t)))
+#else
+#define AEM_STREAM_INPUT_BYTES 0
+#endif
+#if (AVB_NUM_SOURCES > 0)
+#define AEM_STREAM_OUTPUT_BYTES (AVB_NUM_SOURCES * (sizeof(desc_stream_output_0) + sizeof(aem_desc_stream_port_input_output_t)))
+#else
+#define AEM_STREAM_OUTPUT_BYTES 0
+#endif
+#define AEM_MAX_MAPPINGS ((AVB_NUM_MEDIA_OUTPUTS > AVB_NUM_MEDIA_INPUTS) ? AVB_NUM_MEDIA_OUTPUTS : AVB_NUM_MEDIA_INPUTS)
+
+#define AEM_RENDERED_BYTES \
+  ((AVB_NUM_MEDIA_OUTPUTS + AVB_NUM_MEDIA_INPUTS) * sizeof(aem_desc_audio_cluster_t) + \
+   AEM_STREAM_INPUT_BYTES + AEM_STREAM_OUTPUT_BYTES + \
+   (AVB_NUM_SINKS + AVB_NUM_SOURCES) * (8 + 8 * AEM_MAX_MAPPINGS))
+
+// The per channel and per stream descriptors, rendered from the templates
+// once at startup so that reads are a plain copy
+static unsigned char aem_rendered_descriptors[AEM_RENDERED_BYTES];
+
+/* Fill in a descriptor of a type generated from a template.
+ * Returns the size of the descriptor, or 0 if there is no such descriptor */
+static int aem_render_descriptor(unsigned int read_type,
+                                 unsigned int read_id,
+                                 unsigned char *descriptor)
 {
-#if AVB_1722_1_AEM_ENABLED
-  int desc_size_bytes = 0, i = 0;
-  unsigned char *descriptor = NULL;
-  int found_descriptor = 0;
+  aem_desc_audio_cluster_t *cluster = (aem_desc_audio_cluster_t *)descriptor;
+  int desc_size_bytes = 0;
 
-#if AEM_GENERATE_DESCRIPTORS_ON_FLY
   switch (read_type) {
     case AEM_AUDIO_CLUSTER_TYPE:
       if (read_id < (AVB_NUM_MEDIA_OUTPUTS+AVB_NUM_MEDIA_INPUTS)) {
-        descriptor = &desc_audio_cluster_template[0];
         desc_size_bytes = sizeof(aem_desc_audio_cluster_t);
+        memcpy(descriptor, desc_audio_cluster_template, desc_size_bytes);
       }
       break;
-#if (AVB_NUM_SOURCES > 0)
+#if (AVB_NUM_SINKS > 0)
     case AEM_STREAM_INPUT_TYPE:
       if (read_id < AVB_NUM_SINKS) {
-        descriptor = &desc_stream_input_0[0];
         desc_size_bytes = sizeof(desc_stream_input_0);
+        memcpy(descriptor, desc_stream_input_0, desc_size_bytes);
       }
       break;
     case AEM_STREAM_PORT_INPUT_TYPE:
       if (read_id < AVB_NUM_SINKS) {
-        descriptor = &desc_stream_port_input_0[0];
         desc_size_bytes = sizeof(aem_desc_stream_port_input_output_t);
+        memcpy(descriptor, desc_stream_port_input_0, desc_size_bytes);
       }
       break;
 #endif
 #if (AVB_NUM_SOURCES > 0)
     case AEM_STREAM_OUTPUT_TYPE:
       if (read_id < AVB_NUM_SOURCES) {
-        descriptor = &desc_stream_output_0[0];
         desc_size_bytes = sizeof(desc_stream_output_0);
+        memcpy(descriptor, desc_stream_output_0, desc_size_bytes);
       }
       break;
     case AEM_STREAM_PORT_OUTPUT_TYPE:
       if (read_id < AVB_NUM_SOURCES) {
-        descriptor = &desc_stream_port_output_0[0];
         desc_size_bytes = sizeof(aem_desc_stream_port_input_output_t);
+        memcpy(descriptor, desc_stream_port_output_0, desc_size_bytes);
       }
       break;
 #endif
-  }
+    case AEM_AUDIO_MAP_TYPE:
+      if (read_id < (AVB_NUM_SINKS+AVB_NUM_SOURCES))
+      {
+#if (AVB_NUM_SINKS > 0 && AVB_NUM_SOURCES > 0)
+        const int num_mappings = (read_id < AVB_NUM_SINKS) ? AVB_NUM_MEDIA_OUTPUTS/AVB_NUM_SINKS : AVB_NUM_MEDIA_INPUTS/AVB_NUM_SOURCES;
+#elif (AVB_NUM_SOURCES > 0)
+        const int num_mappings = (read_id < AVB_NUM_SOURCES) ? AVB_NUM_MEDIA_INPUTS/AVB_NUM_SOURCES : 0;
+#else
+        const int num_mappings = (read_id < AVB_NUM_SINKS) ? AVB_NUM_MEDIA_OUTPUTS/AVB_NUM_SINKS : 0;
+#endif
+        /* Since the map descriptors aren't constant size, unlike the clusters, and
+         * dependent on the number of channels, we don't use a template */
+        aem_desc_audio_map_t *audio_map = (aem_desc_audio_map_t *)descriptor;
 
-  if (descriptor != NULL)
-  {
-    aem_desc_audio_cluster_t *cluster = (aem_desc_audio_cluster_t *)descriptor;
-    char id_num = (char)read_id;
+        desc_size_bytes = 8+(num_mappings*8);
 
-    // The descriptor id is also the channel number
-    cluster->descriptor_index[1] = (uint8_t)read_id;
+        memset(audio_map, 0, desc_size_bytes);
+        hton_16(audio_map->descriptor_type, AEM_AUDIO_MAP_TYPE);
+        hton_16(audio_map->descriptor_index, read_id);
+        hton_16(audio_map->mappings_offset, 8);
+        hton_16(audio_map->number_of_mappings, num_mappings);
 
-    if ((read_type == AEM_AUDIO_CLUSTER_TYPE) || read_type == AEM_STREAM_OUTPUT_TYPE)
-    {
-      int id = (int)read_id;;
-      if (read_id >= AVB_NUM_MEDIA_OUTPUTS) {
-        id = (int)read_id - AVB_NUM_MEDIA_OUTPUTS;
-      }
-      memset(cluster->object_name, 0, 64);
-      if (read_type == AEM_AUDIO_CLUSTER_TYPE) {
-        strcpy((char *)cluster->object_name, "Channel ");
-        generate_object_name((char *)cluster->object_name, id, 0);
-      }
-      else {
-        strcpy((char *)cluster->object_name, "Output ");
-        generate_object_name((char *)cluster->object_name, id, AVB_NUM_MEDIA_INPUTS/AVB_NUM_SOURCES);
+        for (int i=0; i < num_mappings; i++)
+        {
+          hton_16(audio_map->mappings[i].mapping_stream_index, read_id % AVB_NUM_SINKS);
+          hton_16(audio_map->mappings[i].mapping_stream_channel, i);
+          hton_16(audio_map->mappings[i].mapping_cluster_offset, i);
+          hton_16(audio_map->mappings[i].mapping_cluster_channel, 0); // Single channel audio clusters
+        }
       }
-    }
-    else if (read_type == AEM_STREAM_INPUT_TYPE)
-    {
-      memset(cluster->object_name, 0, 64);
-      strcpy((char *)cluster->object_name, "Input ");
-      generate_object_name((char *)cluster->object_name, (int)id_num, AVB_NUM_MEDIA_OUTPUTS/AVB_NUM_SINKS);
-    }
+      return desc_size_bytes;
+  }
+
+  if (desc_size_bytes == 0)
+    return 0;
+
+  // The descriptor id is also the channel number
+  cluster->descriptor_index[1] = (uint8_t)read_id;
 
-    if (read_type == AEM_STREAM_PORT_OUTPUT_TYPE) {
-      aem_desc_stream_port_input_output_t *stream_port = (aem_desc_stream_port_input_output_t *)descriptor;
-      hton_16(stream_port->base_cluster, AVB_NUM_MEDIA_OUTPUTS + (read_id * AVB_NUM_MEDIA_INPUTS/AVB_NUM_SOURCES));
-      hton_16(stream_port->base_map, AVB_NUM_SOURCES + read_id);
+  if ((read_type == AEM_AUDIO_CLUSTER_TYPE) || read_type == AEM_STREAM_OUTPUT_TYPE)
+  {
+    int id = (int)read_id;
+    if (read_id >= AVB_NUM_MEDIA_OUTPUTS) {
+      id = (int)read_id - AVB_NUM_MEDIA_OUTPUTS;
     }
-    else if (read_type == AEM_STREAM_PORT_INPUT_TYPE) {
-      aem_desc_stream_port_input_output_t *stream_port = (aem_desc_stream_port_input_output_t *)descriptor;
-      hton_16(stream_port->base_cluster, read_id * AVB_NUM_MEDIA_OUTPUTS/AVB_NUM_SINKS);
-      hton_16(stream_port->base_map, read_id);
+    memset(cluster->object_name, 0, 64);
+    if (read_type == AEM_AUDIO_CLUSTER_TYPE) {
+      strcpy((char *)cluster->object_name, "Channel ");
+      generate_object_name((char *)cluster->object_name, id, 0);
+    }
+    else {
+      strcpy((char *)cluster->object_name, "Output ");
+      generate_object_name((char *)cluster->object_name, id, AVB_NUM_MEDIA_INPUTS/AVB_NUM_SOURCES);
     }
-
-    found_descriptor = 1;
   }
-  else if (read_type == AEM_AUDIO_MAP_TYPE)
+  else if (read_type == AEM_STREAM_INPUT_TYPE)
   {
-    if (read_id < (AVB_NUM_SINKS+AVB_NUM_SOURCES))
-    {
-#if (AVB_NUM_SINKS > 0 && AVB_NUM_SOURCES > 0)
-      const int num_mappings = (read_id < AVB_NUM_SINKS) ? AVB_NUM_MEDIA_OUTPUTS/AVB_NUM_SINKS : AVB_NUM_MEDIA_INPUTS/AVB_NUM_SOURCES;
-#elif (AVB_NUM_SOURCES > 0)
-      const int num_mappings = (read_id < AVB_NUM_SOURCES) ? AVB_NUM_MEDIA_INPUTS/AVB_NUM_SOURCES : 0;
-#else
-      const int num_mappings = (read_id < AVB_NUM_SINKS) ? AVB_NUM_MEDIA_OUTPUTS/AVB_NUM_SINKS : 0;
-#endif
-
-      /* Since the map descriptors aren't constant size, unlike the clusters, and
-       * dependent on the number of channels, we don't use a template */
-
-      struct ethernet_hdr_t *hdr = (ethernet_hdr_t*) &avb_1722_1_buf[0];
-      avb_1722_1_aecp_packet_t *pkt = (avb_1722_1_aecp_packet_t*) (hdr + AVB_1722_1_PACKET_BODY_POINTER_OFFSET);
-      avb_1722_1_aecp_aem_msg_t *aem = (avb_1722_1_aecp_aem_msg_t*)(pkt->data.payload);
-      unsigned char *pktptr = (unsigned char *)&(aem->command.read_descriptor_resp.descriptor);
-      aem_desc_audio_map_t *audio_map = (aem_desc_audio_map_t *)pktptr;
-
-      desc_size_bytes = 8+(num_mappings*8);
+    memset(cluster->object_name, 0, 64);
+    strcpy((char *)cluster->object_name, "Input ");
+    generate_object_name((char *)cluster->object_name, (int)read_id, AVB_NUM_MEDIA_OUTPUTS/AVB_NUM_SINKS);
+  }
 
-      memset(audio_map, 0, desc_size_bytes);
-      hton_16(audio_map->descriptor_type, AEM_AUDIO_MAP_TYPE);
-      hton_16(audio_map->descriptor_index, read_id);
-      hton_16(audio_map->mappings_offset, 8);
-      hton_16(audio_map->number_of_mappings, num_mappings);
+  if (read_type == AEM_STREAM_PORT_OUTPUT_TYPE) {
+    aem_desc_stream_port_input_output_t *stream_port = (aem_desc_stream_port_input_output_t *)descriptor;
+    hton_16(stream_port->base_cluster, AVB_NUM_MEDIA_OUTPUTS + (read_id * AVB_NUM_MEDIA_INPUTS/AVB_NUM_SOURCES));
+    hton_16(stream_port->base_map, AVB_NUM_SOURCES + read_id);
+  }
+  else if (read_type == AEM_STREAM_PORT_INPUT_TYPE) {
+    aem_desc_stream_port_input_output_t *stream_port = (aem_desc_stream_port_input_output_t *)descriptor;
+    hton_16(stream_port->base_cluster, read_id * AVB_NUM_MEDIA_OUTPUTS/AVB_NUM_SINKS);
+    hton_16(stream_port->base_map, read_id);
+  }
 
-      for (int i=0; i < num_mappings; i++)
-      {
-        hton_16(audio_map->mappings[i].mapping_stream_index, read_id % AVB_NUM_SINKS);
-        hton_16(audio_map->mappings[i].mapping_stream_channel, i);
-        hton_16(audio_map->mappings[i].mapping_cluster_offset, i);
-        hton_16(audio_map->mappings[i].mapping_cluster_channel, 0); // Single channel audio clusters
-      }
+  return desc_size_bytes;
+}
 
-      found_descriptor = 2; // 2 signifies do not copy descriptor below
+static unsigned char *aem_render_descriptors(unsigned int read_type,
+                                             unsigned int count,
+                                             unsigned char *p,
+                                             int *ok)
+{
+  for (unsigned int id = 0; id < count; id++) {
+    int size = aem_render_descriptor(read_type, id, p);
+    if (size) {
+      *ok &= aem_descriptor_index_add(read_type, id, p, size);
+      p += size;
     }
   }
-  else
-#endif
-  {
-    /* Search for the descriptor */
-    while (aem_descriptor_list[i] <= read_type)
-    {
-      int num_descriptors = aem_descriptor_list[i+1];
+  return p;
+}
 
-      if (aem_descriptor_list[i] == read_type)
-      {
-        for (int j=0, k=2; j < num_descriptors; j++, k += 2)
-        {
-          desc_size_bytes = aem_descriptor_list[i+k];
-          descriptor = (unsigned char *)aem_descriptor_list[i+k+1];
+// The descriptors aem_descriptors_build_index() renders
+#define AEM_RENDERED_DESCRIPTORS \
+  (AVB_NUM_MEDIA_OUTPUTS + AVB_NUM_MEDIA_INPUTS + 3 * (AVB_NUM_SINKS + AVB_NUM_SOURCES))
+#else
+#define AEM_RENDERED_DESCRIPTORS 0
+#endif
 
-          if (( ((unsigned)descriptor[2] << 8) | ((unsigned)descriptor[3]) ) == read_id)
-          {
-            found_descriptor = 1;
-            break;
-          }
-        }
+#if AVB_1722_1_AEM_ENABLED
+static aem_descriptor_entry_t aem_descriptor_index_entries[
+  AEM_DESCRIPTOR_INDEX_ENTRIES(sizeof(aem_descriptor_list)>>2, AEM_RENDERED_DESCRIPTORS)];
 
-      }
+/* Index every descriptor by type and index. Templated descriptors are
+ * rendered after the list so that they replace the template entries. */
+static void aem_descriptors_build_index(void)
+{
+  int ok;
 
-      i += ((num_descriptors*2)+2);
-      if (i >= (sizeof(aem_descriptor_list)>>2)) break;
-    }
+  aem_descriptor_index_init(aem_descriptor_index_entries,
+                            sizeof(aem_descriptor_index_entries)/sizeof(aem_descriptor_index_entries[0]));
+  ok = aem_descriptor_index_add_list(aem_descriptor_list, sizeof(aem_descriptor_list)>>2);
+#if AEM_GENERATE_DESCRIPTORS_ON_FLY
+  {
+    unsigned char *p = aem_rendered_descriptors;
+    p = aem_render_descriptors(AEM_AUDIO_CLUSTER_TYPE, AVB_NUM_MEDIA_OUTPUTS+AVB_NUM_MEDIA_INPUTS, p, &ok);
+    p = aem_render_descriptors(AEM_STREAM_INPUT_TYPE, AVB_NUM_SINKS, p, &ok);
+    p = aem_render_descriptors(AEM_STREAM_PORT_INPUT_TYPE, AVB_NUM_SINKS, p, &ok);
+    p = aem_render_descriptors(AEM_STREAM_OUTPUT_TYPE, AVB_NUM_SOURCES, p, &ok);
+    p = aem_render_descriptors(AEM_STREAM_PORT_OUTPUT_TYPE, AVB_NUM_SOURCES, p, &ok);
+    p = aem_render_descriptors(AEM_AUDIO_MAP_TYPE, AVB_NUM_SINKS+AVB_NUM_SOURCES, p, &ok);
   }
+#endif
+  // The index has room for every descriptor, so only a type beyond
+  // AEM_DESCRIPTOR_INDEX_NUM_TYPES in aem_descriptor_list can fail
+  if (!ok)
+    fail("AEM descriptor list has a descriptor type that cannot be indexed");
+  aem_descriptor_index_finish();
+}
+#endif
 
+static int create_aem_read_descriptor_response(unsigned int read_type,
+                                               unsigned int read_id,
+                                               unsigned char src_addr[6],
+                                               avb_1722_1_aecp_packet_t *pkt,
+                                               CLIENT_INTERFACE(avb_interface, i_avb_api),
+                                               CLIENT_INTERFACE(avb_1722_1_control_callbacks, i_1722_1_entity))
+{
+#if AVB_1722_1_AEM_ENABLED
+  unsigned desc_size_bytes = 0;
+  const unsigned char *descriptor = aem_descriptor_index_find(read_type, read_id, &desc_size_bytes);
 
-  if (found_descriptor)
+  if (descriptor != NULL)
   {
     int packet_size = sizeof(ethernet_hdr_t)+sizeof(avb_1722_1_packet_header_t)+24+desc_size_bytes;
 
     avb_1722_1_aecp_aem_msg_t *aem = (avb_1722_1_aecp_aem_msg_t*)avb_1722_1_create_aecp_response_header(src_addr, AECP_AEM_STATUS_SUCCESS, AECP_CMD_AEM_COMMAND, desc_size_bytes+16, pkt);
 
     memcpy(aem, pkt->data.payload, 6);
-    if (found_descriptor < 2) memcpy(&(aem->command.read_descriptor_resp.descriptor), descriptor, desc_size_bytes+40);
-    set_current_fields_in_descriptor(aem->command.read_descriptor_resp.descriptor, desc_size_bytes, read_type, read_id, i_avb_api, i_1722_1_entity);
+    memcpy(&(aem->command.read_descriptor_resp.descriptor), descriptor, desc_size_bytes);
+    if (AEM_DESCRIPTOR_HAS_CURRENT_FIELDS(read_type))
+      set_current_fields_in_descriptor(aem->command.read_descriptor_resp.descriptor, desc_size_bytes, read_type, read_id, i_avb_api, i_1722_1_entity);
     return packet_size;
   }
   else // Descriptor not found, send NO_SUCH_DESCRIPTOR reply
@@ -418,6 +485,21 @@ static unsigned short process_aem_cmd_acquire(avb_1722_1_aecp_packet_t *pkt, uns
       {
         *status = AECP_AEM_STATUS_BAD_ARGUMENTS;
       }
+      else if (compare_guid(pkt->controller_guid, &acquired_controller_guid) &&
+               entity_acquired_status == AEM_ENTITY_ACQUIRED_BUT_PENDING)
+      {
+        // The Controller waiting for the owner to answer takes the entity
+        *status = AECP_AEM_STATUS_SUCCESS;
+        entity_acquired_status = pending_persistent ? AEM_ENTITY_ACQUIRED_AND_PERSISTENT : AEM_ENTITY_ACQUIRED;
+        acquired_controller_guid = pending_controller_guid;
+        memcpy(acquired_controller_mac, pending_controller_mac, 6);
+        stop_avb_timer(&aecp_aem_controller_available_timer);
+        aecp_aem_controller_available_state = AECP_AEM_CONTROLLER_AVAILABLE_IDLE;
+        debug_printf("1722.1 Controller %x%x acquired entity on release\n", acquired_controller_guid.l<<32, acquired_controller_guid.l);
+
+        avb_1722_1_create_acquire_response_packet(AECP_AEM_STATUS_SUCCESS);
+        avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, 64, ETHERNET_ALL_INTERFACES);
+      }
       else if (compare_guid(pkt->controller_guid, &acquired_controller_guid))
       {
         *status = AECP_AEM_STATUS_SUCCESS;
@@ -461,11 +543,28 @@ static unsigned short process_aem_cmd_acquire(avb_1722_1_aecp_packet_t *pkt, uns
             pkt->data.aem.command.acquire_entity_cmd.owner_guid[i] = acquired_controller_guid.c[7-i];
           }
           debug_printf("1722.1 Controller %x%x acquired entity\n", acquired_controller_guid.l<<32, acquired_controller_guid.l);
-          memcpy(&acquired_controller_mac, &src_addr, 6);
+          memcpy(acquired_controller_mac, src_addr, 6);
           break;
 
         case AEM_ENTITY_ACQUIRED_BUT_PENDING:
+          // Only one Controller at a time waits for the owner to answer
+          if (compare_guid(pkt->controller_guid, &acquired_controller_guid))
+          {
+            *status = AECP_AEM_STATUS_SUCCESS;
+          }
+          else if (compare_guid(pkt->controller_guid, &pending_controller_guid))
+          {
+            *status = AECP_AEM_STATUS_IN_PROGRESS;
+          }
+          else
+          {
+            *status = AECP_AEM_STATUS_ENTITY_ACQUIRED;
+          }
 
+          for(int i=0; i < 8; i++)
+          {
+            pkt->data.aem.command.acquire_entity_cmd.owner_guid[i] = acquired_controller_guid.c[7-i];
+          }
           break;
 
         case AEM_ENTITY_ACQUIRED:
@@ -480,14 +579,14 @@ static unsigned short process_aem_cmd_acquire(avb_1722_1_aecp_packet_t *pkt, uns
             {
               pending_controller_guid.c[7-i] = pkt->controller_guid[i];
             }
-            memcpy(&pending_controller_mac, &src_addr, 6);
+            memcpy(pending_controller_mac, src_addr, 6);
             pending_controller_sequence = ntoh_16(pkt->sequence_id);
             pending_persistent = AEM_ACQUIRE_ENTITY_PERSISTENT_FLAG(&(pkt->data.aem.command.acquire_entity_cmd));
 
             aecp_controller_available_sequence++;
 
             avb_1722_1_create_controller_available_packet();
-            eth_send_packet(i_eth, (char *)avb_1722_1_buf, 64, ETHERNET_ALL_INTERFACES);
+            avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, 64, ETHERNET_ALL_INTERFACES);
 
             start_avb_timer(&aecp_aem_controller_available_timer, 12);
             aecp_aem_controller_available_state = AECP_AEM_CONTROLLER_AVAILABLE_IN_A;
@@ -526,6 +625,95 @@ static unsigned short process_aem_cmd_acquire(avb_1722_1_aecp_packet_t *pkt, uns
   return GET_1722_1_DATALENGTH(&pkt->header) - AVB_1722_1_AECP_COMMAND_DATA_OFFSET;
 }
 
+static int process_aem_cmd_register_unsolicited(avb_1722_1_aecp_packet_t *pkt,
+                                                unsigned char src_addr[6],
+                                                unsigned char *status,
+                                                unsigned short command_type)
+{
+  guid_t controller;
+
+  get_64(controller.c, pkt->controller_guid);
+
+  if (command_type == AECP_AEM_CMD_REGISTER_UNSOLICITED_NOTIFICATION)
+  {
+    // Nothing was polled while no one was registered, so poll from now on
+    if (avb_1722_1_aecp_notify_num_controllers() == 0)
+    {
+      aecp_notify_poll_time = get_local_time();
+    }
+    if (!avb_1722_1_aecp_notify_register(controller.l, src_addr))
+    {
+      *status = AECP_AEM_STATUS_NO_RESOURCES;
+    }
+  }
+  else
+  {
+    avb_1722_1_aecp_notify_deregister(controller.l);
+  }
+
+  // The response carries a flags field, which is reserved
+  memset(pkt->data.aem.command.payload, 0, 4);
+  return 4;
+}
+
+// After a successful SET command, notify the other controllers of the
+// state it changed
+static void aecp_notify_set_command(avb_1722_1_aecp_packet_t *pkt, unsigned short command_type)
+{
+  unsigned char *payload = pkt->data.aem.command.payload;
+  unsigned short get_command;
+  guid_t controller;
+
+  switch (command_type)
+  {
+    case AECP_AEM_CMD_SET_STREAM_FORMAT:
+    case AECP_AEM_CMD_SET_STREAM_INFO:
+    case AECP_AEM_CMD_SET_SAMPLING_RATE:
+    case AECP_AEM_CMD_SET_CLOCK_SOURCE:
+      get_command = command_type + 1;
+      break;
+    case AECP_AEM_CMD_START_STREAMING:
+    case AECP_AEM_CMD_STOP_STREAMING:
+      get_command = AECP_AEM_CMD_GET_STREAM_INFO;
+      break;
+    default:
+      return;
+  }
+
+  get_64(controller.c, pkt->controller_guid);
+  avb_1722_1_aecp_notify_changed(get_command, (unsigned short)ntoh_16(payload), (unsigned short)ntoh_16(payload + 2), controller.l);
+}
+
+#if AVB_1722_1_FAST_CONNECT_ENABLED
+// After a successful SET command, keep the state it changed in the journal
+// so that it is restored at power up
+static void aecp_journal_set_command(avb_1722_1_aecp_packet_t *pkt, unsigned short command_type)
+{
+  unsigned char *payload = pkt->data.aem.command.payload;
+  unsigned len;
+
+  switch (command_type)
+  {
+    case AECP_AEM_CMD_SET_STREAM_FORMAT:
+      len = sizeof(avb_1722_1_aem_getset_stream_format_t);
+      break;
+    case AECP_AEM_CMD_SET_SAMPLING_RATE:
+      len = sizeof(avb_1722_1_aem_getset_sampling_rate_t);
+      break;
+    case AECP_AEM_CMD_SET_CLOCK_SOURCE:
+      len = sizeof(avb_1722_1_aem_getset_clock_source_t);
+      break;
+    default:
+      return;
+  }
+
+  // The journal entry is found by the descriptor, so holds what follows it
+  avb_1722_1_journal_write(AVB_1722_1_JOURNAL_AEM_SET, command_type,
+                           ntoh_16(payload), ntoh_16(payload + 2),
+                           payload + 4, len - 4);
+}
+#endif
+
 static int process_aem_cmd_start_abort_operation(avb_1722_1_aecp_packet_t *pkt,
                                                 unsigned char src_addr[6],
                                                 unsigned char *status,
@@ -577,7 +765,10 @@ static int process_aem_cmd_start_abort_operation(avb_1722_1_aecp_packet_t *pkt,
             if ((result > 0) && (get_local_time() - t >= in_progress_msg_interval_ms)) {
               t = get_local_time();
               avb_1722_1_create_aecp_aem_response(src_addr, AECP_AEM_STATUS_IN_PROGRESS, GET_1722_1_DATALENGTH(&pkt->header), pkt);
-              eth_send_packet(i_eth, (char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
+              avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
+              // The task is blocked here, so the queue would not be sent
+              // until flash is ready
+              avb_1722_1_flush(i_eth);
             }
           } while (result > 0);
 
@@ -591,7 +782,7 @@ static int process_aem_cmd_start_abort_operation(avb_1722_1_aecp_packet_t *pkt,
         }
 
         avb_1722_1_create_aecp_aem_response(src_addr, *status, GET_1722_1_DATALENGTH(&pkt->header), pkt);
-        eth_send_packet(i_eth, (char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
+        avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
 
         return 0;
         break;
@@ -601,8 +792,24 @@ static int process_aem_cmd_start_abort_operation(avb_1722_1_aecp_packet_t *pkt,
       {
         hton_16(cmd->operation_id, operation_id++);
 
+        // There is nothing to store before an upload has started
+        if (!avb_upgrade_image_started()) {
+          *status = AECP_AEM_STATUS_BAD_ARGUMENTS;
+          avb_1722_1_create_aecp_aem_response(src_addr, *status, GET_1722_1_DATALENGTH(&pkt->header), pkt);
+          avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
+          return 0;
+        }
+
+        // Program the pages still waiting before the image is used
+        if (end_write_upgrade_image() != 0) {
+          *status = AECP_AEM_STATUS_ENTITY_MISBEHAVING;
+          avb_1722_1_create_aecp_aem_response(src_addr, *status, GET_1722_1_DATALENGTH(&pkt->header), pkt);
+          avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
+          return 0;
+        }
+
         avb_1722_1_create_aecp_aem_response(src_addr, AECP_AEM_STATUS_SUCCESS, GET_1722_1_DATALENGTH(&pkt->header), pkt);
-        eth_send_packet(i_eth, (char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
+        avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
 
         avb_1722_1_aecp_aem_msg_t *aem_msg = &(pkt->data.aem);
         AEM_MSG_SET_U_FLAG(aem_msg, 1);
@@ -611,7 +818,7 @@ static int process_aem_cmd_start_abort_operation(avb_1722_1_aecp_packet_t *pkt,
 
         hton_16(resp->percent_complete, 1000);
         avb_1722_1_create_aecp_aem_response(src_addr, AECP_AEM_STATUS_SUCCESS, GET_1722_1_DATALENGTH(&pkt->header), pkt);
-        eth_send_packet(i_eth, (char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
+        avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
 
         if (operation_type == AEM_MEMORY_OBJECT_OPERATION_STORE_AND_REBOOT) {
           *reboot = 1;
@@ -628,9 +835,7 @@ static int process_aem_cmd_start_abort_operation(avb_1722_1_aecp_packet_t *pkt,
   }
   else if (command_type == AECP_AEM_CMD_ABORT_OPERATION)
   {
-    aecp_aa_bytes_copied = 0;
-    aecp_aa_flash_write_addr = 0;
-    aecp_aa_next_write_address = 0;
+    abort_write_upgrade_image();
   }
   else
   {
@@ -692,7 +897,7 @@ static void process_avb_1722_1_aecp_aem_msg(avb_1722_1_aecp_packet_t *pkt,
 
         if (num_tx_bytes < 64) num_tx_bytes = 64;
 
-        eth_send_packet(i_eth, (char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
+        avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
 
         break;
       }
@@ -705,9 +910,9 @@ static void process_avb_1722_1_aecp_aem_msg(avb_1722_1_aecp_packet_t *pkt,
 
         if (desc_id == 0)
         {
-          unsigned int pdelay;
+          unsigned int pdelay, pdelay_variance;
           get_avb_ptp_gm(&cmd->as_grandmaster_id[0]);
-          get_avb_ptp_port_pdelay(0, &pdelay);
+          get_avb_ptp_port_pdelay(0, &pdelay, &pdelay_variance);
           hton_32(cmd->propagation_delay, pdelay);
           hton_16(cmd->msrp_mappings_count, 1);
           cmd->msrp_mappings[0] = AVB_SRP_SRCLASS_DEFAULT;
@@ -774,6 +979,12 @@ static void process_avb_1722_1_aecp_aem_msg(avb_1722_1_aecp_packet_t *pkt,
         cd_len = sizeof(avb_1722_1_aem_get_counters_t);
         break;
       }
+      case AECP_AEM_CMD_REGISTER_UNSOLICITED_NOTIFICATION:
+      case AECP_AEM_CMD_DEREGISTER_UNSOLICITED_NOTIFICATION:
+      {
+        cd_len = process_aem_cmd_register_unsolicited(pkt, src_addr, &status, command_type);
+        break;
+      }
       case AECP_AEM_CMD_START_OPERATION:
       case AECP_AEM_CMD_ABORT_OPERATION:
       {
@@ -789,11 +1000,19 @@ static void process_avb_1722_1_aecp_aem_msg(avb_1722_1_aecp_packet_t *pkt,
         status = AECP_AEM_STATUS_NOT_IMPLEMENTED;
         avb_1722_1_aecp_aem_msg_t *aem = (avb_1722_1_aecp_aem_msg_t*)avb_1722_1_create_aecp_response_header(src_addr, status, AECP_CMD_AEM_COMMAND, GET_1722_1_DATALENGTH(&pkt->header), pkt);
         memcpy(aem, pkt->data.payload, num_pkt_bytes - AVB_1722_1_AECP_PAYLOAD_OFFSET);
-        eth_send_packet(i_eth, (char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
+        avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
         return;
       }
     }
 
+    if (status == AECP_AEM_STATUS_SUCCESS)
+    {
+      aecp_notify_set_command(pkt, command_type);
+#if AVB_1722_1_FAST_CONNECT_ENABLED
+      aecp_journal_set_command(pkt, command_type);
+#endif
+    }
+
     // Send a response if required
     if (cd_len > 0)
     {
@@ -844,10 +1063,11 @@ static void process_avb_1722_1_aecp_aem_msg(avb_1722_1_aecp_packet_t *pkt,
 
     if (num_tx_bytes < 64) num_tx_bytes = 64;
 
-    eth_send_packet(i_eth, (char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
+    avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
   }
   if (reboot) {
     avb_1722_1_adp_depart_immediately(i_eth);
+    avb_1722_1_flush(i_eth);
     waitfor(10000); // Wait for the response packet to egress
     device_reboot();
   }
@@ -872,52 +1092,11 @@ static void process_avb_1722_1_aecp_address_access_cmd(avb_1722_1_aecp_packet_t
   if (tlv_count != 1 || mode != AECP_AA_MODE_WRITE) {
     status = AECP_AA_STATUS_TLV_INVALID;
   }
-  else if (aecp_aa_next_write_address != address) {
+  else if (avb_write_upgrade_image(address, aa_cmd->data, length) != 0) {
     // We currently only process address writes in order and do not allow an
     // address to be written to twice
     status = AECP_AA_STATUS_ADDRESS_INVALID;
   }
-  else {
-    int bytes_available = length + aecp_aa_bytes_copied;
-    unsigned int packet_index = 0;
-
-    do {
-      if (aecp_aa_bytes_copied == 0) {
-        if (packet_index == 0) {
-          avb_write_upgrade_image_page(aecp_aa_flash_write_addr, aa_cmd->data, &status);
-          packet_index += FLASH_PAGE_SIZE;
-          aecp_aa_flash_write_addr += FLASH_PAGE_SIZE;
-          bytes_available -= FLASH_PAGE_SIZE;
-        }
-        else if (packet_index + FLASH_PAGE_SIZE > length) {
-          memcpy(aecp_flash_page_buf, &aa_cmd->data[packet_index], bytes_available);
-          aecp_aa_bytes_copied += bytes_available;
-          bytes_available = 0;
-          packet_index = 0;
-        }
-        else if (packet_index + FLASH_PAGE_SIZE <= length) {
-          avb_write_upgrade_image_page(aecp_aa_flash_write_addr, (unsigned char *)&aa_cmd->data[packet_index], &status);
-          packet_index += FLASH_PAGE_SIZE;
-          aecp_aa_flash_write_addr += FLASH_PAGE_SIZE;
-          bytes_available -= FLASH_PAGE_SIZE;
-        }
-      }
-      else if (aecp_aa_bytes_copied == FLASH_PAGE_SIZE) {
-          avb_write_upgrade_image_page(aecp_aa_flash_write_addr, (unsigned char *)aecp_flash_page_buf, &status);
-          aecp_aa_flash_write_addr += FLASH_PAGE_SIZE;
-          bytes_available -= FLASH_PAGE_SIZE;
-          aecp_aa_bytes_copied = 0;
-      }
-      else {
-        int bytes_to_copy = FLASH_PAGE_SIZE - aecp_aa_bytes_copied;
-        memcpy(&aecp_flash_page_buf[aecp_aa_bytes_copied], &aa_cmd->data[packet_index], bytes_to_copy);
-        aecp_aa_bytes_copied += bytes_to_copy;
-        packet_index += bytes_to_copy;
-      }
-    } while(bytes_available > 0);
-
-    aecp_aa_next_write_address += length;
-  }
 
   cd_len = GET_1722_1_DATALENGTH(&pkt->header);
 
@@ -928,7 +1107,7 @@ static void process_avb_1722_1_aecp_address_access_cmd(avb_1722_1_aecp_packet_t
   unsigned num_tx_bytes = num_pkt_bytes + sizeof(ethernet_hdr_t);
 
   if (num_tx_bytes < 64) num_tx_bytes = 64;
-  eth_send_packet(i_eth, (char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
+  avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
 }
 
 
@@ -976,7 +1155,158 @@ void process_avb_1722_1_aecp_packet(unsigned char src_addr[6],
   }
 }
 
-void avb_1722_1_aecp_aem_periodic(CLIENT_INTERFACE(ethernet_tx_if, i_eth))
+// Render the GET response a notification reports into aecp_notify_pkt
+static int aecp_notify_render(unsigned command_type,
+                              unsigned desc_type,
+                              unsigned desc_index,
+                              unsigned char *status,
+                              CLIENT_INTERFACE(avb_interface, i_avb))
+{
+  avb_1722_1_aecp_aem_msg_t *aem_msg = &aecp_notify_pkt.data.aem;
+
+  set_64(aecp_notify_pkt.target_guid, my_guid.c);
+  memset(aem_msg, 0, sizeof(avb_1722_1_aecp_aem_msg_t));
+  AEM_MSG_SET_COMMAND_TYPE(aem_msg, command_type);
+  hton_16(aem_msg->command.payload, desc_type);
+  hton_16(aem_msg->command.payload + 2, desc_index);
+  *status = AECP_AEM_STATUS_SUCCESS;
+
+  switch (command_type)
+  {
+    case AECP_AEM_CMD_GET_STREAM_INFO:
+      process_aem_cmd_getset_stream_info(&aecp_notify_pkt, status, command_type, i_avb);
+      return sizeof(avb_1722_1_aem_getset_stream_info_t);
+    case AECP_AEM_CMD_GET_STREAM_FORMAT:
+      process_aem_cmd_getset_stream_format(&aecp_notify_pkt, status, command_type, i_avb);
+      return sizeof(avb_1722_1_aem_getset_stream_format_t);
+    case AECP_AEM_CMD_GET_SAMPLING_RATE:
+      process_aem_cmd_getset_sampling_rate(&aecp_notify_pkt, status, command_type, i_avb);
+      return sizeof(avb_1722_1_aem_getset_sampling_rate_t);
+    case AECP_AEM_CMD_GET_CLOCK_SOURCE:
+      process_aem_cmd_getset_clock_source(&aecp_notify_pkt, status, command_type, i_avb);
+      return sizeof(avb_1722_1_aem_getset_clock_source_t);
+    case AECP_AEM_CMD_GET_COUNTERS:
+      process_aem_cmd_get_counters(&aecp_notify_pkt, status, i_avb);
+      return sizeof(avb_1722_1_aem_get_counters_t);
+    default:
+      return 0;
+  }
+}
+
+#if AVB_1722_1_FAST_CONNECT_ENABLED
+void avb_1722_1_aecp_aem_restore(CLIENT_INTERFACE(avb_interface, i_avb))
+{
+  avb_1722_1_aecp_aem_msg_t *aem_msg = &aecp_notify_pkt.data.aem;
+  unsigned char data[AVB_1722_1_JOURNAL_DATA_SIZE];
+  unsigned i = 0, command_type, desc_type, desc_index;
+  unsigned char status;
+
+  // Each SET command is applied again as a controller sent it, using the
+  // notification packet as no notifications are sent before this
+  while (avb_1722_1_journal_next(AVB_1722_1_JOURNAL_AEM_SET, &i, &command_type, &desc_type, &desc_index, data))
+  {
+    memset(aem_msg, 0, sizeof(avb_1722_1_aecp_aem_msg_t));
+    AEM_MSG_SET_COMMAND_TYPE(aem_msg, command_type);
+    hton_16(aem_msg->command.payload, desc_type);
+    hton_16(aem_msg->command.payload + 2, desc_index);
+    memcpy(aem_msg->command.payload + 4, data, AVB_1722_1_JOURNAL_DATA_SIZE);
+    status = AECP_AEM_STATUS_SUCCESS;
+
+    switch (command_type)
+    {
+      case AECP_AEM_CMD_SET_STREAM_FORMAT:
+        process_aem_cmd_getset_stream_format(&aecp_notify_pkt, &status, command_type, i_avb);
+        break;
+      case AECP_AEM_CMD_SET_SAMPLING_RATE:
+        process_aem_cmd_getset_sampling_rate(&aecp_notify_pkt, &status, command_type, i_avb);
+        break;
+      case AECP_AEM_CMD_SET_CLOCK_SOURCE:
+        process_aem_cmd_getset_clock_source(&aecp_notify_pkt, &status, command_type, i_avb);
+        break;
+      default:
+        break;
+    }
+
+    if (status != AECP_AEM_STATUS_SUCCESS)
+    {
+      debug_printf("Couldn't restore AEM command %x for descriptor %x:%d\n", command_type, desc_type, desc_index);
+    }
+  }
+}
+#endif
+
+static void avb_1722_1_aecp_aem_notify_periodic(CLIENT_INTERFACE(ethernet_tx_if, i_eth),
+                                                CLIENT_INTERFACE(avb_interface, i_avb))
+{
+  unsigned command_type, desc_type, desc_index;
+  unsigned long long origin;
+  unsigned char status;
+  unsigned now;
+  int cd_len;
+  int num_sent = 0;
+
+  if (avb_1722_1_aecp_notify_num_controllers() == 0) return;
+
+  now = get_local_time();
+
+  // Check one watched descriptor for changes made without a command
+  if ((int)(now - aecp_notify_poll_time) >= 0)
+  {
+    aecp_notify_poll_time = now + AVB_1722_1_AECP_NOTIFY_POLL_MS * XS1_TIMER_KHZ;
+    if (avb_1722_1_aecp_notify_next_watched(&command_type, &desc_type, &desc_index))
+    {
+      cd_len = aecp_notify_render(command_type, desc_type, desc_index, &status, i_avb);
+      if (status == AECP_AEM_STATUS_SUCCESS)
+        avb_1722_1_aecp_notify_update(command_type, desc_type, desc_index,
+                                      aecp_notify_pkt.data.aem.command.payload, cd_len);
+    }
+  }
+
+  if (!avb_1722_1_aecp_notify_next(now, &command_type, &desc_type, &desc_index, &origin)) return;
+
+  cd_len = aecp_notify_render(command_type, desc_type, desc_index, &status, i_avb);
+  if (status != AECP_AEM_STATUS_SUCCESS) return;
+  AEM_MSG_SET_U_FLAG(&aecp_notify_pkt.data.aem, 1);
+
+  for (int i = 0; i < AVB_1722_1_AECP_MAX_NOTIFY_CONTROLLERS; i++)
+  {
+    guid_t controller;
+    unsigned char controller_mac[6];
+    int sequence_id = avb_1722_1_aecp_notify_controller(i, origin, &controller.l, controller_mac);
+    int num_tx_bytes = cd_len +
+                            2 + // U Flag + command type
+                            AVB_1722_1_AECP_PAYLOAD_OFFSET +
+                            sizeof(ethernet_hdr_t);
+
+    if (sequence_id < 0) continue;
+
+    set_64(aecp_notify_pkt.controller_guid, controller.c);
+    hton_16(aecp_notify_pkt.sequence_id, sequence_id);
+    avb_1722_1_create_aecp_aem_response(controller_mac, status, cd_len, &aecp_notify_pkt);
+
+    if (num_tx_bytes < 64) num_tx_bytes = 64;
+
+    avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
+    num_sent++;
+  }
+
+  avb_1722_1_aecp_notify_sent(command_type, desc_type, desc_index,
+                              aecp_notify_pkt.data.aem.command.payload, cd_len, num_sent);
+}
+
+void avb_1722_1_aecp_aem_schedule(void)
+{
+  unsigned when;
+
+  if (avb_1722_1_aecp_notify_num_controllers() == 0) return;
+
+  avb_timer_wake_at(aecp_notify_poll_time);
+  if (avb_1722_1_aecp_notify_next_due(get_local_time(), &when))
+    avb_timer_wake_at(when);
+}
+
+void avb_1722_1_aecp_aem_periodic(CLIENT_INTERFACE(ethernet_tx_if, i_eth),
+                                  CLIENT_INTERFACE(avb_interface, i_avb))
 {
   char available_timeouts[5] = {12, 1, 11, 12, 2};
   if (avb_timer_expired(&aecp_aem_controller_available_timer))
@@ -1047,8 +1377,9 @@ void avb_1722_1_aecp_aem_periodic(CLIENT_INTERFACE(ethernet_tx_if, i_eth))
         num_tx_bytes = 64;
       }
 
-      eth_send_packet(i_eth, (char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
+      avb_1722_1_send(i_eth, (unsigned char *)avb_1722_1_buf, num_tx_bytes, ETHERNET_ALL_INTERFACES);
     }
   }
 
+  avb_1722_1_aecp_aem_notify_periodic(i_eth, i_avb);
 }
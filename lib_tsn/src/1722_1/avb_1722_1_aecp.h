@@ -25,12 +25,14 @@ void process_avb_1722_1_aecp_packet(unsigned char src_addr[6],
 #ifdef __XC__
 }
 #endif
-void avb_1722_1_aecp_aem_periodic(CLIENT_INTERFACE(ethernet_tx_if, i_eth));
+void avb_1722_1_aecp_aem_periodic(CLIENT_INTERFACE(ethernet_tx_if, i_eth),
+                                  CLIENT_INTERFACE(avb_interface, i_avb));
 
-void begin_write_upgrade_image(void);
+/** Note when the AECP state machines next need their periodic call */
+void avb_1722_1_aecp_aem_schedule(void);
 
-void abort_write_upgrade_image(void);
-
-int avb_write_upgrade_image_page(int address, unsigned char data[FLASH_PAGE_SIZE], REFERENCE_PARAM(unsigned short, status));
+/** Apply the AEM SET commands kept in the persistent state journal again,
+ *  restoring the stream formats and media clocks set before power down */
+void avb_1722_1_aecp_aem_restore(CLIENT_INTERFACE(avb_interface, i_avb));
 
 #endif /* AVB_1722_1_AECP_H_ */
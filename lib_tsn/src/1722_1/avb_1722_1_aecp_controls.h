@@ -7,6 +7,13 @@
 #include "avb.h"
 #include "avb_1722_1_callbacks.h"
 
+/** Non-zero for descriptor types with fields that
+ *  set_current_fields_in_descriptor() fills in on each read */
+#define AEM_DESCRIPTOR_HAS_CURRENT_FIELDS(type) \
+  ((type) == AEM_AUDIO_UNIT_TYPE || (type) == AEM_CLOCK_DOMAIN_TYPE || \
+   (type) == AEM_STREAM_INPUT_TYPE || (type) == AEM_STREAM_OUTPUT_TYPE || \
+   (type) == AEM_CONTROL_TYPE || (type) == AEM_SIGNAL_SELECTOR_TYPE)
+
 unsafe void set_current_fields_in_descriptor(unsigned char *unsafe descriptor,
                                             unsigned int desc_size_bytes,
                                             unsigned int read_type, unsigned int read_id,
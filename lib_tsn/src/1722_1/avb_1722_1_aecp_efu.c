@@ -0,0 +1,189 @@
+// Copyright (c) 2013-2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "quadflashlib.h"
+#include "avb_1722_1_aecp_efu.h"
+#include "debug_print.h"
+
+#if AVB_1722_1_EFU_BUFFERS < 1
+#error "AVB_1722_1_EFU_BUFFERS must be at least 1"
+#endif
+
+// The next address while no image has been started
+#define NO_IMAGE 0xffffffff
+
+static unsigned char efu_pages[AVB_1722_1_EFU_BUFFERS][FLASH_PAGE_SIZE];
+static unsigned efu_head;
+static unsigned efu_count;          // Whole pages waiting
+static unsigned efu_fill;           // Bytes in the page after them
+static unsigned efu_next_address = NO_IMAGE;
+static unsigned efu_received_crc;
+static avb_1722_1_efu_stats_t efu_stats;
+
+static unsigned efu_crc(unsigned crc, const unsigned char *data, unsigned len)
+{
+  for (unsigned i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+  }
+  return crc;
+}
+
+// Program the next page of the image
+static void efu_program(const unsigned char page[FLASH_PAGE_SIZE])
+{
+#if AVB_1722_1_FIRMWARE_UPGRADE_ENABLED
+  if (fl_writeImagePage(page) == 0) {
+    efu_stats.programmed++;
+    return;
+  }
+#endif
+  debug_printf("Failed to write upgrade page %d\n", efu_stats.programmed + efu_stats.failed);
+  efu_stats.failed++;
+}
+
+// Read the image stored back from flash and take the CRC-32 of its first
+// len bytes
+static int efu_read_back(unsigned len, unsigned *crc)
+{
+#if AVB_1722_1_FIRMWARE_UPGRADE_ENABLED
+  fl_BootImageInfo image;
+  unsigned char *page = efu_pages[0];
+
+  *crc = 0xffffffff;
+  if (fl_getFactoryImage(&image) != 0 ||
+      fl_getNextBootImage(&image) != 0 ||
+      fl_startImageRead(&image) != 0)
+    return 1;
+  while (len != 0) {
+    unsigned n = len < FLASH_PAGE_SIZE ? len : FLASH_PAGE_SIZE;
+    if (fl_readImagePage(page) != 0)
+      return 1;
+    *crc = efu_crc(*crc, page, n);
+    len -= n;
+  }
+  *crc = ~*crc;
+  return 0;
+#else
+  return 1;
+#endif
+}
+
+static void efu_program_front(void)
+{
+  efu_program(efu_pages[efu_head]);
+  efu_head++;
+  if (efu_head == AVB_1722_1_EFU_BUFFERS)
+    efu_head = 0;
+  efu_count--;
+}
+
+void begin_write_upgrade_image(void)
+{
+  efu_head = 0;
+  efu_count = 0;
+  efu_fill = 0;
+  efu_next_address = 0;
+  efu_received_crc = 0xffffffff;
+  memset(&efu_stats, 0, sizeof(efu_stats));
+}
+
+void abort_write_upgrade_image(void)
+{
+  efu_count = 0;
+  efu_fill = 0;
+  efu_next_address = NO_IMAGE;
+}
+
+int avb_write_upgrade_image(unsigned address, const unsigned char data[], unsigned len)
+{
+  if (address != efu_next_address)
+    return 1;
+
+  efu_received_crc = efu_crc(efu_received_crc, data, len);
+  efu_stats.received += len;
+  efu_next_address += len;
+
+  while (len != 0) {
+    unsigned slot, n = FLASH_PAGE_SIZE - efu_fill;
+
+    // Make room for the next page
+    if (efu_fill == 0 && efu_count == AVB_1722_1_EFU_BUFFERS) {
+      efu_program_front();
+      efu_stats.ring_full++;
+    }
+    slot = efu_head + efu_count;
+    if (slot >= AVB_1722_1_EFU_BUFFERS)
+      slot -= AVB_1722_1_EFU_BUFFERS;
+    if (n > len)
+      n = len;
+
+    memcpy(&efu_pages[slot][efu_fill], data, n);
+    data += n;
+    len -= n;
+    efu_fill += n;
+    if (efu_fill == FLASH_PAGE_SIZE) {
+      efu_fill = 0;
+      efu_count++;
+      if (efu_count > efu_stats.max_depth)
+        efu_stats.max_depth = efu_count;
+    }
+  }
+  return 0;
+}
+
+int avb_upgrade_image_pages_pending(void)
+{
+  return efu_count;
+}
+
+int avb_upgrade_image_program_page(void)
+{
+  if (efu_count != 0)
+    efu_program_front();
+  return efu_count;
+}
+
+int avb_upgrade_image_started(void)
+{
+  return efu_next_address != NO_IMAGE;
+}
+
+int end_write_upgrade_image(void)
+{
+  if (efu_next_address == NO_IMAGE)
+    return 1;
+
+  while (efu_count != 0)
+    efu_program_front();
+
+  // The last page is padded as erased flash
+  if (efu_fill != 0) {
+    unsigned char *page = efu_pages[efu_head];
+    memset(&page[efu_fill], 0xff, FLASH_PAGE_SIZE - efu_fill);
+    efu_program(page);
+    efu_fill = 0;
+  }
+#if AVB_1722_1_FIRMWARE_UPGRADE_ENABLED
+  if (fl_endWriteImage() != 0)
+    efu_stats.failed++;
+#endif
+  efu_next_address = NO_IMAGE;
+
+  efu_stats.received_crc = ~efu_received_crc;
+  if (efu_stats.failed == 0 && efu_read_back(efu_stats.received, &efu_stats.programmed_crc) != 0) {
+    debug_printf("Failed to read back the upgrade image\n");
+    efu_stats.failed++;
+  }
+  if (efu_stats.failed != 0 || efu_stats.received_crc != efu_stats.programmed_crc) {
+    debug_printf("Upgrade image CRC %x, programmed %x\n", efu_stats.received_crc, efu_stats.programmed_crc);
+    return 1;
+  }
+  return 0;
+}
+
+void avb_upgrade_image_get_stats(avb_1722_1_efu_stats_t *stats)
+{
+  *stats = efu_stats;
+  stats->received_crc = ~efu_received_crc;
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2013-2017, XMOS Ltd, All rights reserved
+#ifndef AVB_1722_1_AECP_EFU_H_
+#define AVB_1722_1_AECP_EFU_H_
+
+#include <xccompat.h>
+#include "avb_1722_1_default_conf.h"
+
+/* The firmware upgrade image pipeline.
+
+   The upgrade image arrives in AECP ADDRESS_ACCESS writes, in order from
+   address 0. Each write is cut into FLASH_PAGE_SIZE pages which are
+   copied into a ring of AVB_1722_1_EFU_BUFFERS pages, and the command is
+   answered straight away. The 1722.1 task programs one waiting page at a
+   time once it has no received packets to handle. Programming the flash
+   overlaps the controller's round trip to its next write, and ADP, ACMP
+   and AECP packets are handled between pages. A page is programmed before
+   the write is answered only when the ring is full.
+
+   A CRC-32 of the image is kept as it is received. Once every page is
+   programmed the image is read back from flash, and its CRC-32 must match
+   before the image is stored. */
+
+typedef struct avb_1722_1_efu_stats_t {
+  unsigned received;        //!< Image bytes received
+  unsigned programmed;      //!< Pages programmed
+  unsigned max_depth;       //!< The most pages that have waited at once
+  unsigned ring_full;       //!< Pages programmed while a write waited
+  unsigned failed;          //!< Pages the flash would not take
+  unsigned received_crc;    //!< The CRC-32 of the image received
+  unsigned programmed_crc;  //!< The CRC-32 of the image read back from flash
+} avb_1722_1_efu_stats_t;
+
+/** Start a new image at address 0, once flash is ready for it */
+void begin_write_upgrade_image(void);
+
+/** Drop the image and any pages waiting for flash */
+void abort_write_upgrade_image(void);
+
+/** Take the data of an ADDRESS_ACCESS write.
+ *
+ *  \returns  0, or 1 if the write is not at the next address or no image
+ *            has been started
+ */
+int avb_write_upgrade_image(unsigned address, const unsigned char data[], unsigned len);
+
+/** The number of pages waiting to be programmed */
+int avb_upgrade_image_pages_pending(void);
+
+/** Program the oldest waiting page.
+ *
+ *  \returns  the number of pages still waiting
+ */
+int avb_upgrade_image_program_page(void);
+
+/** Non-zero if an image has been started and not yet ended or dropped */
+int avb_upgrade_image_started(void);
+
+/** Program every waiting page and the last part page of the image, then
+ *  read the image back from flash and check it.
+ *
+ *  \returns  0 if the whole image is in flash with the CRC received, 1 if
+ *            not or if no image has been started
+ */
+int end_write_upgrade_image(void);
+
+/** Copy out the upgrade statistics */
+void avb_upgrade_image_get_stats(REFERENCE_PARAM(avb_1722_1_efu_stats_t, stats));
+
+#endif /* AVB_1722_1_AECP_EFU_H_ */
@@ -0,0 +1,311 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include <xs1.h>
+#include "avb_1722_1_aecp_notify.h"
+#include "aem_descriptor_types.h"
+
+// Flags of a tracked pair
+#define NOTIFY_WATCHED  0x1   // Polled for changes
+#define NOTIFY_DIRTY    0x2   // A notification is waiting
+#define NOTIFY_LIMITED  0x4   // Sent within the last interval
+#define NOTIFY_HAVE_SUM 0x8   // checksum holds the last response
+
+typedef struct notify_controller_t {
+  unsigned long long guid;
+  unsigned char mac[6];
+  unsigned short sequence_id;
+  int in_use;
+} notify_controller_t;
+
+typedef struct notify_entry_t {
+  unsigned short command_type;
+  unsigned short descriptor_type;
+  unsigned short descriptor_index;
+  unsigned short flags;
+  unsigned checksum;
+  unsigned next_allowed;      // When the rate limit ends, if NOTIFY_LIMITED
+  unsigned long long origin;
+} notify_entry_t;
+
+static notify_controller_t controllers[AVB_1722_1_AECP_MAX_NOTIFY_CONTROLLERS];
+static int num_controllers;
+static notify_entry_t entries[AVB_1722_1_AECP_NOTIFY_MAX_TRACKED];
+static int num_entries;
+static int next_watched;
+static unsigned intervals[AVB_1722_1_AECP_NOTIFY_NUM_TYPES];
+static avb_1722_1_aecp_notify_stats_t notify_stats;
+
+void avb_1722_1_aecp_notify_init(void)
+{
+  memset(controllers, 0, sizeof(controllers));
+  num_controllers = 0;
+  num_entries = 0;
+  next_watched = 0;
+  for (int i = 0; i < AVB_1722_1_AECP_NOTIFY_NUM_TYPES; i++)
+    intervals[i] = AVB_1722_1_AECP_NOTIFY_INTERVAL_MS * XS1_TIMER_KHZ;
+  intervals[AEM_CLOCK_DOMAIN_TYPE] = AVB_1722_1_AECP_NOTIFY_CLOCK_DOMAIN_INTERVAL_MS * XS1_TIMER_KHZ;
+  memset(&notify_stats, 0, sizeof(notify_stats));
+}
+
+static notify_controller_t *find_controller(unsigned long long guid)
+{
+  for (int i = 0; i < AVB_1722_1_AECP_MAX_NOTIFY_CONTROLLERS; i++) {
+    if (controllers[i].in_use && controllers[i].guid == guid)
+      return &controllers[i];
+  }
+  return NULL;
+}
+
+int avb_1722_1_aecp_notify_register(unsigned long long controller_guid,
+                                    const unsigned char mac[6])
+{
+  notify_controller_t *c = find_controller(controller_guid);
+
+  if (c == NULL) {
+    for (int i = 0; i < AVB_1722_1_AECP_MAX_NOTIFY_CONTROLLERS; i++) {
+      if (!controllers[i].in_use) {
+        c = &controllers[i];
+        break;
+      }
+    }
+    if (c == NULL)
+      return 0;
+    if (num_controllers == 0) {
+      // Nothing was polled or sent while no one was registered, so forget
+      // any pending changes, rate limits and stale responses
+      for (int i = 0; i < num_entries; i++)
+        entries[i].flags &= NOTIFY_WATCHED;
+    }
+    c->guid = controller_guid;
+    c->sequence_id = 0;
+    c->in_use = 1;
+    num_controllers++;
+  }
+  memcpy(c->mac, mac, 6);
+  return 1;
+}
+
+void avb_1722_1_aecp_notify_deregister(unsigned long long controller_guid)
+{
+  notify_controller_t *c = find_controller(controller_guid);
+
+  if (c != NULL) {
+    c->in_use = 0;
+    num_controllers--;
+  }
+}
+
+int avb_1722_1_aecp_notify_num_controllers(void)
+{
+  return num_controllers;
+}
+
+int avb_1722_1_aecp_notify_controller(int slot,
+                                      unsigned long long origin,
+                                      unsigned long long *controller_guid,
+                                      unsigned char mac[6])
+{
+  notify_controller_t *c = &controllers[slot];
+
+  if (!c->in_use || c->guid == origin)
+    return -1;
+  *controller_guid = c->guid;
+  memcpy(mac, c->mac, 6);
+  return c->sequence_id++;
+}
+
+void avb_1722_1_aecp_notify_set_interval(unsigned descriptor_type,
+                                         unsigned interval)
+{
+  if (descriptor_type < AVB_1722_1_AECP_NOTIFY_NUM_TYPES)
+    intervals[descriptor_type] = interval;
+}
+
+static notify_entry_t *find_entry(unsigned command_type,
+                                  unsigned descriptor_type,
+                                  unsigned descriptor_index,
+                                  int add)
+{
+  notify_entry_t *e;
+
+  for (int i = 0; i < num_entries; i++) {
+    e = &entries[i];
+    if (e->command_type == command_type &&
+        e->descriptor_type == descriptor_type &&
+        e->descriptor_index == descriptor_index)
+      return e;
+  }
+  if (!add || num_entries == AVB_1722_1_AECP_NOTIFY_MAX_TRACKED)
+    return NULL;
+
+  e = &entries[num_entries++];
+  memset(e, 0, sizeof(*e));
+  e->command_type = command_type;
+  e->descriptor_type = descriptor_type;
+  e->descriptor_index = descriptor_index;
+  return e;
+}
+
+int avb_1722_1_aecp_notify_watch(unsigned command_type,
+                                 unsigned descriptor_type,
+                                 unsigned descriptor_index)
+{
+  notify_entry_t *e = find_entry(command_type, descriptor_type, descriptor_index, 1);
+
+  if (e == NULL)
+    return 0;
+  e->flags |= NOTIFY_WATCHED;
+  return 1;
+}
+
+int avb_1722_1_aecp_notify_next_watched(unsigned *command_type,
+                                        unsigned *descriptor_type,
+                                        unsigned *descriptor_index)
+{
+  for (int n = 0; n < num_entries; n++) {
+    notify_entry_t *e = &entries[next_watched];
+
+    next_watched++;
+    if (next_watched >= num_entries)
+      next_watched = 0;
+    if (e->flags & NOTIFY_WATCHED) {
+      *command_type = e->command_type;
+      *descriptor_type = e->descriptor_type;
+      *descriptor_index = e->descriptor_index;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void mark(notify_entry_t *e, unsigned long long origin)
+{
+  notify_stats.changes++;
+  if (e->flags & NOTIFY_DIRTY) {
+    // Changes by different controllers are notified to them all
+    if (e->origin != origin)
+      e->origin = 0;
+    notify_stats.coalesced++;
+  }
+  else {
+    e->origin = origin;
+    e->flags |= NOTIFY_DIRTY;
+  }
+}
+
+void avb_1722_1_aecp_notify_changed(unsigned command_type,
+                                    unsigned descriptor_type,
+                                    unsigned descriptor_index,
+                                    unsigned long long origin)
+{
+  notify_entry_t *e;
+
+  if (num_controllers == 0)
+    return;
+  e = find_entry(command_type, descriptor_type, descriptor_index, 1);
+  if (e != NULL)
+    mark(e, origin);
+}
+
+// FNV-1a is plenty to tell one response from the next
+static unsigned checksum(const unsigned char response[], unsigned len)
+{
+  unsigned sum = 2166136261u;
+
+  for (unsigned i = 0; i < len; i++)
+    sum = (sum ^ response[i]) * 16777619u;
+  return sum;
+}
+
+void avb_1722_1_aecp_notify_update(unsigned command_type,
+                                   unsigned descriptor_type,
+                                   unsigned descriptor_index,
+                                   const unsigned char response[],
+                                   unsigned len)
+{
+  notify_entry_t *e = find_entry(command_type, descriptor_type, descriptor_index, 0);
+  unsigned sum;
+
+  if (e == NULL)
+    return;
+
+  sum = checksum(response, len);
+  if ((e->flags & NOTIFY_HAVE_SUM) && sum != e->checksum && num_controllers > 0)
+    mark(e, 0);
+  e->checksum = sum;
+  e->flags |= NOTIFY_HAVE_SUM;
+}
+
+int avb_1722_1_aecp_notify_next(unsigned now,
+                                unsigned *command_type,
+                                unsigned *descriptor_type,
+                                unsigned *descriptor_index,
+                                unsigned long long *origin)
+{
+  notify_entry_t *due = NULL;
+
+  for (int i = 0; i < num_entries; i++) {
+    notify_entry_t *e = &entries[i];
+
+    // Rate limits are ended here rather than compared when a change is
+    // marked, so the comparison never spans a timer wrap
+    if ((e->flags & NOTIFY_LIMITED) && (int) (now - e->next_allowed) >= 0)
+      e->flags &= ~NOTIFY_LIMITED;
+    if (due == NULL && (e->flags & (NOTIFY_DIRTY | NOTIFY_LIMITED)) == NOTIFY_DIRTY)
+      due = e;
+  }
+  if (due == NULL)
+    return 0;
+
+  due->flags &= ~NOTIFY_DIRTY;
+  due->flags |= NOTIFY_LIMITED;
+  due->next_allowed = now + (due->descriptor_type < AVB_1722_1_AECP_NOTIFY_NUM_TYPES ?
+                             intervals[due->descriptor_type] :
+                             AVB_1722_1_AECP_NOTIFY_INTERVAL_MS * XS1_TIMER_KHZ);
+  *command_type = due->command_type;
+  *descriptor_type = due->descriptor_type;
+  *descriptor_index = due->descriptor_index;
+  *origin = due->origin;
+  return 1;
+}
+
+int avb_1722_1_aecp_notify_next_due(unsigned now, unsigned *when)
+{
+  int found = 0;
+
+  for (int i = 0; i < num_entries; i++) {
+    notify_entry_t *e = &entries[i];
+    unsigned t = now;
+
+    if (!(e->flags & NOTIFY_DIRTY))
+      continue;
+    if ((e->flags & NOTIFY_LIMITED) && (int) (e->next_allowed - now) > 0)
+      t = e->next_allowed;
+    if (!found || (int) (t - *when) < 0)
+      *when = t;
+    found = 1;
+  }
+  return found;
+}
+
+void avb_1722_1_aecp_notify_sent(unsigned command_type,
+                                 unsigned descriptor_type,
+                                 unsigned descriptor_index,
+                                 const unsigned char response[],
+                                 unsigned len,
+                                 int num_sent)
+{
+  notify_entry_t *e = find_entry(command_type, descriptor_type, descriptor_index, 0);
+
+  // The change notified is not a change for the next poll
+  if (e != NULL) {
+    e->checksum = checksum(response, len);
+    e->flags |= NOTIFY_HAVE_SUM;
+  }
+  notify_stats.notifications += num_sent;
+}
+
+void avb_1722_1_aecp_notify_get_stats(avb_1722_1_aecp_notify_stats_t *stats)
+{
+  *stats = notify_stats;
+}
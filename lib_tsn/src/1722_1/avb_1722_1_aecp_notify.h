@@ -0,0 +1,144 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef AVB_1722_1_AECP_NOTIFY_H_
+#define AVB_1722_1_AECP_NOTIFY_H_
+
+#include <xccompat.h>
+#include "avb_1722_1_default_conf.h"
+
+/* Unsolicited AECP notifications.
+
+   Controllers register with REGISTER_UNSOLICITED_NOTIFICATION and are
+   then sent an unsolicited GET response whenever the state it reports
+   changes, instead of polling for it. Each notification is tracked by
+   the GET command that reports it and its descriptor.
+
+   Changes are found in two ways. A SET command from one controller marks
+   the state it changed, and the other controllers are notified. Watched
+   state that can change without a command, such as stream info and
+   clock domain counters, is rendered into a GET response at a low rate
+   and marked when the response differs from the last one.
+
+   Changes to a descriptor within the notification interval of its type
+   are coalesced into one notification sent at the end of the interval.
+   Times are in reference clock ticks. */
+
+/** The number of GET command and descriptor pairs that can be tracked */
+#ifndef AVB_1722_1_AECP_NOTIFY_MAX_TRACKED
+#define AVB_1722_1_AECP_NOTIFY_MAX_TRACKED \
+  (3 * (AVB_NUM_SINKS + AVB_NUM_SOURCES) + 2 * AVB_NUM_MEDIA_CLOCKS + 2)
+#endif
+
+/** The number of descriptor types with their own notification interval,
+ *  up to AEM_CONTROL_BLOCK_TYPE */
+#define AVB_1722_1_AECP_NOTIFY_NUM_TYPES 0x26
+
+typedef struct avb_1722_1_aecp_notify_stats_t {
+  unsigned changes;       //!< State changes marked
+  unsigned coalesced;     //!< Changes merged into a pending notification
+  unsigned notifications; //!< Notifications sent, one per controller
+} avb_1722_1_aecp_notify_stats_t;
+
+/** Remove all registrations and tracked state, and set the notification
+ *  intervals to their defaults */
+void avb_1722_1_aecp_notify_init(void);
+
+/** Register a controller for notifications. A controller that is already
+ *  registered keeps its sequence IDs.
+ *
+ *  \returns  0 if there is no room for another controller
+ */
+int avb_1722_1_aecp_notify_register(unsigned long long controller_guid,
+                                    const unsigned char mac[6]);
+
+/** Deregister a controller. Does nothing if it is not registered. */
+void avb_1722_1_aecp_notify_deregister(unsigned long long controller_guid);
+
+/** The number of registered controllers */
+int avb_1722_1_aecp_notify_num_controllers(void);
+
+#ifndef __XC__
+/** Get the controller registered in a slot to send a notification to.
+ *
+ *  \param slot    from 0 to AVB_1722_1_AECP_MAX_NOTIFY_CONTROLLERS - 1
+ *  \param origin  the GUID of a controller to skip, or 0
+ *  \returns       the sequence ID for the notification, which is then
+ *                 incremented, or -1 if the slot is empty or holds origin
+ */
+int avb_1722_1_aecp_notify_controller(int slot,
+                                      unsigned long long origin,
+                                      unsigned long long *controller_guid,
+                                      unsigned char mac[6]);
+#endif
+
+/** Set the shortest time between notifications for descriptors of a type */
+void avb_1722_1_aecp_notify_set_interval(unsigned descriptor_type,
+                                         unsigned interval);
+
+/** Check a GET command and descriptor pair for changes when polled.
+ *
+ *  \returns  0 if the tracking table is full
+ */
+int avb_1722_1_aecp_notify_watch(unsigned command_type,
+                                 unsigned descriptor_type,
+                                 unsigned descriptor_index);
+
+/** The next watched pair to poll, in turn.
+ *
+ *  \returns  0 if nothing is watched
+ */
+int avb_1722_1_aecp_notify_next_watched(REFERENCE_PARAM(unsigned, command_type),
+                                        REFERENCE_PARAM(unsigned, descriptor_type),
+                                        REFERENCE_PARAM(unsigned, descriptor_index));
+
+/** Mark the state reported by a GET command as changed.
+ *
+ *  \param origin  the GUID of the controller whose command made the
+ *                 change and so does not need notifying, or 0
+ */
+void avb_1722_1_aecp_notify_changed(unsigned command_type,
+                                    unsigned descriptor_type,
+                                    unsigned descriptor_index,
+                                    unsigned long long origin);
+
+/** Pass in the current GET response for a watched pair, which is marked
+ *  as changed if the response differs from the last one passed in. */
+void avb_1722_1_aecp_notify_update(unsigned command_type,
+                                   unsigned descriptor_type,
+                                   unsigned descriptor_index,
+                                   const unsigned char response[],
+                                   unsigned len);
+
+/** Take the next notification that is due.
+ *
+ *  \param origin  set to the GUID of the controller not to notify, or 0
+ *  \returns       0 if no notification is due
+ */
+int avb_1722_1_aecp_notify_next(unsigned now,
+                                REFERENCE_PARAM(unsigned, command_type),
+                                REFERENCE_PARAM(unsigned, descriptor_type),
+                                REFERENCE_PARAM(unsigned, descriptor_index),
+                                REFERENCE_PARAM(unsigned long long, origin));
+
+/** When the next notification waiting will be due, which is now if one
+ *  is due already.
+ *
+ *  \returns  0 if no notification is waiting
+ */
+int avb_1722_1_aecp_notify_next_due(unsigned now,
+                                    REFERENCE_PARAM(unsigned, when));
+
+/** Record the GET response sent as a notification.
+ *
+ *  \param num_sent  the number of controllers it was sent to
+ */
+void avb_1722_1_aecp_notify_sent(unsigned command_type,
+                                 unsigned descriptor_type,
+                                 unsigned descriptor_index,
+                                 const unsigned char response[],
+                                 unsigned len,
+                                 int num_sent);
+
+/** Copy out the notification statistics */
+void avb_1722_1_aecp_notify_get_stats(REFERENCE_PARAM(avb_1722_1_aecp_notify_stats_t, stats));
+
+#endif /* AVB_1722_1_AECP_NOTIFY_H_ */
@@ -3,6 +3,9 @@
 #include <xclib.h>
 #include "avb_1722_common.h"
 #include "avb_1722_1_common.h"
+#include "avb_1722_1_tx_queue.h"
+#include "ethernet_wrappers.h"
+#include "misc_timer.h"
 
 extern unsigned char my_mac_addr[6];
 
@@ -78,3 +81,41 @@ void avb_1722_1_create_1722_1_header(   const unsigned char* dest_addr,
     SET_1722_1_VALID_TIME(pkt, valid_time_status);
     SET_1722_1_DATALENGTH(pkt, data_len);
 }
+
+void avb_1722_1_send(CLIENT_INTERFACE(ethernet_tx_if, i_eth), const unsigned char packet[], unsigned len, unsigned ifnum)
+{
+#if AVB_1722_1_TX_BUFFERS > 0
+    if (avb_1722_1_tx_queue_count() == AVB_1722_1_TX_BUFFERS)
+    {
+        avb_1722_1_send_queued(i_eth);
+    }
+    avb_1722_1_tx_queue_push(packet, len, ifnum, get_local_time());
+#else
+    eth_send_packet(i_eth, (char *)packet, len, ifnum);
+#endif
+}
+
+int avb_1722_1_send_queued(CLIENT_INTERFACE(ethernet_tx_if, i_eth))
+{
+#if AVB_1722_1_TX_BUFFERS > 0
+    const unsigned char *packet;
+    unsigned len, ifnum;
+
+    if (avb_1722_1_tx_queue_count() == 0) return 0;
+
+    packet = avb_1722_1_tx_queue_front(&len, &ifnum);
+    eth_send_packet(i_eth, (char *)packet, len, ifnum);
+    avb_1722_1_tx_queue_pop(get_local_time());
+
+    return avb_1722_1_tx_queue_count();
+#else
+    (void) i_eth;
+    return 0;
+#endif
+}
+
+void avb_1722_1_flush(CLIENT_INTERFACE(ethernet_tx_if, i_eth))
+{
+    while (avb_1722_1_send_queued(i_eth))
+        ;
+}
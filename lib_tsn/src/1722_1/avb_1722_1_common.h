@@ -20,6 +20,20 @@ int qlog2(unsigned n);
 extern "C" {
 #endif
 void avb_1722_1_create_1722_1_header(const unsigned char *dest_addr, int subtype, int message_type, unsigned char valid_time_status, unsigned data_len, ethernet_hdr_t *hdr);
+
+/** Queue a 1722.1 packet for transmission, sending the oldest queued packet
+ *  first if the queue is full. The packet is copied, so the buffer it was
+ *  built in can be reused straight away. */
+void avb_1722_1_send(CLIENT_INTERFACE(ethernet_tx_if, i_eth), const unsigned char packet[], unsigned len, unsigned ifnum);
+
+/** Send the oldest queued 1722.1 packet, if any.
+ *
+ *  \returns  the number of packets still queued
+ */
+int avb_1722_1_send_queued(CLIENT_INTERFACE(ethernet_tx_if, i_eth));
+
+/** Send all queued 1722.1 packets */
+void avb_1722_1_flush(CLIENT_INTERFACE(ethernet_tx_if, i_eth));
 #ifdef __XC__
 }
 #endif
@@ -105,18 +105,68 @@
 #define AVB_1722_1_FIRMWARE_UPGRADE_ENABLED 0
 #endif
 
+/** The number of firmware upgrade image pages that can wait to be
+ *  programmed into flash; see avb_1722_1_aecp_efu.h */
+#ifndef AVB_1722_1_EFU_BUFFERS
+#define AVB_1722_1_EFU_BUFFERS 8
+#endif
+
 #ifndef AVB_1722_1_FAST_CONNECT_ENABLED
 #define AVB_1722_1_FAST_CONNECT_ENABLED 0
 #endif
 
+/** The first flash data partition sector of the persistent state journal;
+ *  see avb_1722_1_journal.h */
+#ifndef AVB_1722_1_JOURNAL_FIRST_SECTOR
+#define AVB_1722_1_JOURNAL_FIRST_SECTOR 0
+#endif
+
+/** The number of flash data partition sectors the journal is spread over */
+#ifndef AVB_1722_1_JOURNAL_NUM_SECTORS
+#define AVB_1722_1_JOURNAL_NUM_SECTORS 4
+#endif
+
 #ifndef AVB_1722_1_ADP_ASSOCIATION_ID
 #define AVB_1722_1_ADP_ASSOCIATION_ID 0
 #endif
 
+/** The number of entities ADP keeps track of. Controllers on large
+ *  networks may need hundreds; see avb_1722_1_entity_db.h */
 #ifndef AVB_1722_1_MAX_ENTITIES
 #define AVB_1722_1_MAX_ENTITIES 4
 #endif
 
+/** The number of 1722.1 packets that can wait for transmission, so that
+ *  bursts of commands are parsed ahead of sending their responses, or 0
+ *  to send each packet as soon as it is built; see avb_1722_1_tx_queue.h */
+#ifndef AVB_1722_1_TX_BUFFERS
+#define AVB_1722_1_TX_BUFFERS 0
+#endif
+
+/** The number of controllers that can register for unsolicited AECP
+ *  notifications; see avb_1722_1_aecp_notify.h */
+#ifndef AVB_1722_1_AECP_MAX_NOTIFY_CONTROLLERS
+#define AVB_1722_1_AECP_MAX_NOTIFY_CONTROLLERS 4
+#endif
+
+/** The shortest time in ms between unsolicited notifications for one
+ *  descriptor. Changes within this time are sent as one notification. */
+#ifndef AVB_1722_1_AECP_NOTIFY_INTERVAL_MS
+#define AVB_1722_1_AECP_NOTIFY_INTERVAL_MS 100
+#endif
+
+/** The shortest time in ms between unsolicited notifications for one
+ *  clock domain, whose notifications are mostly of changed counters */
+#ifndef AVB_1722_1_AECP_NOTIFY_CLOCK_DOMAIN_INTERVAL_MS
+#define AVB_1722_1_AECP_NOTIFY_CLOCK_DOMAIN_INTERVAL_MS 1000
+#endif
+
+/** How often in ms the state behind one watched descriptor is checked
+ *  for changes while controllers are registered */
+#ifndef AVB_1722_1_AECP_NOTIFY_POLL_MS
+#define AVB_1722_1_AECP_NOTIFY_POLL_MS 10
+#endif
+
 #ifndef AVB_1722_1_MAX_LISTENERS
 #define AVB_1722_1_MAX_LISTENERS AVB_NUM_SINKS
 #endif
@@ -130,7 +180,25 @@
 #endif
 
 #ifndef AVB_1722_1_MAX_INFLIGHT_COMMANDS
-#define AVB_1722_1_MAX_INFLIGHT_COMMANDS (AVB_1722_1_MAX_LISTENERS*2)
+#define AVB_1722_1_MAX_INFLIGHT_COMMANDS ((AVB_1722_1_MAX_LISTENERS > 0 ? AVB_1722_1_MAX_LISTENERS : 1)*2)
+#endif
+
+/** The number of controller connect and disconnect commands that can wait
+ *  for a free inflight command entry; see avb_1722_1_acmp_inflight.h */
+#ifndef AVB_1722_1_ACMP_CONTROLLER_QUEUE_LEN
+#define AVB_1722_1_ACMP_CONTROLLER_QUEUE_LEN \
+  ((AVB_1722_1_MAX_TALKERS > 0 ? AVB_1722_1_MAX_TALKERS : 1)*AVB_1722_1_MAX_LISTENERS_PER_TALKER)
+#endif
+
+/** The number of connections a controller can connect or disconnect in one
+ *  batch; see avb_1722_1_acmp_batch.h */
+#ifndef AVB_1722_1_ACMP_MAX_BATCH
+#define AVB_1722_1_ACMP_MAX_BATCH 64
+#endif
+
+/** The number of commands from a batch kept in flight at once */
+#ifndef AVB_1722_1_ACMP_BATCH_WINDOW
+#define AVB_1722_1_ACMP_BATCH_WINDOW AVB_1722_1_MAX_INFLIGHT_COMMANDS
 #endif
 
 /* Debug defines */
@@ -0,0 +1,265 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "avb_1722_1_entity_db.h"
+
+#if AVB_1722_1_MAX_ENTITIES > 32768
+#error "AVB_1722_1_MAX_ENTITIES must be 32768 or less"
+#endif
+
+#define NIL 0xffff
+#define HASH_MASK (AVB_1722_1_ENTITY_DB_HASH_SIZE - 1)
+
+#ifdef AVB_1722_1_ENTITY_DB_SECTION
+#define ENTITY_DB_PLACEMENT __attribute__((section(AVB_1722_1_ENTITY_DB_SECTION)))
+#else
+#define ENTITY_DB_PLACEMENT
+#endif
+
+typedef struct entity_link_t {
+  unsigned short slot;      // Hash table slot holding the entity
+  unsigned short heap_pos;  // Position in the timeout heap
+  unsigned short prev;      // Neighbours in recency order, or the next
+  unsigned short next;      // free entity
+} entity_link_t;
+
+static avb_1722_1_entity_record records[AVB_1722_1_MAX_ENTITIES] ENTITY_DB_PLACEMENT;
+static entity_link_t links[AVB_1722_1_MAX_ENTITIES] ENTITY_DB_PLACEMENT;
+// Entity index + 1 of each slot, 0 if the slot is empty
+static unsigned short slots[AVB_1722_1_ENTITY_DB_HASH_SIZE] ENTITY_DB_PLACEMENT;
+static unsigned short heap[AVB_1722_1_MAX_ENTITIES] ENTITY_DB_PLACEMENT;
+
+static int count;
+static unsigned short newest;
+static unsigned short oldest;
+static unsigned short free_list;
+
+static unsigned hash(unsigned long long guid)
+{
+  unsigned h = (unsigned) (guid ^ (guid >> 32)) * 0x9e3779b1u;
+  return (h ^ (h >> 16)) & HASH_MASK;
+}
+
+/* Recency list, newest first */
+
+static void list_unlink(int i)
+{
+  if (links[i].prev != NIL)
+    links[links[i].prev].next = links[i].next;
+  else
+    newest = links[i].next;
+  if (links[i].next != NIL)
+    links[links[i].next].prev = links[i].prev;
+  else
+    oldest = links[i].prev;
+}
+
+static void list_push(int i)
+{
+  links[i].prev = NIL;
+  links[i].next = newest;
+  if (newest != NIL)
+    links[newest].prev = i;
+  else
+    oldest = i;
+  newest = i;
+}
+
+/* Timeout heap */
+
+static void heap_place(int pos, int i)
+{
+  heap[pos] = i;
+  links[i].heap_pos = pos;
+}
+
+static void heap_sift_up(int pos)
+{
+  int i = heap[pos];
+
+  while (pos > 0) {
+    int parent = (pos - 1) / 2;
+    if (records[heap[parent]].timeout <= records[i].timeout)
+      break;
+    heap_place(pos, heap[parent]);
+    pos = parent;
+  }
+  heap_place(pos, i);
+}
+
+static void heap_sift_down(int pos)
+{
+  int i = heap[pos];
+
+  while (1) {
+    int child = 2 * pos + 1;
+    if (child >= count)
+      break;
+    if (child + 1 < count &&
+        records[heap[child + 1]].timeout < records[heap[child]].timeout)
+      child++;
+    if (records[i].timeout <= records[heap[child]].timeout)
+      break;
+    heap_place(pos, heap[child]);
+    pos = child;
+  }
+  heap_place(pos, i);
+}
+
+/* Hash table */
+
+static void table_remove(int i)
+{
+  unsigned hole = links[i].slot;
+  unsigned s = hole;
+
+  // Shift later entries of the probe sequence back into the hole so that
+  // lookups never need to step over deleted slots
+  slots[hole] = 0;
+  while (1) {
+    unsigned home;
+    int j;
+
+    s = (s + 1) & HASH_MASK;
+    if (slots[s] == 0)
+      break;
+    j = slots[s] - 1;
+    home = hash(records[j].guid.l);
+    if (((s - home) & HASH_MASK) >= ((s - hole) & HASH_MASK)) {
+      slots[hole] = slots[s];
+      links[j].slot = hole;
+      slots[s] = 0;
+      hole = s;
+    }
+  }
+}
+
+void avb_1722_1_entity_db_flush(void)
+{
+  memset(slots, 0, sizeof(slots));
+  for (int i = 0; i < AVB_1722_1_MAX_ENTITIES; i++) {
+    records[i].guid.l = 0;
+    links[i].next = (i + 1 < AVB_1722_1_MAX_ENTITIES) ? i + 1 : NIL;
+  }
+  free_list = 0;
+  newest = NIL;
+  oldest = NIL;
+  count = 0;
+}
+
+int avb_1722_1_entity_db_count(void)
+{
+  return count;
+}
+
+int avb_1722_1_entity_db_find(unsigned long long guid)
+{
+  unsigned s = hash(guid);
+
+  if (guid == 0)
+    return -1;
+  while (slots[s] != 0) {
+    int i = slots[s] - 1;
+    if (records[i].guid.l == guid)
+      return i;
+    s = (s + 1) & HASH_MASK;
+  }
+  return -1;
+}
+
+void avb_1722_1_entity_db_remove(int index)
+{
+  int last;
+
+  if (index < 0 || index >= AVB_1722_1_MAX_ENTITIES ||
+      records[index].guid.l == 0)
+    return;
+
+  table_remove(index);
+  list_unlink(index);
+
+  // Fill the heap position with the last entry and restore the order
+  count--;
+  last = heap[count];
+  if (last != index) {
+    int pos = links[index].heap_pos;
+    heap_place(pos, last);
+    heap_sift_up(pos);
+    heap_sift_down(links[last].heap_pos);
+  }
+
+  records[index].guid.l = 0;
+  links[index].next = free_list;
+  free_list = index;
+}
+
+int avb_1722_1_entity_db_add(unsigned long long guid,
+                             unsigned timeout,
+                             int *added)
+{
+  int i = avb_1722_1_entity_db_find(guid);
+  unsigned s;
+
+  if (i >= 0) {
+    unsigned prev = records[i].timeout;
+    records[i].timeout = timeout;
+    if (timeout < prev)
+      heap_sift_up(links[i].heap_pos);
+    else
+      heap_sift_down(links[i].heap_pos);
+    list_unlink(i);
+    list_push(i);
+    *added = 0;
+    return i;
+  }
+
+  if (free_list == NIL)
+    avb_1722_1_entity_db_remove(oldest);
+
+  i = free_list;
+  free_list = links[i].next;
+
+  memset(&records[i], 0, sizeof(records[i]));
+  records[i].guid.l = guid;
+  records[i].timeout = timeout;
+
+  s = hash(guid);
+  while (slots[s] != 0)
+    s = (s + 1) & HASH_MASK;
+  slots[s] = i + 1;
+  links[i].slot = s;
+
+  list_push(i);
+
+  heap_place(count, i);
+  count++;
+  heap_sift_up(links[i].heap_pos);
+
+  *added = 1;
+  return i;
+}
+
+int avb_1722_1_entity_db_remove_expired(unsigned now)
+{
+  int i;
+
+  if (count == 0 || records[heap[0]].timeout >= now)
+    return -1;
+  i = heap[0];
+  avb_1722_1_entity_db_remove(i);
+  return i;
+}
+
+void avb_1722_1_entity_db_get(int index, avb_1722_1_entity_record *record)
+{
+  *record = records[index];
+}
+
+void avb_1722_1_entity_db_set(int index, const avb_1722_1_entity_record *record)
+{
+  guid_t guid = records[index].guid;
+  unsigned timeout = records[index].timeout;
+
+  records[index] = *record;
+  records[index].guid = guid;
+  records[index].timeout = timeout;
+}
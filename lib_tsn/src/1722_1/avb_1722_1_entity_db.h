@@ -0,0 +1,81 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef AVB_1722_1_ENTITY_DB_H_
+#define AVB_1722_1_ENTITY_DB_H_
+
+#include <xccompat.h>
+#include "avb_1722_1_adp_pdu.h"
+
+/* The ADP entity database.
+
+   Entities are found by GUID through an open addressing hash table with
+   linear probing, and kept in a min-heap ordered by timeout so expired
+   entities are found without scanning the database. When the database is
+   full, a newly advertised entity replaces the entity that was least
+   recently heard from.
+
+   Entities are referred to by an index below AVB_1722_1_MAX_ENTITIES that
+   is stable for as long as the entity stays in the database. The database
+   takes about AVB_1722_1_MAX_ENTITIES * 80 bytes, so large configurations
+   can place it in a separate memory region by defining
+   AVB_1722_1_ENTITY_DB_SECTION as the name of a linker section. */
+
+/** The size of the GUID hash table, a power of two at least twice the
+ *  number of entities and at most 65536 */
+#define AVB_1722_1_ENTITY_DB_HASH_SIZE \
+  (AVB_1722_1_MAX_ENTITIES <= 4 ? 8 : \
+   AVB_1722_1_MAX_ENTITIES <= 8 ? 16 : \
+   AVB_1722_1_MAX_ENTITIES <= 16 ? 32 : \
+   AVB_1722_1_MAX_ENTITIES <= 32 ? 64 : \
+   AVB_1722_1_MAX_ENTITIES <= 64 ? 128 : \
+   AVB_1722_1_MAX_ENTITIES <= 128 ? 256 : \
+   AVB_1722_1_MAX_ENTITIES <= 256 ? 512 : \
+   AVB_1722_1_MAX_ENTITIES <= 512 ? 1024 : \
+   AVB_1722_1_MAX_ENTITIES <= 1024 ? 2048 : \
+   AVB_1722_1_MAX_ENTITIES <= 2048 ? 4096 : \
+   AVB_1722_1_MAX_ENTITIES <= 4096 ? 8192 : \
+   AVB_1722_1_MAX_ENTITIES <= 8192 ? 16384 : \
+   AVB_1722_1_MAX_ENTITIES <= 16384 ? 32768 : 65536)
+
+/** Remove all entities */
+void avb_1722_1_entity_db_flush(void);
+
+/** The number of entities in the database */
+int avb_1722_1_entity_db_count(void);
+
+/** Find an entity.
+ *
+ *  \returns  the index of the entity, or -1 if it is not in the database
+ */
+int avb_1722_1_entity_db_find(unsigned long long guid);
+
+/** Add an entity or refresh an entity already in the database. A refreshed
+ *  entity becomes the most recently heard from.
+ *
+ *  \param guid     the GUID of the entity, not zero
+ *  \param timeout  the time the entity expires, in the caller's units
+ *  \param added    set to 1 if the entity was not in the database
+ *  \returns        the index of the entity
+ */
+int avb_1722_1_entity_db_add(unsigned long long guid,
+                             unsigned timeout,
+                             REFERENCE_PARAM(int, added));
+
+/** Remove the entity at an index */
+void avb_1722_1_entity_db_remove(int index);
+
+/** Remove an entity whose timeout is before now.
+ *
+ *  \returns  the index the entity was at, or -1 if no entity has expired
+ */
+int avb_1722_1_entity_db_remove_expired(unsigned now);
+
+/** Copy out the record of the entity at an index */
+void avb_1722_1_entity_db_get(int index,
+                              REFERENCE_PARAM(avb_1722_1_entity_record, record));
+
+/** Replace the record of the entity at an index. The GUID and timeout of
+ *  the record are kept from avb_1722_1_entity_db_add(). */
+void avb_1722_1_entity_db_set(int index,
+                              REFERENCE_PARAM(const avb_1722_1_entity_record, record));
+
+#endif /* AVB_1722_1_ENTITY_DB_H_ */
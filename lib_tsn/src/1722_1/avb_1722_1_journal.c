@@ -0,0 +1,312 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "quadflashlib.h"
+#include "avb_1722_1_journal.h"
+
+#define RECORD_HEADER   0x5a
+#define NONE            (-1)
+
+typedef struct journal_record_t {
+  unsigned char type;
+  unsigned char erased;
+  unsigned short command;
+  unsigned short descriptor_type;
+  unsigned short descriptor_index;
+  unsigned char data[AVB_1722_1_JOURNAL_DATA_SIZE];
+  unsigned crc;
+} journal_record_t;
+
+#define RECORDS_PER_PAGE (AVB_1722_1_JOURNAL_PAGE_SIZE / sizeof(journal_record_t))
+
+static journal_record_t entries[AVB_1722_1_JOURNAL_MAX_ENTRIES];
+static unsigned num_entries;
+
+// The page being filled, as written to flash
+static journal_record_t page[RECORDS_PER_PAGE];
+
+static unsigned sector;           // The current sector, from 0
+static unsigned generation;       // The generation of the current sector
+static unsigned next_record;      // The next free record in the current sector
+static unsigned records_per_sector;
+static unsigned pages_per_sector;
+static avb_1722_1_journal_stats_t stats;
+
+static unsigned journal_crc(const unsigned char *data, unsigned len)
+{
+  unsigned crc = 0xffffffff;
+
+  for (unsigned i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+  }
+  return ~crc;
+}
+
+static unsigned record_crc(const journal_record_t *r)
+{
+  return journal_crc((const unsigned char *) r, sizeof(journal_record_t) - sizeof(unsigned));
+}
+
+static int record_empty(const journal_record_t *r)
+{
+  const unsigned char *p = (const unsigned char *) r;
+
+  for (unsigned i = 0; i < sizeof(journal_record_t); i++)
+    if (p[i] != 0xff)
+      return 0;
+  return 1;
+}
+
+static unsigned first_page(unsigned s)
+{
+  return (AVB_1722_1_JOURNAL_FIRST_SECTOR + s) * pages_per_sector;
+}
+
+// Read the header of a sector, returning 0 if it has none
+static int read_header(unsigned s, unsigned *gen)
+{
+  if (fl_readDataPage(first_page(s), (unsigned char *) page) != 0)
+    return 0;
+  if (page[0].type != RECORD_HEADER || page[0].crc != record_crc(&page[0]))
+    return 0;
+  memcpy(gen, page[0].data, sizeof(unsigned));
+  return 1;
+}
+
+static int find_entry(unsigned type, unsigned command, unsigned descriptor_type, unsigned descriptor_index)
+{
+  for (unsigned i = 0; i < num_entries; i++) {
+    if (entries[i].type == type &&
+        entries[i].command == command &&
+        entries[i].descriptor_type == descriptor_type &&
+        entries[i].descriptor_index == descriptor_index)
+      return i;
+  }
+  return NONE;
+}
+
+// Apply a record read back or written to the entries
+static int apply(const journal_record_t *r)
+{
+  int i = find_entry(r->type, r->command, r->descriptor_type, r->descriptor_index);
+
+  if (r->erased) {
+    if (i != NONE)
+      entries[i] = entries[--num_entries];
+    return 1;
+  }
+  if (i == NONE) {
+    if (num_entries == AVB_1722_1_JOURNAL_MAX_ENTRIES)
+      return 0;
+    i = num_entries++;
+  }
+  entries[i] = *r;
+  return 1;
+}
+
+// Add a record to the page being filled and write the page
+static int append(const journal_record_t *r)
+{
+  unsigned slot = next_record % RECORDS_PER_PAGE;
+
+  if (slot == 0)
+    memset(page, 0xff, sizeof(page));
+  page[slot] = *r;
+  stats.page_writes++;
+  if (fl_writeDataPage(first_page(sector) + next_record / RECORDS_PER_PAGE, (unsigned char *) page) != 0)
+    return 0;
+  next_record++;
+  return 1;
+}
+
+// Start the next sector with the live entries, then its header
+static int compact(void)
+{
+  journal_record_t header;
+
+  sector = (sector + 1) % AVB_1722_1_JOURNAL_NUM_SECTORS;
+  generation++;
+  stats.erases++;
+  if (fl_eraseDataSector(AVB_1722_1_JOURNAL_FIRST_SECTOR + sector) != 0)
+    return 0;
+
+  next_record = 1;
+  memset(page, 0xff, sizeof(page));
+  for (unsigned i = 0; i < num_entries; i++) {
+    if (!append(&entries[i]))
+      return 0;
+  }
+
+  memset(&header, 0xff, sizeof(header));
+  header.type = RECORD_HEADER;
+  header.erased = 0;
+  memcpy(header.data, &generation, sizeof(unsigned));
+  header.crc = record_crc(&header);
+
+  // The header goes in the first page, which may not be the page being filled
+  if (next_record <= RECORDS_PER_PAGE) {
+    page[0] = header;
+    stats.page_writes++;
+    return fl_writeDataPage(first_page(sector), (unsigned char *) page) == 0;
+  }
+  else {
+    journal_record_t first[RECORDS_PER_PAGE];
+    if (fl_readDataPage(first_page(sector), (unsigned char *) first) != 0)
+      return 0;
+    first[0] = header;
+    stats.page_writes++;
+    if (fl_writeDataPage(first_page(sector), (unsigned char *) first) != 0)
+      return 0;
+    // Keep the page being filled as it is in flash
+    return fl_readDataPage(first_page(sector) + next_record / RECORDS_PER_PAGE, (unsigned char *) page) == 0;
+  }
+}
+
+static int write_record(journal_record_t *r)
+{
+  r->crc = record_crc(r);
+  if (next_record == records_per_sector) {
+    // The entries written by compact() include this record's change
+    if (!apply(r))
+      return 0;
+    return compact();
+  }
+  if (!append(r))
+    return 0;
+  return apply(r);
+}
+
+int avb_1722_1_journal_init(void)
+{
+  int found = 0;
+  unsigned gen;
+
+  memset(&stats, 0, sizeof(stats));
+  num_entries = 0;
+  pages_per_sector = fl_getDataSectorSize(AVB_1722_1_JOURNAL_FIRST_SECTOR) / AVB_1722_1_JOURNAL_PAGE_SIZE;
+  records_per_sector = pages_per_sector * RECORDS_PER_PAGE;
+
+  for (unsigned s = 0; s < AVB_1722_1_JOURNAL_NUM_SECTORS; s++) {
+    if (read_header(s, &gen) && (!found || (int) (gen - generation) > 0)) {
+      sector = s;
+      generation = gen;
+      found = 1;
+    }
+  }
+
+  if (!found) {
+    // Start a journal in the first sector
+    sector = AVB_1722_1_JOURNAL_NUM_SECTORS - 1;
+    generation = 0;
+    compact();
+    return 0;
+  }
+
+  // Replay the current sector in one pass
+  next_record = records_per_sector;
+  for (unsigned p = 0; p < pages_per_sector && next_record == records_per_sector; p++) {
+    if (fl_readDataPage(first_page(sector) + p, (unsigned char *) page) != 0)
+      break;
+    for (unsigned slot = (p == 0); slot < RECORDS_PER_PAGE; slot++) {
+      journal_record_t *r = &page[slot];
+      if (record_empty(r)) {
+        next_record = p * RECORDS_PER_PAGE + slot;
+        break;
+      }
+      if (r->crc != record_crc(r)) {
+        stats.torn++;
+        continue;
+      }
+      stats.records++;
+      apply(r);
+    }
+  }
+  return num_entries;
+}
+
+int avb_1722_1_journal_write(unsigned type,
+                             unsigned command,
+                             unsigned descriptor_type,
+                             unsigned descriptor_index,
+                             const unsigned char data[],
+                             unsigned len)
+{
+  journal_record_t r;
+  int i = find_entry(type, command, descriptor_type, descriptor_index);
+
+  if (len > AVB_1722_1_JOURNAL_DATA_SIZE)
+    len = AVB_1722_1_JOURNAL_DATA_SIZE;
+
+  memset(&r, 0, sizeof(r));
+  r.type = type;
+  r.command = command;
+  r.descriptor_type = descriptor_type;
+  r.descriptor_index = descriptor_index;
+  memcpy(r.data, data, len);
+
+  if (i != NONE && memcmp(entries[i].data, r.data, AVB_1722_1_JOURNAL_DATA_SIZE) == 0)
+    return 1;
+  if (i == NONE && num_entries == AVB_1722_1_JOURNAL_MAX_ENTRIES)
+    return 0;
+  return write_record(&r);
+}
+
+void avb_1722_1_journal_erase(unsigned type,
+                              unsigned command,
+                              unsigned descriptor_type,
+                              unsigned descriptor_index)
+{
+  journal_record_t r;
+
+  if (find_entry(type, command, descriptor_type, descriptor_index) == NONE)
+    return;
+
+  memset(&r, 0, sizeof(r));
+  r.type = type;
+  r.erased = 1;
+  r.command = command;
+  r.descriptor_type = descriptor_type;
+  r.descriptor_index = descriptor_index;
+  write_record(&r);
+}
+
+int avb_1722_1_journal_read(unsigned type,
+                            unsigned command,
+                            unsigned descriptor_type,
+                            unsigned descriptor_index,
+                            unsigned char data[])
+{
+  int i = find_entry(type, command, descriptor_type, descriptor_index);
+
+  if (i == NONE)
+    return 0;
+  memcpy(data, entries[i].data, AVB_1722_1_JOURNAL_DATA_SIZE);
+  return 1;
+}
+
+int avb_1722_1_journal_next(unsigned type,
+                            unsigned *i,
+                            unsigned *command,
+                            unsigned *descriptor_type,
+                            unsigned *descriptor_index,
+                            unsigned char data[])
+{
+  for (; *i < num_entries; (*i)++) {
+    journal_record_t *r = &entries[*i];
+    if (r->type == type) {
+      *command = r->command;
+      *descriptor_type = r->descriptor_type;
+      *descriptor_index = r->descriptor_index;
+      memcpy(data, r->data, AVB_1722_1_JOURNAL_DATA_SIZE);
+      (*i)++;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void avb_1722_1_journal_get_stats(avb_1722_1_journal_stats_t *s)
+{
+  *s = stats;
+}
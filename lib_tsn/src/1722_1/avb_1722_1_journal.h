@@ -0,0 +1,112 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef AVB_1722_1_JOURNAL_H_
+#define AVB_1722_1_JOURNAL_H_
+
+#include <xccompat.h>
+#include "avb_1722_1_default_conf.h"
+
+/* Persistent state journal.
+
+   The state an entity restores at power up, such as the fast connect
+   state of each stream sink and the stream formats and media clock
+   settings set by controllers, is kept as fixed size records appended to
+   a journal in the flash data partition. Each record has a CRC, so one
+   torn by a power cut is ignored. Records are packed into pages, and a
+   page is written again as records are added to it, which only clears
+   bits.
+
+   The journal uses AVB_1722_1_JOURNAL_NUM_SECTORS sectors from
+   AVB_1722_1_JOURNAL_FIRST_SECTOR in turn. When the current sector is
+   full, the live entries are written to the start of the next one
+   before its header, so the sectors are erased evenly and the journal
+   survives a power cut at any point. The sector whose header has the
+   highest generation is current.
+
+   At start up the current sector is read once and the latest record for
+   each entry kept in memory, so entries are read without going back to
+   flash. */
+
+/** The number of entries the journal can hold */
+#ifndef AVB_1722_1_JOURNAL_MAX_ENTRIES
+#define AVB_1722_1_JOURNAL_MAX_ENTRIES \
+  (AVB_1722_1_MAX_LISTENERS + AVB_NUM_SINKS + AVB_NUM_SOURCES + 2 * AVB_NUM_MEDIA_CLOCKS)
+#endif
+
+/** The size of a flash page in bytes */
+#define AVB_1722_1_JOURNAL_PAGE_SIZE    256
+
+/** The number of bytes of data a record holds */
+#define AVB_1722_1_JOURNAL_DATA_SIZE    20
+
+#if AVB_1722_1_JOURNAL_NUM_SECTORS < 2
+#error "AVB_1722_1_JOURNAL_NUM_SECTORS must be at least 2"
+#endif
+
+/** Journal entry types */
+enum avb_1722_1_journal_type_t {
+  AVB_1722_1_JOURNAL_SINK_CONNECTION = 1, //!< The talker a stream sink fast connects to
+  AVB_1722_1_JOURNAL_AEM_SET = 2,         //!< The payload of an AEM SET command
+};
+
+typedef struct avb_1722_1_journal_stats_t {
+  unsigned records;       //!< Records found at start up
+  unsigned torn;          //!< Records found at start up with a bad CRC
+  unsigned page_writes;   //!< Pages written
+  unsigned erases;        //!< Sectors erased
+} avb_1722_1_journal_stats_t;
+
+/** Find the current sector and read the entries from it. A journal is
+ *  started in the first sector if there is none.
+ *
+ *  \returns  the number of entries found
+ */
+int avb_1722_1_journal_init(void);
+
+/** Write an entry, unless it already holds the same data. An entry is
+ *  found by its type, command and descriptor.
+ *
+ *  \returns  0 if there is no room for another entry or flash could not
+ *            be written
+ */
+int avb_1722_1_journal_write(unsigned type,
+                             unsigned command,
+                             unsigned descriptor_type,
+                             unsigned descriptor_index,
+                             const unsigned char data[],
+                             unsigned len);
+
+/** Remove an entry. Does nothing if there is none. */
+void avb_1722_1_journal_erase(unsigned type,
+                              unsigned command,
+                              unsigned descriptor_type,
+                              unsigned descriptor_index);
+
+/** Read an entry.
+ *
+ *  \param data  set to the data of the entry, AVB_1722_1_JOURNAL_DATA_SIZE bytes
+ *  \returns     0 if there is no such entry
+ */
+int avb_1722_1_journal_read(unsigned type,
+                            unsigned command,
+                            unsigned descriptor_type,
+                            unsigned descriptor_index,
+                            unsigned char data[]);
+
+/** Read the entries of a type in turn.
+ *
+ *  \param i     the entry to start from, set to the one after the entry
+ *               returned; start from 0
+ *  \param data  set to the data of the entry, AVB_1722_1_JOURNAL_DATA_SIZE bytes
+ *  \returns     0 if there are no more entries of the type
+ */
+int avb_1722_1_journal_next(unsigned type,
+                            REFERENCE_PARAM(unsigned, i),
+                            REFERENCE_PARAM(unsigned, command),
+                            REFERENCE_PARAM(unsigned, descriptor_type),
+                            REFERENCE_PARAM(unsigned, descriptor_index),
+                            unsigned char data[]);
+
+/** Copy out the journal statistics */
+void avb_1722_1_journal_get_stats(REFERENCE_PARAM(avb_1722_1_journal_stats_t, stats));
+
+#endif /* AVB_1722_1_JOURNAL_H_ */
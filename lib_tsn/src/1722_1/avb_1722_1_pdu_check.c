@@ -0,0 +1,106 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "avb_1722_1_pdu_check.h"
+#include "avb_1722_1_protocol.h"
+#include "avb_1722_1_adp_pdu.h"
+#include "avb_1722_1_acmp_pdu.h"
+#include "avb_1722_1_aecp_pdu.h"
+
+// The common header is followed by the entity ID, counted in the control
+// data length from the controller entity ID of an AECP PDU on
+#define PDU_HEADER_SIZE (sizeof(avb_1722_1_packet_header_t) + 8)
+
+// Controller entity ID and sequence ID
+#define AECP_MIN_LENGTH       10
+// Followed by the U flag and command type
+#define AECP_AEM_MIN_LENGTH   (AECP_MIN_LENGTH + 2)
+// Followed by the TLV count and the mode, length and address of a TLV
+#define AECP_AA_MIN_LENGTH    (AECP_MIN_LENGTH + 2 + 2 + 8)
+
+static avb_1722_1_pdu_stats_t pdu_stats;
+
+void avb_1722_1_pdu_check_init(void)
+{
+  memset(&pdu_stats, 0, sizeof(pdu_stats));
+}
+
+static int aecp_length_ok(const avb_1722_1_aecp_packet_t *pkt, unsigned datalen)
+{
+  switch (GET_1722_1_MSG_TYPE(&pkt->header))
+  {
+    case AECP_CMD_AEM_COMMAND:
+    case AECP_CMD_AEM_RESPONSE:
+      return datalen >= AECP_AEM_MIN_LENGTH;
+    case AECP_CMD_ADDRESS_ACCESS_COMMAND:
+    case AECP_CMD_ADDRESS_ACCESS_RESPONSE:
+      // The data of the first TLV is written to flash, so it must be there
+      return datalen >= AECP_AA_MIN_LENGTH &&
+             datalen >= AECP_AA_MIN_LENGTH + (unsigned) ADDRESS_MSG_GET_LENGTH(&pkt->data.address);
+    default:
+      return datalen >= AECP_MIN_LENGTH;
+  }
+}
+
+static int reject(avb_1722_1_pdu_reject_t reason)
+{
+  pdu_stats.rejected[reason]++;
+  return -(int)reason;
+}
+
+int avb_1722_1_pdu_check(const unsigned char buf[], unsigned len)
+{
+  const avb_1722_1_packet_header_t *pkt = (const avb_1722_1_packet_header_t *) buf;
+  unsigned subtype, datalen;
+  int length_ok;
+
+  if (len < sizeof(avb_1722_1_packet_header_t))
+  {
+    // Too short to tell which protocol it belongs to
+    return 0;
+  }
+
+  subtype = GET_1722_1_SUBTYPE(pkt);
+  if (subtype != DEFAULT_1722_1_ADP_SUBTYPE &&
+      subtype != DEFAULT_1722_1_AECP_SUBTYPE &&
+      subtype != DEFAULT_1722_1_ACMP_SUBTYPE)
+  {
+    return 0;
+  }
+
+  if (len < PDU_HEADER_SIZE)
+    return reject(AVB_1722_1_PDU_TOO_SHORT);
+
+  if (GET_1722_1_CD_FLAG(pkt) != DEFAULT_1722_1_CD_FLAG ||
+      GET_1722_1_SV(pkt) != 0 ||
+      GET_1722_1_AVB_VERSION(pkt) != DEFAULT_1722_1_AVB_VERSION)
+  {
+    return reject(AVB_1722_1_PDU_BAD_HEADER);
+  }
+
+  datalen = GET_1722_1_DATALENGTH(pkt);
+  if (datalen > len - PDU_HEADER_SIZE)
+    return reject(AVB_1722_1_PDU_TRUNCATED);
+
+  switch (subtype)
+  {
+    case DEFAULT_1722_1_ADP_SUBTYPE:
+      length_ok = datalen == AVB_1722_1_ADP_CD_LENGTH;
+      break;
+    case DEFAULT_1722_1_ACMP_SUBTYPE:
+      length_ok = datalen == AVB_1722_1_ACMP_CD_LENGTH;
+      break;
+    default:
+      length_ok = aecp_length_ok((const avb_1722_1_aecp_packet_t *) buf, datalen);
+      break;
+  }
+  if (!length_ok)
+    return reject(AVB_1722_1_PDU_BAD_LENGTH);
+
+  pdu_stats.accepted++;
+  return PDU_HEADER_SIZE + datalen;
+}
+
+void avb_1722_1_pdu_check_get_stats(avb_1722_1_pdu_stats_t *stats)
+{
+  *stats = pdu_stats;
+}
@@ -0,0 +1,47 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef AVB_1722_1_PDU_CHECK_H_
+#define AVB_1722_1_PDU_CHECK_H_
+
+#include <xccompat.h>
+
+/* Checking of received 1722.1 PDUs.
+
+   Every ADP, ACMP and AECP PDU is checked before it is handed to its state
+   machine, so the handlers can trust the control data length and never
+   read or copy beyond the end of the frame. A PDU is rejected if its
+   header is not that of a 1722.1 control PDU, if its control data length
+   is wrong for its subtype and message type or if the frame is too short
+   to hold it. Rejected PDUs are counted by reason. */
+
+/** Reasons a 1722.1 PDU is rejected */
+typedef enum avb_1722_1_pdu_reject_t {
+  AVB_1722_1_PDU_TOO_SHORT = 1,   //!< Shorter than the common 1722.1 header
+  AVB_1722_1_PDU_BAD_HEADER,      //!< Not a control PDU, or an unknown version
+  AVB_1722_1_PDU_BAD_LENGTH,      //!< Control data length wrong for the message
+  AVB_1722_1_PDU_TRUNCATED,       //!< Control data longer than the frame
+  AVB_1722_1_PDU_REJECT_REASONS
+} avb_1722_1_pdu_reject_t;
+
+typedef struct avb_1722_1_pdu_stats_t {
+  unsigned accepted;      //!< PDUs passed to the state machines
+  unsigned rejected[AVB_1722_1_PDU_REJECT_REASONS]; //!< PDUs dropped, by reason
+} avb_1722_1_pdu_stats_t;
+
+/** Clear the statistics */
+void avb_1722_1_pdu_check_init(void);
+
+/** Check a received PDU.
+ *
+ *  \param buf  the PDU, following the Ethernet header
+ *  \param len  the number of bytes received after the Ethernet header
+ *  \returns    the length of the PDU in bytes, which may be less than len
+ *              when the frame was padded, 0 if the PDU is not an ADP, ACMP
+ *              or AECP PDU, or minus the avb_1722_1_pdu_reject_t reason
+ *              it was rejected for
+ */
+int avb_1722_1_pdu_check(const unsigned char buf[], unsigned len);
+
+/** Copy out the statistics */
+void avb_1722_1_pdu_check_get_stats(REFERENCE_PARAM(avb_1722_1_pdu_stats_t, stats));
+
+#endif /* AVB_1722_1_PDU_CHECK_H_ */
@@ -0,0 +1,113 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "avb_1722_1.h"
+#include "avb_1722_1_tx_queue.h"
+
+#if AVB_1722_1_TX_BUFFERS < 0
+#error "AVB_1722_1_TX_BUFFERS must not be negative"
+#endif
+
+typedef struct tx_entry_t {
+  unsigned len;
+  unsigned ifnum;
+  unsigned queued_at;
+} tx_entry_t;
+
+#if AVB_1722_1_TX_BUFFERS > 0
+static unsigned int tx_buffers[AVB_1722_1_TX_BUFFERS][AVB_1722_1_PACKET_SIZE_WORDS];
+static tx_entry_t tx_entries[AVB_1722_1_TX_BUFFERS];
+#endif
+static unsigned tx_head;
+static unsigned tx_count;
+static avb_1722_1_tx_stats_t tx_stats;
+
+void avb_1722_1_tx_queue_init(void)
+{
+  tx_head = 0;
+  tx_count = 0;
+  memset(&tx_stats, 0, sizeof(tx_stats));
+}
+
+int avb_1722_1_tx_queue_count(void)
+{
+  return tx_count;
+}
+
+#if AVB_1722_1_TX_BUFFERS > 0
+void avb_1722_1_tx_queue_push(const unsigned char packet[],
+                              unsigned len,
+                              unsigned ifnum,
+                              unsigned now)
+{
+  unsigned i = tx_head + tx_count;
+
+  if (i >= AVB_1722_1_TX_BUFFERS)
+    i -= AVB_1722_1_TX_BUFFERS;
+  if (len > sizeof(tx_buffers[0]))
+    len = sizeof(tx_buffers[0]);
+
+  memcpy(tx_buffers[i], packet, len);
+  tx_entries[i].len = len;
+  tx_entries[i].ifnum = ifnum;
+  tx_entries[i].queued_at = now;
+
+  tx_count++;
+  if (tx_count > tx_stats.max_depth)
+    tx_stats.max_depth = tx_count;
+}
+
+const unsigned char *avb_1722_1_tx_queue_front(unsigned *len,
+                                               unsigned *ifnum)
+{
+  *len = tx_entries[tx_head].len;
+  *ifnum = tx_entries[tx_head].ifnum;
+  return (const unsigned char *) tx_buffers[tx_head];
+}
+
+void avb_1722_1_tx_queue_pop(unsigned now)
+{
+  unsigned latency = now - tx_entries[tx_head].queued_at;
+  unsigned bucket = 0;
+
+  // Bucket n holds latencies below 2^n
+  while (latency != 0 && bucket < AVB_1722_1_TX_LATENCY_BUCKETS - 1) {
+    latency >>= 1;
+    bucket++;
+  }
+  tx_stats.latency[bucket]++;
+  tx_stats.sent++;
+
+  tx_head++;
+  if (tx_head == AVB_1722_1_TX_BUFFERS)
+    tx_head = 0;
+  tx_count--;
+}
+#endif
+
+void avb_1722_1_tx_queue_get_stats(avb_1722_1_tx_stats_t *stats)
+{
+  *stats = tx_stats;
+}
+
+unsigned avb_1722_1_tx_latency_percentile(const avb_1722_1_tx_stats_t *stats,
+                                          unsigned percent)
+{
+  unsigned total = 0;
+  unsigned long long target;
+
+  for (int i = 0; i < AVB_1722_1_TX_LATENCY_BUCKETS; i++)
+    total += stats->latency[i];
+  if (total == 0)
+    return 0;
+
+  // The smallest count at or above the percentile, at least one packet
+  target = ((unsigned long long) total * percent + 99) / 100;
+  if (target == 0)
+    target = 1;
+  for (int i = 0; i < AVB_1722_1_TX_LATENCY_BUCKETS; i++) {
+    if (stats->latency[i] >= target)
+      return 1u << i;
+    target -= stats->latency[i];
+  }
+  return 1u << (AVB_1722_1_TX_LATENCY_BUCKETS - 1);
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef AVB_1722_1_TX_QUEUE_H_
+#define AVB_1722_1_TX_QUEUE_H_
+
+#include <xccompat.h>
+#include "avb_1722_1_default_conf.h"
+
+/* The 1722.1 transmit queue.
+
+   ADP, ACMP and AECP packets are built in avb_1722_1_buf and then copied
+   into one of AVB_1722_1_TX_BUFFERS buffers to wait for transmission, so
+   avb_1722_1_buf is free to build the next packet straight away. The
+   1722.1 task sends queued packets in order once it has no received
+   packets to handle, so a burst of commands from several controllers is
+   parsed and answered while earlier responses are still waiting for the
+   Ethernet MAC. A packet is sent immediately only when the queue is full,
+   or always when AVB_1722_1_TX_BUFFERS is 0 and there is no queue.
+
+   The time each packet spent in the queue is kept in a histogram with
+   power of two buckets for measuring response latency. */
+
+/** The number of latency histogram buckets. Bucket 0 counts packets
+ *  sent within one reference clock tick, bucket n > 0 those sent within
+ *  [2^(n-1), 2^n) ticks and the last bucket everything longer. */
+#define AVB_1722_1_TX_LATENCY_BUCKETS 28
+
+typedef struct avb_1722_1_tx_stats_t {
+  unsigned sent;          //!< Packets sent since the queue was initialised
+  unsigned max_depth;     //!< The most packets that have waited at once
+  unsigned latency[AVB_1722_1_TX_LATENCY_BUCKETS]; //!< Packets by time queued
+} avb_1722_1_tx_stats_t;
+
+/** Empty the queue and clear its statistics */
+void avb_1722_1_tx_queue_init(void);
+
+/** The number of packets waiting for transmission */
+int avb_1722_1_tx_queue_count(void);
+
+/** Queue a copy of a packet. The queue must not be full.
+ *
+ *  \param packet  the packet, starting with the Ethernet header
+ *  \param len     the packet length in bytes
+ *  \param ifnum   the interface to send on, or ETHERNET_ALL_INTERFACES
+ *  \param now     the reference clock time the packet was queued at
+ */
+void avb_1722_1_tx_queue_push(const unsigned char packet[],
+                              unsigned len,
+                              unsigned ifnum,
+                              unsigned now);
+
+#ifndef __XC__
+/** The oldest packet in the queue, which must not be empty */
+const unsigned char *avb_1722_1_tx_queue_front(unsigned *len,
+                                               unsigned *ifnum);
+#endif
+
+/** Remove the oldest packet from the queue once it has been sent.
+ *
+ *  \param now  the reference clock time the packet was sent at
+ */
+void avb_1722_1_tx_queue_pop(unsigned now);
+
+/** Copy out the queue statistics */
+void avb_1722_1_tx_queue_get_stats(REFERENCE_PARAM(avb_1722_1_tx_stats_t, stats));
+
+/** The time within which a percentage of packets were sent.
+ *
+ *  \returns  the upper bound in reference clock ticks of the histogram
+ *            bucket holding the percentile, or 0 if nothing has been sent
+ */
+unsigned avb_1722_1_tx_latency_percentile(REFERENCE_PARAM(const avb_1722_1_tx_stats_t, stats),
+                                          unsigned percent);
+
+#endif /* AVB_1722_1_TX_QUEUE_H_ */
@@ -49,6 +49,12 @@ typedef interface pull_if {
 void audio_input_sample_buffer(server push_if i_push, server pull_if i_pull);
 [[distributable]]
 void audio_output_sample_buffer(server push_if i_push, server pull_if i_pull);
+/** An audio output buffer pushed to by several tasks, such as a listener
+ *  and talkers monitoring their own streams */
+[[distributable]]
+void audio_output_sample_buffer_shared(server push_if i_push[num_push],
+                                       unsigned num_push,
+                                       server pull_if i_pull);
 
 typedef enum audio_io_t
 {
@@ -0,0 +1,113 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "audio_output_asrc.h"
+#include "audio_output_asrc_coefs.h"
+
+#define COEF_BITS 30
+#define PHASE_BITS 6
+
+#if (1 << PHASE_BITS) != AUDIO_OUTPUT_ASRC_PHASES
+#error "PHASE_BITS does not match AUDIO_OUTPUT_ASRC_PHASES"
+#endif
+
+// An output at history position p is the signal at input time p + DELAY
+#define DELAY (AUDIO_OUTPUT_ASRC_TAPS/2 - 1)
+
+void audio_output_asrc_init(audio_output_asrc_t *a)
+{
+  // Start with zeros before the first input so that output n is at input
+  // time n * ratio
+  memset(a->history, 0, sizeof(a->history));
+  a->count = DELAY;
+  a->pos = 0;
+  a->step = 1ULL << 32;
+  a->mark = -1;
+  a->mark_output = -1;
+  a->mark_delay = 0;
+}
+
+void audio_output_asrc_set_ratio(audio_output_asrc_t *a, unsigned int ratio)
+{
+  if (ratio < AUDIO_OUTPUT_ASRC_MIN_RATIO)
+    ratio = AUDIO_OUTPUT_ASRC_MIN_RATIO;
+  if (ratio > AUDIO_OUTPUT_ASRC_MAX_RATIO)
+    ratio = AUDIO_OUTPUT_ASRC_MAX_RATIO;
+  a->step = (unsigned long long) ratio << (32 - AUDIO_OUTPUT_ASRC_RATIO_BITS);
+}
+
+void audio_output_asrc_mark(audio_output_asrc_t *a, int index)
+{
+  if (a->mark < 0)
+    a->mark = a->count + index;
+}
+
+static inline long long dot(const int *x, const int *c)
+{
+  long long acc = 0;
+  for (int k = 0; k < AUDIO_OUTPUT_ASRC_TAPS; k++)
+    acc += (long long) x[k] * c[k];
+  return acc;
+}
+
+static inline int saturate(long long x)
+{
+  if (x > 0x7fffffffLL)
+    return 0x7fffffff;
+  if (x < -0x80000000LL)
+    return (int) 0x80000000;
+  return (int) x;
+}
+
+int audio_output_asrc_process(audio_output_asrc_t *a,
+                              const int *in,
+                              int n,
+                              int *out)
+{
+  unsigned long long pos = a->pos;
+  int count;
+  int n_out = 0;
+  int consumed;
+
+  memcpy(&a->history[a->count], in, n * sizeof(int));
+  count = a->count + n;
+  a->mark_output = -1;
+
+  while ((int) (pos >> 32) + AUDIO_OUTPUT_ASRC_TAPS <= count) {
+    const int *x = &a->history[pos >> 32];
+    unsigned frac = (unsigned) pos;
+    unsigned phase = frac >> (32 - PHASE_BITS);
+    unsigned interp = frac << PHASE_BITS;
+    long long y0 = dot(x, asrc_coefs[phase]);
+    long long y1 = dot(x, asrc_coefs[phase + 1]);
+
+    // Interpolate between the two phases with 16 bits of the remainder
+    y0 += ((y1 - y0) >> 16) * (interp >> 16);
+    out[n_out] = saturate(y0 >> COEF_BITS);
+
+    if (a->mark >= 0) {
+      long long t = (long long) pos + ((long long) DELAY << 32) -
+                    ((long long) a->mark << 32);
+      if (t >= 0) {
+        a->mark_output = n_out;
+        a->mark_delay = (unsigned) (t >> 16);
+        a->mark = -1;
+      }
+    }
+
+    n_out++;
+    pos += a->step;
+  }
+
+  // Keep the history from the first sample the next output needs
+  consumed = (int) (pos >> 32);
+  if (consumed > count)
+    consumed = count;
+  memmove(&a->history[0], &a->history[consumed],
+          (count - consumed) * sizeof(int));
+  a->count = count - consumed;
+  a->pos = pos - ((unsigned long long) consumed << 32);
+  if (a->mark >= 0)
+    a->mark -= consumed;
+
+  return n_out;
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __AUDIO_OUTPUT_ASRC_h__
+#define __AUDIO_OUTPUT_ASRC_h__
+
+#include <xccompat.h>
+#include "default_avb_conf.h"
+
+/* Asynchronous sample rate converter for media outputs that are not clocked
+   by their stream.
+
+   Each converted output FIFO resamples the incoming stream to its local
+   media clock as the listener writes it. The conversion ratio is steered
+   by the media clock server from the same presentation time error that
+   drives stream derived clock recovery, so a stream from any talker can be
+   played out on a local clock without a PLL. The converter is a fixed
+   point polyphase FIR with linear interpolation between phases, processed
+   a packet block at a time. */
+
+/** Enable the sample rate converter for media outputs whose media clock is
+ *  not derived from the output's own stream. */
+#ifndef AVB_MEDIA_OUTPUT_ASRC
+#define AVB_MEDIA_OUTPUT_ASRC 0
+#endif
+
+/** Filter length in input samples. Must match audio_output_asrc_coefs.h */
+#define AUDIO_OUTPUT_ASRC_TAPS   24
+/** Number of filter phases per input sample. Must match audio_output_asrc_coefs.h */
+#define AUDIO_OUTPUT_ASRC_PHASES 64
+
+/** Largest number of input samples per call of audio_output_asrc_process() */
+#define AUDIO_OUTPUT_ASRC_MAX_BLOCK 32
+
+/** Fractional bits of the conversion ratio passed to audio_output_asrc_set_ratio() */
+#define AUDIO_OUTPUT_ASRC_RATIO_BITS 30
+
+/** Limits of the conversion ratio, in input samples per output sample */
+#define AUDIO_OUTPUT_ASRC_MIN_RATIO (1u << (AUDIO_OUTPUT_ASRC_RATIO_BITS-1))
+#define AUDIO_OUTPUT_ASRC_MAX_RATIO (1u << (AUDIO_OUTPUT_ASRC_RATIO_BITS+1))
+
+/** Most outputs that one call of audio_output_asrc_process() can produce */
+#define AUDIO_OUTPUT_ASRC_MAX_OUTPUT (2*AUDIO_OUTPUT_ASRC_MAX_BLOCK+1)
+
+typedef struct audio_output_asrc_t {
+  int history[AUDIO_OUTPUT_ASRC_TAPS + AUDIO_OUTPUT_ASRC_MAX_BLOCK];
+  int count;                    //!< Number of valid samples in history
+  unsigned long long pos;       //!< Position of the next output in history, 32 fractional bits
+  unsigned long long step;      //!< Input samples per output sample, 32 fractional bits
+  int mark;                     //!< Index in history of the marked input sample, -1 if none
+  int mark_output;              //!< Output of the last process call at or after the mark, -1 if none
+  unsigned int mark_delay;      //!< Input samples from the mark to that output, 16 fractional bits
+} audio_output_asrc_t;
+
+/** Reset the converter to a ratio of 1 with an empty history */
+void audio_output_asrc_init(REFERENCE_PARAM(audio_output_asrc_t, a));
+
+/** Set the conversion ratio.
+ *
+ *  \param ratio  input samples per output sample with
+ *                AUDIO_OUTPUT_ASRC_RATIO_BITS fractional bits, clamped to
+ *                AUDIO_OUTPUT_ASRC_MIN_RATIO..AUDIO_OUTPUT_ASRC_MAX_RATIO
+ */
+void audio_output_asrc_set_ratio(REFERENCE_PARAM(audio_output_asrc_t, a),
+                                 unsigned int ratio);
+
+/** Mark an input sample of the next block so that the output it appears
+ *  in can be found after processing. Ignored if a mark is already pending.
+ *
+ *  \param index  the index of the sample in the next block
+ */
+void audio_output_asrc_mark(REFERENCE_PARAM(audio_output_asrc_t, a),
+                            int index);
+
+#ifndef __XC__
+/** Convert a block of input samples.
+ *
+ *  \param in   the input samples
+ *  \param n    the number of input samples, at most AUDIO_OUTPUT_ASRC_MAX_BLOCK
+ *  \param out  buffer for at least AUDIO_OUTPUT_ASRC_MAX_OUTPUT samples
+ *  \returns    the number of output samples written
+ */
+int audio_output_asrc_process(audio_output_asrc_t *a,
+                              const int *in,
+                              int n,
+                              int *out);
+#endif
+
+#endif // __AUDIO_OUTPUT_ASRC_h__
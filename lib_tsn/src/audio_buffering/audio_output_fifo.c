@@ -28,6 +28,10 @@ audio_output_fifo_init(buffer_handle_t s0, unsigned index)
   s->pending_init_notification = 0;
   s->last_notification_time = 0;
   s->volume = MAX_VOLUME;
+  s->underflows = 0;
+#if AVB_MEDIA_OUTPUT_MAILBOX
+  s->mailbox_enabled = 0;
+#endif
 }
 
 void
@@ -40,7 +44,8 @@ disable_audio_output_fifo(buffer_handle_t s0, unsigned index)
 }
 
 void
-enable_audio_output_fifo(buffer_handle_t s0, unsigned index, int media_clock)
+enable_audio_output_fifo(buffer_handle_t s0, unsigned index, int media_clock,
+                         int rate)
 {
   ofifo_t *s = (ofifo_t *)((struct output_finfo *)s0)->p_buffer[index];
 
@@ -56,6 +61,21 @@ enable_audio_output_fifo(buffer_handle_t s0, unsigned index, int media_clock)
   s->sample_count = 0;
   s->media_clock = media_clock;
   s->pending_init_notification = 1;
+#if AVB_MEDIA_OUTPUT_MAILBOX
+  // The channel is used until the media clock server is told of the stream
+  s->mailbox_enabled = 0;
+#endif
+#if AVB_MEDIA_OUTPUT_ASRC || AVB_MEDIA_OUTPUT_FRACTIONAL_DELAY
+  s->sample_period = rate ? 1000000000 / rate : 0;
+#endif
+#if AVB_MEDIA_OUTPUT_ASRC
+  // The media clock server enables the converter when it is told of the stream
+  s->asrc_enabled = 0;
+  audio_output_asrc_init(&s->asrc);
+#endif
+#if AVB_MEDIA_OUTPUT_FRACTIONAL_DELAY
+  audio_output_frac_delay_init(&s->frac_delay);
+#endif
 }
 
 
@@ -67,10 +87,26 @@ void audio_output_fifo_set_ptp_timestamp(buffer_handle_t s0,
 {
   ofifo_t *s = (ofifo_t *)((struct output_finfo *)s0)->p_buffer[index];
 
+#if AVB_MEDIA_OUTPUT_ASRC
+  if (s->asrc_enabled) {
+    // The marker is placed when the converter outputs the marked sample
+    if (s->marker == 0 && s->asrc.mark < 0) {
+      s->asrc_ptp_ts = ptp_ts;
+      audio_output_asrc_mark(&s->asrc, sample_number);
+    }
+    return;
+  }
+#endif
+
   if (s->marker == 0) {
 	unsigned int* new_marker = s->wrptr + sample_number;
 	if (new_marker >= END_OF_FIFO(s)) new_marker -= AUDIO_OUTPUT_FIFO_WORD_SIZE;
 
+#if AVB_MEDIA_OUTPUT_FRACTIONAL_DELAY
+	// The sample reaches the marked FIFO slot delayed by the filter
+	ptp_ts -= audio_output_frac_delay_ns(&s->frac_delay, s->sample_period);
+#endif
+
 	if (ptp_ts==0) ptp_ts = 1;
     s->ptp_ts = ptp_ts;
     s->local_ts = 0;
@@ -83,6 +119,104 @@ audio_output_fifo_pull_sample(buffer_handle_t s0,
                               unsigned index,
                               unsigned int timestamp);
 
+// Carry out a reply of the media clock server to the timing information
+static void
+fifo_command(ofifo_t *s, int cmd, int arg0, int arg1)
+{
+  switch (cmd)
+    {
+    case BUF_CTL_ADJUST_FILL:
+      {
+        int adjust = arg0;
+        unsigned int *new_wrptr;
+
+#if AVB_MEDIA_OUTPUT_FRACTIONAL_DELAY
+#if AVB_MEDIA_OUTPUT_ASRC
+        // The converter aligns to the presentation time itself
+        if (!s->asrc_enabled)
+#endif
+        adjust = audio_output_frac_delay_adjust(&s->frac_delay, adjust, arg1);
+#endif
+
+        new_wrptr = s->wrptr - adjust;
+        while (new_wrptr < START_OF_FIFO(s))
+          new_wrptr += (END_OF_FIFO(s) - START_OF_FIFO(s));
+
+        while (new_wrptr >= END_OF_FIFO(s))
+          new_wrptr -= (END_OF_FIFO(s) - START_OF_FIFO(s));
+
+        s->wrptr = new_wrptr;
+      }
+      s->state = LOCKED;
+      s->zero_flag = 0;
+      s->ptp_ts = 0;
+      s->local_ts = 0;
+      s->marker = (unsigned int *) 0;
+      break;
+    case BUF_CTL_RESET:
+      s->state = ZEROING;
+      if (s->wrptr == START_OF_FIFO(s))
+        s->zero_marker = END_OF_FIFO(s) - 1;
+      else
+        s->zero_marker = s->wrptr - 1;
+      s->zero_flag = 1;
+      *s->zero_marker = 1;
+      break;
+#if AVB_MEDIA_OUTPUT_ASRC
+    case BUF_CTL_SET_RATIO:
+      audio_output_asrc_set_ratio(&s->asrc, arg0);
+      break;
+#endif
+    default:
+      break;
+    }
+}
+
+#if AVB_MEDIA_OUTPUT_MAILBOX
+// 1722 thread
+static void
+post_mailbox_info(ofifo_t *s)
+{
+  volatile audio_output_fifo_mailbox_t *m = &s->mailbox;
+
+  m->info.locked = s->state == LOCKED;
+  m->info.ptp_ts = s->ptp_ts;
+  m->info.local_ts = s->local_ts;
+  m->info.rdptr = s->dptr - START_OF_FIFO(s);
+  m->info.wrptr = s->wrptr - START_OF_FIFO(s);
+  m->info.underflows = s->underflows;
+  s->ptp_ts = 0;
+  s->local_ts = 0;
+  s->marker = (unsigned int *) 0;
+  m->state = OFIFO_MAILBOX_INFO;
+}
+
+// Media clock server
+int
+audio_output_fifo_get_mailbox_info(int fifo, audio_output_fifo_info_t *info)
+{
+  volatile audio_output_fifo_mailbox_t *m = &((ofifo_t *) fifo)->mailbox;
+
+  if (m->state != OFIFO_MAILBOX_INFO)
+    return 0;
+
+  *info = m->info;
+  return 1;
+}
+
+// Media clock server
+void
+audio_output_fifo_post_mailbox_cmd(int fifo, int cmd, int arg0, int arg1)
+{
+  volatile audio_output_fifo_mailbox_t *m = &((ofifo_t *) fifo)->mailbox;
+
+  m->cmd = cmd;
+  m->arg[0] = arg0;
+  m->arg[1] = arg1;
+  m->state = OFIFO_MAILBOX_COMMAND;
+}
+#endif
+
 // 1722 thread
 void
 audio_output_fifo_maintain(buffer_handle_t s0,
@@ -92,6 +226,7 @@ audio_output_fifo_maintain(buffer_handle_t s0,
 {
   ofifo_t *s = (ofifo_t *)((struct output_finfo *)s0)->p_buffer[index];
   unsigned time_since_last_notification;
+  int pending;
 
   if (s->pending_init_notification && !(*notified_buf_ctl)) {
     notify_buf_ctl_of_new_stream(buf_ctl, (int)s); // TODO: This can pass the index
@@ -99,6 +234,20 @@ audio_output_fifo_maintain(buffer_handle_t s0,
     s->pending_init_notification = 0;
   }
 
+  pending = *notified_buf_ctl;
+
+#if AVB_MEDIA_OUTPUT_MAILBOX
+  if (s->mailbox_enabled) {
+    volatile audio_output_fifo_mailbox_t *m = &s->mailbox;
+
+    if (m->state == OFIFO_MAILBOX_COMMAND) {
+      fifo_command(s, m->cmd, m->arg[0], m->arg[1]);
+      m->state = OFIFO_MAILBOX_EMPTY;
+    }
+    pending = m->state != OFIFO_MAILBOX_EMPTY;
+  }
+#endif
+
   switch (s->state)
     {
     case DISABLED:
@@ -130,20 +279,109 @@ audio_output_fifo_maintain(buffer_handle_t s0,
         (signed) s->sample_count - (signed) s->last_notification_time;
       if (s->ptp_ts != 0 &&
           s->local_ts != 0 &&
-          !(*notified_buf_ctl)
+          !pending
           &&
           (s->last_notification_time == 0 ||
            time_since_last_notification > NOTIFICATION_PERIOD)
           )
         {
-          notify_buf_ctl_of_info(buf_ctl, (int)s); // TODO: FIXME
-          *notified_buf_ctl = 1;
+#if AVB_MEDIA_OUTPUT_MAILBOX
+          if (s->mailbox_enabled)
+            post_mailbox_info(s);
+          else
+#endif
+          {
+            notify_buf_ctl_of_info(buf_ctl, (int)s); // TODO: FIXME
+            *notified_buf_ctl = 1;
+          }
           s->last_notification_time = s->sample_count;
         }
       break;
     }
 }
 
+#ifdef AUDIO_OUTPUT_FIFO_VOLUME_CONTROL
+// With volume control the FIFO holds 24 bit samples. They are kept signed
+// until written so that they can be filtered.
+#define FIFO_SAMPLE(sample) ((sample) & 0xffffff)
+#else
+#define FIFO_SAMPLE(sample) (sample)
+#endif
+
+static inline int
+convert_sample(int sample, int volume)
+{
+  sample = __builtin_bswap32(sample);
+
+#ifndef AVB_1722_FORMAT_SAF
+  sample = sample << 8;
+#endif
+
+#ifdef AUDIO_OUTPUT_FIFO_VOLUME_CONTROL
+  {
+    // Multiply volume into upper word of 64 bit result
+    int h=0, l=0;
+    asm ("maccs %0,%1,%2,%3":"+r"(h),"+r"(l):"r"(sample),"r"(volume));
+    sample = h >> 6;
+  }
+#else
+  sample = (sample * volume);
+#endif
+  return sample;
+}
+
+#if AVB_MEDIA_OUTPUT_ASRC
+// Convert the samples to the local media clock rate a block at a time and
+// write the result to the FIFO
+static void
+asrc_push(ofifo_t *s, unsigned int *sample_ptr, int stride, int n, int volume)
+{
+  int in[AUDIO_OUTPUT_ASRC_MAX_BLOCK];
+  int out[AUDIO_OUTPUT_ASRC_MAX_OUTPUT];
+  unsigned int *wrptr = s->wrptr;
+  int i = 0;
+
+  while (i < n) {
+    int n_in = 0;
+    int n_out;
+
+    while (i < n && n_in < AUDIO_OUTPUT_ASRC_MAX_BLOCK) {
+      in[n_in++] = convert_sample(*sample_ptr, volume);
+      sample_ptr += stride;
+      i += stride;
+    }
+
+    n_out = audio_output_asrc_process(&s->asrc, in, n_in, out);
+
+    for (int j=0;j<n_out;j++) {
+      unsigned int *new_wrptr = wrptr+1;
+
+      if (new_wrptr == END_OF_FIFO(s)) new_wrptr = START_OF_FIFO(s);
+
+      if (j == s->asrc.mark_output) {
+        unsigned int ptp_ts = s->asrc_ptp_ts +
+          (unsigned int) (((unsigned long long) s->asrc.mark_delay * s->sample_period) >> 16);
+        if (ptp_ts==0) ptp_ts = 1;
+        s->ptp_ts = ptp_ts;
+        s->local_ts = 0;
+        s->marker = wrptr;
+      }
+
+      if (new_wrptr != s->dptr) {
+        *wrptr = FIFO_SAMPLE(out[j]);
+        wrptr = new_wrptr;
+      }
+      else {
+        // Overflow
+      }
+    }
+    s->sample_count += n_out;
+  }
+
+  s->wrptr = wrptr;
+}
+#endif
+
 // 1722 thread
 void
 audio_output_fifo_strided_push(buffer_handle_t s0,
@@ -165,28 +403,22 @@ audio_output_fifo_strided_push(buffer_handle_t s0,
 #endif
   int count=0;
 
+#if AVB_MEDIA_OUTPUT_ASRC
+  if (s->asrc_enabled) {
+    asrc_push(s, sample_ptr, stride, n, volume);
+    return;
+  }
+#endif
+
   for(i=0;i<n;i+=stride) {
     count++;
-    sample = *sample_ptr;
-    sample = __builtin_bswap32(sample);
+    sample = convert_sample(*sample_ptr, volume);
     sample_ptr += stride;
 
-#ifndef AVB_1722_FORMAT_SAF
-    sample = sample << 8;
-#endif
-
-#ifdef AUDIO_OUTPUT_FIFO_VOLUME_CONTROL
-
-    {
-        // Multiply volume into upper word of 64 bit result
-    	int h=0, l=0;
-		asm ("maccs %0,%1,%2,%3":"+r"(h),"+r"(l):"r"(sample),"r"(volume));
-		sample = h >> 6;
-	    sample &= 0xffffff;
-	}
-#else
-    sample = (sample * volume);
+#if AVB_MEDIA_OUTPUT_FRACTIONAL_DELAY
+    sample = audio_output_frac_delay_filter(&s->frac_delay, sample);
 #endif
+    sample = FIFO_SAMPLE(sample);
 
     new_wrptr = wrptr+1;
 
@@ -225,6 +457,7 @@ audio_output_fifo_handle_buf_ctl(chanend buf_ctl,
                         s->local_ts,
                         s->dptr - START_OF_FIFO(s),
                         s->wrptr - START_OF_FIFO(s),
+                        s->underflows,
                         tmr);
       s->ptp_ts = 0;
       s->local_ts = 0;
@@ -232,50 +465,49 @@ audio_output_fifo_handle_buf_ctl(chanend buf_ctl,
       break;
     }
     case BUF_CTL_REQUEST_NEW_STREAM_INFO: {
-      send_buf_ctl_new_stream_info(buf_ctl,
-                                   s->media_clock);
+      int mailbox;
+      int asrc = send_buf_ctl_new_stream_info(buf_ctl,
+                                              s->media_clock,
+                                              &mailbox);
+#if AVB_MEDIA_OUTPUT_ASRC
+      s->asrc_enabled = asrc;
+#else
+      (void) asrc;
+#endif
+#if AVB_MEDIA_OUTPUT_MAILBOX
+      // The server does not look at the mailbox until this is acknowledged
+      s->mailbox.state = OFIFO_MAILBOX_EMPTY;
+      s->mailbox_enabled = mailbox;
+#else
+      (void) mailbox;
+#endif
       buf_ctl_ack(buf_ctl);
       *buf_ctl_notified = 0;
       break;
     }
     case BUF_CTL_ADJUST_FILL:
       {
-        int adjust;
-        unsigned int *new_wrptr;
+        int adjust, fraction;
         adjust = get_buf_ctl_adjust(buf_ctl);
-
-        new_wrptr = s->wrptr - adjust;
-        while (new_wrptr < START_OF_FIFO(s))
-          new_wrptr += (END_OF_FIFO(s) - START_OF_FIFO(s));
-
-        while (new_wrptr >= END_OF_FIFO(s))
-          new_wrptr -= (END_OF_FIFO(s) - START_OF_FIFO(s));
-
-        s->wrptr = new_wrptr;
+        fraction = get_buf_ctl_adjust(buf_ctl);
+        fifo_command(s, cmd, adjust, fraction);
       }
-      s->state = LOCKED;
-      s->zero_flag = 0;
-      s->ptp_ts = 0;
-      s->local_ts = 0;
-      s->marker = (unsigned int *) 0;
       buf_ctl_ack(buf_ctl);
       *buf_ctl_notified = 0;
       break;
     case BUF_CTL_RESET:
-      s->state = ZEROING;
-      if (s->wrptr == START_OF_FIFO(s))
-        s->zero_marker = END_OF_FIFO(s) - 1;
-      else
-        s->zero_marker = s->wrptr - 1;
-      s->zero_flag = 1;
-      *s->zero_marker = 1;
+    case BUF_CTL_ACK:
+      fifo_command(s, cmd, 0, 0);
       buf_ctl_ack(buf_ctl);
       *buf_ctl_notified = 0;
       break;
-    case BUF_CTL_ACK:
+#if AVB_MEDIA_OUTPUT_ASRC
+    case BUF_CTL_SET_RATIO:
+      fifo_command(s, cmd, get_buf_ctl_adjust(buf_ctl), 0);
       buf_ctl_ack(buf_ctl);
       *buf_ctl_notified = 0;
       break;
+#endif
     default:
       break;
     }
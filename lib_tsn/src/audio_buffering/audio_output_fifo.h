@@ -5,15 +5,41 @@
 #include <xccompat.h>
 #include <xc2compat.h>
 #include "default_avb_conf.h"
+#include "avb_1722_common.h"
 #include "audio_buffering.h"
+#include "audio_output_asrc.h"
+#include "audio_output_frac_delay.h"
 
 #ifndef AVB_MAX_AUDIO_SAMPLE_RATE
 #define AVB_MAX_AUDIO_SAMPLE_RATE (48000)
 #endif
 
+#if AVB_TALKER_LOCAL_MONITOR
+/** The longest presentation time in ns of a source played on local outputs.
+ *  A talker rejects a monitor for a source with a longer one. */
+#ifndef AVB_TALKER_LOCAL_MONITOR_MAX_DELAY_NS
+#define AVB_TALKER_LOCAL_MONITOR_MAX_DELAY_NS AVB_DEFAULT_PRESENTATION_TIME_DELAY_NS
+#endif
+#endif
+
 #ifndef AUDIO_OUTPUT_FIFO_WORD_SIZE
+#if AVB_TALKER_LOCAL_MONITOR
+// A local monitor receives its stream a whole presentation time before it
+// is played, so the FIFO holds that many samples more than a listener's
+#define AUDIO_OUTPUT_FIFO_WORD_SIZE (AVB_MAX_AUDIO_SAMPLE_RATE/450 + \
+  (AVB_MAX_AUDIO_SAMPLE_RATE/100 * (AVB_TALKER_LOCAL_MONITOR_MAX_DELAY_NS/10000) + 999) / 1000)
+#else
 #define AUDIO_OUTPUT_FIFO_WORD_SIZE (AVB_MAX_AUDIO_SAMPLE_RATE/450)
 #endif
+#endif
+
+/** Exchange timing information between the output FIFOs and the media clock
+ *  server through shared memory when both are on the same tile, rather than
+ *  the buffer control channel. Off by default, so that every FIFO uses the
+ *  channel protocol unless an application asks for the mailbox. */
+#ifndef AVB_MEDIA_OUTPUT_MAILBOX
+#define AVB_MEDIA_OUTPUT_MAILBOX 0
+#endif
 
 #define START_OF_FIFO(s) ((unsigned int*)&((s)->fifo[0]))
 #define END_OF_FIFO(s)   ((unsigned int*)&((s)->fifo[AUDIO_OUTPUT_FIFO_WORD_SIZE]))
@@ -25,6 +51,31 @@ typedef enum ofifo_state_t {
   LOCKED    //!< Clock recovery is locked and working
 } ofifo_state_t;
 
+/** Timing information that a FIFO reports to the media clock server */
+typedef struct audio_output_fifo_info_t {
+  int locked;                               //!< Set if the FIFO is locked
+  unsigned int ptp_ts;                      //!< PTP timestamp of the marked sample
+  unsigned int local_ts;                    //!< Ref clock time the marked sample played out
+  unsigned int rdptr;                       //!< Read index
+  unsigned int wrptr;                       //!< Write index
+  unsigned int underflows;                  //!< Underflow count
+} audio_output_fifo_info_t;
+
+typedef enum ofifo_mailbox_state_t {
+  OFIFO_MAILBOX_EMPTY,                      //!< Owned by the FIFO
+  OFIFO_MAILBOX_INFO,                       //!< Timing information posted, owned by the media clock server
+  OFIFO_MAILBOX_COMMAND                     //!< Reply posted, owned by the FIFO
+} ofifo_mailbox_state_t;
+
+/** Shared memory slot between a FIFO and the media clock server. Each side
+ *  only writes the slot while it owns it and hands it over by writing the
+ *  state last. */
+typedef struct audio_output_fifo_mailbox_t {
+  int state;
+  audio_output_fifo_info_t info;
+  int cmd;                                  //!< One of the BUF_CTL commands
+  int arg[2];
+} audio_output_fifo_mailbox_t;
 
 struct audio_output_fifo_data_t {
   int zero_flag;							//!< When set, the FIFO will output zero samples instead of its contents
@@ -40,6 +91,22 @@ struct audio_output_fifo_data_t {
   int media_clock;							//!<
   int pending_init_notification;			//!<
   int volume;                               //!< The linear volume multipler in 2.30 signed fixed point format
+  unsigned int underflows;                  //!< The number of samples requested from an empty FIFO while locked
+#if AVB_MEDIA_OUTPUT_MAILBOX
+  int mailbox_enabled;                      //!< When set, the media clock server is on this tile and uses the mailbox
+  audio_output_fifo_mailbox_t mailbox;      //!< Timing information and replies exchanged with the media clock server
+#endif
+#if AVB_MEDIA_OUTPUT_ASRC || AVB_MEDIA_OUTPUT_FRACTIONAL_DELAY
+  int sample_period;                        //!< The stream sample period in ns
+#endif
+#if AVB_MEDIA_OUTPUT_ASRC
+  int asrc_enabled;                         //!< When set, samples are converted to the rate of the local media clock
+  unsigned int asrc_ptp_ts;                 //!< The PTP timestamp of the sample marked in the converter
+  audio_output_asrc_t asrc;                 //!< The sample rate converter state
+#endif
+#if AVB_MEDIA_OUTPUT_FRACTIONAL_DELAY
+  audio_output_frac_delay_t frac_delay;     //!< Sub-sample alignment of the stream to its presentation time
+#endif
   unsigned int fifo[AUDIO_OUTPUT_FIFO_WORD_SIZE];
 };
 
@@ -57,6 +124,22 @@ typedef struct ofifo_t {
   int media_clock;
   int pending_init_notification;
   int volume;
+  unsigned int underflows;
+#if AVB_MEDIA_OUTPUT_MAILBOX
+  int mailbox_enabled;
+  audio_output_fifo_mailbox_t mailbox;
+#endif
+#if AVB_MEDIA_OUTPUT_ASRC || AVB_MEDIA_OUTPUT_FRACTIONAL_DELAY
+  int sample_period;
+#endif
+#if AVB_MEDIA_OUTPUT_ASRC
+  int asrc_enabled;
+  unsigned int asrc_ptp_ts;
+  audio_output_asrc_t asrc;
+#endif
+#if AVB_MEDIA_OUTPUT_FRACTIONAL_DELAY
+  audio_output_frac_delay_t frac_delay;
+#endif
   unsigned int fifo[AUDIO_OUTPUT_FIFO_WORD_SIZE];
 } ofifo_t;
 
@@ -81,17 +164,24 @@ void disable_audio_output_fifo(buffer_handle_t s, unsigned index);
  * \brief Enable a FIFO
  *
  * This starts samples flowing through the FIFO
+ *
+ * \param s handle to FIFO buffers
+ * \param index which buffer to operate on
+ * \param media_clock the media clock the FIFO is played out on
+ * \param rate the sample rate of the stream in Hz
  */
 void enable_audio_output_fifo(buffer_handle_t s,
                               unsigned index,
-                              int media_clock);
+                              int media_clock,
+                              int rate);
 
 /**
  *  \brief Perform maintanance on the FIFO, called periodically
  *
  *  This should be called periodically to allow the FIFO to
  *  perform tasks such as informing the clock recovery thread
- *  of some new timing information.
+ *  of some new timing information. When the FIFO uses a mailbox
+ *  this also carries out the replies of the clock recovery thread.
  *
  *  \param s handle to FIFO buffers
  *  \param index which buffer to operate on
@@ -162,6 +252,8 @@ audio_output_fifo_pull_sample(buffer_handle_t s0,
   {
     // Underflow
     // printstrln("Media output FIFO underflow");
+    if (s->state == LOCKED)
+      s->underflows++;
     return 0;
   }
 
@@ -229,6 +321,32 @@ audio_output_fifo_handle_buf_ctl(chanend buf_ctl,
                                  REFERENCE_PARAM(int, buf_ctl_notified),
                                  timer tmr);
 
+/**
+ *  \brief Collect the timing information posted in a FIFO's mailbox
+ *
+ *  Called by the media clock server for FIFOs on its own tile. When this
+ *  returns non-zero the server owns the mailbox until it posts a reply
+ *  with audio_output_fifo_post_mailbox_cmd().
+ *
+ *  \param fifo the address of the FIFO
+ *  \param info the timing information
+ *  \returns non-zero if timing information was waiting
+ */
+int audio_output_fifo_get_mailbox_info(int fifo,
+                                       REFERENCE_PARAM(audio_output_fifo_info_t, info));
+
+/**
+ *  \brief Post a reply to the timing information in a FIFO's mailbox
+ *
+ *  The FIFO carries out the command the next time it is maintained.
+ *
+ *  \param fifo the address of the FIFO
+ *  \param cmd one of the BUF_CTL commands
+ *  \param arg0 first argument of the command
+ *  \param arg1 second argument of the command
+ */
+void audio_output_fifo_post_mailbox_cmd(int fifo, int cmd, int arg0, int arg1);
+
 /**
  *  \brief Set the volume control multiplier for the media FIFO
  *
@@ -0,0 +1,66 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "audio_output_frac_delay.h"
+
+#define ONE (1 << AUDIO_OUTPUT_FRAC_DELAY_BITS)
+
+// Product of three values with AUDIO_OUTPUT_FRAC_DELAY_BITS fractional bits
+// divided by n, with 30 fractional bits
+static int product(long long a, long long b, long long c, int n)
+{
+  return (int) ((a * b * c) / ((long long) n << (3 * AUDIO_OUTPUT_FRAC_DELAY_BITS - 30)));
+}
+
+void audio_output_frac_delay_init(audio_output_frac_delay_t *f)
+{
+  memset(f->history, 0, sizeof(f->history));
+  audio_output_frac_delay_set(f, 0);
+}
+
+void audio_output_frac_delay_set(audio_output_frac_delay_t *f,
+                                 unsigned int delay)
+{
+  // Lagrange interpolation through the taps at delays 0 to 3 samples,
+  // evaluated at a delay of 1 + d
+  long long d = delay & (ONE - 1);
+
+  f->delay = (unsigned int) d;
+  f->coef[0] = -product(d, d - ONE, d - 2*ONE, 6);
+  f->coef[2] = -product(d + ONE, d, d - 2*ONE, 2);
+  f->coef[3] = product(d + ONE, d, d - ONE, 6);
+  // The taps sum to one, so take the rounding error in the largest
+  f->coef[1] = (1 << 30) - f->coef[0] - f->coef[2] - f->coef[3];
+}
+
+int audio_output_frac_delay_adjust(audio_output_frac_delay_t *f,
+                                   int adjust,
+                                   int fraction)
+{
+  // Shorten the FIFO by adjust + fraction samples in total, splitting it
+  // into whole samples and a filter delay in [0, 1)
+  int delay = (int) f->delay - fraction;
+
+  while (delay < 0) {
+    delay += ONE;
+    adjust++;
+  }
+  while (delay >= ONE) {
+    delay -= ONE;
+    adjust--;
+  }
+  audio_output_frac_delay_set(f, delay);
+  return adjust;
+}
+
+int audio_output_frac_delay_fraction(int diff, int sample_diff, int sample_period)
+{
+  long long remainder = diff - (long long) sample_diff * sample_period;
+  return (int) ((remainder << AUDIO_OUTPUT_FRAC_DELAY_BITS) / sample_period);
+}
+
+unsigned int audio_output_frac_delay_ns(audio_output_frac_delay_t *f,
+                                        int sample_period)
+{
+  return (unsigned int) (((unsigned long long) (ONE + f->delay) * sample_period)
+                         >> AUDIO_OUTPUT_FRAC_DELAY_BITS);
+}
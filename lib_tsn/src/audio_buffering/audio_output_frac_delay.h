@@ -0,0 +1,98 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __AUDIO_OUTPUT_FRAC_DELAY_h__
+#define __AUDIO_OUTPUT_FRAC_DELAY_h__
+
+#include <xccompat.h>
+#include "default_avb_conf.h"
+
+/* Sub-sample playout alignment for media outputs.
+
+   When an output FIFO locks, the media clock server can only move the
+   FIFO write pointer by whole samples, which leaves up to a sample of
+   presentation time error between devices. With fractional delay enabled
+   the FIFO also passes the stream through a 4 tap Lagrange interpolator
+   whose delay is set from the fractional part of the error at lock. The
+   filter delays the stream by one sample plus a fraction in [0, 1); a
+   fraction of zero passes samples through unchanged. The cost is some
+   loss of treble at fractions near one half, down to about -5dB at 18kHz
+   for a 48kHz stream, so this is left off by default. */
+
+/** Enable sub-sample presentation time alignment of media outputs */
+#ifndef AVB_MEDIA_OUTPUT_FRACTIONAL_DELAY
+#define AVB_MEDIA_OUTPUT_FRACTIONAL_DELAY 0
+#endif
+
+/** Fractional bits of the delay and of the fraction sent by the server */
+#define AUDIO_OUTPUT_FRAC_DELAY_BITS 16
+
+typedef struct audio_output_frac_delay_t {
+  int coef[4];              //!< Filter coefficients, 30 fractional bits
+  int history[3];           //!< The last three input samples, newest first
+  unsigned int delay;       //!< Delay beyond one sample, AUDIO_OUTPUT_FRAC_DELAY_BITS fractional bits
+} audio_output_frac_delay_t;
+
+/** Reset the filter to a delay of exactly one sample with an empty history */
+void audio_output_frac_delay_init(REFERENCE_PARAM(audio_output_frac_delay_t, f));
+
+/** Set the fractional part of the delay.
+ *
+ *  \param delay  the delay beyond one sample, less than
+ *                1 << AUDIO_OUTPUT_FRAC_DELAY_BITS
+ */
+void audio_output_frac_delay_set(REFERENCE_PARAM(audio_output_frac_delay_t, f),
+                                 unsigned int delay);
+
+/** Take up the fraction of a presentation time error in the filter delay.
+ *
+ *  \param adjust    the number of whole samples the FIFO is to be shortened by
+ *  \param fraction  the fraction of a sample the FIFO is late by beyond
+ *                   adjust, with AUDIO_OUTPUT_FRAC_DELAY_BITS fractional bits,
+ *                   between -1 and 1 sample
+ *  \returns         the number of whole samples to shorten the FIFO by with
+ *                   the new filter delay
+ */
+int audio_output_frac_delay_adjust(REFERENCE_PARAM(audio_output_frac_delay_t, f),
+                                   int adjust,
+                                   int fraction);
+
+/** The part of a presentation time error beyond whole samples, as sent
+ *  with BUF_CTL_ADJUST_FILL.
+ *
+ *  \param diff           the presentation time error in ns, positive if late
+ *  \param sample_diff    the whole samples of the error, diff / sample_period
+ *  \param sample_period  the stream sample period in ns
+ *  \returns              the rest of the error in samples, with
+ *                        AUDIO_OUTPUT_FRAC_DELAY_BITS fractional bits
+ */
+int audio_output_frac_delay_fraction(int diff, int sample_diff, int sample_period);
+
+/** The total delay of the filter in ns
+ *
+ *  \param sample_period  the stream sample period in ns
+ */
+unsigned int audio_output_frac_delay_ns(REFERENCE_PARAM(audio_output_frac_delay_t, f),
+                                        int sample_period);
+
+#ifndef __XC__
+static inline int audio_output_frac_delay_filter(audio_output_frac_delay_t *f,
+                                                 int x)
+{
+  long long acc = (long long) f->coef[0] * x +
+                  (long long) f->coef[1] * f->history[0] +
+                  (long long) f->coef[2] * f->history[1] +
+                  (long long) f->coef[3] * f->history[2];
+
+  f->history[2] = f->history[1];
+  f->history[1] = f->history[0];
+  f->history[0] = x;
+
+  acc >>= 30;
+  if (acc > 0x7fffffffLL)
+    return 0x7fffffff;
+  if (acc < -0x80000000LL)
+    return (int) 0x80000000;
+  return (int) acc;
+}
+#endif
+
+#endif // __AUDIO_OUTPUT_FRAC_DELAY_h__
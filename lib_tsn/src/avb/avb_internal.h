@@ -96,6 +96,11 @@ unsigned avb_get_source_stream_index_from_pointer(avb_source_info_t *unsafe p);
  */
 unsigned avb_get_sink_stream_index_from_pointer(avb_sink_info_t *unsafe p);
 
+/** Get the filtered path delay of a PTP port and the variance of the
+ *  estimate (in ns^2), as last polled from the PTP server.
+ */
+int get_avb_ptp_port_pdelay(int srcport, REFERENCE_PARAM(unsigned, pdelay), REFERENCE_PARAM(unsigned, variance));
+
 unsigned avb_get_source_stream_index_from_stream_id(unsigned int stream_id[2]);
 unsigned avb_get_sink_stream_index_from_stream_id(unsigned int stream_id[2]);
 
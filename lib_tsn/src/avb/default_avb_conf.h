@@ -18,6 +18,12 @@
 #define AVB_NUM_MEDIA_INPUTS 8
 #endif
 
+/** Let talkers play their own streams on local media outputs, in step
+ *  with remote listeners. See set_source_monitor_map(). */
+#ifndef AVB_TALKER_LOCAL_MONITOR
+#define AVB_TALKER_LOCAL_MONITOR 0
+#endif
+
 #ifndef AVB_1722_1_TALKER_ENABLED
 #define AVB_1722_1_TALKER_ENABLED 1
 #endif
@@ -0,0 +1,36 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+
+#ifndef _media_clock_pll_ratio_h_
+#define _media_clock_pll_ratio_h_
+#include "i2c.h"
+#include "avb.h"
+
+/** The ratio register of a fractional-N PLL that multiplies a fixed
+ *  reference up to the master clock of one media clock */
+typedef struct media_clock_pll_ratio_config_t {
+  unsigned clock_num;           //!< The media clock the PLL generates
+  unsigned char device_addr;    //!< 7-bit I2C address of the PLL
+  unsigned char ratio_reg;      //!< Address of the most significant ratio byte,
+                                //!< including any auto-increment flag
+  unsigned ratio_bytes;         //!< Width of the ratio register in bytes, up to 4
+  unsigned frac_bits;           //!< Fractional bits of the ratio
+  unsigned ref_hz;              //!< PLL reference frequency
+  unsigned mclks_per_word;      //!< Master clocks per sample
+} media_clock_pll_ratio_config_t;
+
+/** Media clock output driver for a fractional-N PLL. The ratio is
+ *  written over I2C each time the recovered rate of the clock changes,
+ *  so the PLL must already be set up to use its ratio register (for
+ *  example by audio_clock_CS2300CP_init()). Other clocks are reported as
+ *  ``MEDIA_CLOCK_OUTPUT_PLL_REFERENCE``.
+ *
+ *  \param i_clk_out  server interface to gptp_media_clock_server()
+ *  \param i2c        client interface to the I2C bus of the PLL
+ *  \param config     the PLL's ratio register
+ */
+[[combinable]]
+void media_clock_pll_ratio_driver(server interface media_clock_output_if i_clk_out,
+                                  client interface i2c_master_if i2c,
+                                  media_clock_pll_ratio_config_t config);
+
+#endif
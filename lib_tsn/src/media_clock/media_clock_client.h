@@ -2,6 +2,8 @@
 #ifndef __media_clock_client_h__
 #define __media_clock_client_h__
 
+#include <xccompat.h>
+
 #define CLK_CTL_SET_RATE 0x1
 #define CLK_CTL_STOP     0x2
 
@@ -24,6 +26,7 @@
 #define BUF_CTL_RESET 16
 #define BUF_CTL_NEW_STREAM 17
 #define BUF_CTL_REQUEST_NEW_STREAM_INFO 18
+#define BUF_CTL_SET_RATIO 19
 
 void notify_buf_ctl_of_info(chanend buf_ctl, int stream_num);
 void notify_buf_ctl_of_new_stream(chanend buf_ctl, int stream_num);
@@ -39,7 +42,12 @@ void send_buf_ctl_info(chanend buf_ctl,
                        unsigned int local_ts,
                        unsigned int rdptr,
                        unsigned int wrptr,
+                       unsigned int underflows,
                        timer tmr);
 
-void send_buf_ctl_new_stream_info(chanend buf_ctl,
-                                  int media_clock);
+/** Returns non-zero if the FIFO should convert its stream to the rate of
+ *  the media clock. mailbox is set if the media clock server is on the same
+ *  tile and the FIFO should report to it through its mailbox. */
+int send_buf_ctl_new_stream_info(chanend buf_ctl,
+                                 int media_clock,
+                                 REFERENCE_PARAM(int, mailbox));
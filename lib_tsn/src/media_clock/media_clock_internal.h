@@ -4,6 +4,7 @@
 #include <xccompat.h>
 #include "default_avb_conf.h"
 #include "avb.h"
+#include "media_clock_synth.h"
 
 #ifndef AVB_NUM_MEDIA_CLOCKS
 #define AVB_NUM_MEDIA_CLOCKS 1
@@ -17,17 +18,22 @@
 #define PLL_TO_WORD_MULTIPLIER 100
 #endif
 
+/** The PLL gain profile used for stream derived clocks until changed with
+ *  set_device_media_clock_pll_profile() */
+#ifndef MEDIA_CLOCK_PLL_PROFILE
+#define MEDIA_CLOCK_PLL_PROFILE MEDIA_CLOCK_PLL_PROFILE_CS2100
+#endif
+
 /** A description of a media clock */
 typedef struct media_clock_t {
   media_clock_info_t info;
+  enum media_clock_output_type_t output_type; //!< How the rate reaches the audio clock
   unsigned int wordLength;
-  unsigned int baseLengthRemainder;
-  unsigned int wordTime;
-  unsigned int baseLength;
-  unsigned int lowBits;
-  int count;
+  unsigned int ref_num;             //!< Half period of the PLL reference in words,
+  unsigned int ref_den;             //!< as the ratio ref_num/ref_den
+  media_clock_synth_t synth;        //!< Generator for the PLL reference edges
+  unsigned int port_to_timer;       //!< Offset from port time to timer time
   unsigned int next_event;
-  unsigned int bit;
 } media_clock_t;
 
 
@@ -57,4 +63,34 @@ void update_media_clock_stream_info(int clock_index,
 
 void inform_media_clock_of_lock(int clock_index);
 
+/** Select the loop gains of a clock's recovery.
+ *
+ *  \returns 0 if the profile is not supported, in which case the gains
+ *           are left unchanged
+ */
+int set_media_clock_pll_profile(int clock_index, int profile);
+
+/** Start the ratio control of a sample rate converted output */
+void init_media_output_asrc(int output, unsigned int rate, unsigned int time);
+
+/** The converted output FIFO has been re-aligned */
+void inform_media_output_asrc_of_lock(int output);
+
+/** Run the ratio control of a converted output on a FIFO report.
+ *
+ *  \returns the conversion ratio with AUDIO_OUTPUT_ASRC_RATIO_BITS
+ *           fractional bits
+ */
+unsigned int update_media_output_asrc(int output,
+                                      unsigned int local_ts,
+                                      unsigned int outgoing_ptp_ts,
+                                      unsigned int presentation_ts,
+                                      int locked,
+                                      int fill,
+                                      unsigned int time);
+
+/** Fill in the read only clock recovery fields of a media clock's info */
+void get_media_clock_recovery_status(int clock_index,
+                                     REFERENCE_PARAM(media_clock_info_t, info));
+
 #endif
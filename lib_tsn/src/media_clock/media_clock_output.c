@@ -0,0 +1,44 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include "media_clock_output.h"
+
+// 10ns units per second
+#define WORDLEN_UNITS_PER_SEC 100000000ULL
+
+// Fractional bits of media_clock_t word lengths (WC_FRACTIONAL_BITS). Kept
+// here so that the conversions build on the host without the AVB headers.
+#define WORDLEN_BITS 16
+
+unsigned long long media_clock_output_mclk_hz(unsigned int wordlen,
+                                              unsigned int mclks_per_word)
+{
+  if (wordlen == 0)
+    return 0;
+  // Fits in 64 bits for up to 1024 master clocks per word
+  return ((WORDLEN_UNITS_PER_SEC << (WORDLEN_BITS + 8)) * mclks_per_word) /
+         wordlen;
+}
+
+unsigned int media_clock_output_pll_ratio(unsigned int wordlen,
+                                          unsigned int mclks_per_word,
+                                          unsigned int ref_hz,
+                                          unsigned int frac_bits)
+{
+  unsigned long long mclk = media_clock_output_mclk_hz(wordlen, mclks_per_word);
+  unsigned long long den = (unsigned long long) ref_hz << 8;
+
+  if (den == 0)
+    return 0;
+  // An MCLK below 2^32Hz with up to 20 fractional bits of ratio still fits
+  return (unsigned int) (((mclk << frac_bits) + den / 2) / den);
+}
+
+int media_clock_output_trim_ppb(unsigned int rate, unsigned int wordlen)
+{
+  long long nominal;
+
+  if (rate == 0 || wordlen == 0)
+    return 0;
+  nominal = (long long) ((WORDLEN_UNITS_PER_SEC << WORDLEN_BITS) / rate);
+  // A shorter word means a faster clock
+  return (int) (((nominal - (long long) wordlen) * 1000000000) / (long long) wordlen);
+}
@@ -0,0 +1,44 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __media_clock_output_h__
+#define __media_clock_output_h__
+
+#include <xccompat.h>
+
+/* Conversions from a recovered word length to the settings of media clock
+   output drivers that apply the rate directly rather than through the PLL
+   reference clock (see media_clock_output_if in avb.h). The word length is
+   in 10ns units with WC_FRACTIONAL_BITS fractional bits. */
+
+/** The master clock frequency for a word length
+ *
+ *  \param wordlen         the recovered word length
+ *  \param mclks_per_word  master clocks per sample
+ *  \returns               the frequency in Hz with 8 fractional bits
+ */
+unsigned long long media_clock_output_mclk_hz(unsigned int wordlen,
+                                              unsigned int mclks_per_word);
+
+/** The ratio register value of a fractional-N PLL that multiplies a fixed
+ *  reference up to the master clock for a word length
+ *
+ *  \param wordlen         the recovered word length
+ *  \param mclks_per_word  master clocks per sample
+ *  \param ref_hz          the PLL reference frequency in Hz
+ *  \param frac_bits       fractional bits of the ratio register
+ *  \returns               the rounded ratio
+ */
+unsigned int media_clock_output_pll_ratio(unsigned int wordlen,
+                                          unsigned int mclks_per_word,
+                                          unsigned int ref_hz,
+                                          unsigned int frac_bits);
+
+/** The offset of a word length from the nominal rate in parts per billion,
+ *  positive when the clock is to run fast. For drivers that trim an
+ *  internal PLL or master clock divider.
+ *
+ *  \param rate     the nominal sample rate in Hz
+ *  \param wordlen  the recovered word length
+ */
+int media_clock_output_trim_ppb(unsigned int rate, unsigned int wordlen);
+
+#endif
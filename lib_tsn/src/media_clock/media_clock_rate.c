@@ -0,0 +1,71 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include "media_clock_rate.h"
+
+// 10ns units per second
+#define WORDLEN_UNITS_PER_SEC 100000000ULL
+
+static const unsigned int family_rates[] = {48000, 44100, 32000};
+
+#define NUM_FAMILIES (sizeof(family_rates) / sizeof(family_rates[0]))
+
+static unsigned int gcd(unsigned int a, unsigned int b)
+{
+  while (b) {
+    unsigned int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+unsigned int media_clock_family_rate(unsigned int rate)
+{
+  if (rate == 0)
+    return 0;
+
+  // Multiples and submultiples, so 16kHz is in the 48kHz family
+  for (unsigned int i = 0; i < NUM_FAMILIES; i++) {
+    if (rate % family_rates[i] == 0 || family_rates[i] % rate == 0)
+      return family_rates[i];
+  }
+  return 0;
+}
+
+unsigned long long media_clock_nominal_wordlen(unsigned int rate,
+                                               unsigned int fractional_bits)
+{
+  if (rate == 0)
+    return 0;
+  return (WORDLEN_UNITS_PER_SEC << fractional_bits) / rate;
+}
+
+unsigned long long media_clock_scale_wordlen(unsigned long long family_wordlen,
+                                             unsigned int rate)
+{
+  unsigned int family = media_clock_family_rate(rate);
+
+  if (family == 0)
+    return 0;
+  // A 24 fractional bit word length times the base rate fits in 64 bits
+  return (family_wordlen * family) / rate;
+}
+
+int media_clock_reference_divide(unsigned int rate,
+                                 unsigned int multiplier,
+                                 unsigned int *num,
+                                 unsigned int *den)
+{
+  unsigned int family = media_clock_family_rate(rate);
+  unsigned int n, d, g;
+
+  if (family == 0 || multiplier == 0)
+    return 0;
+
+  // The reference period is multiplier/2 words at the base rate
+  n = multiplier * (rate / gcd(rate, family));
+  d = 4 * (family / gcd(rate, family));
+  g = gcd(n, d);
+  *num = n / g;
+  *den = d / g;
+  return 1;
+}
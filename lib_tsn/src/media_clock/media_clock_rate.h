@@ -0,0 +1,51 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __media_clock_rate_h__
+#define __media_clock_rate_h__
+
+#include <xccompat.h>
+
+/* Word lengths and PLL reference dividers of media clocks.
+
+   Each sample rate belongs to a family with a base rate of 48kHz, 44.1kHz
+   or 32kHz. The PLL reference clock of a media clock runs at the base
+   rate of its family divided by half the clock's PLL multiplier, so an
+   external PLL multiplying the reference by mclks_per_word * multiplier / 2
+   gives the same master clock for every rate in a family. Clocks keep
+   their own rate and multiplier, so clocks of different families can run
+   side by side on separate PLLs.
+
+   Word lengths are in 10ns units. */
+
+/** The base rate of the family of a sample rate
+ *
+ *  \returns the base rate in Hz, or 0 if the rate is not supported
+ */
+unsigned int media_clock_family_rate(unsigned int rate);
+
+/** The nominal word length of a sample rate
+ *
+ *  \param rate            the sample rate in Hz
+ *  \param fractional_bits fractional bits of the result
+ */
+unsigned long long media_clock_nominal_wordlen(unsigned int rate,
+                                               unsigned int fractional_bits);
+
+/** Convert a word length at the base rate of a family to the word length
+ *  of a rate in the family, keeping its fractional bits
+ */
+unsigned long long media_clock_scale_wordlen(unsigned long long family_wordlen,
+                                             unsigned int rate);
+
+/** The half period of the PLL reference clock in words of a media clock,
+ *  as the ratio num/den in lowest terms.
+ *
+ *  \param rate        the sample rate of the clock in Hz
+ *  \param multiplier  the PLL multiplier of the clock
+ *  \returns           0 if the rate is not supported
+ */
+int media_clock_reference_divide(unsigned int rate,
+                                 unsigned int multiplier,
+                                 REFERENCE_PARAM(unsigned int, num),
+                                 REFERENCE_PARAM(unsigned int, den));
+
+#endif
@@ -0,0 +1,151 @@
+// Copyright (c) 2011-2017, XMOS Ltd, All rights reserved
+#include "media_clock_recovery.h"
+
+/* Indexed by media_clock_pll_profile_t */
+static const media_clock_pll_gains_t pll_gains[] = {
+  MEDIA_CLOCK_PLL_GAINS_CS2100,
+  MEDIA_CLOCK_PLL_GAINS_CS2300,
+  MEDIA_CLOCK_PLL_GAINS_DIRECT,
+};
+
+#define NUM_PLL_PROFILES ((int) (sizeof(pll_gains) / sizeof(pll_gains[0])))
+
+static void restart(media_clock_recovery_t *r, unsigned int time)
+{
+  r->wordlen = r->nominal_wordlen;
+  r->first = 1;
+  r->ierror = 0;
+  r->phase_index = 0;
+  r->phase_count = 0;
+  r->locked = 0;
+  r->start_time = time;
+}
+
+void media_clock_recovery_init(media_clock_recovery_t *r,
+                               unsigned long long wordlen,
+                               unsigned int time)
+{
+  r->nominal_wordlen = wordlen;
+  r->lock_time = 0;
+  restart(r, time);
+  r->stream_info1.valid = 0;
+  r->stream_info2.valid = 0;
+}
+
+int media_clock_recovery_set_pll_profile(media_clock_recovery_t *r,
+                                         int profile)
+{
+  if (profile < 0 || profile >= NUM_PLL_PROFILES)
+    return 0;
+  r->gains = pll_gains[profile];
+  return 1;
+}
+
+void media_clock_recovery_stream_info(media_clock_recovery_t *r,
+                                      unsigned int local_ts,
+                                      unsigned int outgoing_ptp_ts,
+                                      unsigned int presentation_ts,
+                                      int locked,
+                                      int fill)
+{
+  r->stream_info2.local_ts = local_ts;
+  r->stream_info2.outgoing_ptp_ts = outgoing_ptp_ts;
+  r->stream_info2.presentation_ts = presentation_ts;
+  r->stream_info2.valid = 1;
+  r->stream_info2.locked = locked;
+  r->stream_info2.fill = fill;
+}
+
+void media_clock_recovery_fifo_adjusted(media_clock_recovery_t *r)
+{
+  r->stream_info2.valid = 0;
+}
+
+/* Push a phase detector output into the history and check whether all of
+   the history is within the lock window */
+static void update_lock_state(media_clock_recovery_t *r,
+                              int phase_error,
+                              unsigned int time)
+{
+  int settled = 1;
+
+  r->phase_history[r->phase_index] = phase_error;
+  r->phase_index = (r->phase_index + 1) % MEDIA_CLOCK_PHASE_HISTORY;
+  if (r->phase_count < MEDIA_CLOCK_PHASE_HISTORY)
+    r->phase_count++;
+
+  if (r->phase_count < MEDIA_CLOCK_PHASE_HISTORY)
+    settled = 0;
+
+  for (unsigned int i = 0; i < r->phase_count && settled; i++) {
+    if (r->phase_history[i] > MEDIA_CLOCK_LOCKED_PHASE_ERROR_NS ||
+        r->phase_history[i] < -MEDIA_CLOCK_LOCKED_PHASE_ERROR_NS)
+      settled = 0;
+  }
+
+  if (settled && !r->locked)
+    r->lock_time = time - r->start_time;
+  r->locked = settled;
+}
+
+void media_clock_recovery_update(media_clock_recovery_t *r,
+                                 unsigned int time)
+{
+  long long diff_local;
+  long long ierror, perror;
+  int phase_error;
+
+  // If the stream info isn't valid at all, then keep the current rate
+  if (!r->stream_info2.valid)
+    return;
+
+  // If there are not two stream infos to compare, then keep the current rate
+  if (!r->stream_info1.valid) {
+    r->stream_info1 = r->stream_info2;
+    r->stream_info2.valid = 0;
+    return;
+  }
+
+  // If the stream is unlocked, return to the nominal rate
+  if (!r->stream_info2.locked) {
+    restart(r, time);
+    r->stream_info1 = r->stream_info2;
+    r->stream_info2.valid = 0;
+    return;
+  }
+
+  // We have all the info we need to perform clock recovery
+  diff_local = r->stream_info2.local_ts - r->stream_info1.local_ts;
+
+  phase_error = (signed) r->stream_info2.outgoing_ptp_ts -
+                (signed) r->stream_info2.presentation_ts;
+
+  ierror = (long long) phase_error << WORDLEN_FRACTIONAL_BITS;
+
+  if (r->first) {
+    perror = 0;
+    r->first = 0;
+  } else
+    perror = ierror - r->ierror;
+
+  r->ierror = ierror;
+
+  r->wordlen = r->wordlen
+               - ((perror / diff_local) * r->gains.p_num) / r->gains.p_den
+               - ((ierror / diff_local) * r->gains.i_num) / r->gains.i_den;
+
+  update_lock_state(r, phase_error, time);
+
+  r->stream_info1 = r->stream_info2;
+  r->stream_info2.valid = 0;
+}
+
+int media_clock_recovery_rate_error_ppb(media_clock_recovery_t *r)
+{
+  // A shorter word means a faster clock
+  long long diff = (long long) (r->nominal_wordlen - r->wordlen);
+
+  if (r->wordlen == 0)
+    return 0;
+  return (int) ((diff * 1000000000) / (long long) r->wordlen);
+}
@@ -0,0 +1,119 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __media_clock_recovery_h__
+#define __media_clock_recovery_h__
+
+#include <xccompat.h>
+#include "default_avb_conf.h"
+
+/* The clock recovery internal representation of the wordlen. More precision
+   and range than the external wordlen representation. The max precision is
+   26 bits before the PTP clock recovery multiplication overflows */
+#define WORDLEN_FRACTIONAL_BITS 24
+
+/** Number of phase detector outputs kept to decide whether a stream derived
+ *  clock has settled */
+#ifndef MEDIA_CLOCK_PHASE_HISTORY
+#define MEDIA_CLOCK_PHASE_HISTORY 8
+#endif
+
+/** A recovered clock is reported as locked once every phase error in the
+ *  history is within this many ns */
+#ifndef MEDIA_CLOCK_LOCKED_PHASE_ERROR_NS
+#define MEDIA_CLOCK_LOCKED_PHASE_ERROR_NS 2000
+#endif
+
+/**
+ *  \brief Records the state of the media stream
+ *
+ *  It is used by the stream based clock recovery to store stream state, and
+ *  therefore work out deltas between the last clock recovery state and the
+ *  current one
+ */
+typedef struct stream_info_t {
+  int valid;
+  unsigned int local_ts;
+  unsigned int outgoing_ptp_ts;
+  unsigned int presentation_ts;
+  int locked;
+  int fill;
+} stream_info_t;
+
+/** Loop gains for one external PLL. The wordlen is corrected by
+ *  p_num/p_den of the phase error rate and i_num/i_den of the phase error,
+ *  both per local tick. */
+typedef struct media_clock_pll_gains_t {
+  int p_num;
+  int p_den;
+  int i_num;
+  int i_den;
+} media_clock_pll_gains_t;
+
+/* The gains of each media_clock_pll_profile_t, tuned with
+   host/media_clock_sim */
+#define MEDIA_CLOCK_PLL_GAINS_CS2100 {80, 11, 1, 5}
+#define MEDIA_CLOCK_PLL_GAINS_CS2300 {32, 1, 1, 4}
+#define MEDIA_CLOCK_PLL_GAINS_DIRECT {32, 1, 2, 1}
+
+/* The gains of the ratio loop of a sample rate converted output. The ratio
+   takes effect at the next packet, with no PLL to filter it, so the loop
+   trades some lock time for less ratio ripple. */
+#define MEDIA_CLOCK_ASRC_GAINS {16, 1, 1, 1}
+
+/** The clock recovery state of one media clock */
+typedef struct media_clock_recovery_t {
+  unsigned long long wordlen;
+  unsigned long long nominal_wordlen;
+  long long ierror;
+  int first;
+  media_clock_pll_gains_t gains;
+  stream_info_t stream_info1;
+  stream_info_t stream_info2;
+  int phase_history[MEDIA_CLOCK_PHASE_HISTORY]; //!< Phase errors in ns
+  unsigned int phase_index;
+  unsigned int phase_count;
+  int locked;
+  unsigned int start_time;      //!< Local time recovery (re)started
+  unsigned int lock_time;       //!< Ticks from start_time to lock
+} media_clock_recovery_t;
+
+/** Initialise the recovery state.
+ *
+ *  \param r        the recovery state
+ *  \param wordlen  the nominal wordlen with WORDLEN_FRACTIONAL_BITS
+ *  \param time     the current local time
+ */
+void media_clock_recovery_init(REFERENCE_PARAM(media_clock_recovery_t, r),
+                               unsigned long long wordlen,
+                               unsigned int time);
+
+/** Select the loop gains for an external PLL.
+ *
+ *  \param profile  a media_clock_pll_profile_t
+ *  \returns        0 if the profile is not known
+ */
+int media_clock_recovery_set_pll_profile(REFERENCE_PARAM(media_clock_recovery_t, r),
+                                         int profile);
+
+/** Record the latest state of the stream the clock is derived from */
+void media_clock_recovery_stream_info(REFERENCE_PARAM(media_clock_recovery_t, r),
+                                      unsigned int local_ts,
+                                      unsigned int outgoing_ptp_ts,
+                                      unsigned int presentation_ts,
+                                      int locked,
+                                      int fill);
+
+/** The output FIFO has been re-aligned so the last stream info is stale */
+void media_clock_recovery_fifo_adjusted(REFERENCE_PARAM(media_clock_recovery_t, r));
+
+/** Run one iteration of stream derived clock recovery.
+ *
+ *  \param r        the recovery state
+ *  \param time     the current local time
+ */
+void media_clock_recovery_update(REFERENCE_PARAM(media_clock_recovery_t, r),
+                                 unsigned int time);
+
+/** The recovered rate relative to the nominal rate in parts per billion */
+int media_clock_recovery_rate_error_ppb(REFERENCE_PARAM(media_clock_recovery_t, r));
+
+#endif // __media_clock_recovery_h__
@@ -8,37 +8,16 @@
 #include "media_clock_internal.h"
 #include "media_clock_client.h"
 #include "misc_timer.h"
-
-// The clock recovery internal representation of the worldlen.  More precision and range than the external
-// worldlen representation.  The max percision is 26 bits before the PTP clock recovery multiplcation overflows
-#define WORDLEN_FRACTIONAL_BITS 24
-
-/**
- *  \brief Records the state of the media stream
- *
- *  It is used by the stream based clock recovery to store stream state, and
- *  therefore work out deltas between the last clock recovery state and the
- *  current one
- */
-typedef struct stream_info_t {
-	int valid;
-	unsigned int local_ts;
-	unsigned int outgoing_ptp_ts;
-	unsigned int presentation_ts;
-	int locked;
-	int fill;
-} stream_info_t;
+#include "media_clock_recovery.h"
+#include "audio_output_asrc.h"
+#include "media_clock_rate.h"
 
 /**
  * \brief Records the state of the clock recovery for one media clock
  */
 typedef struct clock_info_t {
-	unsigned long long wordlen;
-	long long ierror;
 	unsigned int rate;
-	int first;
-	stream_info_t stream_info1;
-	stream_info_t stream_info2;
+	media_clock_recovery_t recovery;
 } clock_info_t;
 
 /// The array of media clock state structures
@@ -51,18 +30,14 @@ static unsigned int local_wordlen_to_external_wordlen(unsigned long long w) {
 	return (w >> (WORDLEN_FRACTIONAL_BITS - WC_FRACTIONAL_BITS));
 }
 
+/* Recovery runs on the word length of the base rate of the clock's family,
+   so the loop gains are the same for every rate in the family */
 static unsigned long long calculate_wordlen(unsigned int sample_rate) {
-	const unsigned long long nanoseconds = (100000000LL << WORDLEN_FRACTIONAL_BITS);
-	/* Calculate what master clock we should be using */
-	if ((sample_rate % 48000) == 0) {
-	    return (nanoseconds / 48000);
-	}
-	else if ((sample_rate % 44100) == 0) {
-	    return (nanoseconds / 44100);
-	}
-	else {
+	unsigned int family = media_clock_family_rate(sample_rate);
+
+	if (family == 0)
 		fail("Unsupported sample rate");
-	}
+	return media_clock_nominal_wordlen(family, WORDLEN_FRACTIONAL_BITS);
 }
 
 void init_media_clock_recovery(chanend ptp_svr,
@@ -70,18 +45,19 @@ void init_media_clock_recovery(chanend ptp_svr,
 							   unsigned int clk_time,
 							   unsigned int rate) {
 	clock_info_t *clock_info = &clock_states[clock_num];
+	unsigned long long wordlen = 0;
 
-	clock_info->first = 1;
 	clock_info->rate = rate;
-	clock_info->ierror = 0;
 	if (rate != 0) {
-		clock_info->wordlen = calculate_wordlen(clock_info->rate);
-	} else {
-		clock_info->wordlen = 0;
+		wordlen = calculate_wordlen(clock_info->rate);
 	}
+	media_clock_recovery_init(&clock_info->recovery, wordlen, clk_time);
+}
+
+int set_media_clock_pll_profile(int clock_index, int profile) {
+	clock_info_t *clock_info = &clock_states[clock_index];
 
-	clock_info->stream_info1.valid = 0;
-	clock_info->stream_info2.valid = 0;
+	return media_clock_recovery_set_pll_profile(&clock_info->recovery, profile);
 }
 
 void update_media_clock_stream_info(int clock_index,
@@ -90,22 +66,65 @@ void update_media_clock_stream_info(int clock_index,
                                     unsigned int presentation_ts,
                                     int locked,
                                     int fill) {
-	clock_info_t *clock_info = &clock_states[clock_index];
-
-	clock_info->stream_info2.local_ts = local_ts;
-	clock_info->stream_info2.outgoing_ptp_ts = outgoing_ptp_ts;
-	clock_info->stream_info2.presentation_ts = presentation_ts;
-	clock_info->stream_info2.valid = 1;
-	clock_info->stream_info2.locked = locked;
-	clock_info->stream_info2.fill = fill;
+	media_clock_recovery_stream_info(&clock_states[clock_index].recovery,
+	                                 local_ts,
+	                                 outgoing_ptp_ts,
+	                                 presentation_ts,
+	                                 locked,
+	                                 fill);
 }
 
 void inform_media_clock_of_lock(int clock_index) {
-	clock_info_t *clock_info = &clock_states[clock_index];
-	clock_info->stream_info2.valid = 0;
+	media_clock_recovery_fifo_adjusted(&clock_states[clock_index].recovery);
+}
+
+void get_media_clock_recovery_status(int clock_index,
+                                     media_clock_info_t *info) {
+	media_clock_recovery_t *r = &clock_states[clock_index].recovery;
+
+	info->recovery_locked = r->locked;
+	info->lock_time_ms = r->lock_time / 100000;
+	info->rate_error_ppb = media_clock_recovery_rate_error_ppb(r);
+}
+
+#if AVB_MEDIA_OUTPUT_ASRC && (AVB_NUM_MEDIA_OUTPUTS != 0)
+/* A converted output runs the stream derived recovery loop, but the
+   recovered wordlen sets the converter ratio instead of driving a PLL */
+static media_clock_recovery_t asrc_loops[AVB_NUM_MEDIA_OUTPUTS];
+static const media_clock_pll_gains_t asrc_gains = MEDIA_CLOCK_ASRC_GAINS;
+
+void init_media_output_asrc(int output, unsigned int rate, unsigned int time) {
+	media_clock_recovery_t *r = &asrc_loops[output];
+
+	media_clock_recovery_init(r, calculate_wordlen(rate), time);
+	r->gains = asrc_gains;
 }
 
-#define MAX_ERROR_TOLERANCE 100
+void inform_media_output_asrc_of_lock(int output) {
+	media_clock_recovery_fifo_adjusted(&asrc_loops[output]);
+}
+
+unsigned int update_media_output_asrc(int output,
+                                      unsigned int local_ts,
+                                      unsigned int outgoing_ptp_ts,
+                                      unsigned int presentation_ts,
+                                      int locked,
+                                      int fill,
+                                      unsigned int time) {
+	media_clock_recovery_t *r = &asrc_loops[output];
+	long long diff;
+
+	media_clock_recovery_stream_info(r, local_ts, outgoing_ptp_ts,
+	                                 presentation_ts, locked, fill);
+	media_clock_recovery_update(r, time);
+
+	// A shorter recovered wordlen means the stream is faster than the
+	// local clock, so more input samples are used per output sample
+	diff = (long long) (r->nominal_wordlen - r->wordlen);
+	return (1 << AUDIO_OUTPUT_ASRC_RATIO_BITS) +
+	       (int) ((diff << AUDIO_OUTPUT_ASRC_RATIO_BITS) / (long long) r->wordlen);
+}
+#endif
 
 unsigned int update_media_clock(chanend ptp_svr,
 								int clock_index,
@@ -113,71 +132,13 @@ unsigned int update_media_clock(chanend ptp_svr,
 								unsigned int t2,
 								int period0) {
 	clock_info_t *clock_info = &clock_states[clock_index];
-	long long diff_local;
-	int clock_type = mclock->info.clock_type;
-
-	switch (clock_type) {
-	case DEVICE_MEDIA_CLOCK_LOCAL_CLOCK:
-		return local_wordlen_to_external_wordlen(clock_info->wordlen);
-		break;
-
-	case DEVICE_MEDIA_CLOCK_INPUT_STREAM_DERIVED: {
-		long long ierror, perror;
-
-		// If the stream info isn't valid at all, then return the default clock rate
-		if (!clock_info->stream_info2.valid)
-			return local_wordlen_to_external_wordlen(clock_info->wordlen);
-
-		// If there are not two stream infos to compare, then return default clock rate
-		if (!clock_info->stream_info1.valid) {
-			clock_info->stream_info1 = clock_info->stream_info2;
-			clock_info->stream_info2.valid = 0;
-			return local_wordlen_to_external_wordlen(clock_info->wordlen);
-		}
-
-		// If the stream is unlocked, return the default clock rate
-		if (!clock_info->stream_info2.locked) {
-			clock_info->wordlen = calculate_wordlen(clock_info->rate);
-			clock_info->stream_info1 = clock_info->stream_info2;
-			clock_info->stream_info2.valid = 0;
-			clock_info->first = 1;
-			clock_info->ierror = 0;
-
-		// We have all the info we need to perform clock recovery
-		} else {
-			diff_local = clock_info->stream_info2.local_ts
-					- clock_info->stream_info1.local_ts;
-
-			ierror = (signed) clock_info->stream_info2.outgoing_ptp_ts -
-					 (signed) clock_info->stream_info2.presentation_ts;
-
-			ierror = ierror << WORDLEN_FRACTIONAL_BITS;
-
-			if (clock_info->first) {
-				perror = 0;
-				clock_info->first = 0;
-			} else
-				perror = ierror - clock_info->ierror;
-
-			clock_info->ierror = ierror;
-
-#if 0
-			// These values were tuned for CS2300-CP PLL
-			clock_info->wordlen = clock_info->wordlen - ((perror / diff_local) * 32) - ((ierror / diff_local) / 4);
-#else
-			// and these for CS2100-CP PLL
-			clock_info->wordlen = clock_info->wordlen - ((perror / diff_local) * 80)/11 - ((ierror / diff_local) * 1) / 5;
-#endif
 
-			clock_info->stream_info1 = clock_info->stream_info2;
-			clock_info->stream_info2.valid = 0;
-		}
-		break;
-	}
+	if (mclock->info.clock_type == DEVICE_MEDIA_CLOCK_INPUT_STREAM_DERIVED)
+		media_clock_recovery_update(&clock_info->recovery, t2);
 
-		break;
-	}
-
-	return local_wordlen_to_external_wordlen(clock_info->wordlen);
+	if (clock_info->rate == 0)
+		return local_wordlen_to_external_wordlen(clock_info->recovery.wordlen);
+	return local_wordlen_to_external_wordlen(
+	         media_clock_scale_wordlen(clock_info->recovery.wordlen,
+	                                   clock_info->rate));
 }
-
@@ -0,0 +1,113 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include "media_clock_synth.h"
+
+#define ONE (1 << MEDIA_CLOCK_SYNTH_FRACTIONAL_BITS)
+
+void media_clock_synth_init(media_clock_synth_t *s,
+                            int order,
+                            unsigned int start_time)
+{
+  s->order = order;
+  s->period_int = 0;
+  s->period_frac = 0;
+  s->acc1 = 0;
+  s->acc2 = 0;
+  s->prev_carry2 = 0;
+  s->pending = 0;
+  s->time = start_time;
+  s->level = 0;
+  s->rd = 0;
+  s->wr = 0;
+}
+
+void media_clock_synth_set_half_period(media_clock_synth_t *s,
+                                       unsigned long long half_period)
+{
+  s->period_int = half_period >> MEDIA_CLOCK_SYNTH_FRACTIONAL_BITS;
+  s->period_frac = half_period & (ONE - 1);
+}
+
+/* Length of the next half period in whole ticks */
+static unsigned int next_half_period(media_clock_synth_t *s)
+{
+  int carry = 0;
+  int carry2 = 0;
+
+  s->acc1 += s->period_frac;
+  if (s->acc1 >= ONE) {
+    s->acc1 -= ONE;
+    carry = 1;
+  }
+
+  if (s->order > 1) {
+    /* MASH 1-1: the second stage integrates the first stage's error and its
+       differentiated carry cancels that error, leaving second order shaped
+       quantization noise */
+    s->acc2 += s->acc1;
+    if (s->acc2 >= ONE) {
+      s->acc2 -= ONE;
+      carry2 = 1;
+    }
+    carry += carry2 - s->prev_carry2;
+    s->prev_carry2 = carry2;
+  }
+
+  return s->period_int + carry;
+}
+
+void media_clock_synth_fill(media_clock_synth_t *s)
+{
+  unsigned int n = s->wr - s->rd;
+
+  /* Compact the block */
+  for (unsigned int i = 0; i < n; i++) {
+    s->out_time[i] = s->out_time[s->rd + i];
+    s->out_word[i] = s->out_word[s->rd + i];
+  }
+  s->rd = 0;
+  s->wr = n;
+
+  if (s->period_int == 0)
+    return;
+
+  while (s->wr < MEDIA_CLOCK_SYNTH_BLOCK_SIZE) {
+    if (s->pending == 0)
+      s->pending = next_half_period(s);
+
+    if (s->pending > MEDIA_CLOCK_SYNTH_MAX_SEGMENT) {
+      /* Hold the current level part way, leaving at least half a segment
+         for the edge itself */
+      unsigned int step = s->pending > 2 * MEDIA_CLOCK_SYNTH_MAX_SEGMENT ?
+                          MEDIA_CLOCK_SYNTH_MAX_SEGMENT : s->pending / 2;
+      s->time += step;
+      s->pending -= step;
+    } else {
+      s->time += s->pending;
+      s->pending = 0;
+      s->level = ~s->level;
+    }
+    s->out_time[s->wr] = s->time;
+    s->out_word[s->wr] = s->level;
+    s->wr++;
+  }
+}
+
+void media_clock_synth_next(media_clock_synth_t *s,
+                            unsigned int *time,
+                            unsigned int *word)
+{
+  if (s->rd == s->wr)
+    media_clock_synth_fill(s);
+
+  if (s->rd == s->wr) {
+    /* No rate set yet, hold the current level */
+    s->time += MEDIA_CLOCK_SYNTH_MAX_SEGMENT / 2;
+    *time = s->time;
+    *word = s->level;
+    return;
+  }
+
+  *time = s->out_time[s->rd];
+  *word = s->out_word[s->rd];
+  s->rd++;
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __media_clock_synth_h__
+#define __media_clock_synth_h__
+
+#include <xccompat.h>
+#include "default_avb_conf.h"
+
+/* Fractional-N edge synthesizer for the PLL reference clock.
+
+   The edges of the reference square wave are placed on the 10ns port
+   timer grid. The fractional part of the half period is handled by a
+   sigma-delta modulator so that the timing error is pushed to high
+   frequencies where the external PLL's loop filter removes it. Edges are
+   computed a block at a time and handed out as timed 32-bit port words. */
+
+#define MEDIA_CLOCK_SYNTH_FRACTIONAL_BITS 16
+
+/** Number of port outputs computed ahead in one go */
+#ifndef MEDIA_CLOCK_SYNTH_BLOCK_SIZE
+#define MEDIA_CLOCK_SYNTH_BLOCK_SIZE 16
+#endif
+
+/** Order of the sigma-delta modulator: 1 is a plain phase accumulator,
+ *  2 is a MASH 1-1 modulator */
+#ifndef MEDIA_CLOCK_SYNTH_ORDER
+#define MEDIA_CLOCK_SYNTH_ORDER 2
+#endif
+
+/* The port timer is 16 bits so consecutive timed outputs must be less than
+   this many ticks apart. Longer half periods are split by repeating the
+   current level. */
+#define MEDIA_CLOCK_SYNTH_MAX_SEGMENT 0xf000
+
+typedef struct media_clock_synth_t {
+  int order;
+  unsigned int period_int;        //!< Half period in ticks, integer part
+  unsigned int period_frac;       //!< Half period fractional part
+  unsigned int acc1;              //!< First modulator stage
+  unsigned int acc2;              //!< Second modulator stage
+  int prev_carry2;
+  unsigned int pending;           //!< Ticks left until the next edge
+  unsigned int time;              //!< Port time of the last queued output
+  unsigned int level;             //!< Port level of the last queued output
+  unsigned int rd;
+  unsigned int wr;
+  unsigned int out_time[MEDIA_CLOCK_SYNTH_BLOCK_SIZE];
+  unsigned int out_word[MEDIA_CLOCK_SYNTH_BLOCK_SIZE];
+} media_clock_synth_t;
+
+/** Initialise a synthesizer.
+ *
+ *  \param s          the synthesizer state
+ *  \param order      the modulator order (1 or 2)
+ *  \param start_time the port time from which the first half period is
+ *                    counted
+ */
+void media_clock_synth_init(REFERENCE_PARAM(media_clock_synth_t, s),
+                            int order,
+                            unsigned int start_time);
+
+/** Set the half period of the generated clock in timer ticks with
+ *  MEDIA_CLOCK_SYNTH_FRACTIONAL_BITS fractional bits. Takes effect from
+ *  the next block.
+ */
+void media_clock_synth_set_half_period(REFERENCE_PARAM(media_clock_synth_t, s),
+                                       unsigned long long half_period);
+
+/** Compute the next block of port outputs */
+void media_clock_synth_fill(REFERENCE_PARAM(media_clock_synth_t, s));
+
+/** Take the next port output from the block, refilling it when empty.
+ *
+ *  \param s      the synthesizer state
+ *  \param time   the port time at which to output the word
+ *  \param word   the 32-bit word to output
+ */
+void media_clock_synth_next(REFERENCE_PARAM(media_clock_synth_t, s),
+                            REFERENCE_PARAM(unsigned int, time),
+                            REFERENCE_PARAM(unsigned int, word));
+
+#endif // __media_clock_synth_h__
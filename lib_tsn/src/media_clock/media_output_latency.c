@@ -0,0 +1,107 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include "media_output_latency.h"
+
+/* The largest change of offset in one window, in samples. This is kept
+   well inside the lost lock threshold so that the stream derived clock can
+   slew the FIFO to the new fill level without the output losing lock. */
+#define MAX_OFFSET_STEP 4
+
+static void start_window(media_output_latency_t *l)
+{
+  l->window_count = 0;
+  l->window_min_fill = l->fifo_size;
+  l->window_max_fill = 0;
+  l->window_underflow = 0;
+}
+
+void media_output_latency_init(media_output_latency_t *l, int fifo_size)
+{
+  l->min_offset = 0;
+  l->fifo_size = fifo_size;
+  l->underflows = 0;
+  media_output_latency_reset(l);
+}
+
+void media_output_latency_reset(media_output_latency_t *l)
+{
+  l->offset = l->min_offset;
+  l->total_underflows = 0;
+  media_output_latency_locked(l);
+}
+
+void media_output_latency_set_accumulated_latency(media_output_latency_t *l,
+                                                  unsigned int accumulated_latency,
+                                                  unsigned int presentation_delay)
+{
+  // Samples cannot be played before the worst case arrival time of the
+  // stream, nor before the talker's presentation time.
+  if (accumulated_latency > presentation_delay)
+    l->min_offset = (int) (accumulated_latency - presentation_delay);
+  else
+    l->min_offset = 0;
+
+  if (l->offset < l->min_offset)
+    l->offset = l->min_offset;
+}
+
+void media_output_latency_locked(media_output_latency_t *l)
+{
+  l->fill = 0;
+  l->min_fill = l->fifo_size;
+  l->max_fill = 0;
+  start_window(l);
+}
+
+void media_output_latency_update(media_output_latency_t *l,
+                                 int fill,
+                                 unsigned int underflows,
+                                 int sample_period,
+                                 int adapt)
+{
+  int step;
+
+  l->fill = fill;
+  if (fill < l->min_fill)
+    l->min_fill = fill;
+  if (fill > l->max_fill)
+    l->max_fill = fill;
+
+  if (underflows != l->underflows) {
+    l->total_underflows += underflows - l->underflows;
+    l->underflows = underflows;
+    l->window_underflow = 1;
+  }
+
+  if (fill < l->window_min_fill)
+    l->window_min_fill = fill;
+  if (fill > l->window_max_fill)
+    l->window_max_fill = fill;
+
+  l->window_count++;
+  if (l->window_count < AVB_ADAPTIVE_PRESENTATION_WINDOW)
+    return;
+
+  if (adapt && sample_period > 0) {
+    if (l->window_underflow ||
+        l->window_min_fill < AVB_ADAPTIVE_PRESENTATION_MIN_FILL) {
+      // Play later, as far as the FIFO has room for
+      step = AVB_ADAPTIVE_PRESENTATION_MIN_FILL - l->window_min_fill;
+      if (l->window_underflow || step < 1)
+        step = MAX_OFFSET_STEP;
+      if (step > MAX_OFFSET_STEP)
+        step = MAX_OFFSET_STEP;
+      if (l->window_max_fill + step >= l->fifo_size)
+        step = l->fifo_size - 1 - l->window_max_fill;
+      if (step > 0)
+        l->offset += step * sample_period;
+    }
+    else if (l->window_min_fill > AVB_ADAPTIVE_PRESENTATION_MIN_FILL +
+                                  AVB_ADAPTIVE_PRESENTATION_HYSTERESIS) {
+      // Play one sample earlier
+      if (l->offset - sample_period >= l->min_offset)
+        l->offset -= sample_period;
+    }
+  }
+
+  start_window(l);
+}
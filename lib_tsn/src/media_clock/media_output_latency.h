@@ -0,0 +1,88 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __media_output_latency_h__
+#define __media_output_latency_h__
+
+#include <xccompat.h>
+#include "default_avb_conf.h"
+
+/* Fill statistics and adaptive presentation time for one output FIFO.
+
+   In adaptive mode the listener plays samples at their presentation time
+   plus an offset. The offset is shrunk while the FIFO never runs close to
+   empty and grown as soon as it does, so the effective FIFO depth follows
+   the arrival jitter of the link. It is never shrunk below what the SRP
+   accumulated latency of the stream allows. */
+
+/** Enable adaptive presentation time for listener outputs. When disabled
+ *  samples are always played at the talker's presentation time. */
+#ifndef AVB_ADAPTIVE_PRESENTATION_TIME
+#define AVB_ADAPTIVE_PRESENTATION_TIME 0
+#endif
+
+/** Number of FIFO reports (about 5ms each at 48kHz) over which the lowest
+ *  fill level is measured before the offset is adjusted */
+#ifndef AVB_ADAPTIVE_PRESENTATION_WINDOW
+#define AVB_ADAPTIVE_PRESENTATION_WINDOW 64
+#endif
+
+/** Fill level in samples to keep in reserve below the lowest fill seen */
+#ifndef AVB_ADAPTIVE_PRESENTATION_MIN_FILL
+#define AVB_ADAPTIVE_PRESENTATION_MIN_FILL 12
+#endif
+
+/** Spare fill in samples above the reserve that is tolerated before the
+ *  offset is shrunk */
+#define AVB_ADAPTIVE_PRESENTATION_HYSTERESIS 2
+
+typedef struct media_output_latency_t {
+  int offset;               //!< ns added to presentation times, never negative
+  int min_offset;           //!< Earliest playout allowed by the SRP accumulated latency, never negative
+  int fifo_size;            //!< Usable FIFO size in samples
+  int window_count;
+  int window_min_fill;
+  int window_max_fill;
+  unsigned int underflows;  //!< Underflow count at the last report
+  int window_underflow;     //!< Set if the FIFO underflowed in this window
+  int fill;                 //!< Statistics since the FIFO last locked
+  int min_fill;
+  int max_fill;
+  unsigned int total_underflows;
+} media_output_latency_t;
+
+/** Initialise the state for a FIFO.
+ *
+ *  \param fifo_size  the usable size of the FIFO in samples
+ */
+void media_output_latency_init(REFERENCE_PARAM(media_output_latency_t, l),
+                               int fifo_size);
+
+/** Start a new stream: return to the earliest allowed playout and clear
+ *  the statistics */
+void media_output_latency_reset(REFERENCE_PARAM(media_output_latency_t, l));
+
+/** Set the SRP accumulated latency of the stream that feeds the FIFO.
+ *
+ *  \param accumulated_latency  the accumulated latency in ns, 0 if unknown
+ *  \param presentation_delay   the talker's presentation time offset in ns
+ */
+void media_output_latency_set_accumulated_latency(REFERENCE_PARAM(media_output_latency_t, l),
+                                                  unsigned int accumulated_latency,
+                                                  unsigned int presentation_delay);
+
+/** The FIFO has been (re)aligned to the presentation times */
+void media_output_latency_locked(REFERENCE_PARAM(media_output_latency_t, l));
+
+/** Process a report from a locked FIFO.
+ *
+ *  \param fill           the fill level in samples
+ *  \param underflows     the FIFO's underflow counter
+ *  \param sample_period  the sample period in ns
+ *  \param adapt          non-zero to adjust the presentation offset
+ */
+void media_output_latency_update(REFERENCE_PARAM(media_output_latency_t, l),
+                                 int fill,
+                                 unsigned int underflows,
+                                 int sample_period,
+                                 int adapt);
+
+#endif // __media_output_latency_h__
@@ -0,0 +1,55 @@
+// Copyright (c) 2011-2017, XMOS Ltd, All rights reserved
+#include "media_output_lock.h"
+
+void media_output_lock_init(media_output_lock_t *l)
+{
+  l->lock_count = 0;
+  l->prev_diff = 0;
+  l->stability_count = 0;
+}
+
+media_output_lock_action_t
+media_output_lock_update(media_output_lock_t *l,
+                         const media_output_lock_params_t *params,
+                         int fifo_locked,
+                         int sample_diff,
+                         int fill)
+{
+  media_output_lock_action_t action = MEDIA_OUTPUT_LOCK_ACK;
+  int large_change = params->lost_lock_threshold_large != 0 &&
+                     (sample_diff > params->lost_lock_threshold_large ||
+                      sample_diff < -params->lost_lock_threshold_large);
+
+  if (fifo_locked && l->lock_count < params->lock_count_threshold) {
+    l->lock_count++;
+  }
+
+  if (sample_diff < params->acceptable_fill_adjust &&
+      sample_diff > -params->acceptable_fill_adjust &&
+      (sample_diff - l->prev_diff <= 1 &&
+       sample_diff - l->prev_diff >= -1)) {
+    l->stability_count++;
+  } else {
+    l->stability_count = 0;
+  }
+
+  if (!fifo_locked && (l->stability_count > params->stable_threshold)) {
+    if (fill - sample_diff > params->max_adjust ||
+        fill - sample_diff < -params->max_adjust) {
+      action = MEDIA_OUTPUT_LOCK_TOO_LARGE;
+    } else {
+      l->lock_count = 0;
+      action = MEDIA_OUTPUT_LOCK_ADJUST_FILL;
+    }
+  } else if (fifo_locked &&
+             ((l->lock_count == params->lock_count_threshold &&
+               (sample_diff > params->lost_lock_threshold ||
+                sample_diff < -params->lost_lock_threshold ||
+                fill < params->min_fill_level))
+              || large_change)) {
+    action = MEDIA_OUTPUT_LOCK_LOST;
+  }
+
+  l->prev_diff = sample_diff;
+  return action;
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __media_output_lock_h__
+#define __media_output_lock_h__
+
+#include <xccompat.h>
+
+/* The decision logic the media clock server applies to each output FIFO
+   report: when to align the FIFO to the presentation times and when to
+   give up on a stream and reset the FIFO. Kept apart from the channel
+   protocol so that it can be run in a host simulation. */
+
+/** Tuning of the output FIFO lock decisions */
+typedef struct media_output_lock_params_t {
+  int stable_threshold;           //!< Consecutive stable reports before aligning the FIFO
+  int lock_count_threshold;       //!< Reports after alignment before lock can be lost
+  int lost_lock_threshold;        //!< Presentation error in samples that loses lock
+  int lost_lock_threshold_large;  //!< Presentation error that loses lock at any time, 0 to disable
+  int min_fill_level;             //!< Fill level below which a locked FIFO is reset
+  int acceptable_fill_adjust;     //!< Largest presentation error considered stable
+  int max_adjust;                 //!< Largest fill adjustment that can be applied
+} media_output_lock_params_t;
+
+/** Per output FIFO lock state */
+typedef struct media_output_lock_t {
+  int lock_count;
+  int prev_diff;
+  int stability_count;
+} media_output_lock_t;
+
+typedef enum media_output_lock_action_t {
+  MEDIA_OUTPUT_LOCK_ACK,          //!< No change
+  MEDIA_OUTPUT_LOCK_ADJUST_FILL,  //!< Move the write pointer by the sample diff and lock
+  MEDIA_OUTPUT_LOCK_TOO_LARGE,    //!< The required adjustment does not fit in the FIFO, reset
+  MEDIA_OUTPUT_LOCK_LOST          //!< Lock was lost, reset the FIFO
+} media_output_lock_action_t;
+
+void media_output_lock_init(REFERENCE_PARAM(media_output_lock_t, l));
+
+/** Process one report from an output FIFO.
+ *
+ *  \param l            the FIFO's lock state
+ *  \param params       the tuning parameters
+ *  \param fifo_locked  whether the FIFO is currently locked
+ *  \param sample_diff  the presentation error in samples
+ *  \param fill         the FIFO fill level in samples
+ *  \returns            the action to apply to the FIFO
+ */
+media_output_lock_action_t
+media_output_lock_update(REFERENCE_PARAM(media_output_lock_t, l),
+                         REFERENCE_PARAM(const media_output_lock_params_t, params),
+                         int fifo_locked,
+                         int sample_diff,
+                         int fill);
+
+#endif // __media_output_lock_h__
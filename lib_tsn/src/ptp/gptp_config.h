@@ -7,9 +7,34 @@
 
 #define PTP_NUM_PORTS   (NUM_ETHERNET_MASTER_PORTS)
 
+#ifndef PTP_LOG_MIN_PDELAY_REQ_INTERVAL
 #define PTP_LOG_MIN_PDELAY_REQ_INTERVAL            (0)
+#endif
+#ifndef PTP_LOG_SYNC_INTERVAL
 #define PTP_LOG_SYNC_INTERVAL                      (-3)
+#endif
+#ifndef PTP_LOG_ANNOUNCE_INTERVAL
 #define PTP_LOG_ANNOUNCE_INTERVAL (0)
+#endif
+
+/* A slave port asks its master (with a Signaling message) for Syncs at
+   PTP_LOG_SYNC_INTERVAL_LOCKING until sync lock is achieved and then at
+   PTP_LOG_SYNC_INTERVAL_LOCKED. If both equal PTP_LOG_SYNC_INTERVAL no
+   request is sent. */
+#ifndef PTP_LOG_SYNC_INTERVAL_LOCKING
+#define PTP_LOG_SYNC_INTERVAL_LOCKING PTP_LOG_SYNC_INTERVAL
+#endif
+
+#ifndef PTP_LOG_SYNC_INTERVAL_LOCKED
+#define PTP_LOG_SYNC_INTERVAL_LOCKED PTP_LOG_SYNC_INTERVAL
+#endif
+
+/* Message intervals requested by a link peer, and those advertised by the
+   master, are clamped to this range. Announce and Sync receipt timeouts are
+   three intervals and must stay inside the 32-bit timer window (about 21s),
+   so 4s is the longest interval honoured. */
+#define PTP_LOG_MIN_REQUESTABLE_INTERVAL (-7)
+#define PTP_LOG_MAX_REQUESTABLE_INTERVAL (2)
 
 #define PTP_LEAP61 (0)
 #define PTP_LEAP59 (1)
@@ -35,19 +60,11 @@
 #define TIMER_TICKS_PER_SEC (100000000)
 #define LOG_SEC_TO_TIMER_TICKS(x) (x < 0 ? (TIMER_TICKS_PER_SEC >> (-x)) : TIMER_TICKS_PER_SEC << (x))
 
-#define PDELAY_REQ_PERIOD \
-       LOG_SEC_TO_TIMER_TICKS(PTP_LOG_MIN_PDELAY_REQ_INTERVAL)
-
-#define SYNC_PERIOD LOG_SEC_TO_TIMER_TICKS(PTP_LOG_SYNC_INTERVAL)
 
 #define PTP_SYNC_RECEIPT_TIMEOUT_MULTIPLE  (3)
 
-#define ANNOUNCE_PERIOD LOG_SEC_TO_TIMER_TICKS(PTP_LOG_ANNOUNCE_INTERVAL)
-
 #define PTP_ANNOUNCE_RECEIPT_TIMEOUT_MULTIPLE      (3)
 
-#define RECV_ANNOUNCE_TIMEOUT (PTP_ANNOUNCE_RECEIPT_TIMEOUT_MULTIPLE * ANNOUNCE_PERIOD)
-
 #define PTP_SYNC_LOCK_ACCEPTABLE_VARIATION 0x100000
 #define PTP_SYNC_LOCK_STABILITY_COUNT 5
 
@@ -59,4 +76,138 @@
 
 #define PTP_NEIGHBOR_PROP_DELAY_THRESH_NS 800
 
+/* Static delay asymmetry per port in ns (802.1AS delayAsymmetry). A positive
+   value means the master to slave direction is slower than the reverse. */
+#ifndef PTP_PORT_DELAY_ASYMMETRY_NS
+#define PTP_PORT_DELAY_ASYMMETRY_NS {0}
+#endif
+
+/* The neighborRateRatio is averaged with this weight and estimates that
+   differ from 1.0 by more than PTP_NEIGHBOR_RATE_RATIO_MAX_PPM are discarded */
+#define PTP_NEIGHBOR_RATE_RATIO_WEIGHT 8
+#define PTP_NEIGHBOR_RATE_RATIO_MAX_PPM 200
+
+/* Estimators that can be selected with PTP_PATH_DELAY_FILTER */
+#define PTP_PATH_DELAY_FILTER_EWMA   0 //!< Exponential average with a weight of PTP_PATH_DELAY_WEIGHT
+#define PTP_PATH_DELAY_FILTER_MEDIAN 1 //!< Median of the last PTP_PATH_DELAY_MEDIAN_WINDOW samples
+#define PTP_PATH_DELAY_FILTER_KALMAN 2 //!< Scalar Kalman filter with a random walk model
+
+#ifndef PTP_PATH_DELAY_FILTER
+#define PTP_PATH_DELAY_FILTER PTP_PATH_DELAY_FILTER_EWMA
+#endif
+
+#ifndef PTP_PATH_DELAY_WEIGHT
+#define PTP_PATH_DELAY_WEIGHT 32
+#endif
+
+#ifndef PTP_PATH_DELAY_MEDIAN_WINDOW
+#define PTP_PATH_DELAY_MEDIAN_WINDOW 7
+#endif
+
+/* Process noise of the Kalman filter in ns^2 per pdelay exchange. This
+   sets how quickly the estimate follows a genuine change in link delay. */
+#ifndef PTP_PATH_DELAY_KALMAN_Q
+#define PTP_PATH_DELAY_KALMAN_Q 1
+#endif
+
+/* Lower bound on the measurement noise used by the Kalman filter (ns^2) */
+#ifndef PTP_PATH_DELAY_KALMAN_MIN_R
+#define PTP_PATH_DELAY_KALMAN_MIN_R 4
+#endif
+
+/* Measurement noise assumed before any residuals have been observed (ns^2) */
+#ifndef PTP_PATH_DELAY_INITIAL_VARIANCE
+#define PTP_PATH_DELAY_INITIAL_VARIANCE 10000
+#endif
+
+/* Weight of the exponential average of the squared residuals */
+#ifndef PTP_PATH_DELAY_VARIANCE_WEIGHT
+#define PTP_PATH_DELAY_VARIANCE_WEIGHT 16
+#endif
+
+/* A sample is treated as an outlier when it is more than
+   PTP_PATH_DELAY_OUTLIER_THRESH_NS away from the current estimate _and_
+   more than PTP_PATH_DELAY_OUTLIER_SIGMAS standard deviations of the
+   measurement noise away. Rejection is off (0) by default, so the path
+   delay follows every measurement as it always has; 100ns suits a link
+   whose neighbour occasionally answers late. */
+#ifndef PTP_PATH_DELAY_OUTLIER_THRESH_NS
+#define PTP_PATH_DELAY_OUTLIER_THRESH_NS 0
+#endif
+
+#ifndef PTP_PATH_DELAY_OUTLIER_SIGMAS
+#define PTP_PATH_DELAY_OUTLIER_SIGMAS 4
+#endif
+
+/* Number of samples accepted before outlier rejection is enabled */
+#ifndef PTP_PATH_DELAY_OUTLIER_MIN_SAMPLES
+#define PTP_PATH_DELAY_OUTLIER_MIN_SAMPLES 4
+#endif
+
+/* When more than this many of the last 2 * PTP_PATH_DELAY_OUTLIER_MAX_REJECTS
+   samples are rejected the link delay is assumed to have really changed,
+   and the estimator restarts from the median of the rejected samples */
+#ifndef PTP_PATH_DELAY_OUTLIER_MAX_REJECTS
+#define PTP_PATH_DELAY_OUTLIER_MAX_REJECTS 4
+#endif
+
+/* Send one-step Syncs (no Follow_Up) when acting as master. The origin
+   timestamp is predicted from the time the Sync is scheduled for, as the
+   MAC cannot insert it, so this is off by default. */
+#ifndef PTP_ONE_STEP_SYNC
+#define PTP_ONE_STEP_SYNC 0
+#endif
+
+/* Initial estimate of the time from the scheduled launch of a one-step Sync
+   to it leaving the MAC, in 100MHz timer ticks */
+#ifndef PTP_ONE_STEP_TX_LATENCY
+#define PTP_ONE_STEP_TX_LATENCY 200
+#endif
+
+/* The latency estimate tracks the measured egress time with this weight */
+#ifndef PTP_ONE_STEP_LATENCY_WEIGHT
+#define PTP_ONE_STEP_LATENCY_WEIGHT 8
+#endif
+
+/* If the predicted launch time of a one-step Sync was out by more than
+   this the next Sync is sent two-step */
+#ifndef PTP_ONE_STEP_MAX_ERROR_NS
+#define PTP_ONE_STEP_MAX_ERROR_NS 200
+#endif
+
+/* Keep extrapolating the grandmaster's frequency when it is lost, and
+   slew rather than step to a grandmaster that is found again. Off by
+   default, which keeps the last rate and steps onto a new grandmaster. */
+#ifndef PTP_HOLDOVER_ENABLE
+#define PTP_HOLDOVER_ENABLE 0
+#endif
+
+/* Seconds of lock needed before holdover is possible */
+#define PTP_HOLDOVER_MIN_SAMPLES 16
+#define PTP_HOLDOVER_UPDATE_PERIOD (TIMER_TICKS_PER_SEC)
+#define PTP_HOLDOVER_FREQ_WEIGHT 8
+#define PTP_HOLDOVER_DRIFT_WEIGHT 64
+#define PTP_HOLDOVER_MAX_PPM 200
+
+/* On reacquiring a grandmaster, phase errors up to PTP_HOLDOVER_MAX_SLEW_NS
+   are removed by running up to PTP_HOLDOVER_SLEW_PPM fast or slow. Larger
+   errors are stepped. */
+#ifndef PTP_HOLDOVER_SLEW_PPM
+#define PTP_HOLDOVER_SLEW_PPM 50
+#endif
+
+#ifndef PTP_HOLDOVER_MAX_SLEW_NS
+#define PTP_HOLDOVER_MAX_SLEW_NS 500000
+#endif
+
+/* Binary trace of gPTP events, see gptp_trace.h */
+#ifndef PTP_TRACE_ENABLE
+#define PTP_TRACE_ENABLE 0
+#endif
+
+/* The trace ring holds 2^PTP_TRACE_LOG2_ENTRIES entries of 16 bytes */
+#ifndef PTP_TRACE_LOG2_ENTRIES
+#define PTP_TRACE_LOG2_ENTRIES 7
+#endif
+
 #endif // __gptp_config_h__
@@ -0,0 +1,133 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+/* Grandmaster holdover.
+
+   The model is an alpha-beta tracker on g_ptp_adjust: a frequency offset
+   plus a linear drift, updated about once a second while sync is locked.
+   In holdover the frequency is extrapolated along the drift. */
+#include "gptp_holdover.h"
+#include "gptp_internal.h"
+
+#define TICKS_PER_SEC 100000000LL
+#define MAX_HOLDOVER_SECONDS 100000
+#define MAX_ADJUST (((long long) PTP_HOLDOVER_MAX_PPM << PTP_ADJUST_PREC) / 1000000)
+
+void ptp_holdover_init(ptp_holdover_t *h)
+{
+  h->valid = 0;
+  h->active = 0;
+  h->samples = 0;
+  h->freq = 0;
+  h->drift = 0;
+  h->residual = 0;
+  h->elapsed = 0;
+}
+
+/* Convert timer ticks to seconds with PTP_HOLDOVER_PREC fractional bits */
+static long long ticks_to_seconds(unsigned long long ticks)
+{
+  return (long long) ((ticks << PTP_HOLDOVER_PREC) / TICKS_PER_SEC);
+}
+
+void ptp_holdover_update(ptp_holdover_t *h, unsigned local_ts, int adjust)
+{
+  long long measured = (long long) adjust << PTP_HOLDOVER_PREC;
+  long long dt, predicted, residual;
+
+  if (h->active)
+    return;
+
+  if (h->samples == 0) {
+    h->freq = measured;
+    h->drift = 0;
+    h->residual = 0;
+    h->last_ts = local_ts;
+    h->samples = 1;
+    return;
+  }
+
+  if ((int) (local_ts - h->last_ts) < PTP_HOLDOVER_UPDATE_PERIOD)
+    return;
+
+  dt = ticks_to_seconds(local_ts - h->last_ts);
+  h->last_ts = local_ts;
+
+  predicted = h->freq + ((h->drift * dt) >> PTP_HOLDOVER_PREC);
+  residual = measured - predicted;
+
+  h->freq = predicted + residual / PTP_HOLDOVER_FREQ_WEIGHT;
+  h->drift += (residual << PTP_HOLDOVER_PREC) / (dt * PTP_HOLDOVER_DRIFT_WEIGHT);
+  h->residual += ((residual < 0 ? -residual : residual) - h->residual) / PTP_HOLDOVER_FREQ_WEIGHT;
+
+  h->samples++;
+  if (h->samples >= PTP_HOLDOVER_MIN_SAMPLES)
+    h->valid = 1;
+}
+
+int ptp_holdover_start(ptp_holdover_t *h, unsigned local_ts)
+{
+  if (!h->valid)
+    return 0;
+  h->active = 1;
+  h->elapsed = 0;
+  h->last_ts = local_ts;
+  return 1;
+}
+
+void ptp_holdover_stop(ptp_holdover_t *h)
+{
+  /* The model restarts from scratch as the new grandmaster may run at a
+     different rate */
+  ptp_holdover_init(h);
+}
+
+int ptp_holdover_adjust(ptp_holdover_t *h, unsigned local_ts)
+{
+  long long t, adjust;
+
+  h->elapsed += local_ts - h->last_ts;
+  h->last_ts = local_ts;
+
+  t = ticks_to_seconds(h->elapsed);
+  adjust = (h->freq + ((h->drift * t) >> PTP_HOLDOVER_PREC)) >> PTP_HOLDOVER_PREC;
+
+  if (adjust > MAX_ADJUST)
+    adjust = MAX_ADJUST;
+  else if (adjust < -MAX_ADJUST)
+    adjust = -MAX_ADJUST;
+
+  return (int) adjust;
+}
+
+unsigned ptp_holdover_time_error(ptp_holdover_t *h)
+{
+  long long t = h->elapsed / TICKS_PER_SEC;
+  long long error;
+
+  if (!h->active)
+    return 0;
+
+  if (t > MAX_HOLDOVER_SECONDS)
+    t = MAX_HOLDOVER_SECONDS;
+
+  /* The frequency is only known to within the mean prediction error. The
+     drift is estimated over at least PTP_HOLDOVER_MIN_SAMPLES seconds so
+     is known to within that error spread over the same period */
+  error = (h->residual * t) >> PTP_HOLDOVER_PREC;
+  error += ((h->residual / PTP_HOLDOVER_MIN_SAMPLES) * t * t / 2) >> PTP_HOLDOVER_PREC;
+
+  /* Convert from PTP_ADJUST_PREC seconds to ns */
+  if (error > (0xffffffffLL << PTP_ADJUST_PREC) / 1000000000)
+    return 0xffffffff;
+  return (unsigned) ((error * 1000000000) >> PTP_ADJUST_PREC);
+}
+
+long long ptp_holdover_slew(long long error, unsigned elapsed)
+{
+  long long max_step = ((long long) elapsed * 10 * PTP_HOLDOVER_SLEW_PPM) / 1000000;
+
+  if (error > PTP_HOLDOVER_MAX_SLEW_NS || error < -PTP_HOLDOVER_MAX_SLEW_NS ||
+      (error <= max_step && error >= -max_step))
+    return error;
+
+  return error > 0 ? max_step : -max_step;
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __gptp_holdover_h__
+#define __gptp_holdover_h__
+
+#include <xccompat.h>
+#include "gptp_config.h"
+
+/* Fractional bits kept below PTP_ADJUST_PREC by the drift model */
+#define PTP_HOLDOVER_PREC 16
+
+/** State of the grandmaster frequency model used for holdover.
+ *
+ *  While locked the model tracks g_ptp_adjust as a frequency offset plus a
+ *  linear drift (aging). When the grandmaster is lost the model is
+ *  extrapolated to keep the gPTP time running at the old grandmaster's
+ *  rate.
+ */
+typedef struct ptp_holdover_t {
+  int valid;                      //!< Set once enough samples have been seen to extrapolate
+  int active;                     //!< Set while in holdover
+  unsigned int samples;
+  unsigned int last_ts;           //!< Local timer value of the last update
+  long long freq;                 //!< Frequency offset, PTP_ADJUST_PREC + PTP_HOLDOVER_PREC bits
+  long long drift;                //!< Change in frequency offset per second, same units
+  long long residual;             //!< Mean absolute prediction error, same units
+  unsigned long long elapsed;     //!< Timer ticks spent in holdover
+} ptp_holdover_t;
+
+void ptp_holdover_init(REFERENCE_PARAM(ptp_holdover_t, h));
+
+/** Feed the current g_ptp_adjust into the model while locked */
+void ptp_holdover_update(REFERENCE_PARAM(ptp_holdover_t, h),
+                         unsigned local_ts,
+                         int adjust);
+
+/** Enter holdover.
+ *
+ *  \returns 1 if the model is good enough to extrapolate, 0 otherwise
+ */
+int ptp_holdover_start(REFERENCE_PARAM(ptp_holdover_t, h), unsigned local_ts);
+
+void ptp_holdover_stop(REFERENCE_PARAM(ptp_holdover_t, h));
+
+/** The extrapolated ptp adjust (PTP_ADJUST_PREC) at a given local time.
+ *  Must be called at least every 40 seconds while in holdover.
+ */
+int ptp_holdover_adjust(REFERENCE_PARAM(ptp_holdover_t, h), unsigned local_ts);
+
+/** Estimate of the time error accumulated in holdover, in ns */
+unsigned ptp_holdover_time_error(REFERENCE_PARAM(ptp_holdover_t, h));
+
+/** The phase correction to apply on a Sync while slewing onto a grandmaster
+ *  found again after holdover.
+ *
+ *  \param error    the gPTP time error against the grandmaster in ns
+ *  \param elapsed  timer ticks since the previous correction
+ *  \returns        at most PTP_HOLDOVER_SLEW_PPM of elapsed, or error itself
+ *                  once it is small enough to remove in one go or too large
+ *                  (over PTP_HOLDOVER_MAX_SLEW_NS) to slew
+ */
+long long ptp_holdover_slew(long long error, unsigned elapsed);
+
+#endif // __gptp_holdover_h__
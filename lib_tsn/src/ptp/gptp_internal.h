@@ -3,6 +3,8 @@
 #define __ptp_internal_h__
 
 #include "nettypes.h"
+#include "gptp.h"
+#include "gptp_pdelay_filter.h"
 
 #define PTP_ADJUST_PREC 30
 
@@ -11,7 +13,11 @@ enum ptp_cmd_t {
   PTP_GET_TIME_INFO_MOD64,
   PTP_GET_GRANDMASTER,
   PTP_GET_STATE,
-  PTP_GET_PDELAY
+  PTP_GET_PDELAY,
+  PTP_SET_PORT_ASYMMETRY,
+  PTP_SEND_TRACE,
+  PTP_REQUEST_MESSAGE_INTERVALS,
+  PTP_GET_HOLDOVER
 };
 
 typedef enum ptp_port_role_t {
@@ -24,6 +30,14 @@ typedef enum ptp_port_role_t {
 typedef struct ptp_path_delay_t {
   int valid;
   unsigned int pdelay;
+  unsigned int pdelay_variance;   //!< Variance of the pdelay estimate in ns^2
+  int asymmetry;                  //!< Master to slave delay minus the mean path delay in ns
+  int neighbor_rate_ratio;        //!< Neighbour clock rate relative to ours - 1, PTP_ADJUST_PREC fixed point
+  int neighbor_rate_ratio_valid;
+  int prev_resp_valid;
+  ptp_timestamp prev_resp_egress_ts;
+  unsigned int prev_resp_ingress_ts;
+  ptp_pdelay_filter_t filter;
   unsigned int lost_responses;
   unsigned int exchanges;
   unsigned int multiple_resp_count;
@@ -54,9 +68,78 @@ ptp_port_role_t ptp_get_state(chanend ptp_server);
  **/
 void ptp_get_propagation_delay(chanend ptp_server, unsigned *pdelay);
 
+/** Retrieve the filtered path delay and its variance for a port
+ *
+ *  \param ptp_server chanend connected to the ptp_server
+ *  \param port       the PTP port number
+ *  \param pdelay     the mean path delay in ns
+ *  \param variance   the variance of the path delay estimate in ns^2
+ *
+ **/
+void ptp_get_path_delay_info(chanend ptp_server, int port,
+                             REFERENCE_PARAM(unsigned, pdelay),
+                             REFERENCE_PARAM(unsigned, variance));
+
+/** Set the delay asymmetry of a port at runtime
+ *
+ *  The asymmetry is the master to slave delay minus the mean path delay,
+ *  as defined by 802.1AS. It overrides the ``PTP_PORT_DELAY_ASYMMETRY_NS``
+ *  default for that port.
+ *
+ *  \param ptp_server chanend connected to the ptp_server
+ *  \param port       the PTP port number
+ *  \param asymmetry  the asymmetry in ns
+ *
+ **/
+void ptp_set_port_delay_asymmetry(chanend ptp_server, int port, int asymmetry);
+
+/** Ask the link peer of a port to change its message intervals
+ *
+ *  A Signaling message with a message interval request TLV is sent to the
+ *  peer. Each interval is log2 of the interval in seconds, or one of
+ *  ``PTP_LOG_INTERVAL_NO_CHANGE``, ``PTP_LOG_INTERVAL_INITIAL`` and
+ *  ``PTP_LOG_INTERVAL_STOP`` from gptp_pdu.h.
+ *
+ *  \param ptp_server                 chanend connected to the ptp_server
+ *  \param port                       the PTP port number
+ *  \param log_pdelay_req_interval    the interval between the peer's Pdelay_Reqs
+ *  \param log_sync_interval          the interval between the peer's Syncs
+ *  \param log_announce_interval      the interval between the peer's Announces
+ *
+ **/
+void ptp_request_message_intervals(chanend ptp_server, int port,
+                                   int log_pdelay_req_interval,
+                                   int log_sync_interval,
+                                   int log_announce_interval);
+
 
 void ptp_get_current_grandmaster(chanend ptp_server, unsigned char grandmaster[8]);
 
+/** Get the holdover state of the PTP server
+ *
+ *  The server is in holdover when it has lost its grandmaster and is
+ *  extrapolating the grandmaster's frequency.
+ *
+ *  \param ptp_server chanend connected to the ptp_server
+ *  \param active     set to 1 when in holdover, 0 otherwise
+ *  \param time_error the estimated time error accumulated in holdover in ns
+ *
+ **/
+void ptp_get_holdover_state(chanend ptp_server,
+                            REFERENCE_PARAM(int, active),
+                            REFERENCE_PARAM(unsigned, time_error));
+
+/** Ask the PTP server to send its event trace over xSCOPE
+ *
+ *  This has no effect unless the library is built with PTP_TRACE_ENABLE.
+ *  The PTP server is blocked while the trace is sent so this should only be
+ *  used for diagnostics.
+ *
+ *  \param ptp_server chanend connected to the ptp_server
+ *
+ **/
+void ptp_dump_trace(chanend ptp_server);
+
 
 /** Initialize the inline ptp server.
  *
@@ -0,0 +1,29 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include "gptp_message_interval.h"
+#include "gptp_pdu.h"
+
+unsigned ptp_log_interval_to_ticks(int log_interval)
+{
+  if (log_interval < PTP_LOG_MIN_REQUESTABLE_INTERVAL)
+    log_interval = PTP_LOG_MIN_REQUESTABLE_INTERVAL;
+  if (log_interval > PTP_LOG_MAX_REQUESTABLE_INTERVAL)
+    log_interval = PTP_LOG_MAX_REQUESTABLE_INTERVAL;
+  return LOG_SEC_TO_TIMER_TICKS(log_interval);
+}
+
+int ptp_apply_interval_request(int current, int requested, int initial)
+{
+  switch (requested) {
+  case PTP_LOG_INTERVAL_NO_CHANGE:
+    return current;
+  case PTP_LOG_INTERVAL_INITIAL:
+    return initial;
+  case PTP_LOG_INTERVAL_STOP:
+    return PTP_LOG_INTERVAL_STOP;
+  }
+  if (requested < PTP_LOG_MIN_REQUESTABLE_INTERVAL)
+    return PTP_LOG_MIN_REQUESTABLE_INTERVAL;
+  if (requested > PTP_LOG_MAX_REQUESTABLE_INTERVAL)
+    return PTP_LOG_MAX_REQUESTABLE_INTERVAL;
+  return requested;
+}
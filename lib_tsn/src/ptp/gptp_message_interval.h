@@ -0,0 +1,33 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __gptp_message_interval_h__
+#define __gptp_message_interval_h__
+
+#include "gptp_config.h"
+
+/* Every time kept by the PTP server is a 32-bit reference timer value
+   compared with timeafter(), so no period or receipt timeout built from a
+   log2 message interval may reach 2^31 ticks (about 21s). */
+#if (TIMER_TICKS_PER_SEC << PTP_LOG_MAX_REQUESTABLE_INTERVAL) * PTP_SYNC_RECEIPT_TIMEOUT_MULTIPLE > 0x7fffffff || \
+    (TIMER_TICKS_PER_SEC << PTP_LOG_MAX_REQUESTABLE_INTERVAL) * PTP_ANNOUNCE_RECEIPT_TIMEOUT_MULTIPLE > 0x7fffffff
+#error "PTP_LOG_MAX_REQUESTABLE_INTERVAL is too large for the receipt timeouts to fit the timer"
+#endif
+
+/** Convert a log2 message interval in seconds to reference timer ticks.
+ *
+ *  The interval is first clamped to the range PTP_LOG_MIN_REQUESTABLE_INTERVAL
+ *  to PTP_LOG_MAX_REQUESTABLE_INTERVAL.
+ */
+unsigned ptp_log_interval_to_ticks(int log_interval);
+
+/** Apply one interval of a received message interval request TLV.
+ *
+ *  \param current    the interval currently in use
+ *  \param requested  the interval from the TLV, which may be one of the
+ *                    PTP_LOG_INTERVAL_* special values
+ *  \param initial    the interval to go back to on PTP_LOG_INTERVAL_INITIAL
+ *  \returns          the new interval, clamped to the requestable range,
+ *                    or PTP_LOG_INTERVAL_STOP
+ */
+int ptp_apply_interval_request(int current, int requested, int initial);
+
+#endif // __gptp_message_interval_h__
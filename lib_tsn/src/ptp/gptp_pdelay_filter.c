@@ -0,0 +1,180 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+/* Path delay estimators used by the gPTP peer delay mechanism.
+
+   Every pdelay exchange yields one raw measurement of the link delay. A
+   single bad turnaround (e.g. a Pdelay_Resp delayed by a loaded neighbour)
+   can be many microseconds out, so samples that fall well outside the
+   observed measurement noise are rejected before they reach the
+   estimator. */
+#include <limits.h>
+#include "gptp_pdelay_filter.h"
+
+#define KALMAN_GAIN_PREC 16
+
+#if PTP_PATH_DELAY_OUTLIER_MAX_REJECTS < 1 || PTP_PATH_DELAY_OUTLIER_MAX_REJECTS > 16
+#error "PTP_PATH_DELAY_OUTLIER_MAX_REJECTS must be between 1 and 16"
+#endif
+
+#define REJECT_WINDOW_MASK ((1u << (2 * PTP_PATH_DELAY_OUTLIER_MAX_REJECTS)) - 1)
+
+void ptp_pdelay_filter_init(ptp_pdelay_filter_t *f)
+{
+  f->valid = 0;
+  f->estimate = 0;
+  f->variance = PTP_PATH_DELAY_INITIAL_VARIANCE;
+  f->noise = PTP_PATH_DELAY_INITIAL_VARIANCE;
+  f->samples = 0;
+  f->reject_history = 0;
+  f->rejected_index = 0;
+  f->total_rejects = 0;
+  f->kalman_p = PTP_PATH_DELAY_INITIAL_VARIANCE;
+  f->window_index = 0;
+}
+
+static unsigned int clamp_variance(long long v)
+{
+  if (v < 0)
+    return 0;
+  if (v > UINT_MAX)
+    return UINT_MAX;
+  return (unsigned int) v;
+}
+
+#define MAX_SORTED (PTP_PATH_DELAY_MEDIAN_WINDOW > PTP_PATH_DELAY_OUTLIER_MAX_REJECTS ? \
+                    PTP_PATH_DELAY_MEDIAN_WINDOW : PTP_PATH_DELAY_OUTLIER_MAX_REJECTS)
+
+static int median(const int window[], unsigned n)
+{
+  int sorted[MAX_SORTED];
+
+  /* Insertion sort, the window is only a handful of samples */
+  for (unsigned i=0; i < n; i++) {
+    int x = window[i];
+    int j = i;
+    while (j > 0 && sorted[j-1] > x) {
+      sorted[j] = sorted[j-1];
+      j--;
+    }
+    sorted[j] = x;
+  }
+
+  if (n & 1)
+    return sorted[n/2];
+  else
+    return (sorted[n/2 - 1] + sorted[n/2]) / 2;
+}
+
+static unsigned count_bits(unsigned x)
+{
+  unsigned n = 0;
+  for (; x; x &= x - 1)
+    n++;
+  return n;
+}
+
+static void restart(ptp_pdelay_filter_t *f, int delay)
+{
+  ptp_pdelay_filter_init(f);
+  f->valid = 1;
+  f->estimate = delay;
+  f->last_sample = delay;
+  f->window[0] = delay;
+  f->window_index = 1;
+  f->samples = 1;
+}
+
+static int is_outlier(ptp_pdelay_filter_t *f, long long residual)
+{
+  long long abs_residual = residual < 0 ? -residual : residual;
+
+  if (PTP_PATH_DELAY_OUTLIER_THRESH_NS == 0 ||
+      f->samples < PTP_PATH_DELAY_OUTLIER_MIN_SAMPLES)
+    return 0;
+
+  return (abs_residual > PTP_PATH_DELAY_OUTLIER_THRESH_NS &&
+          residual * residual > (long long) PTP_PATH_DELAY_OUTLIER_SIGMAS *
+                                PTP_PATH_DELAY_OUTLIER_SIGMAS * f->noise);
+}
+
+int ptp_pdelay_filter_update(ptp_pdelay_filter_t *f, int type, int delay)
+{
+  long long residual, step;
+  unsigned n;
+
+  if (!f->valid) {
+    restart(f, delay);
+    return 1;
+  }
+
+  residual = (long long) delay - f->estimate;
+
+  f->reject_history <<= 1;
+  if (is_outlier(f, residual)) {
+    f->reject_history |= 1;
+    f->total_rejects++;
+    f->rejected[f->rejected_index++ % PTP_PATH_DELAY_OUTLIER_MAX_REJECTS] = delay;
+    if (count_bits(f->reject_history & REJECT_WINDOW_MASK) > PTP_PATH_DELAY_OUTLIER_MAX_REJECTS) {
+      /* Too many to be glitches: the link delay has changed. The noise
+         estimate still holds, so outliers are rejected straight away. */
+      unsigned total_rejects = f->total_rejects;
+      unsigned noise = f->noise;
+      int estimate = median(f->rejected, PTP_PATH_DELAY_OUTLIER_MAX_REJECTS);
+
+      restart(f, estimate);
+      f->total_rejects = total_rejects;
+      f->noise = noise;
+      f->samples = PTP_PATH_DELAY_OUTLIER_MIN_SAMPLES;
+    }
+    return 0;
+  }
+
+  /* The measurement noise is estimated from the difference between
+     successive samples rather than from the residual so that it is not
+     inflated while the estimate is catching up with a change in delay */
+  step = (long long) delay - f->last_sample;
+  f->noise = clamp_variance(f->noise +
+                            (step * step / 2 - (long long) f->noise) /
+                            PTP_PATH_DELAY_VARIANCE_WEIGHT);
+  f->last_sample = delay;
+  f->samples++;
+
+  switch (type) {
+  case PTP_PATH_DELAY_FILTER_MEDIAN:
+    f->window[f->window_index % PTP_PATH_DELAY_MEDIAN_WINDOW] = delay;
+    f->window_index++;
+    n = f->window_index < PTP_PATH_DELAY_MEDIAN_WINDOW ?
+        f->window_index : PTP_PATH_DELAY_MEDIAN_WINDOW;
+    f->estimate = median(f->window, n);
+    /* The median of n gaussian samples has pi/2 times the variance of
+       their mean */
+    f->variance = clamp_variance(((long long) f->noise * 157) / (100 * n));
+    break;
+
+  case PTP_PATH_DELAY_FILTER_KALMAN: {
+    long long r = f->noise < PTP_PATH_DELAY_KALMAN_MIN_R ?
+                  PTP_PATH_DELAY_KALMAN_MIN_R : f->noise;
+    long long k;
+
+    f->kalman_p += PTP_PATH_DELAY_KALMAN_Q;
+    k = (f->kalman_p << KALMAN_GAIN_PREC) / (f->kalman_p + r);
+    f->estimate += (int) ((k * residual +
+                           (1 << (KALMAN_GAIN_PREC - 1))) >> KALMAN_GAIN_PREC);
+    f->kalman_p = (((1 << KALMAN_GAIN_PREC) - k) * f->kalman_p) >> KALMAN_GAIN_PREC;
+    if (f->kalman_p < 1)
+      f->kalman_p = 1;
+    f->variance = clamp_variance(f->kalman_p);
+    break;
+  }
+
+  case PTP_PATH_DELAY_FILTER_EWMA:
+  default:
+    /* Re-average with a given weighting. The variance of an exponential
+       average with weight w is 1/(2w-1) of the sample variance */
+    f->estimate = (int) (((long long) f->estimate * (PTP_PATH_DELAY_WEIGHT - 1) +
+                          delay) / PTP_PATH_DELAY_WEIGHT);
+    f->variance = f->noise / (2 * PTP_PATH_DELAY_WEIGHT - 1);
+    break;
+  }
+
+  return 1;
+}
@@ -0,0 +1,40 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __gptp_pdelay_filter_h__
+#define __gptp_pdelay_filter_h__
+
+#include <xccompat.h>
+#include "gptp_config.h"
+
+/** State of the path delay estimator for one port */
+typedef struct ptp_pdelay_filter_t {
+  int valid;                //!< Set once the first sample has been accepted
+  int estimate;             //!< The current path delay estimate in ns (may be negative)
+  unsigned int variance;    //!< Variance of the estimate in ns^2
+  unsigned int noise;       //!< Variance of the measurement noise in ns^2
+  int last_sample;          //!< The last accepted measurement in ns
+  unsigned int samples;     //!< Number of samples accepted since the last restart
+  unsigned int reject_history; //!< One bit per recent sample, set if it was rejected
+  int rejected[PTP_PATH_DELAY_OUTLIER_MAX_REJECTS]; //!< The latest rejected samples
+  unsigned int rejected_index;
+  unsigned int total_rejects; //!< Number of samples rejected since initialisation
+  long long kalman_p;       //!< Kalman error covariance in ns^2
+  unsigned int window_index;
+  int window[PTP_PATH_DELAY_MEDIAN_WINDOW];
+} ptp_pdelay_filter_t;
+
+/** Initialise (or restart) a path delay estimator */
+void ptp_pdelay_filter_init(REFERENCE_PARAM(ptp_pdelay_filter_t, f));
+
+/** Feed a raw path delay measurement into an estimator.
+ *
+ *  \param f        the estimator state
+ *  \param type     one of the PTP_PATH_DELAY_FILTER_* values
+ *  \param delay    the measured path delay in ns
+ *  \returns        1 if the sample was used, 0 if it was rejected as an
+ *                  outlier
+ */
+int ptp_pdelay_filter_update(REFERENCE_PARAM(ptp_pdelay_filter_t, f),
+                             int type,
+                             int delay);
+
+#endif // __gptp_pdelay_filter_h__
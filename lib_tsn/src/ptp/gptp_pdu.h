@@ -118,6 +118,34 @@ typedef struct
   n16_t requestingPortId;
 } PdelayRespFollowUpMessage;
 
+// PTP Signaling message carrying a message interval request TLV
+// (802.1AS 10.6.4.3)
+typedef struct
+{
+  n80_t targetPortIdentity;
+  n16_t tlvType;
+  n16_t lengthField;
+  n8_t  organizationId[3];
+  n8_t  organizationSubType[3];
+  n8_t  linkDelayInterval;
+  n8_t  timeSyncInterval;
+  n8_t  announceInterval;
+  n8_t  flags;
+  n16_t reserved;
+} SignalingMessage;
+
+#define PTP_ORGANIZATION_EXTENSION_TLV_TYPE (0x3)
+#define PTP_MESSAGE_INTERVAL_REQUEST_SUBTYPE (2)
+#define PTP_MESSAGE_INTERVAL_REQUEST_TLV_LENGTH (12)
+
+// Special values of the intervals in a message interval request
+#define PTP_LOG_INTERVAL_NO_CHANGE        (-128)
+#define PTP_LOG_INTERVAL_INITIAL          (126)
+#define PTP_LOG_INTERVAL_STOP             (127)
+
+#define PTP_COMPUTE_NEIGHBOR_RATE_RATIO_FLAG  (0x1)
+#define PTP_COMPUTE_NEIGHBOR_PROP_DELAY_FLAG  (0x2)
+
 // Macro to evaluate flagField(s) in PTP message
 #define ALTERNATE_MASTER_FLAG(msgHdr)        (msgHdr->flagField[0] & 0x1)
 
@@ -0,0 +1,62 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <xscope.h>
+#include "gptp_trace.h"
+
+#if PTP_TRACE_ENABLE
+
+ptp_trace_t ptp_trace;
+
+void ptp_trace_init(void)
+{
+  ptp_trace.magic = PTP_TRACE_MAGIC;
+  ptp_trace.version = PTP_TRACE_VERSION;
+  ptp_trace.log2_entries = PTP_TRACE_LOG2_ENTRIES;
+  ptp_trace.index = 0;
+}
+
+void ptp_trace_write(int event, int port, int seq_id,
+                     unsigned local_ts, int a, int b)
+{
+  ptp_trace_entry_t *e = &ptp_trace.entries[ptp_trace.index & (PTP_TRACE_ENTRIES - 1)];
+
+  e->event = event;
+  e->port = port;
+  e->seq_id = seq_id;
+  e->local_ts = local_ts;
+  e->a = a;
+  e->b = b;
+  ptp_trace.index++;
+}
+
+void ptp_trace_send(void)
+{
+#ifdef GPTP_TRACE
+  /* The header is sent first, followed by the ring in memory order. The
+     host decoder uses the index in the header to find the oldest entry */
+  xscope_bytes(GPTP_TRACE, sizeof(ptp_trace) - sizeof(ptp_trace.entries),
+               (const unsigned char *) &ptp_trace);
+  for (int i = 0; i < PTP_TRACE_ENTRIES; i++) {
+    xscope_bytes(GPTP_TRACE, sizeof(ptp_trace_entry_t),
+                 (const unsigned char *) &ptp_trace.entries[i]);
+  }
+#endif
+}
+
+#else
+
+void ptp_trace_init(void) {}
+
+void ptp_trace_write(int event, int port, int seq_id,
+                     unsigned local_ts, int a, int b)
+{
+  (void) event;
+  (void) port;
+  (void) seq_id;
+  (void) local_ts;
+  (void) a;
+  (void) b;
+}
+
+void ptp_trace_send(void) {}
+
+#endif
@@ -0,0 +1,69 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __gptp_trace_h__
+#define __gptp_trace_h__
+
+/* Binary trace of gPTP events.
+
+   The PTP server writes fixed size records into a ring buffer from its
+   timing critical paths instead of calling debug_printf. The ring can be
+   read out with the debugger (e.g. ``dump binary value trace.bin
+   ptp_trace``) or sent over xSCOPE with ptp_dump_trace() and then converted
+   to CSV with lib_tsn/host/gptp_trace_to_csv.py.
+
+   Enable with PTP_TRACE_ENABLE in avb_conf.h. */
+
+#include "gptp_config.h"
+
+#define PTP_TRACE_MAGIC 0x54505447 // "GTPT"
+#define PTP_TRACE_VERSION 1
+#define PTP_TRACE_ENTRIES (1 << PTP_TRACE_LOG2_ENTRIES)
+
+/* The meaning of the a/b fields of each event is given alongside */
+typedef enum ptp_trace_event_t {
+  PTP_TRACE_SYNC_RX = 1,       //!< local_ts: ingress
+  PTP_TRACE_FOLLOW_UP_RX,      //!< local_ts: sync ingress, a/b: origin seconds (low word)/ns
+  PTP_TRACE_SYNC_TX,           //!< local_ts: egress, a/b: egress seconds (low word)/ns
+  PTP_TRACE_PDELAY_RESP,       //!< local_ts: resp ingress (t4), a: req egress (t1), b: responder turnaround in ns
+  PTP_TRACE_PDELAY,            //!< a: raw path delay in ns, b: filtered path delay in ns
+  PTP_TRACE_PDELAY_OUTLIER,    //!< a: rejected path delay in ns, b: filtered path delay in ns
+  PTP_TRACE_ADJUST,            //!< local_ts: sync ingress, a: g_ptp_adjust, b: measured adjust
+  PTP_TRACE_ROLE,              //!< a: new ptp_port_role_t
+  PTP_TRACE_LOCK,              //!< a: 1 when sync lock is gained, 0 when lost
+  PTP_TRACE_HOLDOVER           //!< a: 1 entering holdover, 0 leaving, b: estimated time error in ns
+} ptp_trace_event_t;
+
+typedef struct ptp_trace_entry_t {
+  unsigned char event;         //!< A ptp_trace_event_t
+  unsigned char port;
+  unsigned short seq_id;       //!< The PTP sequenceId of the message (if any)
+  unsigned int local_ts;       //!< Reference timer value when the event happened
+  int a;
+  int b;
+} ptp_trace_entry_t;
+
+typedef struct ptp_trace_t {
+  unsigned int magic;
+  unsigned int version;
+  unsigned int log2_entries;
+  unsigned int index;          //!< Total number of entries ever written
+  ptp_trace_entry_t entries[PTP_TRACE_ENTRIES];
+} ptp_trace_t;
+
+void ptp_trace_init(void);
+
+void ptp_trace_write(int event, int port, int seq_id,
+                     unsigned local_ts, int a, int b);
+
+/** Send the trace ring over the xSCOPE probe ``gPTP Trace`` (if the
+ *  application defines it in config.xscope).
+ */
+void ptp_trace_send(void);
+
+#if PTP_TRACE_ENABLE
+#define PTP_TRACE(event, port, seq_id, local_ts, a, b) \
+  ptp_trace_write(event, port, seq_id, local_ts, a, b)
+#else
+#define PTP_TRACE(event, port, seq_id, local_ts, a, b)
+#endif
+
+#endif // __gptp_trace_h__
@@ -0,0 +1,91 @@
+// Copyright (c) 2011-2017, XMOS Ltd, All rights reserved
+#include <xs1.h>
+#include "misc_timer.h"
+
+#define TICKS_PER_CENTISECOND (XS1_TIMER_KHZ * 10)
+
+// Tasks on the same tile that are not combined run at the same time, so
+// each logical core schedules its own periodic work
+#define MAX_LOGICAL_CORES 8
+
+static unsigned periodic_start[MAX_LOGICAL_CORES];
+static unsigned periodic_wake[MAX_LOGICAL_CORES];
+
+// Wake when a timer expires. A long countdown wakes once a period instead,
+// so the wake time stays within the range of a signed timer comparison.
+static void avb_timer_wake_on_expiry(avb_timer *tmr)
+{
+  unsigned remaining = tmr->active - 1;
+
+  if (tmr->period != 0 && remaining > 0x40000000 / tmr->period)
+    avb_timer_wake_at(tmr->timeout);
+  else
+    avb_timer_wake_at(tmr->timeout + remaining * tmr->period);
+}
+
+void init_avb_timer(avb_timer *tmr, int mult)
+{
+  tmr->active = 0;
+  tmr->timeout_multiplier = mult;
+}
+
+void start_avb_timer(avb_timer *tmr, unsigned int period_cs)
+{
+  tmr->period = (period_cs * TICKS_PER_CENTISECOND);
+  tmr->timeout = get_local_time() + (period_cs * TICKS_PER_CENTISECOND);
+  tmr->active = tmr->timeout_multiplier;
+  if (tmr->active)
+    avb_timer_wake_on_expiry(tmr);
+}
+
+int avb_timer_expired(avb_timer *tmr)
+{
+  unsigned int now = get_local_time();
+  if (!tmr->active)
+    return 0;
+
+  // Count every period that has passed since the last check. A period
+  // ends at its timeout, which is when the task is woken to check it.
+  while (tmr->active && (int)(now - tmr->timeout) >= 0) {
+    tmr->active--;
+    tmr->timeout += tmr->period;
+  }
+
+  if (tmr->active) {
+    avb_timer_wake_on_expiry(tmr);
+    return 0;
+  }
+  return 1;
+}
+
+void stop_avb_timer(avb_timer *tmr)
+{
+  tmr->active = 0;
+}
+
+void avb_timer_begin_periodic(unsigned now, unsigned max_sleep)
+{
+  unsigned core = get_logical_core_id();
+  periodic_start[core] = now;
+  periodic_wake[core] = now + max_sleep;
+}
+
+void avb_timer_wake_at(unsigned t)
+{
+  unsigned core = get_logical_core_id();
+  unsigned start = periodic_start[core];
+
+  if ((int)(t - start) < (int)(periodic_wake[core] - start))
+    periodic_wake[core] = t;
+}
+
+void avb_timer_wake_now(void)
+{
+  unsigned core = get_logical_core_id();
+  periodic_wake[core] = periodic_start[core];
+}
+
+unsigned avb_timer_next_wake(void)
+{
+  return periodic_wake[get_logical_core_id()];
+}
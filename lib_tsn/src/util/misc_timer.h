@@ -24,6 +24,16 @@ void start_avb_timer(REFERENCE_PARAM(avb_timer,tmr), unsigned int period_cs);
 int avb_timer_expired(REFERENCE_PARAM(avb_timer,tmr));
 void stop_avb_timer(REFERENCE_PARAM(avb_timer,tmr));
 
+/*!
+ * Scheduling of a task's periodic work. The task begins each pass with
+ * avb_timer_begin_periodic(); timers that are checked or started, and
+ * state machines with work to do, note when they next need to run, and
+ * avb_timer_next_wake() gives the earliest of these, or now + max_sleep.
+ */
+void avb_timer_begin_periodic(unsigned now, unsigned max_sleep);
+void avb_timer_wake_at(unsigned t);
+void avb_timer_wake_now(void);
+unsigned avb_timer_next_wake(void);
 
 
 #endif /*MISC_TIMER_H_*/
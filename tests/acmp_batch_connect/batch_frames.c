@@ -0,0 +1,81 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "batch_frames.h"
+#include "avb_1722_common.h"
+#include "avb_1722_1_protocol.h"
+#include "avb_1722_1_acmp_pdu.h"
+
+#define ETH_HEADER   14
+#define PDU_HEADER   12
+
+static const unsigned char listener_mac[6] = LISTENER_MAC;
+
+// GUIDs are formed from MAC addresses
+static unsigned long long mac_guid(const unsigned char mac[6])
+{
+  unsigned long long guid = 0;
+
+  for (int i = 0; i < 3; i++)
+    guid = (guid << 8) | mac[i];
+  guid = (guid << 16) | 0xfffe;
+  for (int i = 3; i < 6; i++)
+    guid = (guid << 8) | mac[i];
+  return guid;
+}
+
+static unsigned long long get_guid(const unsigned char *p)
+{
+  unsigned long long guid = 0;
+
+  for (int i = 0; i < 8; i++)
+    guid = (guid << 8) | p[i];
+  return guid;
+}
+
+static unsigned get16(const unsigned char *p)
+{
+  return (p[0] << 8) | p[1];
+}
+
+void batch_connections(avb_1722_1_acmp_connection_t connections[], unsigned num_connections)
+{
+  static const unsigned char talker_mac[6] = {0x00, 0x22, 0x97, 0x20, 0x00, 0x00};
+
+  for (unsigned i = 0; i < num_connections; i++) {
+    connections[i].talker_guid.l = mac_guid(talker_mac);
+    connections[i].listener_guid.l = mac_guid(listener_mac) + i / SINKS_PER_LISTENER;
+    connections[i].talker_unique_id = 0;
+    connections[i].listener_unique_id = i % SINKS_PER_LISTENER;
+  }
+}
+
+int rx_command(const unsigned char frame[], unsigned len, unsigned *connection, unsigned *seq)
+{
+  const unsigned char *pdu = frame + ETH_HEADER;
+  unsigned message_type;
+
+  if (len < ETH_HEADER + PDU_HEADER + AVB_1722_1_ACMP_CD_LENGTH ||
+      get16(frame + 12) != AVB_1722_ETHERTYPE ||
+      pdu[0] != (0x80 | DEFAULT_1722_1_ACMP_SUBTYPE))
+    return -1;
+
+  message_type = pdu[1] & 0xf;
+  if (message_type != ACMP_CMD_CONNECT_RX_COMMAND && message_type != ACMP_CMD_DISCONNECT_RX_COMMAND)
+    return -1;
+
+  *connection = (unsigned) (get_guid(pdu + 28) - mac_guid(listener_mac)) * SINKS_PER_LISTENER +
+                get16(pdu + 38);
+  *seq = get16(pdu + 48);
+  return message_type;
+}
+
+unsigned rx_response(unsigned char pdu[], const unsigned char frame[], unsigned status)
+{
+  unsigned len = PDU_HEADER + AVB_1722_1_ACMP_CD_LENGTH;
+
+  memcpy(pdu, frame + ETH_HEADER, len);
+  // The response to a command is the message type after it
+  pdu[1] = (pdu[1] & 0xf0) | ((pdu[1] & 0xf) + 1);
+  pdu[2] = (status << 3) | (pdu[2] & 7);
+  return len;
+}
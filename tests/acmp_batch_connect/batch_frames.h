@@ -0,0 +1,40 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef BATCH_FRAMES_H_
+#define BATCH_FRAMES_H_
+
+#include <xccompat.h>
+#include "avb_1722_1_acmp_batch.h"
+
+#define ENTITY_MAC      {0x00, 0x22, 0x97, 0x01, 0x02, 0x03}
+#define LISTENER_MAC    {0x00, 0x22, 0x97, 0x30, 0x00, 0x00}
+
+/** The listeners each have this many sinks */
+#define SINKS_PER_LISTENER 16
+
+/** Enough for an ACMP PDU */
+#define BATCH_MAX_PDU 64
+
+/** Fill in connections from a talker to the sinks of the listeners, in
+ *  order of listener and then sink */
+void batch_connections(avb_1722_1_acmp_connection_t connections[], unsigned num_connections);
+
+/** The message type of a CONNECT_RX_COMMAND or DISCONNECT_RX_COMMAND the
+ *  entity sent, from the Ethernet header on.
+ *
+ *  \param connection  set to the position of the connection it is for, as
+ *                     batch_connections() orders them
+ *  \param seq         set to the sequence ID of the command
+ *  \returns           the message type, or -1 if the frame is another
+ */
+int rx_command(const unsigned char frame[], unsigned len,
+               REFERENCE_PARAM(unsigned, connection),
+               REFERENCE_PARAM(unsigned, seq));
+
+/** Build the response of a listener to a command rx_command() accepted.
+ *
+ *  \param pdu  filled with the response from the 1722.1 header on
+ *  \returns    the length of the response
+ */
+unsigned rx_response(unsigned char pdu[], const unsigned char frame[], unsigned status);
+
+#endif /* BATCH_FRAMES_H_ */
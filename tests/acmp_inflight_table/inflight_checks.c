@@ -0,0 +1,90 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "inflight_checks.h"
+#include "avb_1722_1_acmp_inflight.h"
+
+#define CONTROLLER        0
+#define DISCONNECT_RX     ACMP_CMD_DISCONNECT_RX_COMMAND
+#define TIMEOUT_TICKS     5                   // 500ms, from Table 7.4
+
+extern avb_1722_1_acmp_inflight_command acmp_controller_inflight_commands[AVB_1722_1_MAX_INFLIGHT_COMMANDS];
+
+static void make_command(avb_1722_1_acmp_cmd_resp *c, int i, unsigned short seq)
+{
+  memset(c, 0, sizeof(*c));
+  c->message_type = DISCONNECT_RX;
+  c->talker_guid.l = 0x001cab0000000001ULL;
+  c->listener_guid.l = 0x001cab0000010000ULL + i;
+  c->talker_unique_id = i % 4;
+  c->listener_unique_id = i;
+  c->sequence_id = seq;
+}
+
+int check_wrap(void)
+{
+  avb_1722_1_acmp_cmd_resp c;
+  unsigned short seq = 65536 - AVB_1722_1_MAX_INFLIGHT_COMMANDS / 2;
+
+  acmp_inflight_init(CONTROLLER);
+  for (int i = 0; i < AVB_1722_1_MAX_INFLIGHT_COMMANDS; i++) {
+    unsigned short s = seq + i;
+    if (!acmp_inflight_available(CONTROLLER, s))
+      return 0;
+    make_command(&c, i, s);
+    acmp_inflight_add(CONTROLLER, &c, DISCONNECT_RX, i, TIMEOUT_TICKS);
+  }
+  // The table is full, and only IDs in flight are found
+  if (acmp_inflight_available(CONTROLLER, (unsigned short) (seq + AVB_1722_1_MAX_INFLIGHT_COMMANDS)))
+    return 0;
+  for (int i = 0; i < AVB_1722_1_MAX_INFLIGHT_COMMANDS; i++) {
+    int index = acmp_inflight_find(CONTROLLER, (unsigned short) (seq + i));
+    if (index < 0 || acmp_controller_inflight_commands[index].original_sequence_id != i)
+      return 0;
+    if (acmp_inflight_find(CONTROLLER, (unsigned short) (seq + i + AVB_1722_1_MAX_INFLIGHT_COMMANDS)) >= 0)
+      return 0;
+  }
+  acmp_inflight_free(CONTROLLER, acmp_inflight_find(CONTROLLER, seq));
+  return acmp_inflight_count(CONTROLLER) == AVB_1722_1_MAX_INFLIGHT_COMMANDS - 1 &&
+         acmp_inflight_available(CONTROLLER, (unsigned short) (seq + AVB_1722_1_MAX_INFLIGHT_COMMANDS));
+}
+
+int check_wheel(void)
+{
+  avb_1722_1_acmp_cmd_resp c;
+  int order[3];
+  int n = 0;
+
+  acmp_inflight_init(CONTROLLER);
+  make_command(&c, 0, 0);
+  acmp_inflight_add(CONTROLLER, &c, DISCONNECT_RX, 0, 45);
+  make_command(&c, 1, 1);
+  acmp_inflight_add(CONTROLLER, &c, DISCONNECT_RX, 1, 2);
+  make_command(&c, 2, 2);
+  acmp_inflight_add(CONTROLLER, &c, DISCONNECT_RX, 2, 20);
+
+  // Nothing is due early, then each command comes out when due
+  for (unsigned t = 1; t <= 45; t++) {
+    int index;
+
+    acmp_inflight_tick(CONTROLLER);
+    while ((index = acmp_inflight_next_timeout(CONTROLLER)) >= 0) {
+      if (n == 3)
+        return 0;
+      order[n++] = index;
+      if (acmp_controller_inflight_commands[index].timeout != t)
+        return 0;
+      acmp_inflight_free(CONTROLLER, index);
+    }
+  }
+  if (n != 3 || order[0] != 1 || order[1] != 2 || order[2] != 0)
+    return 0;
+
+  // A retry moves the timeout; a wheel left alone for two turns catches up
+  make_command(&c, 3, 3);
+  acmp_inflight_add(CONTROLLER, &c, DISCONNECT_RX, 3, 2);
+  acmp_inflight_retry(CONTROLLER, 3, 50);
+  for (int t = 0; t < 2 * ACMP_INFLIGHT_WHEEL_SLOTS; t++)
+    acmp_inflight_tick(CONTROLLER);
+  return acmp_inflight_next_timeout(CONTROLLER) == 3 &&
+         acmp_controller_inflight_commands[3].retried;
+}
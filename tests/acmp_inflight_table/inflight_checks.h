@@ -0,0 +1,16 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef INFLIGHT_CHECKS_H_
+#define INFLIGHT_CHECKS_H_
+
+/* Checks of the controller inflight table on its own, which must not be
+   in use. See avb_1722_1_acmp_inflight.h */
+
+/** The table is filled across a sequence ID wrap, and only the IDs in
+ *  flight are found. Returns 1 if it passes. */
+int check_wrap(void);
+
+/** Commands come off the timer wheel when they are due, and a wheel not
+ *  ticked for two turns catches up. Returns 1 if it passes. */
+int check_wheel(void);
+
+#endif /* INFLIGHT_CHECKS_H_ */
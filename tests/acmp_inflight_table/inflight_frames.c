@@ -0,0 +1,89 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "inflight_frames.h"
+#include "avb_1722_common.h"
+#include "avb_1722_1_protocol.h"
+#include "avb_1722_1_acmp_pdu.h"
+
+#define ETH_HEADER   14
+#define PDU_HEADER   12
+
+static const unsigned char entity_mac[6] = ENTITY_MAC;
+static const unsigned char controller_mac[6] = CONTROLLER_MAC;
+static const unsigned char listener_mac[6] = LISTENER_MAC;
+static const unsigned char talker_mac[6] = {0x00, 0x22, 0x97, 0x20, 0x00, 0x00};
+
+static void put16(unsigned char *p, unsigned v)
+{
+  p[0] = v >> 8;
+  p[1] = v;
+}
+
+static unsigned get16(const unsigned char *p)
+{
+  return (p[0] << 8) | p[1];
+}
+
+// GUIDs are formed from MAC addresses
+static void put_guid(unsigned char *p, const unsigned char mac[6])
+{
+  memcpy(p, mac, 3);
+  p[3] = 0xff;
+  p[4] = 0xfe;
+  memcpy(p + 5, mac + 3, 3);
+}
+
+static unsigned long long mac_guid(const unsigned char mac[6])
+{
+  unsigned char p[8];
+  unsigned long long guid = 0;
+
+  put_guid(p, mac);
+  for (int i = 0; i < 8; i++)
+    guid = (guid << 8) | p[i];
+  return guid;
+}
+
+void listener_connection(guid_t *talker_guid, guid_t *listener_guid)
+{
+  talker_guid->l = mac_guid(talker_mac);
+  listener_guid->l = mac_guid(listener_mac);
+}
+
+unsigned rx_command(unsigned char pdu[], unsigned message_type, unsigned seq)
+{
+  memset(pdu, 0, PDU_HEADER + AVB_1722_1_ACMP_CD_LENGTH);
+  pdu[0] = 0x80 | DEFAULT_1722_1_ACMP_SUBTYPE;
+  pdu[1] = message_type;
+  pdu[3] = AVB_1722_1_ACMP_CD_LENGTH;
+  put_guid(pdu + 12, controller_mac);
+  put_guid(pdu + 20, talker_mac);
+  put_guid(pdu + 28, entity_mac);
+  put16(pdu + 48, seq);
+  return PDU_HEADER + AVB_1722_1_ACMP_CD_LENGTH;
+}
+
+int acmp_frame(const unsigned char frame[], unsigned len, unsigned *seq, unsigned *status)
+{
+  const unsigned char *pdu = frame + ETH_HEADER;
+
+  if (len < ETH_HEADER + PDU_HEADER + AVB_1722_1_ACMP_CD_LENGTH ||
+      get16(frame + 12) != AVB_1722_ETHERTYPE ||
+      pdu[0] != (0x80 | DEFAULT_1722_1_ACMP_SUBTYPE))
+    return -1;
+
+  *seq = get16(pdu + 48);
+  *status = pdu[2] >> 3;
+  return pdu[1] & 0xf;
+}
+
+unsigned acmp_response(unsigned char pdu[], const unsigned char frame[], unsigned status)
+{
+  unsigned len = PDU_HEADER + AVB_1722_1_ACMP_CD_LENGTH;
+
+  memcpy(pdu, frame + ETH_HEADER, len);
+  // The response to a command is the message type after it
+  pdu[1] = (pdu[1] & 0xf0) | ((pdu[1] & 0xf) + 1);
+  pdu[2] = (status << 3) | (pdu[2] & 7);
+  return len;
+}
@@ -0,0 +1,46 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef INFLIGHT_FRAMES_H_
+#define INFLIGHT_FRAMES_H_
+
+#include <xccompat.h>
+#include "avb_1722_1_acmp_pdu.h"
+
+#define ENTITY_MAC      {0x00, 0x22, 0x97, 0x01, 0x02, 0x03}
+#define CONTROLLER_MAC  {0x00, 0x22, 0x97, 0x0a, 0x0b, 0x0c}
+#define LISTENER_MAC    {0x00, 0x22, 0x97, 0x30, 0x00, 0x00}
+
+/** Enough for an ACMP PDU */
+#define INFLIGHT_MAX_PDU 64
+
+/** Fill in the GUIDs of a connection from a talker to a listener that is
+ *  not the entity */
+void listener_connection(REFERENCE_PARAM(guid_t, talker_guid),
+                         REFERENCE_PARAM(guid_t, listener_guid));
+
+/** Build a CONNECT_RX_COMMAND or DISCONNECT_RX_COMMAND from the controller
+ *  to sink 0 of the entity, for a talker that is not the entity.
+ *
+ *  \param pdu  filled with the command from the 1722.1 header on
+ *  \returns    the length of the command
+ */
+unsigned rx_command(unsigned char pdu[], unsigned message_type, unsigned seq);
+
+/** The message type of an ACMP frame the entity sent, from the Ethernet
+ *  header on.
+ *
+ *  \param seq     set to the sequence ID of the frame
+ *  \param status  set to the status of the frame
+ *  \returns       the message type, or -1 if the frame is not ACMP
+ */
+int acmp_frame(const unsigned char frame[], unsigned len,
+               REFERENCE_PARAM(unsigned, seq),
+               REFERENCE_PARAM(unsigned, status));
+
+/** Build the response to a command the entity sent.
+ *
+ *  \param pdu  filled with the response from the 1722.1 header on
+ *  \returns    the length of the response
+ */
+unsigned acmp_response(unsigned char pdu[], const unsigned char frame[], unsigned status);
+
+#endif /* INFLIGHT_FRAMES_H_ */
@@ -0,0 +1,163 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include "avb_1722_1_entity_db.h"
+
+/* Correctness and lookup cost of the ADP entity database at 1024
+   entities.
+
+   The database is filled with GUIDs of the form vendor OUI plus serial,
+   then exercised with refreshes, departures, timeouts and overflow, and
+   checked against a plain list of what should be present. Lookups are
+   timed on the reference clock. */
+
+#define N           AVB_1722_1_MAX_ENTITIES
+#define BASE_GUID   0x001cab00000000ULL
+#define BENCH_LOOPS 4
+
+static unsigned long long guids[N];
+static unsigned present[N];
+
+static unsigned long long make_guid(int i)
+{
+  // Serial numbers are not contiguous in practice
+  return BASE_GUID | ((unsigned long long) (i * 7919u) << 8) | 0xfe;
+}
+
+static int check_all(void)
+{
+  int n = 0;
+
+  for (int i = 0; i < N; i++) {
+    int index = avb_1722_1_entity_db_find(guids[i]);
+    avb_1722_1_entity_record r;
+
+    if (!present[i]) {
+      if (index >= 0)
+        return 0;
+      continue;
+    }
+    if (index < 0)
+      return 0;
+    avb_1722_1_entity_db_get(index, &r);
+    if (r.guid.l != guids[i] || r.vendor_id != (unsigned) i)
+      return 0;
+    n++;
+  }
+  return n == avb_1722_1_entity_db_count();
+}
+
+static int add(int i, unsigned timeout)
+{
+  avb_1722_1_entity_record r;
+  int added;
+  int index = avb_1722_1_entity_db_add(guids[i], timeout, &added);
+
+  r.vendor_id = i;
+  avb_1722_1_entity_db_set(index, &r);
+  present[i] = 1;
+  return added;
+}
+
+#ifdef __XS2A__
+static unsigned get_time(void)
+{
+  unsigned t;
+  asm volatile("gettime %0" : "=r"(t));
+  return t;
+}
+#else
+#include <time.h>
+static unsigned get_time(void)
+{
+  return (unsigned) clock();
+}
+#endif
+
+int main(void)
+{
+  int pass = 1;
+  int ok, expired;
+  unsigned prev, start, ticks;
+  unsigned long long prev_guid;
+
+  avb_1722_1_entity_db_flush();
+  for (int i = 0; i < N; i++)
+    guids[i] = make_guid(i);
+
+  // Fill with timeouts spread over 31 periods
+  ok = 1;
+  for (int i = 0; i < N; i++)
+    ok &= add(i, 2 + (i * 13) % 31);
+  ok &= check_all();
+  printf("fill %d entities: %s\n", avb_1722_1_entity_db_count(), ok ? "ok" : "failed");
+  pass &= ok;
+
+  // Refreshing is not an addition and moves the timeout
+  ok = 1;
+  for (int i = 0; i < N; i += 3)
+    ok &= !add(i, 100);
+  ok &= check_all();
+  printf("refresh: %s\n", ok ? "ok" : "failed");
+  pass &= ok;
+
+  // Departures leave the rest of each probe sequence reachable
+  for (int i = 1; i < N; i += 2) {
+    avb_1722_1_entity_db_remove(avb_1722_1_entity_db_find(guids[i]));
+    present[i] = 0;
+  }
+  ok = check_all();
+  printf("depart: %d left %s\n", avb_1722_1_entity_db_count(), ok ? "ok" : "failed");
+  pass &= ok;
+
+  // Expiry comes out in timeout order and stops at unexpired entities
+  ok = 1;
+  prev = 0;
+  expired = 0;
+  while (1) {
+    int index = avb_1722_1_entity_db_remove_expired(50);
+    if (index < 0)
+      break;
+    for (int i = 0; i < N; i++) {
+      if (present[i] && avb_1722_1_entity_db_find(guids[i]) < 0) {
+        unsigned timeout = 2 + (i * 13) % 31;
+        if (timeout < prev || i % 3 == 0)
+          ok = 0;
+        prev = timeout;
+        present[i] = 0;
+        expired++;
+      }
+    }
+  }
+  ok &= check_all();
+  for (int i = 0; i < N; i++)
+    if (present[i] && i % 3 != 0)
+      ok = 0;
+  printf("expire: %d expired, %d left %s\n", expired,
+         avb_1722_1_entity_db_count(), ok ? "ok" : "failed");
+  pass &= ok;
+
+  // A full database makes way for new entities, least recent first
+  for (int i = 0; i < N; i++)
+    if (!present[i])
+      add(i, 200);
+  ok = avb_1722_1_entity_db_count() == N;
+  // Entity 0 was refreshed first and is the least recently heard from,
+  // so a new entity takes its place
+  prev_guid = guids[0];
+  guids[0] = BASE_GUID | 1;
+  ok &= add(0, 200);
+  ok &= avb_1722_1_entity_db_find(prev_guid) < 0;
+  ok &= check_all();
+  printf("overflow: %s\n", ok ? "ok" : "failed");
+  pass &= ok;
+
+  start = get_time();
+  for (int k = 0; k < BENCH_LOOPS; k++)
+    for (int i = 0; i < N; i++)
+      avb_1722_1_entity_db_find(guids[i]);
+  ticks = get_time() - start;
+  printf("find: %u cycles per lookup\n", ticks / (BENCH_LOOPS * N));
+
+  printf("%s\n", pass ? "PASS" : "FAIL");
+  return 0;
+}
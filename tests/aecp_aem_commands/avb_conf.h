@@ -0,0 +1,43 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __avb_conf_h__
+#define __avb_conf_h__
+
+/* The entity of AN00202 with twice the channels and streams, so that more
+   descriptors are rendered from templates */
+
+#define AVB_NUM_SOURCES 2
+#define AVB_NUM_TALKER_UNITS 1
+#define AVB_NUM_MEDIA_INPUTS 16
+#define AVB_1722_1_TALKER_ENABLED 1
+
+#define AVB_NUM_SINKS 2
+#define AVB_NUM_LISTENER_UNITS 1
+#define AVB_NUM_MEDIA_OUTPUTS 16
+#define AVB_1722_1_LISTENER_ENABLED 1
+
+#define AVB_MAX_CHANNELS_PER_TALKER_STREAM 8
+#define AVB_MAX_CHANNELS_PER_LISTENER_STREAM 8
+
+#define AVB_1722_FORMAT_61883_6 1
+#define AVB_NUM_MEDIA_UNITS 1
+#define AVB_NUM_MEDIA_CLOCKS 1
+#define AVB_MAX_AUDIO_SAMPLE_RATE 192000
+
+#define AVB_ENABLE_1722_MAAP 1
+
+#define AVB_ENABLE_1722_1 1
+#define AVB_1722_1_ADP_ENTITY_CAPABILITIES (AVB_1722_1_ADP_ENTITY_CAPABILITIES_AEM_SUPPORTED| \
+                                          AVB_1722_1_ADP_ENTITY_CAPABILITIES_CLASS_A_SUPPORTED| \
+                                          AVB_1722_1_ADP_ENTITY_CAPABILITIES_GPTP_SUPPORTED| \
+                                          AVB_1722_1_ADP_ENTITY_CAPABILITIES_AEM_IDENTIFY_CONTROL_INDEX_VALID)
+#define AVB_1722_1_ADP_MODEL_ID 0x1234
+
+enum aem_control_indices {
+    DESCRIPTOR_INDEX_CONTROL_IDENTIFY = 0,
+};
+
+#define AVB_1722_1_FIRMWARE_UPGRADE_ENABLED 1
+#define AVB_1722_1_FAST_CONNECT_ENABLED 0
+#define AVB_1722_1_CONTROLLER_ENABLED 0
+
+#endif
@@ -0,0 +1,92 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <xs1.h>
+#include <string.h>
+#include <quadflashlib.h>
+#include "default_avb_conf.h"
+#include "flash_stubs.h"
+#include "misc_timer.h"
+
+static unsigned busy;
+static unsigned ready_at;
+static unsigned image_ends;
+
+void flash_stubs_busy(unsigned busy_calls)
+{
+  busy = busy_calls;
+}
+
+unsigned flash_stubs_ready_at(void)
+{
+  return ready_at;
+}
+
+unsigned flash_stubs_image_ends(void)
+{
+  return image_ends;
+}
+
+int fl_getFactoryImage(fl_BootImageInfo *image)
+{
+  memset(image, 0, sizeof(*image));
+  image->factory = 1;
+  return 0;
+}
+
+int fl_getNextBootImage(fl_BootImageInfo *image)
+{
+  image->startAddress += FLASH_MAX_UPGRADE_IMAGE_SIZE;
+  image->size = FLASH_MAX_UPGRADE_IMAGE_SIZE;
+  image->factory = 0;
+  return 0;
+}
+
+// Erasing room for the image takes a few calls
+static int start_image(void)
+{
+  if (busy) {
+    busy--;
+    waitfor(get_local_time() + FLASH_BUSY_MS * XS1_TIMER_KHZ);
+    return 1;
+  }
+  ready_at = get_local_time();
+  return 0;
+}
+
+int fl_startImageAdd(fl_BootImageInfo *image, unsigned max_size, unsigned padding)
+{
+  (void) image;
+  (void) max_size;
+  (void) padding;
+  return start_image();
+}
+
+int fl_startImageReplace(fl_BootImageInfo *image, unsigned max_size)
+{
+  (void) image;
+  (void) max_size;
+  return start_image();
+}
+
+int fl_writeImagePage(const unsigned char page[])
+{
+  (void) page;
+  return 0;
+}
+
+int fl_endWriteImage(void)
+{
+  image_ends++;
+  return 0;
+}
+
+int fl_startImageRead(fl_BootImageInfo *image)
+{
+  (void) image;
+  return 0;
+}
+
+int fl_readImagePage(unsigned char page[])
+{
+  memset(page, 0xff, FLASH_PAGE_SIZE);
+  return 0;
+}
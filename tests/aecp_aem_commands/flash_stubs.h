@@ -0,0 +1,22 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef FLASH_STUBS_H_
+#define FLASH_STUBS_H_
+
+/* The flash library calls of the firmware upgrade, for an entity with a
+   factory image and an upgrade image and no flash. Pages written to the
+   upgrade image are dropped, and read back as erased. */
+
+/** How long flash is busy each time it is not ready to start an image */
+#define FLASH_BUSY_MS 130
+
+/** Make the next busy_calls calls to start an image each take
+ *  FLASH_BUSY_MS and report that flash is not ready yet */
+void flash_stubs_busy(unsigned busy_calls);
+
+/** The time flash was last ready to start an image */
+unsigned flash_stubs_ready_at(void);
+
+/** The number of images ended */
+unsigned flash_stubs_image_ends(void);
+
+#endif /* FLASH_STUBS_H_ */
@@ -0,0 +1,33 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef RX_LINK_H_
+#define RX_LINK_H_
+
+#include "ethernet.h"
+
+#define RX_LINK_MAX_FRAMES 16
+#define RX_LINK_FRAME_SIZE 128
+
+/** The controllers on the network the 1722.1 task receives from */
+interface rx_link_if {
+  /** Send a 1722.1 PDU from a controller to the entity. A frame that
+   *  would overflow the link is dropped, and shows up as a missing
+   *  response.
+   *
+   *  \param src_mac  the address of the controller
+   *  \param pdu      the PDU from the 1722.1 header on
+   *  \param n        the length of the PDU
+   */
+  void receive(unsigned char src_mac[6], unsigned char pdu[n], unsigned n);
+
+  /** Stop serving */
+  void stop(void);
+};
+
+/** The Ethernet configuration and receive interfaces the 1722.1 task uses.
+    The entity has the address ENTITY_MAC, and frames sent to i_link are
+    passed to i_rx in order. */
+void rx_link(server interface ethernet_cfg_if i_cfg,
+             server interface ethernet_rx_if i_rx,
+             server interface rx_link_if i_link);
+
+#endif /* RX_LINK_H_ */
@@ -0,0 +1,157 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include <string.h>
+#include "aem_descriptor_index.h"
+#include "aem_descriptor_types.h"
+
+/* Cost of a full AEM enumeration of a large entity.
+
+   A controller reads every descriptor of an entity with 64 channels in
+   each direction and 16 streams each way. Each read is replayed against a
+   linear search of the descriptor list, as READ_DESCRIPTOR used to do,
+   and against the descriptor index, copying the descriptor into a packet
+   buffer in both cases. Times are on the reference clock.
+
+   The index is given exactly enough entries for the list, so one more
+   descriptor must be refused. */
+
+#define NUM_CHANNELS 64
+#define NUM_STREAMS  16
+#define MAX_DESCS    400
+#define BUF_BYTES    48000
+
+typedef struct desc_t {
+  unsigned type;
+  unsigned size;
+  const unsigned char *data;
+} desc_t;
+
+static unsigned char storage[BUF_BYTES];
+static desc_t list[MAX_DESCS];
+static unsigned num_descs;
+static unsigned char packet[512];
+static aem_descriptor_entry_t entries[MAX_DESCS];
+
+static void add(unsigned type, unsigned count, unsigned size)
+{
+  static unsigned char *p = storage;
+
+  for (unsigned i = 0; i < count; i++) {
+    p[0] = type >> 8;
+    p[1] = type & 0xff;
+    p[2] = i >> 8;
+    p[3] = i & 0xff;
+    for (unsigned k = 4; k < size; k++)
+      p[k] = (unsigned char) (type * 31 + i * 7 + k);
+    list[num_descs].type = type;
+    list[num_descs].size = size;
+    list[num_descs].data = p;
+    num_descs++;
+    p += size;
+  }
+}
+
+// The search READ_DESCRIPTOR did before the index
+static const unsigned char *list_find(unsigned type, unsigned index, unsigned *size)
+{
+  for (unsigned i = 0; i < num_descs && list[i].type <= type; i++) {
+    const unsigned char *d = list[i].data;
+    if (list[i].type == type && (((unsigned) d[2] << 8) | d[3]) == index) {
+      *size = list[i].size;
+      return d;
+    }
+  }
+  return NULL;
+}
+
+#ifdef __XS2A__
+static unsigned get_time(void)
+{
+  unsigned t;
+  asm volatile("gettime %0" : "=r"(t));
+  return t;
+}
+#else
+#include <time.h>
+static unsigned get_time(void)
+{
+  return (unsigned) clock();
+}
+#endif
+
+static unsigned enumerate(int use_index, int *ok)
+{
+  unsigned start = get_time();
+
+  for (unsigned i = 0; i < num_descs; i++) {
+    unsigned type = list[i].type;
+    unsigned index = ((unsigned) list[i].data[2] << 8) | list[i].data[3];
+    unsigned size = 0;
+    const unsigned char *d = use_index ? aem_descriptor_index_find(type, index, &size)
+                                       : list_find(type, index, &size);
+    if (d == NULL) {
+      *ok = 0;
+      continue;
+    }
+    memcpy(packet, d, size);
+    if (d != list[i].data || size != list[i].size)
+      *ok = 0;
+  }
+  return get_time() - start;
+}
+
+int main(void)
+{
+  unsigned list_ticks, index_ticks, size;
+  int ok = 1;
+
+  add(AEM_ENTITY_TYPE, 1, 312);
+  add(AEM_CONFIGURATION_TYPE, 1, 100);
+  add(AEM_AUDIO_UNIT_TYPE, 1, 140);
+  add(AEM_STREAM_INPUT_TYPE, NUM_STREAMS, 392);
+  add(AEM_STREAM_OUTPUT_TYPE, NUM_STREAMS, 392);
+  add(AEM_JACK_INPUT_TYPE, 1, 74);
+  add(AEM_JACK_OUTPUT_TYPE, 1, 74);
+  add(AEM_AVB_INTERFACE_TYPE, 1, 98);
+  add(AEM_CLOCK_SOURCE_TYPE, 2, 84);
+  add(AEM_LOCALE_TYPE, 1, 72);
+  add(AEM_STRINGS_TYPE, 1, 452);
+  add(AEM_STREAM_PORT_INPUT_TYPE, NUM_STREAMS, 16);
+  add(AEM_STREAM_PORT_OUTPUT_TYPE, NUM_STREAMS, 16);
+  add(AEM_AUDIO_CLUSTER_TYPE, 2 * NUM_CHANNELS, 83);
+  add(AEM_AUDIO_MAP_TYPE, 2 * NUM_STREAMS, 40);
+  add(AEM_CONTROL_TYPE, 1, 120);
+  add(AEM_CLOCK_DOMAIN_TYPE, 1, 76);
+
+  // Add in reverse to check that the order of addition does not matter
+  aem_descriptor_index_init(entries, num_descs);
+  for (int i = num_descs - 1; i >= 0; i--) {
+    const unsigned char *d = list[i].data;
+    ok &= aem_descriptor_index_add(list[i].type, ((unsigned) d[2] << 8) | d[3],
+                                   d, list[i].size);
+  }
+  // Replacing a descriptor needs no room, a new one must be refused
+  ok &= aem_descriptor_index_add(AEM_ENTITY_TYPE, 0, list[0].data, list[0].size);
+  ok &= !aem_descriptor_index_add(AEM_ENTITY_TYPE, 1, list[0].data, list[0].size);
+  aem_descriptor_index_finish();
+
+  if (aem_descriptor_index_find(AEM_AUDIO_CLUSTER_TYPE, 2 * NUM_CHANNELS, &size) ||
+      aem_descriptor_index_find(AEM_MIXER_TYPE, 0, &size) ||
+      aem_descriptor_index_find(AEM_INVALID_TYPE, 0, &size))
+    ok = 0;
+  printf("%u descriptors indexed: %s\n", num_descs, ok ? "ok" : "failed");
+
+  list_ticks = enumerate(0, &ok);
+  index_ticks = enumerate(1, &ok);
+  printf("enumeration: list search %u cycles, index %u cycles\n",
+         list_ticks, index_ticks);
+
+  // A linear search is O(n) per read, so should be several times slower
+  if (index_ticks * 3 > list_ticks) {
+    printf("index not faster than search\n");
+    ok = 0;
+  }
+
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return 0;
+}
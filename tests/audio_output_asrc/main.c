@@ -0,0 +1,157 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include <math.h>
+#include "audio_output_asrc.h"
+
+/* Quality and cost of the media output sample rate converter.
+
+   A sine is converted in 48kHz packet sized blocks and compared with the
+   ideal signal at the output times. The converter is then timed on the
+   reference clock, which counts one tick per instruction of a thread on a
+   500MHz core with up to five active threads. */
+
+#define BLOCK        6              // Samples per channel in a 48kHz packet
+#define NUM_BLOCKS   200
+#define SETTLE       (2 * AUDIO_OUTPUT_ASRC_TAPS)
+#define AMPLITUDE    (0.5 * 2147483647.0)
+#define BENCH_BLOCKS 100
+
+static int in[BLOCK];
+static int out[AUDIO_OUTPUT_ASRC_MAX_OUTPUT];
+
+static unsigned ratio_fixed(double ratio)
+{
+  return (unsigned) (ratio * (1 << AUDIO_OUTPUT_ASRC_RATIO_BITS) + 0.5);
+}
+
+static int snr(double ratio, double freq)
+{
+  audio_output_asrc_t a;
+  double r = (double) ratio_fixed(ratio) / (1 << AUDIO_OUTPUT_ASRC_RATIO_BITS);
+  double signal = 0, error = 0;
+  long long n_in = 0, n_out = 0;
+
+  audio_output_asrc_init(&a);
+  audio_output_asrc_set_ratio(&a, ratio_fixed(ratio));
+
+  for (int b = 0; b < NUM_BLOCKS; b++) {
+    int n;
+    for (int k = 0; k < BLOCK; k++)
+      in[k] = (int) (AMPLITUDE * sin(2 * M_PI * freq * n_in++));
+    n = audio_output_asrc_process(&a, in, BLOCK, out);
+    for (int j = 0; j < n; j++, n_out++) {
+      double ideal = AMPLITUDE * sin(2 * M_PI * freq * n_out * r);
+      if (n_out < SETTLE)
+        continue;
+      signal += ideal * ideal;
+      error += (out[j] - ideal) * (out[j] - ideal);
+    }
+  }
+  return (int) (10 * log10(signal / error));
+}
+
+/* A ratio of exactly 1 must pass the samples through unchanged */
+static int passthrough(void)
+{
+  audio_output_asrc_t a;
+  unsigned n_in = 0, n_out = 0;
+
+  audio_output_asrc_init(&a);
+  for (int b = 0; b < NUM_BLOCKS; b++) {
+    int n;
+    for (int k = 0; k < BLOCK; k++)
+      in[k] = (int) ((n_in++ * 0x01234567u) & 0x7fffff00);
+    n = audio_output_asrc_process(&a, in, BLOCK, out);
+    for (int j = 0; j < n; j++, n_out++) {
+      if (out[j] != (int) ((n_out * 0x01234567u) & 0x7fffff00))
+        return 0;
+    }
+  }
+  return n_out > 0;
+}
+
+/* The marked input must come out at the first output at or after it */
+static int mark(double ratio)
+{
+  audio_output_asrc_t a;
+  double r = (double) ratio_fixed(ratio) / (1 << AUDIO_OUTPUT_ASRC_RATIO_BITS);
+  int n_out = 0;
+  int marked = -1;
+  int found = 0;
+
+  audio_output_asrc_init(&a);
+  audio_output_asrc_set_ratio(&a, ratio_fixed(ratio));
+  for (int b = 0; b < NUM_BLOCKS; b++) {
+    int n;
+    if (marked < 0) {
+      marked = b * BLOCK + 3;
+      audio_output_asrc_mark(&a, 3);
+    }
+    n = audio_output_asrc_process(&a, in, BLOCK, out);
+    if (a.mark_output >= 0) {
+      double t = (n_out + a.mark_output) * r;
+      double delay = (double) a.mark_delay / 65536;
+      if (t - marked < 0 || t - marked >= r ||
+          fabs(t - marked - delay) > 0.001)
+        return 0;
+      marked = -1;
+      found++;
+    }
+    n_out += n;
+  }
+  return found > NUM_BLOCKS / 8;
+}
+
+static unsigned get_time(void)
+{
+  unsigned t;
+  asm volatile("gettime %0" : "=r"(t));
+  return t;
+}
+
+static void bench(double ratio)
+{
+  audio_output_asrc_t a;
+  unsigned start, ticks;
+  int n_out = 0;
+
+  audio_output_asrc_init(&a);
+  audio_output_asrc_set_ratio(&a, ratio_fixed(ratio));
+  start = get_time();
+  for (int b = 0; b < BENCH_BLOCKS; b++)
+    n_out += audio_output_asrc_process(&a, in, BLOCK, out);
+  ticks = get_time() - start;
+
+  printf("ratio %.4f: %u cycles per sample per channel, %u MIPS for 8 channels at 48kHz\n",
+         ratio, ticks / n_out, (unsigned) ((unsigned long long) ticks * 8 * 48000 / n_out / 1000000));
+}
+
+int main(void)
+{
+  static const double ratios[] = {1.0001, 0.9999, 1.02};
+  static const double freqs[] = {1000.0 / 48000, 10000.0 / 48000, 18000.0 / 48000};
+  int pass = 1;
+
+  pass &= passthrough();
+  printf("passthrough %s\n", pass ? "ok" : "failed");
+
+  for (unsigned i = 0; i < sizeof(ratios) / sizeof(ratios[0]); i++) {
+    int ok = mark(ratios[i]);
+    printf("ratio %.4f: snr", ratios[i]);
+    for (unsigned j = 0; j < sizeof(freqs) / sizeof(freqs[0]); j++) {
+      int db = snr(ratios[i], freqs[j]);
+      printf(" %d", db);
+      // 16 bit quality over most of the band
+      if (db < 75)
+        pass = 0;
+    }
+    printf(" dB, mark %s\n", ok ? "ok" : "failed");
+    pass &= ok;
+  }
+
+  for (unsigned i = 0; i < sizeof(ratios) / sizeof(ratios[0]); i++)
+    bench(ratios[i]);
+
+  printf("%s\n", pass ? "PASS" : "FAIL");
+  return 0;
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include <math.h>
+#include "audio_output_frac_delay.h"
+
+/* Sub-sample alignment of 48kHz media outputs.
+
+   For a few fractional delays a sine is passed through the Lagrange filter
+   and its delay and gain are measured from the output. The delay at 1kHz
+   must be one sample plus the fraction, and the pass band flat.
+
+   Then the FIFO is locked at presentation time errors that are not whole
+   samples. Each error is split as the media clock server does, into whole
+   samples and a BUF_CTL_ADJUST_FILL fraction, and applied as the FIFO does.
+   The FIFO moves its marker timestamps earlier by audio_output_frac_delay_ns,
+   so the error left is the error at lock, less the samples taken out of the
+   FIFO, plus the measured filter delay, less the delay the timestamp was
+   reduced by before the lock. It must be within MAX_RESIDUAL_NS. Whole
+   sample alignment, as without the filter, is printed for comparison and
+   must fail. */
+#define RATE             48000
+#define SAMPLE_PERIOD_NS (1000000000 / RATE)
+#define AMPLITUDE        (0.5 * 2147483647.0)
+#define SETTLE           16
+#define MEASURE          480       // A whole number of periods at each frequency
+#define MAX_DELAY_ERR    0.005     // samples
+#define MAX_RESIDUAL_NS  10
+
+static const double fractions[] = {0, 0.25, 0.5, 0.75};
+static const double freqs[] = {1000, 10000, 18000};
+static const double lock_errors[] = {2.3, -0.6, 5.9, 0.99, -3.45};
+
+/* Measure the delay in samples and the gain in dB of a filter at freq.
+   The filter state is copied so the caller's history is left alone. */
+static void measure(const audio_output_frac_delay_t *filter, double freq,
+                    double *delay, double *gain_db)
+{
+  audio_output_frac_delay_t f = *filter;
+  double w = 2 * M_PI * freq / RATE;
+  double i_sum = 0, q_sum = 0, phase;
+
+  for (int n = 0; n < SETTLE + MEASURE; n++) {
+    int y = audio_output_frac_delay_filter(&f, (int) (AMPLITUDE * sin(w * n)));
+    if (n >= SETTLE) {
+      i_sum += y * sin(w * n);
+      q_sum += y * cos(w * n);
+    }
+  }
+
+  *gain_db = 20 * log10(2 * sqrt(i_sum * i_sum + q_sum * q_sum) / MEASURE / AMPLITUDE);
+  phase = atan2(-q_sum, i_sum);
+  if (phase < 0)
+    phase += 2 * M_PI;
+  *delay = phase / w;
+}
+
+static int check_response(void)
+{
+  int ok = 1;
+
+  for (unsigned i = 0; i < sizeof(fractions) / sizeof(fractions[0]); i++) {
+    audio_output_frac_delay_t f;
+    double delay, gain[3];
+    int pass;
+
+    audio_output_frac_delay_init(&f);
+    audio_output_frac_delay_set(&f, (unsigned) (fractions[i] * (1 << AUDIO_OUTPUT_FRAC_DELAY_BITS)));
+
+    for (unsigned k = 0; k < sizeof(freqs) / sizeof(freqs[0]); k++) {
+      double d;
+      measure(&f, freqs[k], &d, &gain[k]);
+      if (k == 0)
+        delay = d;
+    }
+
+    pass = fabs(delay - (1 + fractions[i])) <= MAX_DELAY_ERR &&
+           fabs(gain[0]) < 0.05 && gain[1] > -1 && gain[2] > -6;
+    printf("fraction %.2f: delay %.3f samples, gain %.2fdB at 1kHz %.2fdB at 10kHz %.2fdB at 18kHz: %s\n",
+           fractions[i], delay, gain[0], gain[1], gain[2], pass ? "ok" : "failed");
+    ok &= pass;
+  }
+  return ok;
+}
+
+static int check_lock(void)
+{
+  audio_output_frac_delay_t f;
+  int ok = 1;
+
+  audio_output_frac_delay_init(&f);
+
+  for (unsigned i = 0; i < sizeof(lock_errors) / sizeof(lock_errors[0]); i++) {
+    int diff = (int) (lock_errors[i] * SAMPLE_PERIOD_NS);
+    int sample_diff = diff / SAMPLE_PERIOD_NS;
+    int fraction = audio_output_frac_delay_fraction(diff, sample_diff, SAMPLE_PERIOD_NS);
+    unsigned old_ns = audio_output_frac_delay_ns(&f, SAMPLE_PERIOD_NS);
+    int adjust = audio_output_frac_delay_adjust(&f, sample_diff, fraction);
+    unsigned new_ns = audio_output_frac_delay_ns(&f, SAMPLE_PERIOD_NS);
+    double delay, gain;
+    double residual, whole_sample_residual;
+    int pass;
+
+    measure(&f, freqs[0], &delay, &gain);
+    residual = diff - (double) adjust * SAMPLE_PERIOD_NS +
+               delay * SAMPLE_PERIOD_NS - old_ns;
+    whole_sample_residual = diff - (double) sample_diff * SAMPLE_PERIOD_NS;
+
+    pass = fabs(residual) <= MAX_RESIDUAL_NS &&
+           fabs(whole_sample_residual) > MAX_RESIDUAL_NS;
+    printf("lock at %dns: %d samples, timestamps %uns earlier, residual %.1fns (%.1fns whole samples only): %s\n",
+           diff, adjust, new_ns, residual, whole_sample_residual,
+           pass ? "ok" : "failed");
+    ok &= pass;
+  }
+  return ok;
+}
+
+int main(void)
+{
+  int ok = check_response();
+  ok &= check_lock();
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return 0;
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include "mailbox_test.h"
+#include "audio_output_fifo.h"
+#include "media_clock_client.h"
+
+/* The FIFO posts REPORTS timing reports through the real mailbox code in
+   audio_output_fifo_maintain(), each as soon as the reply to the previous
+   one has been carried out. Every field of report k is derived from k, so
+   the server can tell a report that was read while it was being written
+   (torn) from a whole one, and a report that was lost, repeated or read
+   out of order.
+
+   The server answers each report with BUF_CTL_ADJUST_FILL, moving the write
+   pointer by -1, 0 or +1 samples. The next report must show the write
+   pointer where that reply left it, so each reply must have been carried
+   out, once, before the next report. The server spends a varying time on
+   each report so the two sides interleave differently each time. */
+#define REPORTS 1000
+#define FIFO_SIZE AUDIO_OUTPUT_FIFO_WORD_SIZE
+// Samples between reports, more than the FIFO's notification period
+#define REPORT_SPACING 1000
+
+static struct audio_output_fifo_data_t fifo_data;
+static struct output_finfo finfo;
+
+static unsigned fifo_seq;
+static unsigned fifo_errors;
+
+static unsigned server_seq;
+static unsigned server_errors;
+static unsigned torn_reports;
+static unsigned expected_wrptr;
+
+#define REPORT_PTP_TS(k)   (0x10000 + (k) * 3)
+#define REPORT_LOCAL_TS(k) (0x20000 + (k) * 5)
+#define REPORT_RDPTR(k)    ((k) % FIFO_SIZE)
+
+static int server_adjust(unsigned k)
+{
+  return (int) (k % 3) - 1;
+}
+
+void mailbox_test_init(void)
+{
+  ofifo_t *s = (ofifo_t *) &fifo_data;
+
+  finfo.p_buffer[0] = (unsigned int *) &fifo_data;
+  audio_output_fifo_init(&finfo, 0);
+  enable_audio_output_fifo(&finfo, 0, 0, 48000);
+  s->state = LOCKED;
+  s->pending_init_notification = 0;
+  s->mailbox.state = OFIFO_MAILBOX_EMPTY;
+  s->mailbox_enabled = 1;
+  expected_wrptr = s->wrptr - START_OF_FIFO(s);
+}
+
+// The listener marks a sample and sees it play out
+static void set_report(ofifo_t *s, unsigned k)
+{
+  s->ptp_ts = REPORT_PTP_TS(k);
+  s->local_ts = REPORT_LOCAL_TS(k);
+  s->underflows = k;
+  s->dptr = START_OF_FIFO(s) + REPORT_RDPTR(k);
+  s->sample_count += REPORT_SPACING;
+}
+
+int mailbox_test_fifo_step(chanend c)
+{
+  ofifo_t *s = (ofifo_t *) &fifo_data;
+  volatile audio_output_fifo_mailbox_t *m = &s->mailbox;
+  int notified = 0;
+
+  // Only an empty mailbox is the FIFO's to post into
+  if (m->state == OFIFO_MAILBOX_EMPTY) {
+    if (fifo_seq == REPORTS)
+      return 1;
+    if (s->ptp_ts != 0) {
+      // The last report was not posted
+      fifo_errors++;
+      return 1;
+    }
+    set_report(s, fifo_seq++);
+  }
+  audio_output_fifo_maintain(&finfo, 0, c, &notified);
+  if (notified)
+    fifo_errors++;
+  return 0;
+}
+
+unsigned mailbox_test_fifo_errors(void)
+{
+  return fifo_errors;
+}
+
+int mailbox_test_server_step(void)
+{
+  audio_output_fifo_info_t info;
+  unsigned k;
+  int adjust;
+
+  if (!audio_output_fifo_get_mailbox_info((int) &fifo_data, &info))
+    return server_seq == REPORTS;
+
+  k = info.underflows;
+  if (info.ptp_ts != REPORT_PTP_TS(k) ||
+      info.local_ts != REPORT_LOCAL_TS(k) ||
+      info.rdptr != REPORT_RDPTR(k) ||
+      !info.locked)
+    torn_reports++;
+  if (k != server_seq || info.wrptr != expected_wrptr)
+    server_errors++;
+
+  // Vary how long the server holds the mailbox
+  for (volatile unsigned i = 0; i < (k * 7) % 13; i++)
+    ;
+
+  adjust = server_adjust(k);
+  expected_wrptr = (info.wrptr + FIFO_SIZE - adjust) % FIFO_SIZE;
+  audio_output_fifo_post_mailbox_cmd((int) &fifo_data, BUF_CTL_ADJUST_FILL, adjust, 0);
+  server_seq++;
+  return server_seq == REPORTS;
+}
+
+void mailbox_test_report(unsigned fifo_errors)
+{
+  int ok = server_seq == REPORTS && server_errors == 0 &&
+           torn_reports == 0 && fifo_errors == 0;
+
+  printf("reports %u: out of order or unanswered %u, torn %u, lost %u: %s\n",
+         server_seq, server_errors, torn_reports, fifo_errors,
+         ok ? "ok" : "failed");
+  printf("%s\n", ok ? "PASS" : "FAIL");
+}
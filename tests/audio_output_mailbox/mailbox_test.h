@@ -0,0 +1,20 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef __mailbox_test_h__
+#define __mailbox_test_h__
+
+#include <xccompat.h>
+
+void mailbox_test_init(void);
+
+/** Run the FIFO side once. Returns non-zero when all reports are answered. */
+int mailbox_test_fifo_step(chanend c);
+
+unsigned mailbox_test_fifo_errors(void);
+
+/** Run the media clock server side once. Returns non-zero when all reports
+ *  have been answered. */
+int mailbox_test_server_step(void);
+
+void mailbox_test_report(unsigned fifo_errors);
+
+#endif
@@ -0,0 +1,944 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include <string.h>
+#include "network.h"
+#include "default_avb_conf.h"
+#include "avb_1722_common.h"
+#include "avb_1722_1_protocol.h"
+#include "avb_1722_1_adp_pdu.h"
+#include "avb_1722_1_acmp_pdu.h"
+#include "avb_1722_1_aecp_pdu.h"
+#include "aem_descriptor_types.h"
+#include "aem_descriptor_index.h"
+#include "avb_1722_1_pdu_check.h"
+#include "avb_1722_1_entity_db.h"
+#include "avb_1722_1_acmp_inflight.h"
+
+#define TICKS_PER_US      100
+#define THINK_TIME        (20 * TICKS_PER_US)     // Controller turnaround
+#define TALKER_TIME       (200 * TICKS_PER_US)    // Talker turnaround
+#define HOLD_TIME         (2000 * TICKS_PER_US)
+#define RETRY_TIME        (500 * TICKS_PER_US)
+#define CONNECT_RETRY     (1000 * TICKS_PER_US)
+#define MALFORMED_GAP     (5 * TICKS_PER_US)
+
+#define NUM_ENTITIES      1000
+#define ENUM_CONTROLLERS  4
+#define CONTENDERS        8
+#define NUM_CONTROLLERS   CONTENDERS
+#define NUM_RANDOM        2000
+#define NUM_VALID         5
+#define MALFORMED_PER_PDU 64
+#define NUM_MALFORMED     (NUM_VALID * 3 * MALFORMED_PER_PDU + NUM_RANDOM)
+#define MAX_PENDING       64
+#define MAX_READS         128
+
+#define LISTENER          1     // The listener's inflight table
+#define ENTITY_GUID       0x002297fffe010203ULL
+#define CONTROLLER_GUID   0x0022970a0b100001ULL
+#define TALKER_GUID       0x002297fffe200000ULL
+#define ADVERTISER_GUID   0x002297fffe300000ULL
+#define STREAM_ID         0x0022972000000000ULL
+
+#define ETH_HEADER        14
+#define PDU_HEADER        12
+#define AECP_COMMON       (PDU_HEADER + 10)
+#define AEM_HEADER        (AECP_COMMON + 2)
+// configuration_index and reserved come before the descriptor
+#define DESCRIPTOR        (AEM_HEADER + 4)
+
+// Frames the other entities send to the entity
+enum frame_kind_t {
+  K_ADP_AVAILABLE,
+  K_ADP_DEPARTING,
+  K_READ,
+  K_ACQUIRE,
+  K_RELEASE,
+  K_CONTROLLER_AVAILABLE,
+  K_CONNECT_RX,
+  K_CONNECT_TX_RESPONSE,
+  K_MALFORMED,
+};
+
+// Command types measured
+enum command_stat_t {
+  S_ADP_AVAILABLE,
+  S_ADP_DEPARTING,
+  S_READ,
+  S_ACQUIRE,
+  S_CONNECT_RX,
+  NUM_STATS
+};
+
+static const char *stat_names[NUM_STATS] = {
+  "ENTITY_AVAILABLE", "ENTITY_DEPARTING", "READ_DESCRIPTOR", "ACQUIRE_ENTITY", "CONNECT_RX"
+};
+
+typedef struct command_stats_t {
+  unsigned count;
+  unsigned first;               // The first arrival
+  unsigned last;                // The last response
+  unsigned long long total;     // Latency
+  unsigned max;
+} command_stats_t;
+
+typedef struct event_t {
+  unsigned send;            // When the frame is sent
+  unsigned char kind;
+  unsigned char source;     // Controller
+  unsigned short arg;
+  unsigned short seq;
+} event_t;
+
+typedef struct descriptor_count_t {
+  unsigned type;
+  unsigned count;
+} descriptor_count_t;
+
+// The list of entity_fixture/src/aem_descriptors.h.in, with the per
+// channel and per stream descriptors rendered from the configuration
+static const descriptor_count_t expected[] = {
+  {AEM_ENTITY_TYPE, 1},
+  {AEM_CONFIGURATION_TYPE, 1},
+  {AEM_AUDIO_UNIT_TYPE, 1},
+  {AEM_STREAM_INPUT_TYPE, AVB_NUM_SINKS},
+  {AEM_STREAM_OUTPUT_TYPE, AVB_NUM_SOURCES},
+  {AEM_JACK_INPUT_TYPE, 1},
+  {AEM_JACK_OUTPUT_TYPE, 1},
+  {AEM_AVB_INTERFACE_TYPE, 1},
+  {AEM_CLOCK_SOURCE_TYPE, 2},
+  {AEM_MEMORY_OBJECT_TYPE, 1},
+  {AEM_LOCALE_TYPE, 1},
+  {AEM_STRINGS_TYPE, 1},
+  {AEM_STREAM_PORT_INPUT_TYPE, AVB_NUM_SINKS},
+  {AEM_STREAM_PORT_OUTPUT_TYPE, AVB_NUM_SOURCES},
+  {AEM_EXTERNAL_PORT_INPUT_TYPE, 1},
+  {AEM_EXTERNAL_PORT_OUTPUT_TYPE, 1},
+  {AEM_AUDIO_CLUSTER_TYPE, AVB_NUM_MEDIA_OUTPUTS + AVB_NUM_MEDIA_INPUTS},
+  {AEM_AUDIO_MAP_TYPE, AVB_NUM_SINKS + AVB_NUM_SOURCES},
+  {AEM_CONTROL_TYPE, 1},
+  {AEM_CLOCK_DOMAIN_TYPE, 1},
+};
+
+static const unsigned char entity_mac[6] = ENTITY_MAC;
+
+static int scenario;
+
+// The link to the entity
+static event_t pending[MAX_PENDING];
+static unsigned num_pending;
+static unsigned rx_link_free;
+static unsigned char head_pdu[NETWORK_MAX_PDU];
+static unsigned char head_src[6];
+static unsigned head_len;
+static int head_built;
+static event_t received;
+static unsigned received_at;
+static unsigned awaiting;
+static command_stats_t stats[NUM_STATS];
+
+// The controllers
+static unsigned short cmd_seq[NUM_CONTROLLERS];
+static unsigned cmd_arrival[NUM_CONTROLLERS];
+static int cmd_outstanding[NUM_CONTROLLERS];
+static unsigned wrong;
+static unsigned short read_type[MAX_READS];
+static unsigned short read_index[MAX_READS];
+static unsigned char read_exists[MAX_READS];
+static unsigned num_reads, num_found;
+static unsigned next_read[ENUM_CONTROLLERS];
+static int holds[CONTENDERS];
+static unsigned holders, max_holders, grants, refusals, in_progress;
+
+// The connections and the talker
+static unsigned short connect_seq[AVB_NUM_SINKS];
+static unsigned connect_arrival[AVB_NUM_SINKS];
+static int connect_outstanding[AVB_NUM_SINKS];
+static int connected[AVB_NUM_SINKS];
+static unsigned connect_refused;
+static unsigned talker_in_flight, max_talker_in_flight;
+
+static int adp_ok;
+static unsigned truncated, truncated_taken;
+static unsigned random_state;
+static unsigned other_frames;
+static int entity_answered;
+
+static unsigned later(unsigned a, unsigned b)
+{
+  return (int)(a - b) > 0 ? a : b;
+}
+
+static unsigned wire(unsigned len)
+{
+  // Padding, FCS, preamble and inter-frame gap at one tick a bit
+  if (len < 60)
+    len = 60;
+  return (len + 24) * 8;
+}
+
+static void put16(unsigned char *p, unsigned v)
+{
+  p[0] = v >> 8;
+  p[1] = v;
+}
+
+static void put64(unsigned char *p, unsigned long long v)
+{
+  for (int i = 0; i < 8; i++)
+    p[i] = v >> (56 - 8 * i);
+}
+
+static unsigned get16(const unsigned char *p)
+{
+  return (p[0] << 8) | p[1];
+}
+
+static unsigned long long get64(const unsigned char *p)
+{
+  unsigned long long v = 0;
+  for (int i = 0; i < 8; i++)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+// The controller GUID is formed from its MAC address
+static void controller_mac(unsigned c, unsigned char mac[6])
+{
+  static const unsigned char base[6] = {0x00, 0x22, 0x97, 0x0a, 0x0b, 0x10};
+
+  memcpy(mac, base, 6);
+  mac[5] += c;
+}
+
+static unsigned long long controller_guid(unsigned c)
+{
+  return CONTROLLER_GUID + ((unsigned long long) c << 16);
+}
+
+static int find_controller(unsigned long long guid)
+{
+  for (unsigned c = 0; c < NUM_CONTROLLERS; c++)
+    if (controller_guid(c) == guid)
+      return c;
+  return -1;
+}
+
+static void put_header(unsigned char *p, unsigned subtype, unsigned msg_type,
+                       unsigned status, unsigned datalen)
+{
+  p[0] = 0x80 | subtype;
+  p[1] = msg_type;
+  p[2] = (status << 3) | ((datalen >> 8) & 7);
+  p[3] = datalen;
+}
+
+static void record(int stat, unsigned arrival, unsigned done)
+{
+  command_stats_t *s = &stats[stat];
+
+  if (s->count == 0)
+    s->first = arrival;
+  s->count++;
+  s->last = done;
+  s->total += done - arrival;
+  if (done - arrival > s->max)
+    s->max = done - arrival;
+}
+
+static void print_stats(void)
+{
+  for (int i = 0; i < NUM_STATS; i++) {
+    command_stats_t *s = &stats[i];
+    if (s->count < 2)
+      continue;
+    printf("  %s: %u, %u per second, latency mean %u us, max %u us\n",
+           stat_names[i], s->count,
+           (unsigned) (s->count * 100000000ULL / (s->last - s->first)),
+           (unsigned) (s->total / s->count / TICKS_PER_US),
+           s->max / TICKS_PER_US);
+  }
+}
+
+static void schedule(unsigned send, int kind, int source, unsigned arg, unsigned seq)
+{
+  unsigned i = num_pending;
+
+  // A frame that does not fit is never sent, and shows up as a missing
+  // response
+  if (num_pending == MAX_PENDING)
+    return;
+  // Kept in order of sending
+  while (i > 0 && (int)(pending[i - 1].send - send) > 0) {
+    pending[i] = pending[i - 1];
+    i--;
+  }
+  pending[i].send = send;
+  pending[i].kind = kind;
+  pending[i].source = source;
+  pending[i].arg = arg;
+  pending[i].seq = seq;
+  num_pending++;
+  if (i == 0)
+    head_built = 0;
+}
+
+static void send_command(unsigned c, int kind, unsigned arg, unsigned send)
+{
+  cmd_seq[c]++;
+  cmd_outstanding[c] = 1;
+  awaiting++;
+  schedule(send, kind, c, arg, cmd_seq[c]);
+}
+
+static void connect(unsigned sink, unsigned send)
+{
+  connect_seq[sink] = ++cmd_seq[0];
+  connect_outstanding[sink] = 1;
+  awaiting++;
+  schedule(send, K_CONNECT_RX, 0, sink, connect_seq[sink]);
+}
+
+/* Frames sent to the entity, from the 1722.1 header on */
+
+static unsigned build_adp(unsigned char *p, unsigned message_type, unsigned n, unsigned available)
+{
+  memset(p, 0, PDU_HEADER + AVB_1722_1_ADP_CD_LENGTH);
+  put_header(p, DEFAULT_1722_1_ADP_SUBTYPE, message_type, 31, AVB_1722_1_ADP_CD_LENGTH);
+  put64(p + 4, ADVERTISER_GUID + n);
+  p[PDU_HEADER + 43] = available;   // available_index
+  return PDU_HEADER + AVB_1722_1_ADP_CD_LENGTH;
+}
+
+static unsigned build_aem(unsigned char *p, unsigned command_type, unsigned c,
+                          unsigned seq, unsigned payload_len)
+{
+  memset(p, 0, AEM_HEADER + payload_len);
+  put_header(p, DEFAULT_1722_1_AECP_SUBTYPE, AECP_CMD_AEM_COMMAND, 0, AEM_HEADER - PDU_HEADER + payload_len);
+  put64(p + 4, ENTITY_GUID);
+  put64(p + 12, controller_guid(c));
+  put16(p + 20, seq);
+  put16(p + 22, command_type);
+  return AEM_HEADER + payload_len;
+}
+
+static unsigned build_read(unsigned char *p, unsigned c, unsigned seq,
+                           unsigned type, unsigned index)
+{
+  unsigned len = build_aem(p, AECP_AEM_CMD_READ_DESCRIPTOR, c, seq, 8);
+
+  put16(p + AEM_HEADER + 4, type);
+  put16(p + AEM_HEADER + 6, index);
+  return len;
+}
+
+static unsigned build_acquire(unsigned char *p, unsigned c, unsigned seq, int release)
+{
+  unsigned len = build_aem(p, AECP_AEM_CMD_ACQUIRE_ENTITY, c, seq,
+                           sizeof(avb_1722_1_aem_acquire_entity_command_t));
+
+  if (release)
+    p[AEM_HEADER] = 0x80;
+  return len;
+}
+
+static unsigned build_acmp(unsigned char *p, unsigned message_type, unsigned sink, unsigned seq)
+{
+  memset(p, 0, PDU_HEADER + AVB_1722_1_ACMP_CD_LENGTH);
+  put_header(p, DEFAULT_1722_1_ACMP_SUBTYPE, message_type, ACMP_STATUS_SUCCESS, AVB_1722_1_ACMP_CD_LENGTH);
+  put64(p + 12, controller_guid(0));
+  put64(p + 20, TALKER_GUID);
+  put64(p + 28, ENTITY_GUID);
+  put16(p + 36, sink);
+  put16(p + 38, sink);
+  put16(p + 48, seq);
+  if (message_type == ACMP_CMD_CONNECT_TX_RESPONSE) {
+    static const unsigned char dest_mac[6] = {0x91, 0xe0, 0xf0, 0x00, 0xfe, 0x00};
+
+    put64(p + 4, STREAM_ID + sink);
+    memcpy(p + 40, dest_mac, 6);
+    p[45] += sink;
+    put16(p + 46, 1);   // connection_count
+    put16(p + 52, 2);   // vlan_id
+  }
+  return PDU_HEADER + AVB_1722_1_ACMP_CD_LENGTH;
+}
+
+static unsigned build_malformed(unsigned char *p, unsigned n);
+
+static unsigned build_frame(unsigned char *p, unsigned char src_addr[6], const event_t *e)
+{
+  static const unsigned char talker_mac[6] = {0x00, 0x22, 0x97, 0x20, 0x00, 0x00};
+  static const unsigned char advertiser_mac[6] = {0x00, 0x22, 0x97, 0x30, 0x00, 0x00};
+
+  controller_mac(e->source, src_addr);
+  switch (e->kind) {
+    case K_ADP_AVAILABLE:
+    case K_ADP_DEPARTING:
+      memcpy(src_addr, advertiser_mac, 6);
+      put16(src_addr + 4, e->arg);
+      return build_adp(p, e->kind == K_ADP_AVAILABLE ? ENTITY_AVAILABLE : ENTITY_DEPARTING,
+                       e->arg, e->seq);
+    case K_READ:
+      return build_read(p, e->source, e->seq, read_type[e->arg], read_index[e->arg]);
+    case K_ACQUIRE:
+    case K_RELEASE:
+      return build_acquire(p, e->source, e->seq, e->kind == K_RELEASE);
+    case K_CONTROLLER_AVAILABLE:
+      // The owner answers the entity's command
+      memset(p, 0, AEM_HEADER);
+      put_header(p, DEFAULT_1722_1_AECP_SUBTYPE, AECP_CMD_AEM_RESPONSE, AECP_AEM_STATUS_SUCCESS,
+                 AEM_HEADER - PDU_HEADER);
+      put64(p + 4, controller_guid(e->source));
+      put64(p + 12, ENTITY_GUID);
+      put16(p + 20, e->seq);
+      put16(p + 22, AECP_AEM_CMD_CONTROLLER_AVAILABLE);
+      return AEM_HEADER;
+    case K_CONNECT_RX:
+      return build_acmp(p, ACMP_CMD_CONNECT_RX_COMMAND, e->arg, e->seq);
+    case K_CONNECT_TX_RESPONSE:
+      memcpy(src_addr, talker_mac, 6);
+      return build_acmp(p, ACMP_CMD_CONNECT_TX_RESPONSE, e->arg, e->seq);
+    default:
+      return build_malformed(p, e->arg);
+  }
+}
+
+/* The link */
+
+int network_busy(void)
+{
+  return num_pending || awaiting;
+}
+
+// What follows a frame that reaches the entity
+static void arrived(const event_t *e, unsigned arrival)
+{
+  unsigned n = e->arg;
+
+  switch (e->kind) {
+    case K_ADP_AVAILABLE:
+      // Every entity advertises at once
+      if (n + 1 < NUM_ENTITIES)
+        schedule(e->send, e->kind, 0, n + 1, e->seq);
+      break;
+    case K_ADP_DEPARTING:
+      if (n + 2 < NUM_ENTITIES)
+        schedule(e->send, e->kind, 0, n + 2, e->seq);
+      break;
+    case K_RELEASE:
+      // The entity is free from the moment it takes the release
+      holds[e->source] = 2;
+      holders--;
+      cmd_arrival[e->source] = arrival;
+      break;
+    case K_READ:
+    case K_ACQUIRE:
+      cmd_arrival[e->source] = arrival;
+      break;
+    case K_CONNECT_RX:
+      connect_arrival[n] = arrival;
+      break;
+    case K_CONNECT_TX_RESPONSE:
+      talker_in_flight--;
+      break;
+    case K_MALFORMED:
+      // Then a controller checks the entity still answers
+      if (n + 1 < NUM_MALFORMED)
+        schedule(e->send + MALFORMED_GAP, e->kind, 0, n + 1, 0);
+      else
+        send_command(0, K_READ, 0, e->send + MALFORMED_GAP);
+      break;
+  }
+}
+
+unsigned network_receive(unsigned char pdu[NETWORK_MAX_PDU],
+                         unsigned char src_addr[6], unsigned now)
+{
+  unsigned rx_len, arrival;
+
+  if (num_pending == 0)
+    return 0;
+  if (!head_built) {
+    head_len = build_frame(head_pdu, head_src, &pending[0]);
+    head_built = 1;
+  }
+
+  // Frames are padded to the minimum Ethernet frame size
+  rx_len = head_len < 60 - ETH_HEADER ? 60 - ETH_HEADER : head_len;
+  arrival = later(pending[0].send, rx_link_free) + wire(ETH_HEADER + rx_len);
+  if ((int)(arrival - now) > 0)
+    return 0;
+
+  memcpy(pdu, head_pdu, head_len);
+  memset(pdu + head_len, 0, rx_len - head_len);
+  memcpy(src_addr, head_src, 6);
+  received = pending[0];
+  received_at = arrival;
+  rx_link_free = arrival;
+  num_pending--;
+  memmove(&pending[0], &pending[1], num_pending * sizeof(event_t));
+  head_built = 0;
+  arrived(&received, arrival);
+  return rx_len;
+}
+
+void network_processed(unsigned now)
+{
+  switch (received.kind) {
+    case K_ADP_AVAILABLE:
+      record(S_ADP_AVAILABLE, received_at, now);
+      break;
+    case K_ADP_DEPARTING:
+      record(S_ADP_DEPARTING, received_at, now);
+      break;
+    case K_MALFORMED:
+      break;
+    default:
+      other_frames++;
+      break;
+  }
+}
+
+/* The other entities */
+
+static int read_response_ok(const unsigned char *pdu, unsigned len, unsigned n)
+{
+  unsigned status = pdu[2] >> 3;
+  unsigned datalen = ((pdu[2] & 7) << 8) | pdu[3];
+
+  if (len < DESCRIPTOR + 4)
+    return 0;
+  if (!read_exists[n])
+    return status == AECP_AEM_STATUS_NO_SUCH_DESCRIPTOR &&
+           get16(pdu + AEM_HEADER + 4) == read_type[n] &&
+           get16(pdu + AEM_HEADER + 6) == read_index[n];
+
+  // The descriptor must fill the response, and be the one asked for
+  if (status != AECP_AEM_STATUS_SUCCESS ||
+      PDU_HEADER + datalen > len ||
+      datalen < DESCRIPTOR - PDU_HEADER + 4 ||
+      get16(pdu + DESCRIPTOR) != read_type[n] ||
+      get16(pdu + DESCRIPTOR + 2) != read_index[n])
+    return 0;
+
+  // The entity GUID is filled in at startup
+  if (read_type[n] == AEM_ENTITY_TYPE &&
+      (len < DESCRIPTOR + 12 || get64(pdu + DESCRIPTOR + 4) != ENTITY_GUID))
+    return 0;
+  return 1;
+}
+
+static void read_response(unsigned c, const unsigned char *pdu, unsigned len, unsigned done)
+{
+  unsigned n = scenario == ENUMERATION ? next_read[c] : 0;
+  int ok = read_response_ok(pdu, len, n);
+
+  record(S_READ, cmd_arrival[c], done);
+  cmd_outstanding[c] = 0;
+  awaiting--;
+  if (!ok)
+    wrong++;
+
+  if (scenario == ENUMERATION) {
+    next_read[c] = ++n;
+    if (n < num_reads)
+      send_command(c, K_READ, n, done + THINK_TIME);
+  }
+  else {
+    entity_answered = ok;
+  }
+}
+
+static void acquire_response(unsigned c, const unsigned char *pdu, unsigned done)
+{
+  unsigned status = pdu[2] >> 3;
+  int owner;
+
+  if (status == AECP_AEM_STATUS_IN_PROGRESS) {
+    // The entity is asking the owner, and answers again when it knows
+    if (holds[c] == 0)
+      in_progress++;
+    else
+      wrong++;
+    return;
+  }
+
+  cmd_outstanding[c] = 0;
+  awaiting--;
+  if (holds[c] == 2) {
+    // Released
+    if (status == AECP_AEM_STATUS_SUCCESS)
+      holds[c] = -1;
+    else {
+      wrong++;
+    }
+    return;
+  }
+
+  record(S_ACQUIRE, cmd_arrival[c], done);
+  owner = find_controller(get64(pdu + AEM_HEADER + 4));
+  if (status == AECP_AEM_STATUS_SUCCESS && owner == (int) c) {
+    holds[c] = 1;
+    grants++;
+    if (++holders > max_holders)
+      max_holders = holders;
+    send_command(c, K_RELEASE, 0, done + HOLD_TIME);
+  }
+  else if (status == AECP_AEM_STATUS_ENTITY_ACQUIRED && owner >= 0 && holds[owner] > 0) {
+    refusals++;
+    send_command(c, K_ACQUIRE, 0, done + RETRY_TIME + c * 37 * TICKS_PER_US);
+  }
+  else {
+    wrong++;
+  }
+}
+
+static void controller_aecp(const unsigned char *frame, unsigned len, unsigned sent_at)
+{
+  const unsigned char *pdu = frame + ETH_HEADER;
+  unsigned message_type = pdu[1] & 0xf;
+  unsigned command_type = get16(pdu + 22) & 0x7fff;
+  unsigned char mac[6];
+  int c;
+
+  if (message_type == AECP_CMD_AEM_COMMAND && command_type == AECP_AEM_CMD_CONTROLLER_AVAILABLE) {
+    // The entity asks the controller that holds it whether it is still there
+    c = find_controller(get64(pdu + 4));
+    if (c < 0 || scenario != CONTENTION || get64(pdu + 12) != ENTITY_GUID)
+      return;
+    controller_mac(c, mac);
+    if (memcmp(frame, mac, 6) != 0 || holds[c] <= 0)
+      wrong++;
+    else
+      schedule(sent_at + THINK_TIME, K_CONTROLLER_AVAILABLE, c, 0, get16(pdu + 20));
+    return;
+  }
+
+  if (message_type != AECP_CMD_AEM_RESPONSE || get64(pdu + 4) != ENTITY_GUID)
+    return;
+  c = find_controller(get64(pdu + 12));
+  if (c < 0 || !cmd_outstanding[c] || get16(pdu + 20) != cmd_seq[c])
+    return;
+  controller_mac(c, mac);
+  if (memcmp(frame, mac, 6) != 0) {
+    // Sent to the wrong address, so the controller never sees it
+    wrong++;
+    return;
+  }
+
+  if (command_type == AECP_AEM_CMD_READ_DESCRIPTOR)
+    read_response(c, pdu, len - ETH_HEADER, sent_at);
+  else if (command_type == AECP_AEM_CMD_ACQUIRE_ENTITY && len >= ETH_HEADER + AEM_HEADER + 12)
+    acquire_response(c, pdu, sent_at);
+}
+
+static void acmp_deliver(const unsigned char *pdu, unsigned sent_at)
+{
+  unsigned message_type = pdu[1] & 0xf;
+  unsigned status = pdu[2] >> 3;
+  unsigned sink = get16(pdu + 38);
+
+  // The talker answers every CONNECT_TX_COMMAND
+  if (message_type == ACMP_CMD_CONNECT_TX_COMMAND && get64(pdu + 20) == TALKER_GUID) {
+    if (++talker_in_flight > max_talker_in_flight)
+      max_talker_in_flight = talker_in_flight;
+    schedule(sent_at + TALKER_TIME, K_CONNECT_TX_RESPONSE, 0, sink, get16(pdu + 48));
+    return;
+  }
+
+  if (message_type != ACMP_CMD_CONNECT_RX_RESPONSE || get64(pdu + 12) != controller_guid(0) ||
+      sink >= AVB_NUM_SINKS || !connect_outstanding[sink] || get16(pdu + 48) != connect_seq[sink])
+    return;
+  record(S_CONNECT_RX, connect_arrival[sink], sent_at);
+  connect_outstanding[sink] = 0;
+  awaiting--;
+  if (status == ACMP_STATUS_SUCCESS) {
+    connected[sink] = 1;
+  }
+  else if (status == ACMP_STATUS_COULD_NOT_SEND_MESSAGE) {
+    // The listener has no room to track another command; try again
+    connect_refused++;
+    connect(sink, sent_at + CONNECT_RETRY);
+  }
+  else {
+    wrong++;
+  }
+}
+
+void network_deliver(const unsigned char frame[], unsigned len, unsigned sent_at)
+{
+  const unsigned char *pdu = frame + ETH_HEADER;
+
+  if (len < ETH_HEADER + PDU_HEADER ||
+      memcmp(frame + 6, entity_mac, 6) != 0 ||
+      get16(frame + 12) != AVB_1722_ETHERTYPE)
+    return;
+
+  switch (pdu[0] & 0x7f) {
+    case DEFAULT_1722_1_AECP_SUBTYPE:
+      if (len >= ETH_HEADER + AEM_HEADER)
+        controller_aecp(frame, len, sent_at);
+      break;
+    case DEFAULT_1722_1_ACMP_SUBTYPE:
+      if (len >= ETH_HEADER + PDU_HEADER + AVB_1722_1_ACMP_CD_LENGTH)
+        acmp_deliver(pdu, sent_at);
+      break;
+  }
+}
+
+/* Malformed PDUs */
+
+enum malformed_t {
+  M_TRUNCATED,
+  M_FLIPPED,
+  M_LENGTH,
+};
+
+static unsigned lcg(void)
+{
+  random_state = random_state * 1103515245 + 12345;
+  return random_state >> 16;
+}
+
+static unsigned build_valid(unsigned char *p, unsigned n)
+{
+  switch (n) {
+    case 0:
+      return build_adp(p, ENTITY_AVAILABLE, 1, 1);
+    case 1:
+      return build_read(p, 0, 1, AEM_ENTITY_TYPE, 0);
+    case 2:
+      return build_acquire(p, 0, 1, 0);
+    case 3:
+      return build_acmp(p, ACMP_CMD_CONNECT_RX_COMMAND, 1, 1);
+    default:
+      // An address access write with its data
+      memset(p, 0, AECP_COMMON + 12 + 16);
+      put_header(p, DEFAULT_1722_1_AECP_SUBTYPE, AECP_CMD_ADDRESS_ACCESS_COMMAND, 0, 10 + 12 + 16);
+      put64(p + 4, ENTITY_GUID);
+      put16(p + AECP_COMMON, 1);
+      put16(p + AECP_COMMON + 2, 0x1000 | 16);
+      return AECP_COMMON + 12 + 16;
+  }
+}
+
+static unsigned build_malformed(unsigned char *p, unsigned n)
+{
+  unsigned len;
+
+  if (n < NUM_VALID * 3 * MALFORMED_PER_PDU) {
+    unsigned valid = n / (3 * MALFORMED_PER_PDU);
+    unsigned variant = n % (3 * MALFORMED_PER_PDU);
+    unsigned which = variant % MALFORMED_PER_PDU;
+
+    len = build_valid(p, valid);
+    switch (variant / MALFORMED_PER_PDU) {
+      case M_TRUNCATED:
+        return which * len / MALFORMED_PER_PDU;
+      case M_FLIPPED:
+        p[which / 8] ^= 1 << (which % 8);
+        return len;
+      default: {
+        // The length field says more or less than is there
+        unsigned datalen = len - PDU_HEADER + (which % 2 ? which : -1 - which / 8);
+        p[2] = (p[2] & 0xf8) | ((datalen >> 8) & 7);
+        p[3] = datalen;
+        return len;
+      }
+    }
+  }
+
+  // Random bytes, mostly with a 1722.1 subtype. Each frame has its own
+  // seed, so it is the same however often it is built.
+  random_state = n;
+  len = lcg() % 96;
+  for (unsigned i = 0; i < len; i++)
+    p[i] = lcg();
+  if (len && lcg() % 4)
+    p[0] = 0x80 | (DEFAULT_1722_1_ADP_SUBTYPE + lcg() % 3);
+  if (len > 1 && lcg() % 2)
+    p[1] &= 0x0f;
+  return len;
+}
+
+static void check_truncated(void)
+{
+  unsigned char p[NETWORK_MAX_PDU];
+
+  // A truncated PDU must never get through
+  truncated = truncated_taken = 0;
+  for (unsigned n = 0; n < NUM_VALID * MALFORMED_PER_PDU; n++) {
+    unsigned valid = n / MALFORMED_PER_PDU;
+    unsigned len = build_valid(p, valid) * (n % MALFORMED_PER_PDU) / MALFORMED_PER_PDU;
+    truncated_taken += avb_1722_1_pdu_check(p, len) > 0;
+    truncated++;
+  }
+}
+
+/* Scenarios */
+
+static void list_reads(void)
+{
+  unsigned i;
+
+  // Every descriptor, the one after the last of each type and one of a
+  // type that cannot be indexed
+  num_reads = num_found = 0;
+  for (i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+    for (unsigned index = 0; index <= expected[i].count && num_reads < MAX_READS - 1; index++) {
+      read_type[num_reads] = expected[i].type;
+      read_index[num_reads] = index;
+      read_exists[num_reads] = index < expected[i].count;
+      num_found += read_exists[num_reads];
+      num_reads++;
+    }
+  }
+  read_type[num_reads] = AEM_DESCRIPTOR_INDEX_NUM_TYPES;
+  read_index[num_reads] = 0;
+  read_exists[num_reads] = 0;
+  num_reads++;
+}
+
+void scenario_start(int s, unsigned now)
+{
+  scenario = s;
+  num_pending = 0;
+  head_built = 0;
+  rx_link_free = now;
+  awaiting = 0;
+  wrong = 0;
+  other_frames = 0;
+  memset(stats, 0, sizeof(stats));
+  memset(cmd_outstanding, 0, sizeof(cmd_outstanding));
+  memset(connect_outstanding, 0, sizeof(connect_outstanding));
+  avb_1722_1_pdu_check_init();
+  if (num_reads == 0)
+    list_reads();
+
+  switch (s) {
+    case ADP_ADVERTISE:
+      adp_ok = 1;
+      avb_1722_1_entity_db_flush();
+      schedule(now, K_ADP_AVAILABLE, 0, 0, 1);
+      break;
+    case ADP_ADVERTISE_AGAIN:
+      schedule(now, K_ADP_AVAILABLE, 0, 0, 2);
+      break;
+    case ADP_DEPART:
+      schedule(now, K_ADP_DEPARTING, 0, 0, 3);
+      break;
+    case ENUMERATION:
+      for (unsigned c = 0; c < ENUM_CONTROLLERS; c++) {
+        next_read[c] = 0;
+        send_command(c, K_READ, 0, now);
+      }
+      break;
+    case CONTENTION:
+      holders = max_holders = grants = refusals = in_progress = 0;
+      for (unsigned c = 0; c < CONTENDERS; c++) {
+        holds[c] = 0;
+        send_command(c, K_ACQUIRE, 0, now);
+      }
+      break;
+    case CONNECTION_STORM:
+      connect_refused = 0;
+      talker_in_flight = max_talker_in_flight = 0;
+      for (unsigned sink = 0; sink < AVB_NUM_SINKS; sink++) {
+        connected[sink] = 0;
+        connect(sink, now);
+      }
+      break;
+    case TRUNCATED:
+      check_truncated();
+      break;
+    case MALFORMED:
+      entity_answered = 0;
+      schedule(now, K_MALFORMED, 0, 0, 0);
+      break;
+  }
+}
+
+int scenario_report(int s)
+{
+  static const char *rounds[] = {"advertise", "advertise again", "half depart"};
+  avb_1722_1_pdu_stats_t pdu_stats;
+  int ok = 0;
+
+  switch (s) {
+    case ADP_ADVERTISE:
+    case ADP_ADVERTISE_AGAIN:
+    case ADP_DEPART: {
+      int known = avb_1722_1_entity_db_count();
+
+      ok = known == (s == ADP_DEPART ? NUM_ENTITIES / 2 : NUM_ENTITIES);
+      printf("ADP flood from %d entities, %s, %d known\n", NUM_ENTITIES, rounds[s - ADP_ADVERTISE], known);
+      print_stats();
+      if (s == ADP_DEPART) {
+        for (unsigned n = 0; n < NUM_ENTITIES; n++)
+          ok &= (avb_1722_1_entity_db_find(ADVERTISER_GUID + n) >= 0) == (int)(n % 2);
+      }
+      adp_ok &= ok;
+      if (s == ADP_DEPART)
+        printf("ADP flood: %s\n", adp_ok ? "ok" : "failed");
+      break;
+    }
+    case ENUMERATION:
+      ok = !awaiting && wrong == 0;
+      for (unsigned c = 0; c < ENUM_CONTROLLERS; c++)
+        ok &= next_read[c] == num_reads;
+      printf("enumeration of %u descriptors and %u that do not exist by %d controllers, %u wrong: %s\n",
+             num_found, num_reads - num_found, ENUM_CONTROLLERS, wrong, ok ? "ok" : "failed");
+      print_stats();
+      break;
+    case CONTENTION:
+      ok = !awaiting && wrong == 0 && grants == CONTENDERS && max_holders == 1 && in_progress > 0;
+      printf("acquire by %d controllers, %u grants, %u refusals, %u IN_PROGRESS, %u held at once, %u wrong: %s\n",
+             CONTENDERS, grants, refusals, in_progress, max_holders, wrong, ok ? "ok" : "failed");
+      print_stats();
+      break;
+    case CONNECTION_STORM: {
+      unsigned num_connected = 0;
+
+      for (unsigned sink = 0; sink < AVB_NUM_SINKS; sink++)
+        num_connected += connected[sink];
+      ok = !awaiting && wrong == 0 && num_connected == AVB_NUM_SINKS && connect_refused > 0 &&
+           max_talker_in_flight <= AVB_1722_1_MAX_INFLIGHT_COMMANDS;
+      printf("connection storm of %d streams, %u refused while %u were in flight, %u connected, %u wrong: %s\n",
+             AVB_NUM_SINKS, connect_refused, max_talker_in_flight, num_connected, wrong, ok ? "ok" : "failed");
+      print_stats();
+      break;
+    }
+    case TRUNCATED:
+      avb_1722_1_pdu_check_get_stats(&pdu_stats);
+      ok = truncated_taken == 0;
+      printf("%u truncated PDUs: %u too short, %u truncated, %u taken: %s\n", truncated,
+             pdu_stats.rejected[AVB_1722_1_PDU_TOO_SHORT],
+             pdu_stats.rejected[AVB_1722_1_PDU_TRUNCATED],
+             truncated_taken, ok ? "ok" : "failed");
+      break;
+    case MALFORMED: {
+      unsigned taken, rejected = 0;
+
+      // The talker's answers and the last READ_DESCRIPTOR are not counted
+      avb_1722_1_pdu_check_get_stats(&pdu_stats);
+      taken = pdu_stats.accepted - other_frames;
+      for (int i = AVB_1722_1_PDU_TOO_SHORT; i < AVB_1722_1_PDU_REJECT_REASONS; i++)
+        rejected += pdu_stats.rejected[i];
+      printf("%d malformed frames padded to the minimum size: %u not 1722.1, %u too short, "
+             "%u bad header, %u bad length, %u truncated, %u taken\n",
+             NUM_MALFORMED, NUM_MALFORMED - rejected - taken,
+             pdu_stats.rejected[AVB_1722_1_PDU_TOO_SHORT],
+             pdu_stats.rejected[AVB_1722_1_PDU_BAD_HEADER],
+             pdu_stats.rejected[AVB_1722_1_PDU_BAD_LENGTH],
+             pdu_stats.rejected[AVB_1722_1_PDU_TRUNCATED],
+             taken);
+      ok = !awaiting && entity_answered && acmp_inflight_count(LISTENER) == 0;
+      printf("READ_DESCRIPTOR after them %s, %d listener commands in flight: %s\n",
+             entity_answered ? "answered" : "not answered", acmp_inflight_count(LISTENER),
+             ok ? "ok" : "failed");
+      break;
+    }
+  }
+  return ok;
+}
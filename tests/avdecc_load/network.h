@@ -0,0 +1,63 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef NETWORK_H_
+#define NETWORK_H_
+
+#include <xccompat.h>
+
+#define ENTITY_MAC      {0x00, 0x22, 0x97, 0x01, 0x02, 0x03}
+
+/** Enough for any PDU sent to the entity */
+#define NETWORK_MAX_PDU 128
+
+/* The controllers, talker and other entities on a 100Mb/s link to the
+   entity. Each scenario puts frames on the link; the other entities
+   answer the frames the entity sends, as they arrive. */
+
+enum scenario_t {
+  ADP_ADVERTISE,
+  ADP_ADVERTISE_AGAIN,
+  ADP_DEPART,
+  ENUMERATION,
+  CONTENTION,
+  CONNECTION_STORM,
+  TRUNCATED,
+  MALFORMED,
+  NUM_SCENARIOS
+};
+
+/** Clear the link and the statistics and put the first frames of a
+ *  scenario on the link */
+void scenario_start(int scenario, unsigned now);
+
+/** Print what the entity did in a scenario.
+ *
+ *  \returns  non-zero if it did what it should
+ */
+int scenario_report(int scenario);
+
+/** Non-zero while a frame is on its way to the entity or a command sent
+ *  to it has not been answered */
+int network_busy(void);
+
+/** Take the next frame to reach the entity.
+ *
+ *  \param pdu       filled with the frame from the 1722.1 header on,
+ *                   padded to the minimum Ethernet frame size
+ *  \param src_addr  filled with the source address of the frame
+ *  \returns         the length of the PDU, or 0 if no frame has reached
+ *                   the entity by now
+ */
+unsigned network_receive(unsigned char pdu[NETWORK_MAX_PDU],
+                         unsigned char src_addr[6], unsigned now);
+
+/** Note the time the entity was done with the frame it last received */
+void network_processed(unsigned now);
+
+/** Hand a frame the entity sent to the other entities.
+ *
+ *  \param frame    the frame, from the Ethernet header on
+ *  \param sent_at  the time the entity sent it
+ */
+void network_deliver(const unsigned char frame[], unsigned len, unsigned sent_at);
+
+#endif /* NETWORK_H_ */
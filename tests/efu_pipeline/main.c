@@ -0,0 +1,208 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include <string.h>
+#include <quadflashlib.h>
+#include "avb_1722_1_aecp_efu.h"
+
+/* Uploading a firmware upgrade image with AECP ADDRESS_ACCESS writes.
+
+   A controller writes an image just under FLASH_MAX_UPGRADE_IMAGE_SIZE in
+   512 byte writes, sending each write once the response to the one before
+   reaches it. Meanwhile ACMP commands for the entity arrive every 3.7ms.
+   The 1722.1 task is simulated on a virtual clock, handling one packet or
+   programming one flash page at a time. A page takes 1ms to program.
+
+   Before the pipeline each write was programmed before it was answered,
+   and a last part page of the image was never programmed.
+
+   When the image is stored it is read back from flash and checked against
+   the CRC-32 of the image received, so a page that flash took but holds
+   wrongly is found. */
+
+#define IMAGE_SIZE        (FLASH_MAX_UPGRADE_IMAGE_SIZE - 100)
+#define WRITE_SIZE        512
+#define ROUND_TRIP_US     1500    // From sending a response to the next write
+#define HANDLE_US         50      // Handle a packet and queue its response
+#define ACMP_PERIOD_US    3700
+#define PROGRAM_US        1000
+#define NEVER             0xffffffffu
+
+static unsigned char image[IMAGE_SIZE];
+static unsigned char flash[FLASH_MAX_UPGRADE_IMAGE_SIZE];
+static unsigned flash_offset;
+static int pages;
+static unsigned now;
+static unsigned read_offset;
+static int fail_page = -1;
+static int corrupt_page = -1;
+
+int fl_writeImagePage(const unsigned char page[])
+{
+  now += PROGRAM_US;
+  if (flash_offset + FLASH_PAGE_SIZE > sizeof(flash))
+    return 1;
+  if (pages++ == fail_page)
+    return 1;
+  memcpy(&flash[flash_offset], page, FLASH_PAGE_SIZE);
+  if (pages == corrupt_page)
+    flash[flash_offset] ^= 0x10;
+  flash_offset += FLASH_PAGE_SIZE;
+  return 0;
+}
+
+int fl_getFactoryImage(fl_BootImageInfo *info)
+{
+  memset(info, 0, sizeof(*info));
+  return 0;
+}
+
+int fl_getNextBootImage(fl_BootImageInfo *info)
+{
+  info->size = flash_offset;
+  return 0;
+}
+
+int fl_startImageRead(fl_BootImageInfo *info)
+{
+  (void) info;
+  read_offset = 0;
+  return 0;
+}
+
+int fl_readImagePage(unsigned char page[])
+{
+  if (read_offset + FLASH_PAGE_SIZE > flash_offset)
+    return 1;
+  memcpy(page, &flash[read_offset], FLASH_PAGE_SIZE);
+  read_offset += FLASH_PAGE_SIZE;
+  return 0;
+}
+
+int fl_endWriteImage(void)
+{
+  return 0;
+}
+
+typedef struct upload_t {
+  unsigned time_us;
+  unsigned max_acmp_wait_us;
+  int stored;
+} upload_t;
+
+// Run the upload, with the pipeline or programming each write before
+// answering it
+static upload_t upload(int pipelined)
+{
+  upload_t result = {0, 0, 0};
+  unsigned next_write = 0, write_at = 0, acmp_at = ACMP_PERIOD_US;
+
+  memset(flash, 0, sizeof(flash));
+  flash_offset = 0;
+  pages = 0;
+  now = 0;
+  begin_write_upgrade_image();
+
+  while (next_write < IMAGE_SIZE) {
+    if (acmp_at <= now) {
+      if (now - acmp_at > result.max_acmp_wait_us)
+        result.max_acmp_wait_us = now - acmp_at;
+      acmp_at += ACMP_PERIOD_US;
+      now += HANDLE_US;
+    }
+    else if (write_at <= now) {
+      unsigned len = IMAGE_SIZE - next_write < WRITE_SIZE ? IMAGE_SIZE - next_write : WRITE_SIZE;
+      if (avb_write_upgrade_image(next_write, &image[next_write], len) != 0)
+        return result;
+      if (!pipelined) {
+        while (avb_upgrade_image_pages_pending())
+          avb_upgrade_image_program_page();
+      }
+      next_write += len;
+      now += HANDLE_US;
+      write_at = next_write < IMAGE_SIZE ? now + ROUND_TRIP_US : NEVER;
+    }
+    else if (avb_upgrade_image_pages_pending()) {
+      avb_upgrade_image_program_page();
+    }
+    else {
+      now = write_at < acmp_at ? write_at : acmp_at;
+    }
+  }
+
+  // The STORE operation programs what is left
+  now += ROUND_TRIP_US;
+  result.stored = end_write_upgrade_image() == 0;
+  result.time_us = now;
+  return result;
+}
+
+static int flash_holds_image(void)
+{
+  for (unsigned i = IMAGE_SIZE; i < flash_offset; i++)
+    if (flash[i] != 0xff)
+      return 0;
+  return flash_offset == (IMAGE_SIZE + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE * FLASH_PAGE_SIZE &&
+         memcmp(flash, image, IMAGE_SIZE) == 0;
+}
+
+int main(void)
+{
+  avb_1722_1_efu_stats_t stats;
+  upload_t before, after;
+  int pass = 1;
+  int ok;
+
+  for (unsigned i = 0; i < IMAGE_SIZE; i++)
+    image[i] = (i * 7) ^ (i >> 8);
+
+  before = upload(0);
+  ok = before.stored && flash_holds_image();
+  printf("programmed before answering: %u bytes in %u ms, ACMP waits up to %u us: %s\n",
+         IMAGE_SIZE, before.time_us / 1000, before.max_acmp_wait_us, ok ? "ok" : "failed");
+  pass &= ok;
+
+  after = upload(1);
+  avb_upgrade_image_get_stats(&stats);
+  ok = after.stored && flash_holds_image() &&
+       stats.received == IMAGE_SIZE && stats.received_crc == stats.programmed_crc &&
+       stats.max_depth <= AVB_1722_1_EFU_BUFFERS;
+  printf("pipelined: %u bytes in %u ms, ACMP waits up to %u us, %u pages waited at most: %s\n",
+         IMAGE_SIZE, after.time_us / 1000, after.max_acmp_wait_us, stats.max_depth, ok ? "ok" : "failed");
+  pass &= ok;
+  pass &= after.time_us * 3 < before.time_us * 2 && after.max_acmp_wait_us < before.max_acmp_wait_us;
+
+  // Writes must come in order
+  begin_write_upgrade_image();
+  ok = avb_write_upgrade_image(0, image, WRITE_SIZE) == 0 &&
+       avb_write_upgrade_image(0, image, WRITE_SIZE) != 0 &&
+       avb_write_upgrade_image(2 * WRITE_SIZE, image, WRITE_SIZE) != 0;
+  abort_write_upgrade_image();
+  ok &= avb_write_upgrade_image(WRITE_SIZE, image, WRITE_SIZE) != 0;
+  printf("out of order writes refused: %s\n", ok ? "ok" : "failed");
+  pass &= ok;
+
+  // A page the flash would not take is found when the image is stored
+  fail_page = 100;
+  after = upload(1);
+  avb_upgrade_image_get_stats(&stats);
+  ok = !after.stored && stats.failed == 1;
+  printf("failed page found on store: %s\n", ok ? "ok" : "failed");
+  pass &= ok;
+
+  // So is a page the flash took but holds wrongly
+  fail_page = -1;
+  corrupt_page = 100;
+  after = upload(1);
+  avb_upgrade_image_get_stats(&stats);
+  ok = !after.stored && stats.failed == 0 && stats.received_crc != stats.programmed_crc;
+  printf("corrupt page found on store: %s\n", ok ? "ok" : "failed");
+  pass &= ok;
+
+  // Nothing is stored once the image is ended
+  ok = !avb_upgrade_image_started() && end_write_upgrade_image() != 0;
+  printf("store without an image refused: %s\n", ok ? "ok" : "failed");
+  pass &= ok;
+
+  printf("%s\n", pass ? "PASS" : "FAIL");
+  return 0;
+}
@@ -0,0 +1,362 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "aecp_commands.h"
+#include "default_avb_conf.h"
+#include "avb_1722_common.h"
+#include "avb_1722_1_protocol.h"
+#include "avb_1722_1_adp_pdu.h"
+#include "avb_1722_1_aecp_pdu.h"
+#include "aem_descriptor_types.h"
+
+#define ETH_HEADER   14
+#define PDU_HEADER   12
+#define AEM_HEADER   (PDU_HEADER + 12)
+// configuration_index and reserved come before the descriptor
+#define DESCRIPTOR   (AEM_HEADER + 4)
+
+static const unsigned char entity_mac[6] = ENTITY_MAC;
+
+typedef struct descriptor_count_t {
+  unsigned type;
+  unsigned count;
+} descriptor_count_t;
+
+// The list of entity_fixture/src/aem_descriptors.h.in, with the per
+// channel and per stream descriptors rendered from the configuration
+static const descriptor_count_t expected[] = {
+  {AEM_ENTITY_TYPE, 1},
+  {AEM_CONFIGURATION_TYPE, 1},
+  {AEM_AUDIO_UNIT_TYPE, 1},
+  {AEM_STREAM_INPUT_TYPE, AVB_NUM_SINKS},
+  {AEM_STREAM_OUTPUT_TYPE, AVB_NUM_SOURCES},
+  {AEM_JACK_INPUT_TYPE, 1},
+  {AEM_JACK_OUTPUT_TYPE, 1},
+  {AEM_AVB_INTERFACE_TYPE, 1},
+  {AEM_CLOCK_SOURCE_TYPE, 2},
+  {AEM_MEMORY_OBJECT_TYPE, 1},
+  {AEM_LOCALE_TYPE, 1},
+  {AEM_STRINGS_TYPE, 1},
+  {AEM_STREAM_PORT_INPUT_TYPE, AVB_NUM_SINKS},
+  {AEM_STREAM_PORT_OUTPUT_TYPE, AVB_NUM_SOURCES},
+  {AEM_EXTERNAL_PORT_INPUT_TYPE, 1},
+  {AEM_EXTERNAL_PORT_OUTPUT_TYPE, 1},
+  {AEM_AUDIO_CLUSTER_TYPE, AVB_NUM_MEDIA_OUTPUTS + AVB_NUM_MEDIA_INPUTS},
+  {AEM_AUDIO_MAP_TYPE, AVB_NUM_SINKS + AVB_NUM_SOURCES},
+  {AEM_CONTROL_TYPE, 1},
+  {AEM_CLOCK_DOMAIN_TYPE, 1},
+};
+
+static void put16(unsigned char *p, unsigned v)
+{
+  p[0] = v >> 8;
+  p[1] = v;
+}
+
+static unsigned get16(const unsigned char *p)
+{
+  return (p[0] << 8) | p[1];
+}
+
+// The entity GUID is formed from its MAC address
+static void put_entity_guid(unsigned char *p)
+{
+  memcpy(p, entity_mac, 3);
+  p[3] = 0xff;
+  p[4] = 0xfe;
+  memcpy(p + 5, entity_mac + 3, 3);
+}
+
+void aecp_controller_mac(unsigned controller, unsigned char mac[6])
+{
+  static const unsigned char first_mac[6] = CONTROLLER_MAC;
+
+  memcpy(mac, first_mac, 6);
+  mac[5] += controller;
+}
+
+static void put_controller_guid(unsigned char *p, unsigned controller)
+{
+  aecp_controller_mac(controller, p);
+  p[6] = 0;
+  p[7] = 1;
+}
+
+static unsigned aem_pdu(unsigned char pdu[], unsigned message_type,
+                        unsigned controller, unsigned command_type,
+                        unsigned seq, unsigned payload_len)
+{
+  unsigned datalen = AEM_HEADER - PDU_HEADER + payload_len;
+
+  memset(pdu, 0, AEM_HEADER + payload_len);
+  pdu[0] = 0x80 | DEFAULT_1722_1_AECP_SUBTYPE;
+  pdu[1] = message_type;
+  pdu[2] = (datalen >> 8) & 7;
+  pdu[3] = datalen;
+  put_entity_guid(pdu + 4);
+  put_controller_guid(pdu + 12, controller);
+  put16(pdu + 20, seq);
+  put16(pdu + 22, command_type);
+  return AEM_HEADER + payload_len;
+}
+
+static unsigned aem_command(unsigned char pdu[], unsigned command_type,
+                            unsigned seq, unsigned payload_len)
+{
+  return aem_pdu(pdu, AECP_CMD_AEM_COMMAND, 0, command_type, seq, payload_len);
+}
+
+unsigned aecp_controller_read_descriptor_command(unsigned char pdu[], unsigned controller,
+                                                 unsigned seq, unsigned type,
+                                                 unsigned index)
+{
+  unsigned len = aem_pdu(pdu, AECP_CMD_AEM_COMMAND, controller,
+                         AECP_AEM_CMD_READ_DESCRIPTOR, seq, 8);
+
+  put16(pdu + AEM_HEADER + 4, type);
+  put16(pdu + AEM_HEADER + 6, index);
+  return len;
+}
+
+unsigned aecp_read_descriptor_command(unsigned char pdu[], unsigned seq,
+                                      unsigned type, unsigned index)
+{
+  return aecp_controller_read_descriptor_command(pdu, 0, seq, type, index);
+}
+
+unsigned aem_expected_descriptors(unsigned i, unsigned *type)
+{
+  if (i >= sizeof(expected) / sizeof(expected[0]))
+    return 0;
+  *type = expected[i].type;
+  return expected[i].count;
+}
+
+unsigned aecp_start_operation_command(unsigned char pdu[], unsigned seq,
+                                      unsigned type, unsigned index,
+                                      unsigned operation_type)
+{
+  unsigned len = aem_command(pdu, AECP_AEM_CMD_START_OPERATION, seq, 8);
+
+  put16(pdu + AEM_HEADER, type);
+  put16(pdu + AEM_HEADER + 2, index);
+  put16(pdu + AEM_HEADER + 6, operation_type);
+  return len;
+}
+
+static int response_status(const unsigned char frame[], unsigned len,
+                           unsigned controller, unsigned seq,
+                           unsigned command_type)
+{
+  const unsigned char *pdu = frame + ETH_HEADER;
+  unsigned char guid[8];
+  unsigned char mac[6];
+
+  aecp_controller_mac(controller, mac);
+  if (len < ETH_HEADER + AEM_HEADER ||
+      memcmp(frame, mac, 6) != 0 ||
+      memcmp(frame + 6, entity_mac, 6) != 0 ||
+      get16(frame + 12) != AVB_1722_ETHERTYPE ||
+      pdu[0] != (0x80 | DEFAULT_1722_1_AECP_SUBTYPE) ||
+      (pdu[1] & 0xf) != AECP_CMD_AEM_RESPONSE)
+    return -1;
+
+  put_entity_guid(guid);
+  if (memcmp(pdu + 4, guid, 8) != 0)
+    return -1;
+  put_controller_guid(guid, controller);
+  if (memcmp(pdu + 12, guid, 8) != 0 ||
+      get16(pdu + 20) != seq ||
+      get16(pdu + 22) != command_type)
+    return -1;
+
+  return pdu[2] >> 3;
+}
+
+int aecp_response_status(const unsigned char frame[], unsigned len,
+                         unsigned seq, unsigned command_type)
+{
+  return response_status(frame, len, 0, seq, command_type);
+}
+
+int aecp_controller_response_status(const unsigned char frame[], unsigned len,
+                                    unsigned controller, unsigned seq,
+                                    unsigned command_type)
+{
+  return response_status(frame, len, controller, seq, command_type);
+}
+
+unsigned aecp_register_unsolicited_command(unsigned char pdu[], unsigned controller,
+                                           unsigned seq, int deregister)
+{
+  // The command has a flags field, which is reserved
+  return aem_pdu(pdu, AECP_CMD_AEM_COMMAND, controller,
+                 deregister ? AECP_AEM_CMD_DEREGISTER_UNSOLICITED_NOTIFICATION :
+                              AECP_AEM_CMD_REGISTER_UNSOLICITED_NOTIFICATION,
+                 seq, 4);
+}
+
+unsigned aecp_set_sampling_rate_command(unsigned char pdu[], unsigned controller,
+                                        unsigned seq, unsigned index,
+                                        unsigned rate)
+{
+  unsigned len = aem_pdu(pdu, AECP_CMD_AEM_COMMAND, controller,
+                         AECP_AEM_CMD_SET_SAMPLING_RATE, seq, 8);
+
+  put16(pdu + AEM_HEADER, AEM_AUDIO_UNIT_TYPE);
+  put16(pdu + AEM_HEADER + 2, index);
+  put16(pdu + AEM_HEADER + 4, rate >> 16);
+  put16(pdu + AEM_HEADER + 6, rate);
+  return len;
+}
+
+int aecp_unsolicited_response(const unsigned char frame[], unsigned len,
+                              unsigned *command_type,
+                              unsigned *descriptor_type,
+                              unsigned *seq)
+{
+  const unsigned char *pdu = frame + ETH_HEADER;
+  unsigned char guid[8];
+
+  if (len < ETH_HEADER + AEM_HEADER + 4 ||
+      memcmp(frame + 6, entity_mac, 6) != 0 ||
+      get16(frame + 12) != AVB_1722_ETHERTYPE ||
+      pdu[0] != (0x80 | DEFAULT_1722_1_AECP_SUBTYPE) ||
+      (pdu[1] & 0xf) != AECP_CMD_AEM_RESPONSE ||
+      !(pdu[22] & 0x80))
+    return -1;
+
+  put_entity_guid(guid);
+  if (memcmp(pdu + 4, guid, 8) != 0)
+    return -1;
+
+  // It must be sent to the controller it names
+  for (unsigned c = 0; c < AECP_MAX_CONTROLLERS; c++) {
+    put_controller_guid(guid, c);
+    if (memcmp(pdu + 12, guid, 8) == 0 && memcmp(frame, guid, 6) == 0) {
+      *command_type = get16(pdu + 22) & 0x7fff;
+      *descriptor_type = get16(pdu + AEM_HEADER);
+      *seq = get16(pdu + 20);
+      return c;
+    }
+  }
+  return -1;
+}
+
+unsigned adp_controller_departing(unsigned char pdu[], unsigned controller)
+{
+  memset(pdu, 0, PDU_HEADER + AVB_1722_1_ADP_CD_LENGTH);
+  pdu[0] = 0x80 | DEFAULT_1722_1_ADP_SUBTYPE;
+  pdu[1] = ENTITY_DEPARTING;
+  pdu[2] = (AVB_1722_1_ADP_CD_LENGTH >> 8) & 7;
+  pdu[3] = AVB_1722_1_ADP_CD_LENGTH;
+  put_controller_guid(pdu + 4, controller);
+  return PDU_HEADER + AVB_1722_1_ADP_CD_LENGTH;
+}
+
+unsigned aecp_acquire_command(unsigned char pdu[], unsigned controller,
+                              unsigned seq, int release)
+{
+  unsigned len = aem_pdu(pdu, AECP_CMD_AEM_COMMAND, controller,
+                         AECP_AEM_CMD_ACQUIRE_ENTITY, seq,
+                         sizeof(avb_1722_1_aem_acquire_entity_command_t));
+
+  if (release)
+    pdu[AEM_HEADER] = 0x80;
+  return len;
+}
+
+int aecp_acquire_response_status(const unsigned char frame[], unsigned len,
+                                 unsigned controller, unsigned seq,
+                                 int *owner)
+{
+  const unsigned char *owner_guid = frame + ETH_HEADER + AEM_HEADER + 4;
+  int status = response_status(frame, len, controller, seq, AECP_AEM_CMD_ACQUIRE_ENTITY);
+  unsigned char guid[8];
+
+  *owner = -1;
+  if (status < 0 ||
+      len < ETH_HEADER + AEM_HEADER + sizeof(avb_1722_1_aem_acquire_entity_command_t))
+    return -1;
+  for (unsigned c = 0; c < AECP_MAX_CONTROLLERS; c++) {
+    put_controller_guid(guid, c);
+    if (memcmp(owner_guid, guid, 8) == 0)
+      *owner = c;
+  }
+  return status;
+}
+
+int aecp_controller_available_command(const unsigned char frame[], unsigned len,
+                                      unsigned controller, unsigned *seq)
+{
+  const unsigned char *pdu = frame + ETH_HEADER;
+  unsigned char guid[8];
+
+  // The entity asks the controller that holds it whether it is still there
+  if (len < ETH_HEADER + AEM_HEADER ||
+      memcmp(frame + 6, entity_mac, 6) != 0 ||
+      get16(frame + 12) != AVB_1722_ETHERTYPE ||
+      pdu[0] != (0x80 | DEFAULT_1722_1_AECP_SUBTYPE) ||
+      (pdu[1] & 0xf) != AECP_CMD_AEM_COMMAND ||
+      (get16(pdu + 22) & 0x7fff) != AECP_AEM_CMD_CONTROLLER_AVAILABLE)
+    return 0;
+
+  put_controller_guid(guid, controller);
+  if (memcmp(pdu + 4, guid, 8) != 0)
+    return 0;
+  put_entity_guid(guid);
+  if (memcmp(pdu + 12, guid, 8) != 0)
+    return 0;
+
+  *seq = get16(pdu + 20);
+  return 1;
+}
+
+unsigned aecp_controller_available_response(unsigned char pdu[],
+                                            unsigned controller, unsigned seq)
+{
+  unsigned char guid[8];
+  unsigned len = aem_pdu(pdu, AECP_CMD_AEM_RESPONSE, controller,
+                         AECP_AEM_CMD_CONTROLLER_AVAILABLE, seq, 0);
+
+  // The controller answers the entity's command, so the roles swap
+  memcpy(guid, pdu + 4, 8);
+  memcpy(pdu + 4, pdu + 12, 8);
+  memcpy(pdu + 12, guid, 8);
+  return len;
+}
+
+int aecp_read_descriptor_response_ok(const unsigned char frame[], unsigned len,
+                                     unsigned seq, unsigned type,
+                                     unsigned index, int exists)
+{
+  const unsigned char *pdu = frame + ETH_HEADER;
+  unsigned char guid[8];
+  int status;
+  unsigned datalen;
+
+  status = aecp_response_status(frame, len, seq, AECP_AEM_CMD_READ_DESCRIPTOR);
+  if (status < 0 || len < ETH_HEADER + DESCRIPTOR)
+    return 0;
+
+  datalen = ((pdu[2] & 7) << 8) | pdu[3];
+  if (!exists)
+    return status == AECP_AEM_STATUS_NO_SUCH_DESCRIPTOR &&
+           get16(pdu + AEM_HEADER + 4) == type &&
+           get16(pdu + AEM_HEADER + 6) == index;
+
+  // The descriptor must fill the response, and be the one asked for
+  if (status != AECP_AEM_STATUS_SUCCESS ||
+      PDU_HEADER + datalen > len - ETH_HEADER ||
+      datalen < DESCRIPTOR - PDU_HEADER + 4 ||
+      get16(pdu + DESCRIPTOR) != type ||
+      get16(pdu + DESCRIPTOR + 2) != index)
+    return 0;
+
+  // The entity GUID is filled in at startup
+  if (type == AEM_ENTITY_TYPE) {
+    put_entity_guid(guid);
+    if (memcmp(pdu + DESCRIPTOR + 4, guid, 8) != 0)
+      return 0;
+  }
+  return 1;
+}
@@ -0,0 +1,171 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef AECP_COMMANDS_H_
+#define AECP_COMMANDS_H_
+
+#include <xccompat.h>
+
+#define ENTITY_MAC      {0x00, 0x22, 0x97, 0x01, 0x02, 0x03}
+#define CONTROLLER_MAC  {0x00, 0x22, 0x97, 0x0a, 0x0b, 0x0c}
+
+/** The number of controllers that can send commands. Controller n has the
+ *  address CONTROLLER_MAC plus n, and the other commands are sent by
+ *  controller 0. */
+#define AECP_MAX_CONTROLLERS 8
+
+/** Enough for any command sent to the entity */
+#define AECP_MAX_PDU 128
+
+/** Build a READ_DESCRIPTOR command from the controller to the entity.
+ *
+ *  \param pdu  filled with the command from the 1722.1 header on
+ *  \returns    the length of the command
+ */
+unsigned aecp_read_descriptor_command(unsigned char pdu[], unsigned seq,
+                                      unsigned type, unsigned index);
+
+/** Build a READ_DESCRIPTOR command from one of the controllers to the
+ *  entity, as aecp_read_descriptor_command().
+ */
+unsigned aecp_controller_read_descriptor_command(unsigned char pdu[], unsigned controller,
+                                                 unsigned seq, unsigned type,
+                                                 unsigned index);
+
+/** Build a START_OPERATION command from the controller to the entity.
+ *
+ *  \param pdu  filled with the command from the 1722.1 header on
+ *  \returns    the length of the command
+ */
+unsigned aecp_start_operation_command(unsigned char pdu[], unsigned seq,
+                                      unsigned type, unsigned index,
+                                      unsigned operation_type);
+
+/** The status of a response to an AEM command.
+ *
+ *  \param frame  the frame the entity sent, from the Ethernet header on
+ *  \param len    the length of the frame, 0 if none was sent
+ *  \returns      the status, or -1 if the frame is not a response from the
+ *                entity to the command
+ */
+int aecp_response_status(const unsigned char frame[], unsigned len,
+                         unsigned seq, unsigned command_type);
+
+/** The status of a response to an AEM command from one of the
+ *  controllers, as aecp_response_status().
+ */
+int aecp_controller_response_status(const unsigned char frame[], unsigned len,
+                                    unsigned controller, unsigned seq,
+                                    unsigned command_type);
+
+/** The address of a controller */
+void aecp_controller_mac(unsigned controller, unsigned char mac[6]);
+
+/** Build an ACQUIRE_ENTITY command for the entity descriptor.
+ *
+ *  \param pdu      filled with the command from the 1722.1 header on
+ *  \param release  non-zero to release the entity rather than acquire it
+ *  \returns        the length of the command
+ */
+unsigned aecp_acquire_command(unsigned char pdu[], unsigned controller,
+                              unsigned seq, int release);
+
+/** The status of a response to an ACQUIRE_ENTITY command.
+ *
+ *  \param frame  the frame the entity sent, from the Ethernet header on
+ *  \param len    the length of the frame, 0 if none was sent
+ *  \param owner  set to the controller the response names as the owner,
+ *                or -1 if it names none of them
+ *  \returns      the status, or -1 if the frame is not a response from the
+ *                entity to the command, sent to the controller
+ */
+int aecp_acquire_response_status(const unsigned char frame[], unsigned len,
+                                 unsigned controller, unsigned seq,
+                                 REFERENCE_PARAM(int, owner));
+
+/** Check for the CONTROLLER_AVAILABLE command the entity sends the
+ *  controller that holds it. The destination address is not checked.
+ *
+ *  \param frame  the frame the entity sent, from the Ethernet header on
+ *  \param len    the length of the frame, 0 if none was sent
+ *  \param seq    set to the sequence ID of the command
+ *  \returns      non-zero if the frame is the command, with the
+ *                controller as its target
+ */
+int aecp_controller_available_command(const unsigned char frame[], unsigned len,
+                                      unsigned controller,
+                                      REFERENCE_PARAM(unsigned, seq));
+
+/** Build a controller's response to the entity's CONTROLLER_AVAILABLE
+ *  command.
+ *
+ *  \param pdu  filled with the response from the 1722.1 header on
+ *  \returns    the length of the response
+ */
+unsigned aecp_controller_available_response(unsigned char pdu[],
+                                            unsigned controller, unsigned seq);
+
+/** Build a REGISTER_UNSOLICITED_NOTIFICATION command, or a
+ *  DEREGISTER_UNSOLICITED_NOTIFICATION.
+ *
+ *  \param pdu         filled with the command from the 1722.1 header on
+ *  \param deregister  non-zero to deregister rather than register
+ *  \returns           the length of the command
+ */
+unsigned aecp_register_unsolicited_command(unsigned char pdu[], unsigned controller,
+                                           unsigned seq, int deregister);
+
+/** Build a SET_SAMPLING_RATE command for an audio unit.
+ *
+ *  \param pdu  filled with the command from the 1722.1 header on
+ *  \returns    the length of the command
+ */
+unsigned aecp_set_sampling_rate_command(unsigned char pdu[], unsigned controller,
+                                        unsigned seq, unsigned index,
+                                        unsigned rate);
+
+/** Check for an unsolicited response the entity sends to a registered
+ *  controller.
+ *
+ *  \param frame            the frame the entity sent, from the Ethernet
+ *                          header on
+ *  \param len              the length of the frame, 0 if none was sent
+ *  \param command_type     set to the GET command it answers
+ *  \param descriptor_type  set to the type of the descriptor it reports
+ *  \param seq              set to its sequence ID
+ *  \returns                the controller it was sent to, or -1 if the
+ *                          frame is not an unsolicited response
+ */
+int aecp_unsolicited_response(const unsigned char frame[], unsigned len,
+                              REFERENCE_PARAM(unsigned, command_type),
+                              REFERENCE_PARAM(unsigned, descriptor_type),
+                              REFERENCE_PARAM(unsigned, seq));
+
+/** Build the ENTITY_DEPARTING a controller sends as it leaves the network.
+ *
+ *  \param pdu  filled with the ADP PDU from the 1722.1 header on
+ *  \returns    the length of the PDU
+ */
+unsigned adp_controller_departing(unsigned char pdu[], unsigned controller);
+
+/** The descriptors the entity of entity_fixture/src/aem_descriptors.h.in
+ *  has.
+ *
+ *  \param i     the number of the descriptor type, from 0
+ *  \param type  set to the descriptor type
+ *  \returns     the number of descriptors of the type, or 0 once i is
+ *               past the last type
+ */
+unsigned aem_expected_descriptors(unsigned i, REFERENCE_PARAM(unsigned, type));
+
+/** Check the response to a READ_DESCRIPTOR command.
+ *
+ *  \param frame   the frame the entity sent, from the Ethernet header on
+ *  \param len     the length of the frame, 0 if none was sent
+ *  \param exists  non-zero if the descriptor should be returned, zero if
+ *                 the response should be NO_SUCH_DESCRIPTOR
+ *  \returns       non-zero if the response is right
+ */
+int aecp_read_descriptor_response_ok(const unsigned char frame[], unsigned len,
+                                     unsigned seq, unsigned type,
+                                     unsigned index, int exists);
+
+#endif /* AECP_COMMANDS_H_ */
@@ -0,0 +1,50 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef ENTITY_STUBS_H_
+#define ENTITY_STUBS_H_
+
+#include "avb.h"
+#include "avb_1722_1_callbacks.h"
+#include "ethernet.h"
+
+#define LOOPBACK_MAX_FRAMES 16
+#define LOOPBACK_FRAME_SIZE 1520
+
+/** The frames the entity has sent, oldest first */
+interface loopback_if {
+  /** Take the oldest frame sent and not yet taken.
+   *
+   *  \returns  the length of the frame, or 0 if there is none
+   */
+  unsigned take_frame(unsigned char frame[LOOPBACK_FRAME_SIZE]);
+
+  /** The time the oldest frame not yet taken was sent */
+  unsigned front_sent_at(void);
+
+  /** The number of frames sent and not yet taken */
+  unsigned count(void);
+
+  /** Stop serving */
+  void stop(void);
+};
+
+/** Everything the 1722.1 task talks to other than the network.
+
+    Frames sent to i_eth are kept for i_loop. i_avb reports every stream
+    and media clock at 48kHz, with the streams sharing the media inputs
+    and outputs equally. i_1722_1_entity reports a one byte control value
+    of 0 and a signal selector of 0. */
+void entity_stubs(server interface ethernet_tx_if i_eth,
+                  server interface loopback_if i_loop,
+                  server interface avb_interface i_avb,
+                  server interface avb_1722_1_control_callbacks i_1722_1_entity);
+
+/** The batches of connections the controller has completed, as told to
+ *  avb_controller_on_batch_complete()
+ *
+ *  \param num_connections  set to the number of connections in the last batch
+ *  \param num_failed       set to the number of them that failed
+ *  \returns                the number of batches completed
+ */
+unsigned entity_batches_completed(unsigned &num_connections, unsigned &num_failed);
+
+#endif /* ENTITY_STUBS_H_ */
@@ -0,0 +1,176 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include "gptp_holdover.h"
+#include "gptp_internal.h"
+
+/* The grandmaster runs 20ppm fast and its frequency ages by 0.01ppm a
+   second. The slave measures it four times a second for LOCK_SECONDS with
+   +-0.02ppm of noise, of which the model takes one a second, then loses it
+   for HOLDOVER_SECONDS.
+
+   - Holdover must not start before PTP_HOLDOVER_MIN_SAMPLES updates.
+   - The extrapolated frequency must stay within MAX_FREQ_ERR_PPB of the
+     grandmaster's. Holding the last measured frequency, as without
+     holdover, is run as a reference and must fail.
+   - A grandmaster near PTP_HOLDOVER_MAX_PPM must be extrapolated no
+     further than the clamp.
+   - A phase error found on leaving holdover must be slewed at no more
+     than PTP_HOLDOVER_SLEW_PPM, and one over PTP_HOLDOVER_MAX_SLEW_NS
+     stepped. */
+#define TICKS_PER_SEC      100000000
+#define UPDATE_TICKS       (TICKS_PER_SEC / 4)
+#define LOCK_SECONDS       100
+#define HOLDOVER_SECONDS   60
+#define GM_PPB             20000
+#define GM_AGING_PPB       10
+#define NOISE_PPB          20
+#define MAX_FREQ_ERR_PPB   100
+#define SYNC_TICKS         (TICKS_PER_SEC / 8)
+
+static unsigned rand_state = 1;
+
+static int noise_ppb(void)
+{
+  rand_state = rand_state * 1664525 + 1013904223;
+  return (int) ((rand_state >> 16) % (2 * NOISE_PPB + 1)) - NOISE_PPB;
+}
+
+static int ppb_to_adjust(long long ppb)
+{
+  return (int) ((ppb << PTP_ADJUST_PREC) / 1000000000);
+}
+
+static long long adjust_to_ppb(long long adjust)
+{
+  return (adjust * 1000000000) >> PTP_ADJUST_PREC;
+}
+
+/* Lock onto a grandmaster starting at ppb and ageing by aging_ppb a second.
+   Returns the number of model updates fed before holdover was possible. */
+static unsigned lock(ptp_holdover_t *h, unsigned *t, long long ppb, long long aging_ppb,
+                     int *last_adjust)
+{
+  unsigned qualified = 0;
+
+  ptp_holdover_init(h);
+  for (unsigned i = 0; i <= LOCK_SECONDS * (TICKS_PER_SEC / UPDATE_TICKS); i++) {
+    long long gm = ppb + aging_ppb * i * UPDATE_TICKS / TICKS_PER_SEC;
+    *last_adjust = ppb_to_adjust(gm + noise_ppb());
+    ptp_holdover_update(h, *t, *last_adjust);
+    if (!qualified && h->valid)
+      qualified = h->samples;
+    *t += UPDATE_TICKS;
+  }
+  return qualified;
+}
+
+static int check_qualification(void)
+{
+  ptp_holdover_t h;
+  unsigned t = 0xf0000000;
+  int ok = 1;
+
+  ptp_holdover_init(&h);
+  for (int i = 0; i < PTP_HOLDOVER_MIN_SAMPLES * 4; i++) {
+    if (h.samples < PTP_HOLDOVER_MIN_SAMPLES && ptp_holdover_start(&h, t))
+      ok = 0;
+    ptp_holdover_update(&h, t, ppb_to_adjust(GM_PPB));
+    t += UPDATE_TICKS;
+  }
+  if (!ptp_holdover_start(&h, t))
+    ok = 0;
+
+  printf("qualification: %u updates from %d measurements: %s\n",
+         h.samples, PTP_HOLDOVER_MIN_SAMPLES * 4, ok ? "ok" : "failed");
+  return ok;
+}
+
+static int check_extrapolation(int reference)
+{
+  ptp_holdover_t h;
+  unsigned t = 0;
+  int last_adjust;
+  long long max_err = 0;
+  int ok;
+
+  unsigned qualified = lock(&h, &t, GM_PPB, GM_AGING_PPB, &last_adjust);
+  ptp_holdover_start(&h, t);
+
+  for (int s = 1; s <= HOLDOVER_SECONDS; s++) {
+    long long gm = GM_PPB + GM_AGING_PPB * (LOCK_SECONDS + s);
+    long long adjust, err;
+
+    t += TICKS_PER_SEC;
+    adjust = reference ? last_adjust : ptp_holdover_adjust(&h, t);
+    err = adjust_to_ppb(adjust) - gm;
+    if (err < 0)
+      err = -err;
+    if (err > max_err)
+      max_err = err;
+  }
+
+  ok = max_err <= MAX_FREQ_ERR_PPB &&
+       (reference || qualified == PTP_HOLDOVER_MIN_SAMPLES);
+  printf("%s: max_freq_err %lldppb after %ds: %s\n",
+         reference ? "reference" : "extrapolation", max_err, HOLDOVER_SECONDS,
+         ok ? "ok" : "failed");
+  return ok;
+}
+
+static int check_clamp(void)
+{
+  ptp_holdover_t h;
+  unsigned t = 0;
+  int last_adjust;
+  long long max_adjust = 0;
+  long long limit = ((long long) PTP_HOLDOVER_MAX_PPM << PTP_ADJUST_PREC) / 1000000;
+
+  lock(&h, &t, (PTP_HOLDOVER_MAX_PPM - 2) * 1000LL, 50, &last_adjust);
+  ptp_holdover_start(&h, t);
+  for (int s = 1; s <= HOLDOVER_SECONDS; s++) {
+    long long adjust;
+    t += TICKS_PER_SEC;
+    adjust = ptp_holdover_adjust(&h, t);
+    if (adjust > max_adjust)
+      max_adjust = adjust;
+  }
+
+  printf("clamp: max %lldppb limit %dppb: %s\n", adjust_to_ppb(max_adjust),
+         PTP_HOLDOVER_MAX_PPM * 1000, max_adjust == limit ? "ok" : "failed");
+  return max_adjust == limit;
+}
+
+static int check_slew(long long error)
+{
+  long long max_step = (long long) SYNC_TICKS * 10 * PTP_HOLDOVER_SLEW_PPM / 1000000;
+  int syncs = 0;
+  int ok = 1;
+
+  while (error != 0) {
+    long long step = ptp_holdover_slew(error, SYNC_TICKS);
+    if (step != error && (step > max_step || step < -max_step))
+      ok = 0;
+    error -= step;
+    syncs++;
+  }
+
+  printf("slew: %d syncs: %s\n", syncs, ok ? "ok" : "failed");
+  return ok;
+}
+
+int main(void)
+{
+  int ok = 1;
+
+  ok &= check_qualification();
+  ok &= !check_extrapolation(1);
+  ok &= check_extrapolation(0);
+  ok &= check_clamp();
+  ok &= check_slew(100000);
+  ok &= check_slew(-100000);
+  ok &= check_slew(PTP_HOLDOVER_MAX_SLEW_NS + 1);
+  ok &= check_slew(1000);
+
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return 0;
+}
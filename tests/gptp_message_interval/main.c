@@ -0,0 +1,67 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include "gptp_message_interval.h"
+#include "gptp_pdu.h"
+
+/* A link peer signals Announce and Sync intervals from 2^-1 to 2^5 seconds.
+   The PTP server keeps the time of the last message and the periods as
+   32-bit timer values and compares them with timeafter(), exactly as below.
+
+   For each requested interval the applied period and the Announce and Sync
+   receipt timeouts must not expire just after a message was received, nor
+   before the timeout has elapsed, and must expire once it has. Intervals
+   longer than the timer window allows are clamped, so 2^3 to 2^5 seconds
+   must come out as 2^2. The time of the last message is close to the timer
+   wrap to check the comparisons across it. */
+#define timeafter(A, B) ((int)((B) - (A)) < 0)
+
+#define LAST_RECEIVED_TIME 0xf0000000
+#define TICKS_PER_MS       (TIMER_TICKS_PER_SEC / 1000)
+
+static int expires_correctly(unsigned last, unsigned timeout)
+{
+  return !timeafter(last + 1, last + timeout) &&
+         !timeafter(last + timeout / 2, last + timeout) &&
+         !timeafter(last + timeout - 1, last + timeout) &&
+         timeafter(last + timeout + 1, last + timeout);
+}
+
+int main(void)
+{
+  int failed = 0;
+
+  for (int requested = -1; requested <= 5; requested++) {
+    int applied = ptp_apply_interval_request(PTP_LOG_ANNOUNCE_INTERVAL,
+                                             requested,
+                                             PTP_LOG_ANNOUNCE_INTERVAL);
+    unsigned period = ptp_log_interval_to_ticks(applied);
+    unsigned announce_timeout = period * PTP_ANNOUNCE_RECEIPT_TIMEOUT_MULTIPLE;
+    unsigned sync_timeout = period * PTP_SYNC_RECEIPT_TIMEOUT_MULTIPLE;
+    int ok = expires_correctly(LAST_RECEIVED_TIME, period) &&
+             expires_correctly(LAST_RECEIVED_TIME, announce_timeout) &&
+             expires_correctly(LAST_RECEIVED_TIME, sync_timeout) &&
+             applied == (requested > PTP_LOG_MAX_REQUESTABLE_INTERVAL ?
+                         PTP_LOG_MAX_REQUESTABLE_INTERVAL : requested);
+
+    printf("log interval %d: applied %d period %ums announce timeout %ums sync timeout %ums: %s\n",
+           requested, applied, period / TICKS_PER_MS,
+           announce_timeout / TICKS_PER_MS, sync_timeout / TICKS_PER_MS,
+           ok ? "ok" : "failed");
+    if (!ok)
+      failed = 1;
+  }
+
+  if (ptp_apply_interval_request(1, PTP_LOG_INTERVAL_NO_CHANGE, 0) != 1 ||
+      ptp_apply_interval_request(1, PTP_LOG_INTERVAL_INITIAL, 0) != 0 ||
+      ptp_apply_interval_request(1, PTP_LOG_INTERVAL_STOP, 0) != PTP_LOG_INTERVAL_STOP ||
+      ptp_apply_interval_request(1, -100, 0) != PTP_LOG_MIN_REQUESTABLE_INTERVAL) {
+    printf("special values: failed\n");
+    failed = 1;
+  }
+  else {
+    printf("special values: ok\n");
+  }
+
+  printf("%s\n", failed ? "FAIL" : "PASS");
+  return 0;
+}
@@ -0,0 +1,242 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include "ptp_frames.h"
+#include "gptp.h"
+#include "gptp_internal.h"
+#include "gptp_config.h"
+#include "gptp_pdu.h"
+
+#define NS_PER_SEC   1000000000LL
+#define GM_BASE_NS   (1000 * NS_PER_SEC)
+#define LINK_BASE_NS (7 * NS_PER_SEC)
+#define CORRECTION   1234
+
+#define PTP_HDR_OFFSET (sizeof(ethernet_hdr_t))
+#define PTP_BODY_OFFSET (sizeof(ethernet_hdr_t) + sizeof(ComMessageHdr))
+
+extern unsigned ptp_reference_local_ts;
+extern ptp_timestamp ptp_reference_ptp_ts;
+extern signed int g_ptp_adjust;
+
+static const unsigned char peer_mac[6] = {0x00, 0x22, 0x97, 0xaa, 0xbb, 0xcc};
+static const unsigned char peer_port_id[10] = {0x00, 0x22, 0x97, 0xff, 0xfe,
+                                               0xaa, 0xbb, 0xcc, 0x00, 0x01};
+
+static unsigned peer_base;
+static long long gm_step;
+static unsigned short sync_seq, announce_seq;
+
+void peer_init(unsigned t)
+{
+  peer_base = t;
+  gm_step = 0;
+}
+
+void peer_step(int ns)
+{
+  gm_step += ns;
+}
+
+static long long gm_ns(unsigned t)
+{
+  return GM_BASE_NS + (long long) (int) (t - peer_base) * 10 + gm_step;
+}
+
+static long long link_ns(unsigned t)
+{
+  return LINK_BASE_NS + (long long) (int) (t - peer_base) * 10;
+}
+
+static void ns_to_network(n80_t *ts, long long ns)
+{
+  unsigned long long sec = ns / NS_PER_SEC;
+  unsigned nsec = ns % NS_PER_SEC;
+
+  for (int i = 0; i < 6; i++)
+    ts->data[i] = sec >> (8 * (5 - i));
+  for (int i = 0; i < 4; i++)
+    ts->data[6 + i] = nsec >> (8 * (3 - i));
+}
+
+static long long network_to_ns(const n80_t *ts)
+{
+  unsigned long long sec = 0;
+  unsigned nsec = 0;
+
+  for (int i = 0; i < 6; i++)
+    sec = (sec << 8) | ts->data[i];
+  for (int i = 6; i < 10; i++)
+    nsec = (nsec << 8) | ts->data[i];
+  return sec * NS_PER_SEC + nsec;
+}
+
+/* The gPTP time of local time t, as the device's local_to_ptp_ts() */
+static long long local_to_ptp_ns(unsigned t)
+{
+  long long ref = ((long long) ptp_reference_ptp_ts.seconds[0] |
+                   ((long long) ptp_reference_ptp_ts.seconds[1] << 32)) * NS_PER_SEC +
+                  ptp_reference_ptp_ts.nanoseconds;
+  long long diff = (long long) (int) (t - ptp_reference_local_ts) * 10;
+
+  return ref + diff + ((diff * g_ptp_adjust) >> PTP_ADJUST_PREC);
+}
+
+static ComMessageHdr *peer_header(unsigned char frame[], int type,
+                                  unsigned body_len, unsigned short seq)
+{
+  ethernet_hdr_t *eth = (ethernet_hdr_t *) frame;
+  ComMessageHdr *hdr = (ComMessageHdr *) &frame[PTP_HDR_OFFSET];
+  const unsigned char dest[6] = PTP_DEFAULT_DEST_ADDR;
+
+  memset(frame, 0, PTP_BODY_OFFSET + body_len);
+  memcpy(eth->dest_addr, dest, 6);
+  memcpy(eth->src_addr, peer_mac, 6);
+  eth->ethertype = hton16(PTP_ETHERTYPE);
+
+  hdr->transportSpecific_messageType = PTP_TRANSPORT_SPECIFIC_HDR | type;
+  hdr->versionPTP = PTP_VERSION_NUMBER;
+  hdr->messageLength = hton16(sizeof(ComMessageHdr) + body_len);
+  memcpy(hdr->sourcePortIdentity.data, peer_port_id, 10);
+  hdr->sequenceId = hton16(seq);
+  hdr->logMessageInterval = 0x7f;
+  return hdr;
+}
+
+static unsigned frame_len(unsigned body_len)
+{
+  unsigned len = PTP_BODY_OFFSET + body_len;
+  return len < 64 ? 64 : len;
+}
+
+int frame_type(const unsigned char frame[])
+{
+  const ethernet_hdr_t *eth = (const ethernet_hdr_t *) frame;
+  const ComMessageHdr *hdr = (const ComMessageHdr *) &frame[PTP_HDR_OFFSET];
+
+  if (ntoh16(eth->ethertype) != PTP_ETHERTYPE)
+    return -1;
+  return hdr->transportSpecific_messageType & PTP_MESSAGE_TYPE_MASK;
+}
+
+unsigned peer_pdelay_resp(unsigned char resp[], unsigned char follow_up[],
+                          const unsigned char req[], unsigned egress)
+{
+  const ComMessageHdr *req_hdr = (const ComMessageHdr *) &req[PTP_HDR_OFFSET];
+  unsigned short seq = ntoh16(req_hdr->sequenceId);
+  ComMessageHdr *hdr;
+  PdelayRespMessage *body = (PdelayRespMessage *) &resp[PTP_BODY_OFFSET];
+  PdelayRespFollowUpMessage *fu_body = (PdelayRespFollowUpMessage *) &follow_up[PTP_BODY_OFFSET];
+
+  hdr = peer_header(resp, PTP_PDELAY_RESP_MESG, sizeof(PdelayRespMessage), seq);
+  hdr->flagField[0] = 0x2;
+  ns_to_network(&body->requestReceiptTimestamp, link_ns(egress + LINK_DELAY));
+  memcpy(body->requestingPortIdentity.data, req_hdr->sourcePortIdentity.data, 8);
+  memcpy(body->requestingPortId.data, &req_hdr->sourcePortIdentity.data[8], 2);
+
+  peer_header(follow_up, PTP_PDELAY_RESP_FOLLOW_UP_MESG,
+              sizeof(PdelayRespFollowUpMessage), seq);
+  ns_to_network(&fu_body->responseOriginTimestamp,
+                link_ns(egress + LINK_DELAY + PEER_TURNAROUND));
+  memcpy(fu_body->requestingPortIdentity.data, req_hdr->sourcePortIdentity.data, 8);
+  memcpy(fu_body->requestingPortId.data, &req_hdr->sourcePortIdentity.data[8], 2);
+
+  return frame_len(sizeof(PdelayRespMessage));
+}
+
+unsigned peer_announce(unsigned char frame[])
+{
+  AnnounceMessage *body = (AnnounceMessage *) &frame[PTP_BODY_OFFSET];
+  unsigned body_len = sizeof(AnnounceMessage) - (PTP_MAXIMUM_PATH_TRACE_TLV - 1) * 8;
+  ComMessageHdr *hdr = peer_header(frame, PTP_ANNOUNCE_MESG, body_len, announce_seq++);
+
+  hdr->controlField = PTP_CTL_FIELD_OTHERS;
+  hdr->logMessageInterval = 0;
+  body->grandmasterPriority1 = 100;
+  body->clockClass = 248;
+  body->clockAccuracy = 0xfe;
+  body->clockOffsetScaledLogVariance = hton16(0x4100);
+  body->grandmasterPriority2 = 248;
+  memcpy(body->grandmasterIdentity.data, peer_port_id, 8);
+  body->timeSource = 0xa0;
+  body->tlvType = hton16(PTP_ANNOUNCE_TLV_TYPE);
+  body->tlvLength = hton16(8);
+  memcpy(body->pathSequence[0].data, peer_port_id, 8);
+
+  return frame_len(body_len);
+}
+
+unsigned peer_sync(unsigned char sync[], unsigned char follow_up[],
+                   unsigned t, int one_step)
+{
+  ComMessageHdr *hdr;
+  FollowUpMessage *body;
+
+  sync_seq++;
+  if (one_step) {
+    unsigned long long correction = ((unsigned long long) CORRECTION << 16) | 0x8000;
+
+    hdr = peer_header(sync, PTP_SYNC_MESG, sizeof(FollowUpMessage), sync_seq);
+    hdr->logMessageInterval = PTP_LOG_SYNC_INTERVAL;
+    for (int i = 0; i < 8; i++)
+      hdr->correctionField.data[i] = correction >> (8 * (7 - i));
+    body = (FollowUpMessage *) &sync[PTP_BODY_OFFSET];
+    ns_to_network(&body->preciseOriginTimestamp, gm_ns(t) - CORRECTION);
+    body->tlvType = hton16(PTP_ORGANIZATION_EXTENSION_TLV_TYPE);
+    body->lengthField = hton16(28);
+    body->organizationId[1] = 0x80;
+    body->organizationId[2] = 0xc2;
+    body->organizationSubType[2] = 1;
+    return frame_len(sizeof(FollowUpMessage));
+  }
+
+  hdr = peer_header(sync, PTP_SYNC_MESG, sizeof(SyncMessage), sync_seq);
+  hdr->flagField[0] = 0x2;
+  hdr->logMessageInterval = PTP_LOG_SYNC_INTERVAL;
+
+  hdr = peer_header(follow_up, PTP_FOLLOW_UP_MESG, sizeof(FollowUpMessage), sync_seq);
+  hdr->controlField = PTP_CTL_FIELD_FOLLOW_UP;
+  hdr->logMessageInterval = PTP_LOG_SYNC_INTERVAL;
+  body = (FollowUpMessage *) &follow_up[PTP_BODY_OFFSET];
+  ns_to_network(&body->preciseOriginTimestamp, gm_ns(t));
+  return frame_len(sizeof(FollowUpMessage));
+}
+
+int sync_is_two_step(const unsigned char frame[])
+{
+  const ComMessageHdr *hdr = (const ComMessageHdr *) &frame[PTP_HDR_OFFSET];
+  return TWO_STEP_FLAG(hdr) != 0;
+}
+
+int sync_one_step_ok(const unsigned char frame[], unsigned len)
+{
+  const ComMessageHdr *hdr = (const ComMessageHdr *) &frame[PTP_HDR_OFFSET];
+  const FollowUpMessage *body = (const FollowUpMessage *) &frame[PTP_BODY_OFFSET];
+
+  return len >= PTP_BODY_OFFSET + sizeof(FollowUpMessage) &&
+         !TWO_STEP_FLAG(hdr) &&
+         ntoh16(hdr->messageLength) == sizeof(ComMessageHdr) + sizeof(FollowUpMessage) &&
+         hdr->controlField == PTP_CTL_FIELD_SYNC &&
+         ntoh16(body->tlvType) == PTP_ORGANIZATION_EXTENSION_TLV_TYPE &&
+         ntoh16(body->lengthField) == 28 &&
+         body->organizationId[0] == 0x00 &&
+         body->organizationId[1] == 0x80 &&
+         body->organizationId[2] == 0xc2 &&
+         body->organizationSubType[0] == 0 &&
+         body->organizationSubType[1] == 0 &&
+         body->organizationSubType[2] == 1;
+}
+
+int origin_error(const unsigned char frame[], unsigned egress)
+{
+  const ComMessageHdr *hdr = (const ComMessageHdr *) &frame[PTP_HDR_OFFSET];
+  const FollowUpMessage *body = (const FollowUpMessage *) &frame[PTP_BODY_OFFSET];
+  long long origin = network_to_ns(&body->preciseOriginTimestamp) +
+                     (ntoh64(hdr->correctionField) >> 16);
+
+  return (int) (origin - local_to_ptp_ns(egress));
+}
+
+int slave_error(unsigned t)
+{
+  return (int) (local_to_ptp_ns(t) - gm_ns(t));
+}
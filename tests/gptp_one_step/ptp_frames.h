@@ -0,0 +1,61 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef PTP_FRAMES_H_
+#define PTP_FRAMES_H_
+
+#include <xccompat.h>
+
+#define DEVICE_MAC      {0x00, 0x22, 0x97, 0x01, 0x02, 0x03}
+
+#define LINK_DELAY      50      // Each way, in ticks
+#define PEER_TURNAROUND 1000    // From Pdelay_Req to Pdelay_Resp at the peer
+
+/* The time aware system on the other end of the link. Its gPTP clock and
+   the free running clock it timestamps Pdelay messages with both run at
+   the same rate as the local timer. */
+
+/** Start the peer's clocks at local time t */
+void peer_init(unsigned t);
+
+/** Step the peer's gPTP clock by ns */
+void peer_step(int ns);
+
+/** The PTP message type of a frame, or -1 if it is not a PTP frame */
+int frame_type(const unsigned char frame[]);
+
+/** The peer's answer to a Pdelay_Req that left at egress. Both frames
+ *  reach the device at egress + 2 * LINK_DELAY + PEER_TURNAROUND.
+ *
+ *  \returns  the length of each frame
+ */
+unsigned peer_pdelay_resp(unsigned char resp[], unsigned char follow_up[],
+                          const unsigned char req[], unsigned egress);
+
+/** An Announce from the peer as a better grandmaster than the device */
+unsigned peer_announce(unsigned char frame[]);
+
+/** A Sync that leaves the peer at local time t, and reaches the device at
+ *  t + LINK_DELAY. A one-step Sync carries its origin timestamp less
+ *  1234ns, and 1234.5ns in its correctionField. A two-step Sync has its
+ *  origin timestamp in follow_up.
+ *
+ *  \returns  the length of each frame
+ */
+unsigned peer_sync(unsigned char sync[], unsigned char follow_up[],
+                   unsigned t, int one_step);
+
+/** Non-zero if a Sync from the device has the two-step flag set */
+int sync_is_two_step(const unsigned char frame[]);
+
+/** Non-zero if a Sync from the device is a one-step Sync with the
+ *  Follow_Up information TLV */
+int sync_one_step_ok(const unsigned char frame[], unsigned len);
+
+/** The origin timestamp plus correctionField of a Sync or Follow_Up from
+ *  the device less the gPTP time the device's two-step Follow_Up would
+ *  give for a Sync that left at egress, in ns */
+int origin_error(const unsigned char frame[], unsigned egress);
+
+/** The device's gPTP time at local time t less the peer's, in ns */
+int slave_error(unsigned t);
+
+#endif /* PTP_FRAMES_H_ */
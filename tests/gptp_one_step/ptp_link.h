@@ -0,0 +1,44 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef PTP_LINK_H_
+#define PTP_LINK_H_
+
+#include "ethernet.h"
+
+#define LINK_MAX_FRAMES 8
+#define LINK_FRAME_SIZE 128
+#define LINK_TX_LATENCY 190
+
+/** The MAC under the gPTP code, run on a time set by the test */
+interface link_if {
+  /** Set the time. Timestamped frames sent from now leave the MAC
+   *  LINK_TX_LATENCY later, with up to 4 ticks of jitter, and others
+   *  leave now. */
+  void set_time(unsigned t);
+
+  /** Make the next Sync sent leave the MAC ticks later */
+  void delay_next_sync(unsigned ticks);
+
+  /** The number of frames sent and not yet taken */
+  unsigned count(void);
+
+  /** Take the oldest frame sent and not yet taken.
+   *
+   *  \param egress_ts  set to the time the frame left the MAC
+   *  \returns       the length of the frame
+   */
+  unsigned take_frame(unsigned char frame[LINK_FRAME_SIZE], unsigned &egress_ts);
+
+  /** Stop serving */
+  void stop(void);
+};
+
+/** The Ethernet configuration, receive and transmit interfaces the gPTP
+    code uses. The MAC is on the tile of c, the other end of the chanend
+    the gPTP code is given. Frames sent to i_tx are kept for i_link. */
+void ptp_link(server interface ethernet_cfg_if i_cfg,
+              server interface ethernet_rx_if i_rx,
+              server interface ethernet_tx_if i_tx,
+              server interface link_if i_link,
+              chanend c);
+
+#endif /* PTP_LINK_H_ */
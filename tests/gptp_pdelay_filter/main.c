@@ -0,0 +1,95 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include "gptp_pdelay_filter.h"
+
+/* Simulated link: 500ns delay with +-40ns of timestamp noise, a 5us outlier
+   every 37 exchanges and a step to 600ns half way through.
+
+   Each estimator is judged on the exchanges from SETTLE_EXCHANGES after the
+   start and after the step. The fixed 1/32 exponential average used before
+   the estimators were added is run as a reference and must fail: every
+   outlier throws it more than 150ns off. */
+#define NUM_EXCHANGES    400
+#define STEP_EXCHANGE    200
+#define TRUE_DELAY_NS    500
+#define STEP_DELAY_NS    600
+#define NOISE_NS         40
+#define OUTLIER_PERIOD   37
+#define OUTLIER_NS       5000
+#define SETTLE_EXCHANGES 50
+#define MAX_ERR_NS       40
+#define MAX_MEAN_ERR_NS  12
+#define REFERENCE        -1
+
+static unsigned rand_state;
+
+static int noise(void)
+{
+  rand_state = rand_state * 1664525 + 1013904223;
+  return (int) ((rand_state >> 16) % (2 * NOISE_NS + 1)) - NOISE_NS;
+}
+
+static const char *filter_name(int type)
+{
+  switch (type) {
+  case REFERENCE: return "reference";
+  case PTP_PATH_DELAY_FILTER_MEDIAN: return "median";
+  case PTP_PATH_DELAY_FILTER_KALMAN: return "kalman";
+  default: return "ewma";
+  }
+}
+
+static int run(int type)
+{
+  ptp_pdelay_filter_t f;
+  int reference = 0;
+  int max_err = 0, total_err = 0, judged = 0;
+
+  rand_state = 1;
+  ptp_pdelay_filter_init(&f);
+
+  for (int i = 0; i < NUM_EXCHANGES; i++) {
+    int true_delay = i < STEP_EXCHANGE ? TRUE_DELAY_NS : STEP_DELAY_NS;
+    int sample = true_delay + noise();
+    int estimate, err;
+
+    if (i % OUTLIER_PERIOD == OUTLIER_PERIOD - 1)
+      sample += OUTLIER_NS;
+
+    if (type == REFERENCE) {
+      reference = i == 0 ? sample : (reference * (PTP_PATH_DELAY_WEIGHT - 1) + sample) / PTP_PATH_DELAY_WEIGHT;
+      estimate = reference;
+    }
+    else {
+      ptp_pdelay_filter_update(&f, type, sample);
+      estimate = f.estimate;
+    }
+
+    err = estimate - true_delay;
+    if (err < 0)
+      err = -err;
+    if (i % STEP_EXCHANGE >= SETTLE_EXCHANGES) {
+      if (err > max_err)
+        max_err = err;
+      total_err += err;
+      judged++;
+    }
+  }
+
+  printf("%s: max_err %d mean_err %d rejects %u\n",
+         filter_name(type), max_err, total_err / judged, f.total_rejects);
+
+  /* Every injected outlier must have been rejected */
+  if (type != REFERENCE && f.total_rejects < NUM_EXCHANGES / OUTLIER_PERIOD)
+    return 0;
+  return max_err <= MAX_ERR_NS && total_err / judged <= MAX_MEAN_ERR_NS;
+}
+
+int main(void)
+{
+  printf("%s\n", run(REFERENCE) ? "FAIL" : "PASS");
+  printf("%s\n", run(PTP_PATH_DELAY_FILTER_EWMA) ? "PASS" : "FAIL");
+  printf("%s\n", run(PTP_PATH_DELAY_FILTER_MEDIAN) ? "PASS" : "FAIL");
+  printf("%s\n", run(PTP_PATH_DELAY_FILTER_KALMAN) ? "PASS" : "FAIL");
+  return 0;
+}
@@ -0,0 +1,61 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include "gptp_trace.h"
+
+/* The gPTP event trace ring.
+
+   Three and a half times as many events as the ring holds are written,
+   with the reference timer wrapping among the newest of them. Only the
+   newest PTP_TRACE_ENTRIES must be kept, each in the slot of its entry
+   number.
+
+   The ring is then printed as it would be dumped, the header and each
+   slot in memory order as hex, and test_gptp_trace.py decodes it with
+   lib_tsn/host/gptp_trace_to_csv.py. The CSV must list the kept events
+   oldest first, with a time that runs on across the timer wrap. */
+
+#define EVENTS (PTP_TRACE_ENTRIES * 7 / 2)
+#define FIRST_TS (0u - (EVENTS - 4) * TS_STEP)
+#define TS_STEP 0x400                 // 10.24us
+
+extern ptp_trace_t ptp_trace;
+
+static void dump(const void *p, unsigned len)
+{
+  const unsigned char *c = p;
+
+  printf("trace ");
+  for (unsigned i = 0; i < len; i++)
+    printf("%02x", c[i]);
+  printf("\n");
+}
+
+int main(void)
+{
+  int ok = 1;
+
+  ptp_trace_init();
+  for (unsigned n = 0; n < EVENTS; n++) {
+    // Every event type in turn, with a/b fields that identify the entry
+    int event = PTP_TRACE_SYNC_RX + n % PTP_TRACE_HOLDOVER;
+    int a = event == PTP_TRACE_ROLE ? (int) (n % 4) : (int) n * 1000;
+    ptp_trace_write(event, n % 2, n, FIRST_TS + n * TS_STEP, a, -(int) n);
+  }
+
+  if (ptp_trace.index != EVENTS)
+    ok = 0;
+  for (unsigned n = EVENTS - PTP_TRACE_ENTRIES; n < EVENTS; n++) {
+    const ptp_trace_entry_t *e = &ptp_trace.entries[n % PTP_TRACE_ENTRIES];
+    if (e->seq_id != n || e->local_ts != FIRST_TS + n * TS_STEP || e->b != -(int) n)
+      ok = 0;
+  }
+  printf("%u events in a ring of %u, the newest kept in their slots: %s\n",
+         EVENTS, PTP_TRACE_ENTRIES, ok ? "ok" : "failed");
+
+  dump(&ptp_trace, sizeof(ptp_trace) - sizeof(ptp_trace.entries));
+  for (unsigned i = 0; i < PTP_TRACE_ENTRIES; i++)
+    dump(&ptp_trace.entries[i], sizeof(ptp_trace_entry_t));
+
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return 0;
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include "media_clock_rate.h"
+
+/* Word lengths and PLL reference dividers of media clocks at the IEC
+   61883-6 sample rates.
+
+   Each rate's word length is derived the way the media clock server does
+   it, from the recovered word length of its family's base rate, and
+   checked against the exact sample period. The reference clock generated
+   from it must run at the same frequency for every rate in a family. */
+
+#define RECOVERY_BITS 24            // WORDLEN_FRACTIONAL_BITS
+#define CLOCK_BITS    16            // WC_FRACTIONAL_BITS
+#define MAX_ERROR_PPB 50            // One LSB at 192kHz is about 29ppb
+
+static int check_rate(unsigned rate, unsigned multiplier)
+{
+  unsigned family = media_clock_family_rate(rate);
+  unsigned long long recovered = media_clock_nominal_wordlen(family, RECOVERY_BITS);
+  unsigned wordlen = (unsigned) (media_clock_scale_wordlen(recovered, rate) >>
+                                 (RECOVERY_BITS - CLOCK_BITS));
+  // Exact period in 10ns units with CLOCK_BITS fractional bits is
+  // 1e8 * 2^CLOCK_BITS / rate, so the error in ppb is
+  // (wordlen * rate - 1e8 * 2^CLOCK_BITS) * 1e9 / (1e8 * 2^CLOCK_BITS)
+  long long exact = 100000000LL << CLOCK_BITS;
+  long long error_ppb = ((long long) wordlen * rate - exact) * 10 >> CLOCK_BITS;
+  unsigned num, den;
+  unsigned long long half_period;
+  unsigned ref_mhz, expected_mhz;
+  int ok;
+
+  if (!media_clock_reference_divide(rate, multiplier, &num, &den)) {
+    printf("rate %u: unsupported\n", rate);
+    return 0;
+  }
+
+  // Reference frequency in mHz from its half period in 10ns units
+  half_period = (unsigned long long) wordlen * num / den;
+  ref_mhz = (unsigned) (((100000000000ULL << CLOCK_BITS) + half_period) /
+                        (2 * half_period));
+  expected_mhz = (unsigned) ((family * 1000ULL * 2) / multiplier);
+
+  ok = error_ppb <= MAX_ERROR_PPB && error_ppb >= -MAX_ERROR_PPB &&
+       ref_mhz >= expected_mhz - 1 && ref_mhz <= expected_mhz + 1;
+
+  printf("rate %u x%u: family %u, wordlen error %lld ppb, divide %u/%u, reference %u.%03u Hz %s\n",
+         rate, multiplier, family, error_ppb, num, den,
+         ref_mhz / 1000, ref_mhz % 1000, ok ? "ok" : "failed");
+  return ok;
+}
+
+int main(void)
+{
+  static const unsigned rates[] = {32000, 44100, 48000, 88200, 96000, 176400, 192000};
+  int pass = 1;
+
+  for (unsigned i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+    pass &= check_rate(rates[i], 100);
+
+  // A 48kHz and a 44.1kHz domain side by side with their own multipliers
+  pass &= check_rate(48000, 200);
+  pass &= check_rate(44100, 98);
+
+  if (media_clock_family_rate(22000) != 0 || media_clock_family_rate(0) != 0)
+    pass = 0;
+
+  printf("%s\n", pass ? "PASS" : "FAIL");
+  return 0;
+}
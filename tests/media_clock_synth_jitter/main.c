@@ -0,0 +1,125 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include <math.h>
+#include "media_clock_synth.h"
+
+/* Jitter model of the PLL reference edge synthesizer.
+
+   The edges are generated for a fixed rate and compared with their ideal
+   times. The spectrum of the time interval error is reported in octave
+   bands of the edge rate; the lowest bands are the ones the external PLL
+   passes through to the audio clock. */
+
+#define NUM_EDGES       512
+#define INBAND_BINS     16          // Below edge_rate/32, ~55Hz at 44.1kHz
+#define PLL_TO_WORD_MULTIPLIER 100
+#define PS_PER_TICK     10000
+
+static double tie[NUM_EDGES];
+static double cos_table[NUM_EDGES];
+
+static unsigned long long half_period_for_rate(unsigned rate)
+{
+  unsigned long long word_length = (100000000ULL << MEDIA_CLOCK_SYNTH_FRACTIONAL_BITS) / rate;
+  return word_length * PLL_TO_WORD_MULTIPLIER / 4;
+}
+
+/* Returns the number of port outputs needed for NUM_EDGES edges, or -1 if
+   any two outputs were too far apart for the 16-bit port timer */
+static int generate(int order, unsigned long long half_period)
+{
+  media_clock_synth_t s;
+  unsigned prev_time = 0;
+  unsigned prev_word = 0;
+  int outputs = 0;
+  int n = 0;
+
+  media_clock_synth_init(&s, order, 0);
+  media_clock_synth_set_half_period(&s, half_period);
+
+  while (n < NUM_EDGES) {
+    unsigned time, word;
+    media_clock_synth_next(&s, &time, &word);
+    if (time - prev_time >= 0x10000)
+      return -1;
+    prev_time = time;
+    outputs++;
+    if (word != prev_word) {
+      unsigned long long ideal = half_period * (n + 1);
+      tie[n] = (double) (((long long) time << MEDIA_CLOCK_SYNTH_FRACTIONAL_BITS) - (long long) ideal) /
+               (1 << MEDIA_CLOCK_SYNTH_FRACTIONAL_BITS) * PS_PER_TICK;
+      prev_word = word;
+      n++;
+    }
+  }
+  return outputs;
+}
+
+static double band_power(int lo, int hi)
+{
+  double power = 0;
+  for (int k = lo; k < hi; k++) {
+    double re = 0, im = 0;
+    for (int n = 0; n < NUM_EDGES; n++) {
+      re += tie[n] * cos_table[(k * n) % NUM_EDGES];
+      im += tie[n] * cos_table[(k * n + NUM_EDGES / 4) % NUM_EDGES];
+    }
+    power += 2 * (re * re + im * im) / ((double) NUM_EDGES * NUM_EDGES);
+  }
+  return power;
+}
+
+static int run(const char *name, int order, unsigned rate,
+               double *inband)
+{
+  unsigned long long half_period = half_period_for_rate(rate);
+  int outputs = generate(order, half_period);
+  double mean = 0, total = 0;
+
+  if (outputs < 0) {
+    printf("%s %u: port timer overflow\n", name, rate);
+    return 0;
+  }
+
+  /* Remove the constant offset from the edge grid */
+  for (int n = 0; n < NUM_EDGES; n++)
+    mean += tie[n];
+  mean /= NUM_EDGES;
+  for (int n = 0; n < NUM_EDGES; n++) {
+    tie[n] -= mean;
+    total += tie[n] * tie[n];
+  }
+
+  *inband = sqrt(band_power(1, INBAND_BINS));
+  printf("%s %u: outputs %d rms %d ps inband %d ps bands",
+         name, rate, outputs, (int) sqrt(total / NUM_EDGES), (int) *inband);
+  for (int lo = 1; lo < NUM_EDGES / 2; lo *= 2)
+    printf(" %d", (int) sqrt(band_power(lo, lo * 2)));
+  printf("\n");
+
+  /* The modulator must not drift from the ideal edge times */
+  return mean > -PS_PER_TICK && mean < 2 * PS_PER_TICK;
+}
+
+int main(void)
+{
+  static const unsigned rates[] = {44100, 48000, 32000};
+  int pass = 1;
+
+  for (int n = 0; n < NUM_EDGES; n++)
+    cos_table[n] = cos(2 * M_PI * n / NUM_EDGES);
+
+  for (unsigned i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+    double accumulator, mash;
+    pass &= run("accumulator", 1, rates[i], &accumulator);
+    pass &= run("mash", 2, rates[i], &mash);
+
+    /* Noise shaping must not make the in-band jitter worse than the plain
+       accumulator, within a picosecond */
+    if (mash > accumulator + 1)
+      pass = 0;
+  }
+
+  printf("%s\n", pass ? "PASS" : "FAIL");
+  return 0;
+}
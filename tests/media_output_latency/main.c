@@ -0,0 +1,82 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include "media_output_latency.h"
+
+/* A 48kHz output FIFO of FIFO_SIZE samples is fed whole windows of fill
+   reports through the adaptive presentation time logic.
+
+   - An underflow grows the offset by the largest step, and a fill below
+     the reserve grows it by the shortfall.
+   - Growth stops short of overflowing the FIFO.
+   - A FIFO that stays well filled shrinks the offset a sample per window,
+     down to the SRP accumulated latency and no further.
+   - An accumulated latency below the talker's presentation delay, or none
+     at all, must never take the offset below zero (playing before the
+     presentation time). */
+#define FIFO_SIZE          64
+#define SAMPLE_PERIOD_NS   20833
+#define PRESENTATION_NS    2000000
+
+static int failed = 0;
+
+static void window(media_output_latency_t *l, int min_fill, int max_fill,
+                   unsigned underflows)
+{
+  for (int i = 0; i < AVB_ADAPTIVE_PRESENTATION_WINDOW; i++) {
+    int fill = i == 0 ? min_fill : max_fill;
+    media_output_latency_update(l, fill, underflows, SAMPLE_PERIOD_NS, 1);
+  }
+}
+
+static void check(const char *name, int ok, int offset)
+{
+  printf("%s: offset %d: %s\n", name, offset, ok ? "ok" : "failed");
+  if (!ok)
+    failed = 1;
+}
+
+int main(void)
+{
+  media_output_latency_t l;
+  int offset;
+
+  media_output_latency_init(&l, FIFO_SIZE);
+
+  window(&l, 20, 24, 1);
+  check("underflow", l.offset == 4 * SAMPLE_PERIOD_NS, l.offset);
+
+  offset = l.offset;
+  window(&l, AVB_ADAPTIVE_PRESENTATION_MIN_FILL - 2, 24, 1);
+  window(&l, AVB_ADAPTIVE_PRESENTATION_MIN_FILL - 2, 24, 1);
+  check("low fill", l.offset == offset + 4 * SAMPLE_PERIOD_NS &&
+                    l.total_underflows == 1, l.offset);
+
+  offset = l.offset;
+  window(&l, 20, FIFO_SIZE - 2, 2);
+  check("near full", l.offset == offset + SAMPLE_PERIOD_NS, l.offset);
+
+  for (int i = 0; i < 4; i++)
+    window(&l, 40, 44, 2);
+  check("shrink", l.offset == offset - 3 * SAMPLE_PERIOD_NS, l.offset);
+
+  media_output_latency_set_accumulated_latency(&l, PRESENTATION_NS + 3 * SAMPLE_PERIOD_NS,
+                                               PRESENTATION_NS);
+  for (int i = 0; i < 20; i++)
+    window(&l, 40, 44, 2);
+  check("accumulated latency", l.offset == 3 * SAMPLE_PERIOD_NS &&
+                               l.min_offset == 3 * SAMPLE_PERIOD_NS, l.offset);
+
+  media_output_latency_set_accumulated_latency(&l, PRESENTATION_NS / 2, PRESENTATION_NS);
+  for (int i = 0; i < 20; i++)
+    window(&l, 40, 44, 2);
+  check("short accumulated latency", l.offset == 0 && l.min_offset == 0, l.offset);
+
+  media_output_latency_set_accumulated_latency(&l, 0, PRESENTATION_NS);
+  media_output_latency_reset(&l);
+  for (int i = 0; i < 20; i++)
+    window(&l, 40, 44, 2);
+  check("no accumulated latency", l.offset == 0, l.offset);
+
+  printf("%s\n", failed ? "FAIL" : "PASS");
+  return 0;
+}
@@ -0,0 +1,140 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <string.h>
+#include <xs1.h>
+#include "schedule_frames.h"
+#include "default_avb_conf.h"
+#include "avb_1722_common.h"
+#include "avb_1722_1_protocol.h"
+#include "avb_1722_1_adp_pdu.h"
+#include "avb_1722_1_acmp_pdu.h"
+#include "avb_1722_1_aecp_pdu.h"
+#include "avb_1722_maap_protocol.h"
+
+#define ETH_HEADER   14
+#define PDU_HEADER   12
+#define AEM_HEADER   (PDU_HEADER + 12)
+
+#define TICKS_PER_CS (XS1_TIMER_KHZ * 10)
+
+static const unsigned char entity_mac[6] = ENTITY_MAC;
+static const unsigned char controller_mac[6] = CONTROLLER_MAC;
+
+static void put16(unsigned char *p, unsigned v)
+{
+  p[0] = v >> 8;
+  p[1] = v;
+}
+
+static unsigned get16(const unsigned char *p)
+{
+  return (p[0] << 8) | p[1];
+}
+
+// GUIDs are formed from MAC addresses
+static void put_guid(unsigned char *p, const unsigned char mac[6])
+{
+  memcpy(p, mac, 3);
+  p[3] = 0xff;
+  p[4] = 0xfe;
+  memcpy(p + 5, mac + 3, 3);
+}
+
+static void put_header(unsigned char *p, unsigned subtype, unsigned message_type,
+                       unsigned datalen)
+{
+  p[0] = 0x80 | subtype;
+  p[1] = message_type;
+  p[2] = (datalen >> 8) & 7;
+  p[3] = datalen;
+}
+
+unsigned connect_rx_command(unsigned char pdu[], unsigned sink, unsigned seq)
+{
+  static const unsigned char talker_mac[6] = {0x00, 0x22, 0x97, 0x20, 0x00, 0x00};
+
+  memset(pdu, 0, PDU_HEADER + AVB_1722_1_ACMP_CD_LENGTH);
+  put_header(pdu, DEFAULT_1722_1_ACMP_SUBTYPE, ACMP_CMD_CONNECT_RX_COMMAND,
+             AVB_1722_1_ACMP_CD_LENGTH);
+  put_guid(pdu + 12, controller_mac);
+  put_guid(pdu + 20, talker_mac);
+  put_guid(pdu + 28, entity_mac);
+  put16(pdu + 38, sink);
+  put16(pdu + 48, seq);
+  return PDU_HEADER + AVB_1722_1_ACMP_CD_LENGTH;
+}
+
+unsigned register_unsolicited_command(unsigned char pdu[], unsigned seq,
+                                      int deregister)
+{
+  // The command has a flags field, which is reserved
+  unsigned len = AEM_HEADER + 4;
+
+  memset(pdu, 0, len);
+  put_header(pdu, DEFAULT_1722_1_AECP_SUBTYPE, AECP_CMD_AEM_COMMAND, len - PDU_HEADER);
+  put_guid(pdu + 4, entity_mac);
+  put_guid(pdu + 12, controller_mac);
+  put16(pdu + 20, seq);
+  put16(pdu + 22, deregister ? AECP_AEM_CMD_DEREGISTER_UNSOLICITED_NOTIFICATION :
+                               AECP_AEM_CMD_REGISTER_UNSOLICITED_NOTIFICATION);
+  return len;
+}
+
+int frame_kind(const unsigned char frame[], unsigned len)
+{
+  const unsigned char *pdu = frame + ETH_HEADER;
+  unsigned message_type;
+
+  if (len < ETH_HEADER + PDU_HEADER || get16(frame + 12) != AVB_1722_ETHERTYPE)
+    return FRAME_OTHER;
+
+  message_type = pdu[1] & 0xf;
+
+  switch (pdu[0] & 0x7f) {
+    case DEFAULT_MAAP_SUBTYPE:
+      if (message_type == MAAP_PROBE)
+        return FRAME_MAAP_PROBE;
+      if (message_type == MAAP_ANNOUNCE)
+        return FRAME_MAAP_ANNOUNCE;
+      break;
+    case DEFAULT_1722_1_ADP_SUBTYPE:
+      if (message_type == ENTITY_AVAILABLE)
+        return FRAME_ADP_AVAILABLE;
+      break;
+    case DEFAULT_1722_1_ACMP_SUBTYPE:
+      if (len < ETH_HEADER + PDU_HEADER + AVB_1722_1_ACMP_CD_LENGTH)
+        break;
+      if (message_type == ACMP_CMD_CONNECT_TX_COMMAND)
+        return FRAME_CONNECT_TX_COMMAND;
+      if (message_type == ACMP_CMD_CONNECT_RX_RESPONSE)
+        return FRAME_CONNECT_RX_RESPONSE;
+      break;
+    case DEFAULT_1722_1_AECP_SUBTYPE:
+      // Unsolicited notifications are left out
+      if (len >= ETH_HEADER + AEM_HEADER && message_type == AECP_CMD_AEM_RESPONSE &&
+          memcmp(frame, controller_mac, 6) == 0 && !(pdu[22] & 0x80))
+        return FRAME_AEM_RESPONSE;
+      break;
+  }
+  return FRAME_OTHER;
+}
+
+unsigned frame_sequence_id(const unsigned char frame[])
+{
+  const unsigned char *pdu = frame + ETH_HEADER;
+
+  if ((pdu[0] & 0x7f) == DEFAULT_1722_1_ACMP_SUBTYPE)
+    return get16(pdu + 48);
+  return get16(pdu + 20);
+}
+
+unsigned frame_status(const unsigned char frame[])
+{
+  return frame[ETH_HEADER + 2] >> 3;
+}
+
+unsigned maap_probe_interval(const unsigned char frame[])
+{
+  const maap_packet_t *pkt = (const maap_packet_t *) (frame + ETH_HEADER);
+
+  return (MAAP_PROBE_INTERVAL_BASE_CS + (pkt->request_start_address[5] & 7)) * TICKS_PER_CS;
+}
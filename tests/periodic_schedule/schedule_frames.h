@@ -0,0 +1,56 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#ifndef SCHEDULE_FRAMES_H_
+#define SCHEDULE_FRAMES_H_
+
+#include <xccompat.h>
+
+#define ENTITY_MAC      {0x00, 0x22, 0x97, 0x01, 0x02, 0x03}
+#define CONTROLLER_MAC  {0x00, 0x22, 0x97, 0x0a, 0x0b, 0x0c}
+
+/** Enough for any PDU sent to the entity */
+#define SCHEDULE_MAX_PDU 64
+
+/** The frames the entity sends that the test looks for. An AEM response
+ *  is a response to a command from the controller. */
+enum frame_kind_t {
+  FRAME_OTHER,
+  FRAME_MAAP_PROBE,
+  FRAME_MAAP_ANNOUNCE,
+  FRAME_ADP_AVAILABLE,
+  FRAME_CONNECT_TX_COMMAND,
+  FRAME_CONNECT_RX_RESPONSE,
+  FRAME_AEM_RESPONSE,
+  NUM_FRAME_KINDS
+};
+
+/** Build a CONNECT_RX_COMMAND from the controller to a sink of the
+ *  entity, to connect it to a talker that never answers.
+ *
+ *  \param pdu  filled with the command from the 1722.1 header on
+ *  \returns    the length of the command
+ */
+unsigned connect_rx_command(unsigned char pdu[], unsigned sink, unsigned seq);
+
+/** Build a REGISTER_UNSOLICITED_NOTIFICATION command from the controller
+ *  to the entity, or a DEREGISTER_UNSOLICITED_NOTIFICATION.
+ *
+ *  \param pdu  filled with the command from the 1722.1 header on
+ *  \returns    the length of the command
+ */
+unsigned register_unsolicited_command(unsigned char pdu[], unsigned seq,
+                                      int deregister);
+
+/** The kind of a frame the entity sent, from the Ethernet header on */
+int frame_kind(const unsigned char frame[], unsigned len);
+
+/** The sequence ID of an ACMP or AECP frame */
+unsigned frame_sequence_id(const unsigned char frame[]);
+
+/** The status of an ACMP or AECP frame */
+unsigned frame_status(const unsigned char frame[]);
+
+/** The interval between the MAAP probes of the address range a probe asks
+ *  for, in ticks */
+unsigned maap_probe_interval(const unsigned char frame[]);
+
+#endif /* SCHEDULE_FRAMES_H_ */
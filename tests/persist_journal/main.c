@@ -0,0 +1,264 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include <string.h>
+#include "avb_1722_1_journal.h"
+#include "aem_descriptor_types.h"
+#include "avb_1722_1_aecp_aem.h"
+
+/* The persistent state journal on a simulated flash data partition.
+
+   An entity with 8 stream sinks, 8 stream sources and 2 media clocks is
+   reconfigured 20000 times by controllers connecting and disconnecting
+   its sinks, and setting stream formats, sampling rates and clock
+   sources. Every 500 changes the power is cut and the journal read back
+   at start up, which must give the state as it was. A few power cuts
+   land part way through writing a page.
+
+   The flash behaves as NOR flash: writing a page can only clear bits and
+   a sector must be erased to set them again. Page reads take 20us, page
+   writes 1ms and sector erases 50ms.
+
+   The fast connect state used to be kept in one page, with its sector
+   erased every time a sink was connected or disconnected. */
+
+#define NUM_SINKS         8
+#define NUM_SOURCES       8
+#define NUM_CLOCKS        2
+#define NUM_CHANGES       20000
+#define CHANGES_PER_BOOT  500
+#define PAGE_SIZE         AVB_1722_1_JOURNAL_PAGE_SIZE
+#define SECTOR_SIZE       4096
+#define NUM_SECTORS       (AVB_1722_1_JOURNAL_FIRST_SECTOR + AVB_1722_1_JOURNAL_NUM_SECTORS)
+#define READ_US           20
+#define WRITE_US          1000
+#define ERASE_US          50000
+
+static unsigned char flash[NUM_SECTORS * SECTOR_SIZE];
+static unsigned erases[NUM_SECTORS];
+static unsigned page_reads;
+static unsigned bits_set;         // Writes that tried to set a bit
+static int cut_after_bytes = -1;  // Cut the power part way through the next write
+
+int fl_getDataSectorSize(int n)
+{
+  (void) n;
+  return SECTOR_SIZE;
+}
+
+int fl_readDataPage(unsigned n, unsigned char *dst)
+{
+  if ((n + 1) * PAGE_SIZE > sizeof(flash))
+    return 1;
+  memcpy(dst, &flash[n * PAGE_SIZE], PAGE_SIZE);
+  page_reads++;
+  return 0;
+}
+
+int fl_writeDataPage(unsigned n, const unsigned char *data)
+{
+  unsigned len = PAGE_SIZE;
+
+  if ((n + 1) * PAGE_SIZE > sizeof(flash))
+    return 1;
+  if (cut_after_bytes >= 0) {
+    len = cut_after_bytes;
+    cut_after_bytes = -1;
+  }
+  for (unsigned i = 0; i < len; i++) {
+    unsigned char *p = &flash[n * PAGE_SIZE + i];
+    if (data[i] & ~*p)
+      bits_set++;
+    *p &= data[i];
+  }
+  return len == PAGE_SIZE ? 0 : 1;
+}
+
+int fl_eraseDataSector(unsigned n)
+{
+  if (n >= NUM_SECTORS)
+    return 1;
+  memset(&flash[n * SECTOR_SIZE], 0xff, SECTOR_SIZE);
+  erases[n]++;
+  return 0;
+}
+
+// The state the journal should hold
+typedef struct model_t {
+  int connected[NUM_SINKS];
+  unsigned char talker[NUM_SINKS][AVB_1722_1_JOURNAL_DATA_SIZE];
+  unsigned char sink_format[NUM_SINKS][8];
+  unsigned char source_format[NUM_SOURCES][8];
+  unsigned char rate[NUM_CLOCKS][4];
+  unsigned char clock_source[NUM_CLOCKS][4];
+} model_t;
+
+static model_t model;
+static unsigned sink_changes;
+static unsigned rand_state = 1;
+
+static unsigned next_rand(void)
+{
+  rand_state = rand_state * 1103515245 + 12345;
+  return (rand_state >> 16) & 0x7fff;
+}
+
+static void fill(unsigned char *data, unsigned len, unsigned seed)
+{
+  for (unsigned i = 0; i < len; i++)
+    data[i] = seed * 31 + i;
+}
+
+// A controller makes a change, which is journalled
+static int change(unsigned n)
+{
+  unsigned r = next_rand();
+  unsigned i;
+
+  switch (r % 5) {
+    case 0:
+      i = r % NUM_SINKS;
+      sink_changes++;
+      if (model.connected[i]) {
+        model.connected[i] = 0;
+        avb_1722_1_journal_erase(AVB_1722_1_JOURNAL_SINK_CONNECTION, 0, AEM_STREAM_INPUT_TYPE, i);
+        return 1;
+      }
+      model.connected[i] = 1;
+      memset(model.talker[i], 0, AVB_1722_1_JOURNAL_DATA_SIZE);
+      fill(model.talker[i], 18, n);
+      return avb_1722_1_journal_write(AVB_1722_1_JOURNAL_SINK_CONNECTION, 0, AEM_STREAM_INPUT_TYPE, i,
+                                      model.talker[i], 18);
+    case 1:
+      i = r % NUM_SINKS;
+      fill(model.sink_format[i], 8, n % 3);
+      return avb_1722_1_journal_write(AVB_1722_1_JOURNAL_AEM_SET, AECP_AEM_CMD_SET_STREAM_FORMAT,
+                                      AEM_STREAM_INPUT_TYPE, i, model.sink_format[i], 8);
+    case 2:
+      i = r % NUM_SOURCES;
+      fill(model.source_format[i], 8, n % 3);
+      return avb_1722_1_journal_write(AVB_1722_1_JOURNAL_AEM_SET, AECP_AEM_CMD_SET_STREAM_FORMAT,
+                                      AEM_STREAM_OUTPUT_TYPE, i, model.source_format[i], 8);
+    case 3:
+      i = r % NUM_CLOCKS;
+      fill(model.rate[i], 4, n % 2);
+      return avb_1722_1_journal_write(AVB_1722_1_JOURNAL_AEM_SET, AECP_AEM_CMD_SET_SAMPLING_RATE,
+                                      AEM_AUDIO_UNIT_TYPE, i, model.rate[i], 4);
+    default:
+      i = r % NUM_CLOCKS;
+      fill(model.clock_source[i], 2, n % 2);
+      return avb_1722_1_journal_write(AVB_1722_1_JOURNAL_AEM_SET, AECP_AEM_CMD_SET_CLOCK_SOURCE,
+                                      AEM_CLOCK_DOMAIN_TYPE, i, model.clock_source[i], 4);
+  }
+}
+
+static int check_aem(unsigned command, unsigned descriptor_type, unsigned descriptor_index,
+                     const unsigned char *expected, unsigned len)
+{
+  unsigned char data[AVB_1722_1_JOURNAL_DATA_SIZE];
+  unsigned char zero[AVB_1722_1_JOURNAL_DATA_SIZE] = {0};
+
+  // Never set
+  if (memcmp(expected, zero, len) == 0)
+    return !avb_1722_1_journal_read(AVB_1722_1_JOURNAL_AEM_SET, command, descriptor_type, descriptor_index, data);
+  return avb_1722_1_journal_read(AVB_1722_1_JOURNAL_AEM_SET, command, descriptor_type, descriptor_index, data) &&
+         memcmp(data, expected, len) == 0;
+}
+
+// Compare the journal read back at start up with the model
+static int check(void)
+{
+  unsigned char data[AVB_1722_1_JOURNAL_DATA_SIZE];
+  unsigned i, command, descriptor_type, descriptor_index;
+  unsigned num_connected = 0, found = 0;
+
+  for (i = 0; i < NUM_SINKS; i++) {
+    int present = avb_1722_1_journal_read(AVB_1722_1_JOURNAL_SINK_CONNECTION, 0, AEM_STREAM_INPUT_TYPE, i, data);
+    if (present != model.connected[i])
+      return 0;
+    if (present && memcmp(data, model.talker[i], AVB_1722_1_JOURNAL_DATA_SIZE) != 0)
+      return 0;
+    num_connected += present;
+    if (!check_aem(AECP_AEM_CMD_SET_STREAM_FORMAT, AEM_STREAM_INPUT_TYPE, i, model.sink_format[i], 8))
+      return 0;
+  }
+  for (i = 0; i < NUM_SOURCES; i++)
+    if (!check_aem(AECP_AEM_CMD_SET_STREAM_FORMAT, AEM_STREAM_OUTPUT_TYPE, i, model.source_format[i], 8))
+      return 0;
+  for (i = 0; i < NUM_CLOCKS; i++) {
+    if (!check_aem(AECP_AEM_CMD_SET_SAMPLING_RATE, AEM_AUDIO_UNIT_TYPE, i, model.rate[i], 4) ||
+        !check_aem(AECP_AEM_CMD_SET_CLOCK_SOURCE, AEM_CLOCK_DOMAIN_TYPE, i, model.clock_source[i], 4))
+      return 0;
+  }
+
+  // The sinks to fast connect are found by walking the entries
+  i = 0;
+  while (avb_1722_1_journal_next(AVB_1722_1_JOURNAL_SINK_CONNECTION, &i, &command,
+                                 &descriptor_type, &descriptor_index, data))
+    found++;
+  return found == num_connected;
+}
+
+int main(void)
+{
+  avb_1722_1_journal_stats_t stats;
+  unsigned boots = 0, good_boots = 0, torn = 0;
+  unsigned max_boot_us = 0;
+  unsigned total_erases = 0, min_erases = NUM_CHANGES, max_erases = 0;
+  unsigned old_us;
+  int pass = 1;
+
+  memset(flash, 0xff, sizeof(flash));
+  avb_1722_1_journal_init();
+
+  for (unsigned n = 1; n <= NUM_CHANGES; n++) {
+    model_t before = model;
+    // Some power cuts land part way through a page write
+    int cut = n % CHANGES_PER_BOOT == 0 && (n / CHANGES_PER_BOOT) % 8 == 3;
+
+    if (cut)
+      cut_after_bytes = 100;
+    change(n);
+    if (cut && cut_after_bytes < 0) {
+      // The change is either kept or lost
+      avb_1722_1_journal_init();
+      if (!check()) {
+        model = before;
+        if (!check())
+          pass = 0;
+      }
+      torn++;
+    }
+    cut_after_bytes = -1;
+
+    if (n % CHANGES_PER_BOOT == 0) {
+      unsigned reads = page_reads;
+      avb_1722_1_journal_init();
+      boots++;
+      if ((page_reads - reads) * READ_US > max_boot_us)
+        max_boot_us = (page_reads - reads) * READ_US;
+      if (check())
+        good_boots++;
+    }
+  }
+
+  avb_1722_1_journal_get_stats(&stats);
+  for (unsigned s = AVB_1722_1_JOURNAL_FIRST_SECTOR; s < NUM_SECTORS; s++) {
+    total_erases += erases[s];
+    if (erases[s] < min_erases) min_erases = erases[s];
+    if (erases[s] > max_erases) max_erases = erases[s];
+  }
+  old_us = sink_changes * (ERASE_US + READ_US + WRITE_US);
+
+  printf("%d changes, %u power cuts with the state read back: %u good, %u cut mid write\n",
+         NUM_CHANGES, boots, good_boots, torn);
+  printf("start up reads %u pages in %u us\n", max_boot_us / READ_US, max_boot_us);
+  printf("sector erases %u, from %u to %u per sector; bits set without an erase %u\n",
+         total_erases, min_erases, max_erases, bits_set);
+  printf("erased a sector for each of %u sink changes, taking %u ms\n", sink_changes, old_us / 1000);
+
+  pass &= good_boots == boots && torn != 0 && bits_set == 0 &&
+          max_erases - min_erases <= 1 && max_boot_us < 1000 &&
+          total_erases * 10 < sink_changes;
+  printf("%s\n", pass ? "PASS" : "FAIL");
+  return 0;
+}
@@ -0,0 +1,312 @@
+// Copyright (c) 2017, XMOS Ltd, All rights reserved
+#include <xs1.h>
+#include <stdio.h>
+#include <string.h>
+#include "avb_1722_def.h"
+#include "avb_1722_talker.h"
+#include "avb_1722_listener.h"
+#include "audio_buffering.h"
+#include "audio_output_fifo.h"
+#include "gptp.h"
+
+/* A talker monitoring its own stream on local outputs.
+
+   A 48kHz stereo stream is built with avb1722_create_packet(), and each
+   packet is given to avb_1722_listener_process_packet() twice: for the
+   talker's monitor, set up as configure_monitor() in avb_1722_talker.xc
+   does, and for a listener connected to the stream, set up as
+   configure_stream() in avb_1722_listener.xc does. The monitor is set up
+   once the listener has detected the format of the stream, so from then on
+   the FIFOs of both get the same packets. One output plays all the FIFOs,
+   a sample every sample period.
+
+   There is no media clock server. The FIFOs are maintained as if it had
+   already been notified, so each keeps the first sample it marks after
+   zeroing until the stream is connected again. For the default
+   presentation time and for AVB_TALKER_LOCAL_MONITOR_MAX_DELAY_NS (set to
+   5ms by the Makefile) the listener is connected NUM_STARTS times, at
+   different points of the stream, and each time:
+
+   - the monitor marks the sample of each channel that the talker
+     timestamped, with the time it was captured plus the presentation time
+   - the listener marks the same samples with the same times, and the
+     output plays them from both at the same time
+   - the FIFO holds the fill that the media clock server sets to play the
+     marked sample at its presentation time, short of a packet */
+
+#define RATE                   48000
+#define NUM_CHANNELS           2
+#define SYT_INTERVAL           8
+#define SAMPLE_PERIOD_NS       (1000000000 / RATE)
+#define SAMPLES_PER_PACKET     (RATE / AVB1722_PACKET_RATE)
+#define MAX_SAMPLES_PER_PACKET (AVB_MAX_AUDIO_SAMPLE_RATE / 8000)
+
+#define NUM_STARTS             8
+// A sample in SYT_INTERVAL is timestamped, so at 0, 2 or 4 in a packet
+#define TIMESTAMP_POSITIONS    3
+#define MAX_PACKETS_PER_START  1000
+
+// The talker's local time when the first sample is captured, and when the
+// output plays its first sample slot
+#define CAPTURE_START          1000
+#define PLAY_START             1500
+
+// The FIFOs of each channel of the monitor and of the listener
+#define MONITOR_FIFO(c)        (c)
+#define LISTENER_FIFO(c)       (NUM_CHANNELS + (c))
+#define NUM_FIFOS              (2 * NUM_CHANNELS)
+
+// The 24 bit sample of a channel in a frame, as played by the output
+#define SAMPLE(n, c)           ((((n) * NUM_CHANNELS) + (c) + 1) << 8)
+
+static ofifo_t fifos[NUM_FIFOS];
+static struct output_finfo finfo;
+
+static avb1722_Talker_StreamConfig_t talker;
+static unsigned int tx_buf[(MAX_PKT_BUF_SIZE_TALKER + 3) / 4];
+static unsigned char *buf = (unsigned char *) tx_buf;
+// Time information of all zeroes converts local time to nanoseconds
+static ptp_time_info_mod64 time_info;
+static audio_frame_t frame;
+static unsigned next_frame;
+
+// The next sample slot of the output, and the fill of each FIFO when the
+// output played its marked sample
+static unsigned next_slot;
+static int fill_when_played[NUM_FIFOS];
+static int num_played;
+
+static unsigned capture_time(unsigned n)
+{
+  return CAPTURE_START + (unsigned long long) XS1_TIMER_HZ * n / RATE;
+}
+
+static unsigned play_time(unsigned k)
+{
+  return PLAY_START + (unsigned long long) XS1_TIMER_HZ * k / RATE;
+}
+
+static void init_talker(unsigned delay_ns)
+{
+  unsigned tmp = ((RATE / 100) << 16) / (AVB1722_PACKET_RATE / 100);
+
+  memset(&talker, 0, sizeof(talker));
+  talker.num_channels = NUM_CHANNELS;
+  talker.ts_interval = SYT_INTERVAL;
+  talker.samples_per_packet_base = tmp >> 16;
+  talker.samples_per_packet_fractional = tmp & 0xffff;
+  talker.presentation_delay = delay_ns;
+  for (int i = 0; i < NUM_CHANNELS; i++)
+    talker.map[i] = i;
+  AVB1722_Talker_bufInit(buf, &talker, 0);
+}
+
+// As configure_stream() in avb_1722_listener.xc
+static void connect_listener(avb_1722_stream_info_t *s, buffer_handle_t h)
+{
+  s->num_channels = NUM_CHANNELS;
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    s->map[i] = LISTENER_FIFO(i);
+    enable_audio_output_fifo(h, s->map[i], 0, RATE);
+  }
+  s->active = 1;
+  s->state = 0;
+  s->num_channels_in_payload = 0;
+  s->chan_lock = 0;
+  s->prev_num_samples = 0;
+  s->dbc = -1;
+}
+
+// As configure_monitor() in avb_1722_talker.xc
+static void configure_monitor(avb_1722_stream_info_t *m, buffer_handle_t h)
+{
+  m->num_channels = talker.num_channels;
+  m->num_channels_in_payload = talker.num_channels;
+  m->rate = RATE;
+  m->chan_lock = 16;
+  m->prev_num_samples = 0;
+  m->dbc = -1;
+  m->state = 0;
+  for (int i = 0; i < m->num_channels; i++) {
+    m->map[i] = MONITOR_FIFO(i);
+    enable_audio_output_fifo(h, m->map[i], 0, RATE);
+  }
+  m->active = 1;
+}
+
+static int fill_of(ofifo_t *s)
+{
+  int fill = s->wrptr - s->dptr;
+
+  if (fill < 0)
+    fill += AUDIO_OUTPUT_FIFO_WORD_SIZE;
+  return fill;
+}
+
+/* Check the sample a FIFO marked for a channel.
+
+   \returns  the frame of the sample, or -1 if it is not the sample the
+             talker timestamped or has the wrong time */
+static int marked_frame(ofifo_t *s, int channel, unsigned delay_ns)
+{
+  unsigned sample, n;
+
+  if (s->marker == 0 || s->local_ts == 0)
+    return -1;
+
+  sample = *s->marker >> 8;
+  if (sample <= (unsigned) channel || (sample - 1 - channel) % NUM_CHANNELS != 0)
+    return -1;
+  n = (sample - 1 - channel) / NUM_CHANNELS;
+
+  // Timestamped by the talker, with the time it was captured in nanoseconds
+  if (n % SYT_INTERVAL != 0 || (unsigned) s->ptp_ts != capture_time(n) * 10 + delay_ns)
+    return -1;
+  return n;
+}
+
+/* The talker captures frames until it has built a packet.
+
+   \returns  the size of the packet */
+static int capture_packet(void)
+{
+  int size = 0;
+
+  while (!size) {
+    frame.timestamp = capture_time(next_frame);
+    for (int c = 0; c < NUM_CHANNELS; c++)
+      frame.samples[c] = SAMPLE(next_frame, c);
+    next_frame++;
+    size = avb1722_create_packet(buf, &talker, &time_info, &frame, 0);
+  }
+  return size;
+}
+
+/* The output plays the sample slots due by the time the next frame is
+   captured, and notes the fill of each FIFO as it plays the marked sample */
+static void play(buffer_handle_t h)
+{
+  while ((int) (play_time(next_slot) - capture_time(next_frame)) < 0) {
+    for (int i = 0; i < NUM_FIFOS; i++) {
+      int was_played = fifos[i].local_ts != 0;
+
+      // Samples marked while the FIFO is zeroing are dropped with it
+      (void) audio_output_fifo_pull_sample(h, i, play_time(next_slot));
+      if (!was_played && fifos[i].local_ts != 0 && fifos[i].state != ZEROING) {
+        fill_when_played[i] = fill_of(&fifos[i]);
+        num_played++;
+      }
+    }
+    next_slot++;
+  }
+}
+
+/* Check the samples marked by the monitor and the listener.
+
+   \returns  the frame of the samples, or -1 if they were not as sent or
+             not played together */
+static int check_markers(unsigned delay_ns, int *max_fill)
+{
+  int n = marked_frame(&fifos[MONITOR_FIFO(0)], 0, delay_ns);
+
+  if (num_played != NUM_FIFOS || n < 0)
+    return -1;
+
+  for (int c = 0; c < NUM_CHANNELS; c++) {
+    ofifo_t *m = &fifos[MONITOR_FIFO(c)];
+    ofifo_t *l = &fifos[LISTENER_FIFO(c)];
+    int diff, fill;
+
+    if (marked_frame(m, c, delay_ns) != n || marked_frame(l, c, delay_ns) != n ||
+        m->marker - START_OF_FIFO(m) != l->marker - START_OF_FIFO(l) ||
+        m->local_ts != l->local_ts)
+      return -1;
+
+    // The media clock server shortens the FIFO by the samples that the
+    // marked sample played late
+    diff = (int) ((unsigned) m->local_ts * 10 - (unsigned) m->ptp_ts);
+    fill = fill_when_played[MONITOR_FIFO(c)] - diff / SAMPLE_PERIOD_NS;
+    if (fill <= 0 || fill > AUDIO_OUTPUT_FIFO_WORD_SIZE - MAX_SAMPLES_PER_PACKET)
+      return -1;
+    if (fill > *max_fill)
+      *max_fill = fill;
+  }
+  return n;
+}
+
+static int run(unsigned delay_ns)
+{
+  buffer_handle_t h = (buffer_handle_t) &finfo;
+  avb_1722_stream_info_t listener, monitor;
+  int notified_listener = 1, notified_monitor = 1;
+  int starts_ok = 0, max_fill = 0;
+  unsigned positions = 0, num_positions = 0;
+  int ok;
+
+  for (int i = 0; i < NUM_FIFOS; i++) {
+    finfo.p_buffer[i] = (unsigned int *) &fifos[i];
+    audio_output_fifo_init(h, i);
+  }
+  memset(&listener, 0, sizeof(listener));
+  memset(&monitor, 0, sizeof(monitor));
+  init_talker(delay_ns);
+  next_frame = 0;
+  next_slot = 0;
+
+  for (int start = 0; start < NUM_STARTS; start++) {
+    int n;
+
+    // The listener connects a packet later each time
+    for (int i = 0; i < start; i++) {
+      (void) capture_packet();
+      play(h);
+    }
+
+    connect_listener(&listener, h);
+    monitor.active = 0;
+    num_played = 0;
+
+    for (int i = 0; i < MAX_PACKETS_PER_START && num_played != NUM_FIFOS; i++) {
+      int size = capture_packet();
+
+      avb_1722_listener_process_packet(0, &buf[2], size, &listener, NULL, 0,
+                                       &notified_listener, h);
+      if (monitor.active)
+        avb_1722_listener_process_packet(0, &buf[2], size, &monitor, NULL, 0,
+                                         &notified_monitor, h);
+      else if (listener.chan_lock == 16)
+        configure_monitor(&monitor, h);
+      play(h);
+    }
+
+    n = check_markers(delay_ns, &max_fill);
+    if (n >= 0) {
+      starts_ok++;
+      // Where the timestamped sample was in its packet
+      positions |= 1 << (n % SAMPLES_PER_PACKET);
+    }
+
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+      disable_audio_output_fifo(h, LISTENER_FIFO(i));
+      disable_audio_output_fifo(h, MONITOR_FIFO(i));
+    }
+  }
+
+  for (int i = 0; i < SAMPLES_PER_PACKET; i++)
+    num_positions += (positions >> i) & 1;
+
+  ok = starts_ok == NUM_STARTS && num_positions == TIMESTAMP_POSITIONS;
+  printf("presentation %uus: %d of %d starts, timestamped sample at %u places in its packet, "
+         "marked as sent and played with the listener, fill %d of %d at presentation: %s\n",
+         delay_ns / 1000, starts_ok, NUM_STARTS, num_positions, max_fill,
+         AUDIO_OUTPUT_FIFO_WORD_SIZE, ok ? "ok" : "failed");
+  return ok;
+}
+
+int main(void)
+{
+  int ok = run(AVB_DEFAULT_PRESENTATION_TIME_DELAY_NS);
+  ok &= run(AVB_TALKER_LOCAL_MONITOR_MAX_DELAY_NS);
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return 0;
+}
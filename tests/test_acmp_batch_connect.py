@@ -0,0 +1,17 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'acmp_batch_connect/bin/acmp_batch_connect.xe'.format()
+    # The times depend on the timing of the simulation
+    tester = xmostest.ComparisonTester(open('acmp_batch_connect.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'acmp_batch_connect',
+                                       {},
+                                       regexp=True)
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
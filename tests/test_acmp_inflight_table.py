@@ -0,0 +1,15 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'acmp_inflight_table/bin/acmp_inflight_table.xe'.format()
+    tester = xmostest.ComparisonTester(open('acmp_inflight_table.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'acmp_inflight_table',
+                                       {})
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
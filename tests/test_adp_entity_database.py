@@ -0,0 +1,17 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'adp_entity_database/bin/adp_entity_database.xe'.format()
+    # The lookup cost is reported, not checked
+    tester = xmostest.ComparisonTester(open('adp_entity_database.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'adp_entity_database',
+                                       {},
+                                       regexp=True)
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
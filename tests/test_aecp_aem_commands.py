@@ -0,0 +1,15 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'aecp_aem_commands/bin/aecp_aem_commands.xe'.format()
+    tester = xmostest.ComparisonTester(open('aecp_aem_commands.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'aecp_aem_commands',
+                                       {})
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
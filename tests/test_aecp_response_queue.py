@@ -0,0 +1,17 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'aecp_response_queue/bin/aecp_response_queue.xe'.format()
+    # The figures depend on the timing of the simulation
+    tester = xmostest.ComparisonTester(open('aecp_response_queue.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'aecp_response_queue',
+                                       {},
+                                       regexp=True)
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
@@ -0,0 +1,17 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'aecp_unsolicited_notify/bin/aecp_unsolicited_notify.xe'.format()
+    # The time between notifications depends on the timing of the simulation
+    tester = xmostest.ComparisonTester(open('aecp_unsolicited_notify.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'aecp_unsolicited_notify',
+                                       {},
+                                       regexp=True)
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
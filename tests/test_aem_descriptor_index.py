@@ -0,0 +1,17 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'aem_descriptor_index/bin/aem_descriptor_index.xe'.format()
+    # The cycle counts are reported; only their ratio is checked
+    tester = xmostest.ComparisonTester(open('aem_descriptor_index.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'aem_descriptor_index',
+                                       {},
+                                       regexp=True)
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
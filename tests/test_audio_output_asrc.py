@@ -0,0 +1,17 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'audio_output_asrc/bin/audio_output_asrc.xe'.format()
+    # The cycle counts are reported, not checked
+    tester = xmostest.ComparisonTester(open('audio_output_asrc.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'audio_output_asrc',
+                                       {},
+                                       regexp=True)
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
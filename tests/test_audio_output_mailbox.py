@@ -0,0 +1,15 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'audio_output_mailbox/bin/audio_output_mailbox.xe'.format()
+    tester = xmostest.ComparisonTester(open('audio_output_mailbox.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'audio_output_mailbox',
+                                       {})
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
@@ -0,0 +1,17 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'avdecc_load/bin/avdecc_load.xe'.format()
+    # Throughput and latency are reported, not checked
+    tester = xmostest.ComparisonTester(open('avdecc_load.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'avdecc_load',
+                                       {},
+                                       regexp=True)
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
@@ -0,0 +1,16 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'efu_pipeline/bin/efu_pipeline.xe'.format()
+    # The upload runs on a virtual clock, so the figures are exact
+    tester = xmostest.ComparisonTester(open('efu_pipeline.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'efu_pipeline',
+                                       {})
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
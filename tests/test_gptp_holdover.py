@@ -0,0 +1,15 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'gptp_holdover/bin/gptp_holdover.xe'.format()
+    tester = xmostest.ComparisonTester(open('gptp_holdover.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'gptp_holdover',
+                                       {})
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
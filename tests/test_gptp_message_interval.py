@@ -0,0 +1,15 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'gptp_message_interval/bin/gptp_message_interval.xe'.format()
+    tester = xmostest.ComparisonTester(open('gptp_message_interval.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'gptp_message_interval',
+                                       {})
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
@@ -0,0 +1,17 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'gptp_one_step/bin/gptp_one_step.xe'.format()
+    # The errors measured are printed, the test checks them against its bounds
+    tester = xmostest.ComparisonTester(open('gptp_one_step.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'gptp_one_step',
+                                       {},
+                                       regexp=True)
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
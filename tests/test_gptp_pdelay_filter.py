@@ -0,0 +1,15 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'gptp_pdelay_filter/bin/gptp_pdelay_filter.xe'.format()
+    tester = xmostest.ComparisonTester(open('gptp_pdelay_filter.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'gptp_pdelay_filter',
+                                       {})
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
@@ -0,0 +1,44 @@
+#!/usr/bin/env python
+import os
+import sys
+import xmostest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                '..', 'lib_tsn', 'host'))
+import gptp_trace_to_csv
+
+
+class TraceTester(xmostest.ComparisonTester):
+    """Compare the output with the trace lines replaced by their CSV"""
+
+    def run(self, output):
+        data = ''
+        lines = []
+        for line in output:
+            if line.startswith('trace '):
+                data += line.split()[1]
+            else:
+                lines.append(line)
+        csv = []
+
+        class Out(object):
+            def write(self, s):
+                csv.extend(s.splitlines(True))
+
+        gptp_trace_to_csv.to_csv(gptp_trace_to_csv.decode(bytearray.fromhex(data)), Out())
+        # The CSV goes before the PASS/FAIL line
+        super(TraceTester, self).run(lines[:-1] + csv + lines[-1:])
+
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'gptp_trace/bin/gptp_trace.xe'.format()
+    tester = TraceTester(open('gptp_trace.expect'),
+                         'lib_tsn',
+                         'lib_tsn_tests',
+                         'gptp_trace',
+                         {})
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
@@ -0,0 +1,15 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'media_clock_rates/bin/media_clock_rates.xe'.format()
+    tester = xmostest.ComparisonTester(open('media_clock_rates.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'media_clock_rates',
+                                       {})
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
@@ -0,0 +1,15 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'media_output_latency/bin/media_output_latency.xe'.format()
+    tester = xmostest.ComparisonTester(open('media_output_latency.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'media_output_latency',
+                                       {})
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
@@ -0,0 +1,17 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'periodic_schedule/bin/periodic_schedule.xe'.format()
+    # Intervals and wakeup counts depend on the timing of the simulation
+    tester = xmostest.ComparisonTester(open('periodic_schedule.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'periodic_schedule',
+                                       {},
+                                       regexp=True)
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
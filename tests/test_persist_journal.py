@@ -0,0 +1,16 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'persist_journal/bin/persist_journal.xe'.format()
+    # The flash is simulated, so the figures are exact
+    tester = xmostest.ComparisonTester(open('persist_journal.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'persist_journal',
+                                       {})
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)
@@ -0,0 +1,15 @@
+#!/usr/bin/env python
+import xmostest
+
+def runtest():
+    testlevel = 'smoke'
+    resources = xmostest.request_resource('xsim')
+
+    binary = 'talker_local_monitor/bin/talker_local_monitor.xe'.format()
+    tester = xmostest.ComparisonTester(open('talker_local_monitor.expect'),
+                                       'lib_tsn',
+                                       'lib_tsn_tests',
+                                       'talker_local_monitor',
+                                       {})
+    tester.set_min_testlevel(testlevel)
+    xmostest.run_on_simulator(resources['xsim'], binary, simargs=[], tester=tester)